@@ -52,8 +52,12 @@ Node* OrientationConverter::convert( Node *node )
     //        - translate to absolute translation in world coordinates
     //    else if world frame option not set,
     //        - translate back to model's original origin.
+    //
+    // The translation back to the model's origin is kept local so that convert()
+    // doesn't modify the converter, allowing it to be used from several threads.
     BoundingSphere bs = node->getBound();
     Matrix C;
+    Matrix translation = T;
 
     if (_use_world_frame)
     {
@@ -64,7 +68,7 @@ Node* OrientationConverter::convert( Node *node )
         C = Matrix::translate( -bs.center() );
         
         if (_trans_set == false)
-            T = Matrix::translate( bs.center() );
+            translation = Matrix::translate( bs.center() );
     }
 
 
@@ -72,7 +76,7 @@ Node* OrientationConverter::convert( Node *node )
     osg::MatrixTransform* transform = new osg::MatrixTransform;
 
     transform->setDataVariance(osg::Object::STATIC);
-    transform->setMatrix( C * R * S * T );
+    transform->setMatrix( C * R * S * translation );
     
     if (!S.isIdentity())
     {
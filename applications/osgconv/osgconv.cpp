@@ -11,6 +11,7 @@
 #include <osg/Texture3D>
 #include <osg/BlendFunc>
 #include <osg/Timer>
+#include <osg/FrameStamp>
 
 #include <osgDB/Registry>
 #include <osgDB/ReadFile>
@@ -18,6 +19,8 @@
 #include <osgDB/FileNameUtils>
 #include <osgDB/ReaderWriter>
 #include <osgDB/PluginQuery>
+#include <osgDB/FileUtils>
+#include <osgDB/fstream>
 
 #include <osgUtil/Optimizer>
 #include <osgUtil/Simplifier>
@@ -26,7 +29,13 @@
 #include <osgViewer/GraphicsWindow>
 #include <osgViewer/Version>
 
+#include <OpenThreads/Thread>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
+#include <OpenThreads/Atomic>
+
 #include <iostream>
+#include <set>
 
 #include "OrientationConverter.h"
 
@@ -194,7 +203,8 @@ public:
         }
     }
 
-    void write(const std::string &dir)
+    /** write the compressed images to dir, skipping any whose path is already in writtenImages when it is supplied.*/
+    void write(const std::string &dir, std::set<std::string>* writtenImages=0)
     {
         for(TextureSet::iterator itr=_textureSet.begin();
             itr!=_textureSet.end();
@@ -212,6 +222,7 @@ public:
                 name += ".dds";
                 image->setFileName(name);
                 std::string path = dir.empty() ? name : osgDB::concatPaths(dir, name);
+                if (writtenImages && !writtenImages->insert(path).second) continue;
                 osgDB::writeImageFile(*image, path);
                 osg::notify(osg::NOTICE) << "Image written to '" << path << "'." << std::endl;
             }
@@ -411,6 +422,258 @@ public:
 };
 
 
+/** Applies the requested processing to a loaded scene and writes it out.
+  * In batch mode several threads convert files at the same time, so the steps that touch objects
+  * that may be shared between scenes via the object cache, texture compression and the writing of
+  * the compressed images and scenes that reference them, are serialized and each image is only written once.*/
+class SceneConverter
+{
+public:
+
+    SceneConverter(OrientationConverter& oc):
+        _oc(oc),
+        do_convert(false),
+        pruneStateSet(false),
+        fixTransparencyMode(FixTransparencyVisitor::NO_TRANSPARANCY_FIXING),
+        internalFormatMode(osg::Texture::USE_IMAGE_DATA_FORMAT),
+        smooth(false),
+        addMissingColours(false),
+        do_overallNormal(false),
+        do_simplify(false),
+        simplifyPercent(1.0f),
+        batchMode(false) {}
+
+    bool convert(osg::ref_ptr<osg::Node>& root, const std::string& fileNameOut)
+    {
+        if (pruneStateSet)
+        {
+            PruneStateSetVisitor pssv;
+            root->accept(pssv);
+        }
+
+        if (fixTransparencyMode != FixTransparencyVisitor::NO_TRANSPARANCY_FIXING)
+        {
+            FixTransparencyVisitor atv(fixTransparencyMode);
+            root->accept(atv);
+        }
+
+        if (smooth)
+        {
+            osgUtil::SmoothingVisitor sv;
+            root->accept(sv);
+        }
+
+        if (addMissingColours)
+        {
+            AddMissingColoursToGeometryVisitor av;
+            root->accept(av);
+        }
+
+        // optimize the scene graph, remove redundant nodes and state etc.
+        osgUtil::Optimizer optimizer;
+        optimizer.optimize(root.get());
+
+        if( do_convert )
+            root = _oc.convert( root.get() );
+
+        // images shared between scenes are modified in place by the compression, so the lock is held until
+        // the scene has been written to stop other batch threads writing them out meanwhile.
+        bool lockTextures = internalFormatMode != osg::Texture::USE_IMAGE_DATA_FORMAT;
+        if (lockTextures) _textureMutex.lock();
+
+        if (internalFormatMode != osg::Texture::USE_IMAGE_DATA_FORMAT)
+        {
+            std::string ext = osgDB::getFileExtension(fileNameOut);
+            CompressTexturesVisitor ctv(internalFormatMode);
+            root->accept(ctv);
+
+            ctv.compress();
+
+            osgDB::ReaderWriter::Options *options = osgDB::Registry::instance()->getOptions();
+            if (ext!="ive" || (options && options->getOptionString().find("noTexturesInIVEFile")!=std::string::npos))
+            {
+                ctv.write(osgDB::getFilePath(fileNameOut), batchMode ? &_writtenImages : 0);
+            }
+        }
+
+        // scrub normals
+        if ( do_overallNormal )
+        {
+            DefaultNormalsGeometryVisitor dngv;
+            root->accept( dngv );
+        }
+
+        // apply any user-specified simplification
+        if ( do_simplify )
+        {
+            osgUtil::Simplifier simple;
+            simple.setSmoothing( smooth );
+            if (!batchMode) osg::notify( osg::ALWAYS ) << " smoothing: " << smooth << std::endl;
+            simple.setSampleRatio( simplifyPercent );
+            root->accept( simple );
+        }
+
+        osgDB::ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeNode(*root,fileNameOut,osgDB::Registry::instance()->getOptions());
+
+        if (lockTextures) _textureMutex.unlock();
+
+        if (result.success())
+        {
+            osg::notify(batchMode ? osg::INFO : osg::NOTICE)<<"Data written to '"<<fileNameOut<<"'."<< std::endl;
+        }
+        else if  (result.message().empty())
+        {
+            osg::notify(osg::NOTICE)<<"Warning: file write to '"<<fileNameOut<<"' not supported."<< std::endl;
+        }
+        else
+        {
+            osg::notify(osg::NOTICE)<<result.message()<< std::endl;
+        }
+        return result.success();
+    }
+
+    OrientationConverter&                           _oc;
+    bool                                            do_convert;
+    bool                                            pruneStateSet;
+    FixTransparencyVisitor::FixTransparencyMode     fixTransparencyMode;
+    osg::Texture::InternalFormatMode                internalFormatMode;
+    bool                                            smooth;
+    bool                                            addMissingColours;
+    bool                                            do_overallNormal;
+    bool                                            do_simplify;
+    float                                           simplifyPercent;
+    bool                                            batchMode;
+
+protected:
+
+    OpenThreads::Mutex                              _textureMutex;
+    std::set<std::string>                           _writtenImages;
+};
+
+/** Converts each file of a list to its own output file, sharing the Registry and its object cache between the worker threads.*/
+class BatchConversion
+{
+public:
+
+    BatchConversion(SceneConverter& converter, const FileNameList& fileNames, const std::string& outputExtension, const std::string& outputDirectory):
+        _converter(converter),
+        _fileNames(fileNames),
+        _outputExtension(outputExtension),
+        _outputDirectory(outputDirectory) {}
+
+    std::string getOutputFileName(const std::string& fileName) const
+    {
+        if (_outputDirectory.empty()) return osgDB::getNameLessExtension(fileName)+"."+_outputExtension;
+        else return osgDB::concatPaths(_outputDirectory, osgDB::getStrippedName(fileName)+"."+_outputExtension);
+    }
+
+    void convertFiles()
+    {
+        for(unsigned int i = (++_nextFile)-1; i<_fileNames.size(); i = (++_nextFile)-1)
+        {
+            const std::string& fileName = _fileNames[i];
+            std::string fileNameOut = getOutputFileName(fileName);
+            if (fileNameOut==fileName)
+            {
+                osg::notify(osg::NOTICE)<<"Warning: skipping '"<<fileName<<"' as it would be overwritten by its own output."<<std::endl;
+                ++_numFailed;
+                continue;
+            }
+
+            osg::ref_ptr<osg::Node> root = osgDB::readRefNodeFile(fileName);
+            if (root.valid() && _converter.convert(root, fileNameOut))
+            {
+                ++_numConverted;
+            }
+            else
+            {
+                if (!root) osg::notify(osg::NOTICE)<<"Error no data loaded from '"<<fileName<<"'."<< std::endl;
+                ++_numFailed;
+            }
+
+            // expire cached images no longer used by the scenes being converted, so memory use stays bounded on long runs.
+            if ((i%64)==63) expireCachedObjects();
+        }
+    }
+
+    void expireCachedObjects()
+    {
+        osg::ref_ptr<osg::FrameStamp> frameStamp = new osg::FrameStamp;
+        frameStamp->setReferenceTime(_elapsedTime.elapsedTime());
+        osgDB::Registry::instance()->updateTimeStampOfObjectsInCacheWithExternalReferences(*frameStamp);
+        osgDB::Registry::instance()->removeExpiredObjectsInCache(*frameStamp);
+    }
+
+    /** convert all the files using numThreads threads, returning true if all the files were converted.*/
+    bool run(unsigned int numThreads)
+    {
+        osg::notify(osg::NOTICE)<<"Converting "<<_fileNames.size()<<" files using "<<numThreads<<" threads."<<std::endl;
+
+        _elapsedTime.reset();
+
+        // the calling thread does a share of the work itself.
+        std::vector<BatchConvertThread*> threads;
+        for(unsigned int i=1; i<numThreads; ++i)
+        {
+            threads.push_back(new BatchConvertThread(*this));
+            threads.back()->startThread();
+        }
+
+        convertFiles();
+
+        for(std::vector<BatchConvertThread*>::iterator itr = threads.begin(); itr != threads.end(); ++itr)
+        {
+            (*itr)->join();
+            delete *itr;
+        }
+
+        double time = _elapsedTime.elapsedTime();
+        osg::notify(osg::NOTICE)<<"Converted "<<_numConverted<<" files, "<<_numFailed<<" failed, in "<<time<<" seconds";
+        if (time>0.0) osg::notify(osg::NOTICE)<<" ("<<double(_numConverted)/time<<" files per second)";
+        osg::notify(osg::NOTICE)<<"."<<std::endl;
+
+        return _numFailed==0;
+    }
+
+protected:
+
+    class BatchConvertThread : public OpenThreads::Thread
+    {
+    public:
+        BatchConvertThread(BatchConversion& batch): _batch(batch) {}
+        virtual void run() { _batch.convertFiles(); }
+        BatchConversion& _batch;
+    };
+
+    SceneConverter&         _converter;
+    const FileNameList&     _fileNames;
+    std::string             _outputExtension;
+    std::string             _outputDirectory;
+
+    osg::ElapsedTime        _elapsedTime;
+    OpenThreads::Atomic     _nextFile;
+    OpenThreads::Atomic     _numConverted;
+    OpenThreads::Atomic     _numFailed;
+};
+
+/** read a list of file names, one per line, ignoring empty lines and lines starting with '#'.*/
+static bool readFileList(const std::string& fileListName, FileNameList& fileNames)
+{
+    osgDB::ifstream fin(fileListName.c_str());
+    if (!fin) return false;
+
+    std::string line;
+    while(std::getline(fin, line))
+    {
+        std::string::size_type start = line.find_first_not_of(" \t\r");
+        if (start==std::string::npos || line[start]=='#') continue;
+        std::string::size_type end = line.find_last_not_of(" \t\r");
+        fileNames.push_back(line.substr(start, end-start+1));
+    }
+    return true;
+}
+
+
 static void usage( const char *prog, const char *msg )
 {
     if (msg)
@@ -517,6 +780,19 @@ static void usage( const char *prog, const char *msg )
                               "                         (--addMissingColours also accepted)."<< std::endl;
     osg::notify(osg::NOTICE)<<"    --overallNormal    - Replace normals with a single overall normal."<< std::endl;
     osg::notify(osg::NOTICE)<<"    --enable-object-cache - Enable caching of objects, images, etc."<< std::endl;
+    osg::notify(osg::NOTICE)<< std::endl;
+    osg::notify(osg::NOTICE)<<"    --batch ext        - Convert each input file to its own output file with the\n"
+                              "                         extension ext, rather than combining all the inputs into\n"
+                              "                         a single output file. The files are converted in parallel\n"
+                              "                         and share one object cache, so that external images\n"
+                              "                         referenced by several files are only read once.\n"
+                              "                         Input file names may contain '*' wildcards.\n"
+                              "                         Example: --batch osgb \"tiles/*.ive\""<< std::endl;
+    osg::notify(osg::NOTICE)<<"    --file-list file   - Read the input file names, one per line, from file."<< std::endl;
+    osg::notify(osg::NOTICE)<<"    --output-dir dir   - Write the batch output files and compressed textures to dir,\n"
+                              "                         defaults to the directory of each input file."<< std::endl;
+    osg::notify(osg::NOTICE)<<"    --threads n        - Number of threads to use in batch mode, defaults to the\n"
+                              "                         number of processors."<< std::endl;
 
     osg::notify( osg::NOTICE ) << std::endl;
     osg::notify( osg::NOTICE ) <<
@@ -609,7 +885,7 @@ int main( int argc, char **argv )
 
     FileNameList fileNames;
     OrientationConverter oc;
-    bool do_convert = false;
+    SceneConverter converter(oc);
 
     if (arguments.read("--use-world-frame"))
     {
@@ -662,13 +938,13 @@ int main( int argc, char **argv )
             else
             {
                 oc.setRotation( degrees, axis );
-                do_convert = true;
+                converter.do_convert = true;
             }
         }
         else
         {
             oc.setRotation( from, to );
-            do_convert = true;
+            converter.do_convert = true;
         }
     }
 
@@ -682,11 +958,9 @@ int main( int argc, char **argv )
             return 1;
         }
         oc.setScale( scale );
-        do_convert = true;
+        converter.do_convert = true;
     }
 
-    float simplifyPercent = 1.0;
-    bool do_simplify = false;
     while ( arguments.read( "--simplify",str ) )
     {
         float nsimp = 1.0;
@@ -697,9 +971,9 @@ int main( int argc, char **argv )
             return 1;
         }
         std::cout << str << " " << nsimp << std::endl;
-        simplifyPercent = nsimp;
-        osg::notify( osg::INFO ) << "Simplifying with percentage: " << simplifyPercent << std::endl;
-        do_simplify = true;
+        converter.simplifyPercent = nsimp;
+        osg::notify( osg::INFO ) << "Simplifying with percentage: " << converter.simplifyPercent << std::endl;
+        converter.do_simplify = true;
     }
 
     while (arguments.read("-t",str))
@@ -712,41 +986,55 @@ int main( int argc, char **argv )
             return 1;
         }
         oc.setTranslation( trans );
-        do_convert = true;
+        converter.do_convert = true;
     }
 
 
-    FixTransparencyVisitor::FixTransparencyMode fixTransparencyMode = FixTransparencyVisitor::NO_TRANSPARANCY_FIXING;
     std::string fixString;
-    while(arguments.read("--fix-transparency")) fixTransparencyMode = FixTransparencyVisitor::MAKE_OPAQUE_TEXTURE_STATESET_OPAQUE;
+    while(arguments.read("--fix-transparency")) converter.fixTransparencyMode = FixTransparencyVisitor::MAKE_OPAQUE_TEXTURE_STATESET_OPAQUE;
     while(arguments.read("--fix-transparency-mode",fixString))
     {
-         if (fixString=="MAKE_OPAQUE_TEXTURE_STATESET_OPAQUE") fixTransparencyMode = FixTransparencyVisitor::MAKE_OPAQUE_TEXTURE_STATESET_OPAQUE;
-         if (fixString=="MAKE_ALL_STATESET_OPAQUE") fixTransparencyMode = FixTransparencyVisitor::MAKE_ALL_STATESET_OPAQUE;
+         if (fixString=="MAKE_OPAQUE_TEXTURE_STATESET_OPAQUE") converter.fixTransparencyMode = FixTransparencyVisitor::MAKE_OPAQUE_TEXTURE_STATESET_OPAQUE;
+         if (fixString=="MAKE_ALL_STATESET_OPAQUE") converter.fixTransparencyMode = FixTransparencyVisitor::MAKE_ALL_STATESET_OPAQUE;
     };
 
-    bool pruneStateSet = false;
-    while(arguments.read("--prune-StateSet")) pruneStateSet = true;
+    while(arguments.read("--prune-StateSet")) converter.pruneStateSet = true;
 
-    osg::Texture::InternalFormatMode internalFormatMode = osg::Texture::USE_IMAGE_DATA_FORMAT;
-    while(arguments.read("--compressed") || arguments.read("--compressed-arb")) { internalFormatMode = osg::Texture::USE_ARB_COMPRESSION; }
+    while(arguments.read("--compressed") || arguments.read("--compressed-arb")) { converter.internalFormatMode = osg::Texture::USE_ARB_COMPRESSION; }
 
-    while(arguments.read("--compressed-dxt1")) { internalFormatMode = osg::Texture::USE_S3TC_DXT1_COMPRESSION; }
-    while(arguments.read("--compressed-dxt3")) { internalFormatMode = osg::Texture::USE_S3TC_DXT3_COMPRESSION; }
-    while(arguments.read("--compressed-dxt5")) { internalFormatMode = osg::Texture::USE_S3TC_DXT5_COMPRESSION; }
+    while(arguments.read("--compressed-dxt1")) { converter.internalFormatMode = osg::Texture::USE_S3TC_DXT1_COMPRESSION; }
+    while(arguments.read("--compressed-dxt3")) { converter.internalFormatMode = osg::Texture::USE_S3TC_DXT3_COMPRESSION; }
+    while(arguments.read("--compressed-dxt5")) { converter.internalFormatMode = osg::Texture::USE_S3TC_DXT5_COMPRESSION; }
 
-    bool smooth = false;
-    while(arguments.read("--smooth")) { smooth = true; }
+    while(arguments.read("--smooth")) { converter.smooth = true; }
 
-    bool addMissingColours = false;
-    while(arguments.read("--addMissingColours") || arguments.read("--addMissingColors")) { addMissingColours = true; }
+    while(arguments.read("--addMissingColours") || arguments.read("--addMissingColors")) { converter.addMissingColours = true; }
 
-    bool do_overallNormal = false;
-    while(arguments.read("--overallNormal")) { do_overallNormal = true; }
+    while(arguments.read("--overallNormal")) { converter.do_overallNormal = true; }
 
     bool enableObjectCache = false;
     while(arguments.read("--enable-object-cache")) { enableObjectCache = true; }
 
+    std::string batchExtension;
+    while(arguments.read("--batch", batchExtension)) {}
+
+    std::string fileListName;
+    while(arguments.read("--file-list", fileListName))
+    {
+        if (!readFileList(fileListName, fileNames))
+        {
+            usage( argv[0], "Unable to read file list." );
+            return 1;
+        }
+    }
+
+    std::string outputDirectory;
+    while(arguments.read("--output-dir", outputDirectory)) {}
+
+    unsigned int numThreads = OpenThreads::GetNumberOfProcessors();
+    while(arguments.read("--threads", numThreads)) {}
+    if (numThreads<1) numThreads = 1;
+
     // any option left unread are converted into errors to write out later.
     arguments.reportRemainingOptionsAsUnrecognized();
 
@@ -761,7 +1049,16 @@ int main( int argc, char **argv )
     {
         if (!arguments.isOption(pos))
         {
-            fileNames.push_back(arguments[pos]);
+            if (!batchExtension.empty() && std::string(arguments[pos]).find('*')!=std::string::npos)
+            {
+                // expand wildcards here as well as the shell to allow lists that would exceed the command line length
+                osgDB::DirectoryContents contents = osgDB::expandWildcardsInFilename(arguments[pos]);
+                fileNames.insert(fileNames.end(), contents.begin(), contents.end());
+            }
+            else
+            {
+                fileNames.push_back(arguments[pos]);
+            }
         }
     }
 
@@ -771,6 +1068,30 @@ int main( int argc, char **argv )
         osgDB::Registry::instance()->getOptions()->setObjectCacheHint(osgDB::Options::CACHE_ALL);
     }
 
+    if (!batchExtension.empty())
+    {
+        if (fileNames.empty())
+        {
+            usage( argv[0], "No input files given for batch conversion." );
+            return 1;
+        }
+
+        // share external images between the files converted, even when the object cache isn't otherwise enabled.
+        if (osgDB::Registry::instance()->getOptions()==0) osgDB::Registry::instance()->setOptions(new osgDB::Options());
+        osgDB::Options* options = osgDB::Registry::instance()->getOptions();
+        options->setObjectCacheHint(static_cast<osgDB::Options::CacheHintOptions>(options->getObjectCacheHint() | osgDB::Options::CACHE_IMAGES));
+
+        if (!outputDirectory.empty() && osgDB::fileType(outputDirectory)!=osgDB::DIRECTORY && !osgDB::makeDirectory(outputDirectory))
+        {
+            osg::notify(osg::NOTICE)<<"Error unable to create output directory '"<<outputDirectory<<"'."<< std::endl;
+            return 1;
+        }
+
+        converter.batchMode = true;
+        BatchConversion batch(converter, fileNames, batchExtension, outputDirectory);
+        return batch.run(numThreads) ? 0 : 1;
+    }
+
     std::string fileNameOut("converted.osg");
     if (fileNames.size()>1)
     {
@@ -789,84 +1110,9 @@ int main( int argc, char **argv )
     }
 
 
-    if (pruneStateSet)
-    {
-        PruneStateSetVisitor pssv;
-        root->accept(pssv);
-    }
-
-    if (fixTransparencyMode != FixTransparencyVisitor::NO_TRANSPARANCY_FIXING)
-    {
-        FixTransparencyVisitor atv(fixTransparencyMode);
-        root->accept(atv);
-    }
-
     if ( root.valid() )
     {
-
-        if (smooth)
-        {
-            osgUtil::SmoothingVisitor sv;
-            root->accept(sv);
-        }
-
-        if (addMissingColours)
-        {
-            AddMissingColoursToGeometryVisitor av;
-            root->accept(av);
-        }
-
-        // optimize the scene graph, remove redundant nodes and state etc.
-        osgUtil::Optimizer optimizer;
-        optimizer.optimize(root.get());
-
-        if( do_convert )
-            root = oc.convert( root.get() );
-
-        if (internalFormatMode != osg::Texture::USE_IMAGE_DATA_FORMAT)
-        {
-            ext = osgDB::getFileExtension(fileNameOut);
-            CompressTexturesVisitor ctv(internalFormatMode);
-            root->accept(ctv);
-            ctv.compress();
-
-            osgDB::ReaderWriter::Options *options = osgDB::Registry::instance()->getOptions();
-            if (ext!="ive" || (options && options->getOptionString().find("noTexturesInIVEFile")!=std::string::npos))
-            {
-                ctv.write(osgDB::getFilePath(fileNameOut));
-            }
-        }
-
-        // scrub normals
-        if ( do_overallNormal )
-        {
-            DefaultNormalsGeometryVisitor dngv;
-            root->accept( dngv );
-        }
-
-        // apply any user-specified simplification
-        if ( do_simplify )
-        {
-            osgUtil::Simplifier simple;
-            simple.setSmoothing( smooth );
-            osg::notify( osg::ALWAYS ) << " smoothing: " << smooth << std::endl;
-            simple.setSampleRatio( simplifyPercent );
-            root->accept( simple );
-        }
-
-        osgDB::ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeNode(*root,fileNameOut,osgDB::Registry::instance()->getOptions());
-        if (result.success())
-        {
-            osg::notify(osg::NOTICE)<<"Data written to '"<<fileNameOut<<"'."<< std::endl;
-        }
-        else if  (result.message().empty())
-        {
-            osg::notify(osg::NOTICE)<<"Warning: file write to '"<<fileNameOut<<"' not supported."<< std::endl;
-        }
-        else
-        {
-            osg::notify(osg::NOTICE)<<result.message()<< std::endl;
-        }
+        converter.convert(root, fileNameOut);
     }
     else
     {
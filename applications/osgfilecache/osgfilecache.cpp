@@ -25,14 +25,22 @@
 #include <osgDB/FileUtils>
 #include <osgDB/FileCache>
 #include <osgDB/FileNameUtils>
+#include <osgDB/fstream>
 
 #include <iostream>
+#include <sstream>
 #include <algorithm>
+#include <deque>
+#include <set>
 
 #include <signal.h>
 #include <stdlib.h>
 
 #include <OpenThreads/Atomic>
+#include <OpenThreads/Thread>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Condition>
+#include <OpenThreads/ScopedLock>
 
 static OpenThreads::Atomic s_ExitApplication;
 static OpenThreads::Atomic s_SigValue;
@@ -66,7 +74,7 @@ struct Extents
         return *this;
     }
 
-    bool intersects(unsigned level, osg::Vec2d& in_min, osg::Vec2d& in_max)
+    bool intersects(unsigned level, const osg::Vec2d& in_min, const osg::Vec2d& in_max) const
     {
         osg::notify(osg::INFO)<<"intersects("<<level<<", min="<<in_min<<" max="<<in_max<<")"<<std::endl;
         osg::notify(osg::INFO)<<"  _maxLevel="<<_maxLevel<<", _min="<<_min<<" _max="<<_max<<std::endl;
@@ -133,34 +141,48 @@ struct Extents
     osg::Vec2d      _max;
 };
 
-class LoadDataVisitor : public osg::NodeVisitor
+typedef std::vector<Extents> ExtentsList;
+
+class TileQueue;
+
+/** A database file to be loaded along with the state of the traversal at the PagedLOD that references it.*/
+struct Tile : public osg::Referenced
 {
-public:
+    Tile(const std::string& filename, unsigned int level, const osg::Matrixd& matrix, osg::EllipsoidModel* em, Tile* parent):
+        _filename(filename),
+        _level(level),
+        _matrix(matrix),
+        _ellipsoidModel(em),
+        _parent(parent)
+    {
+        // the tile's own load counts as outstanding work until it has been completed.
+        ++_numOutstanding;
+    }
 
+    std::string                         _filename;
+    unsigned int                        _level;
+    osg::Matrixd                        _matrix;
+    osg::ref_ptr<osg::EllipsoidModel>   _ellipsoidModel;
+    osg::ref_ptr<Tile>                  _parent;
 
-    LoadDataVisitor():
-        osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN),
-        _currentLevel(0) {}
+    // number of tiles in this tile's subtree, including itself, that haven't yet been completed.
+    OpenThreads::Atomic                 _numOutstanding;
+};
 
-    void setFileCache(osgDB::FileCache* fileCache) { _fileCache = fileCache; }
+class LoadDataVisitor : public osg::NodeVisitor
+{
+public:
 
-    void addExtents(unsigned int maxLevel, double minX, double minY, double maxX, double maxY)
-    {
-        _extentsList.push_back(Extents(maxLevel, minX, minY, maxX, maxY));
-    }
 
-    void addExtents(unsigned int maxLevel)
-    {
-        _extentsList.push_back(Extents(maxLevel, DBL_MAX, DBL_MAX, -DBL_MAX, -DBL_MAX));
-    }
+    LoadDataVisitor(TileQueue& tileQueue, Tile* tile);
 
     void apply(osg::CoordinateSystemNode& cs)
     {
-        _csnStack.push_back(&cs);
+        _emStack.push_back(cs.getEllipsoidModel());
 
         if (!s_ExitApplication) traverse(cs);
 
-        _csnStack.pop_back();
+        _emStack.pop_back();
     }
 
     void apply(osg::Group& group)
@@ -217,172 +239,451 @@ public:
         popMatrix();
     }
 
-    void apply(osg::PagedLOD& plod)
+    void apply(osg::PagedLOD& plod);
+
+    void apply(osg::Geode& geode)
     {
-        if (s_ExitApplication) return;
+        for(unsigned int i=0; i<geode.getNumDrawables(); ++i)
+        {
+            osg::Geometry* geom = geode.getDrawable(i)->asGeometry();
+            if (geom)
+            {
+                osg::Vec3Array* vertices = dynamic_cast<osg::Vec3Array*>(geom->getVertexArray());
+                if (vertices) updateBound(*vertices);
+            }
+        }
+    }
 
-        ++_currentLevel;
+protected:
 
-        initBound();
+    inline void pushMatrix(osg::Matrix& matrix) { _matrixStack.push_back(matrix); }
 
-        // first compute the bounds of this subgraph
-        for(unsigned int i=0; i<plod.getNumFileNames(); ++i)
+    inline void popMatrix() { _matrixStack.pop_back(); }
+
+    void convertXYZToLatLongHeight(osg::EllipsoidModel* em, osg::Vec3d& v)
+    {
+        em->convertXYZToLatLongHeight(v.x(), v.y(), v.z(),
+                                      v.y(), v.x(), v.z());
+
+        v.x() = osg::RadiansToDegrees(v.x());
+        v.y() = osg::RadiansToDegrees(v.y());
+    }
+
+    void initBound()
+    {
+        _min.set(DBL_MAX, DBL_MAX);
+        _max.set(-DBL_MAX, -DBL_MAX);
+    }
+
+    void updateBound(osg::Vec3d& v)
+    {
+        if (v.x() < _min.x()) _min.x() = v.x();
+        if (v.y() < _min.y()) _min.y() = v.y();
+        if (v.x() > _max.x()) _max.x() = v.x();
+        if (v.y() > _max.y()) _max.y() = v.y();
+    }
+
+    void updateBound(osg::Vec3Array& vertices)
+    {
+        // set up matrix
+        osg::Matrix matrix;
+        if (!_matrixStack.empty()) matrix = _matrixStack.back();
+
+        // set up ellipsoid model
+        osg::EllipsoidModel* em = !_emStack.empty() ?  _emStack.back() : 0;
+
+        for(osg::Vec3Array::iterator itr = vertices.begin();
+            itr != vertices.end();
+            ++itr)
         {
-            if (plod.getFileName(i).empty())
-            {
-                traverse(plod);
-            }
+            osg::Vec3d v = osg::Vec3d(*itr) * matrix;
+            if (em) convertXYZToLatLongHeight(em, v);
+
+            updateBound(v);
         }
+    }
+
+    bool intersects();
 
-        if (intersects())
+    typedef std::vector<osg::Matrix>                MatrixStack;
+    typedef std::vector<osg::EllipsoidModel*>       EllipsoidModelStack;
+
+    TileQueue&          _tileQueue;
+    Tile*               _tile;
+
+    unsigned int        _currentLevel;
+    MatrixStack         _matrixStack;
+    EllipsoidModelStack _emStack;
+
+    osg::Vec2d          _min;
+    osg::Vec2d          _max;
+};
+
+/** Loads tiles on a bounded pool of threads, writing them to the FileCache and queuing the PagedLOD children found in
+  * them. Completed work is appended to a manifest so an interrupted run can resume: tiles listed as cached are read
+  * back from the FileCache without checking the server, and subtrees listed as complete aren't visited at all.*/
+class TileQueue
+{
+public:
+
+    TileQueue(osgDB::FileCache* fileCache):
+        _fileCache(fileCache),
+        _numActive(0),
+        _done(false),
+        _numTilesDownloaded(0),
+        _numTilesFromCache(0),
+        _numSubtreesSkipped(0),
+        _numTilesFailed(0) {}
+
+    ~TileQueue()
+    {
+        for(Threads::iterator itr = _threads.begin(); itr != _threads.end(); ++itr)
         {
-            for(unsigned int i=0; i<plod.getNumFileNames(); ++i)
-            {
-                osg::notify(osg::INFO)<<"   filename["<<i<<"] "<<plod.getFileName(i)<<std::endl;
-                if (!plod.getFileName(i).empty())
-                {
-                    std::string filename;
-                    if (!plod.getDatabasePath().empty())
-                    {
-                        filename = plod.getDatabasePath() + plod.getFileName(i);
-                    }
-                    else
-                    {
-                        filename = plod.getFileName(i);
-                    }
+            delete *itr;
+        }
+    }
 
+    void addExtents(unsigned int maxLevel, double minX, double minY, double maxX, double maxY)
+    {
+        _extentsList.push_back(Extents(maxLevel, minX, minY, maxX, maxY));
+    }
+
+    void addExtents(unsigned int maxLevel)
+    {
+        _extentsList.push_back(Extents(maxLevel, DBL_MAX, DBL_MAX, -DBL_MAX, -DBL_MAX));
+    }
 
-                    osg::ref_ptr<osg::Node> node = readNodeFileAndWriteToCache(filename);
+    const ExtentsList& getExtentsList() const { return _extentsList; }
 
-                    if (!s_ExitApplication && node.valid()) node->accept(*this);
-                }
+    /** read the manifest of an earlier run, if any, and open it to record the progress of this run.*/
+    bool openManifest(const std::string& manifestFileName, bool restart)
+    {
+        // completed subtrees are only valid for the same levels and extents.
+        std::string header = createManifestHeader();
+
+        if (!restart && osgDB::fileExists(manifestFileName))
+        {
+            osgDB::ifstream fin(manifestFileName.c_str());
+            std::string line;
+            bool sameExtents = std::getline(fin, line) && line==header;
+            while(std::getline(fin, line))
+            {
+                if (line.size()<3) continue;
+                if (line[0]=='T') _cachedTiles.insert(line.substr(2));
+                else if (line[0]=='S' && sameExtents) _completedSubtrees.insert(line.substr(2));
             }
+
+            std::cout<<"Resuming from manifest "<<manifestFileName<<" : "<<_cachedTiles.size()<<" cached tiles, "<<_completedSubtrees.size()<<" completed subtrees"<<std::endl;
+            if (!sameExtents) std::cout<<"  levels or extents have changed since the manifest was written, so all subtrees will be revisited."<<std::endl;
         }
 
-        --_currentLevel;
+        // rewrite the manifest with the current header, keeping the entries that are still valid.
+        _manifest.open(manifestFileName.c_str(), std::ios::out | std::ios::trunc);
+        if (!_manifest) return false;
+
+        _manifest<<header<<"\n";
+        for(FileNames::iterator itr = _cachedTiles.begin(); itr != _cachedTiles.end(); ++itr) _manifest<<"T "<<*itr<<"\n";
+        for(FileNames::iterator itr = _completedSubtrees.begin(); itr != _completedSubtrees.end(); ++itr) _manifest<<"S "<<*itr<<"\n";
+        _manifest.flush();
+        return true;
     }
 
-    void apply(osg::Geode& geode)
+    /** queue a file referenced by a PagedLOD, unless its whole subtree was completed by an earlier run.*/
+    void add(const std::string& filename, unsigned int level, const osg::Matrixd& matrix, osg::EllipsoidModel* em, Tile* parent)
     {
-        for(unsigned int i=0; i<geode.getNumDrawables(); ++i)
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+        if (_completedSubtrees.count(filename)!=0)
+        {
+            ++_numSubtreesSkipped;
+            return;
+        }
+
+        if (parent) ++(parent->_numOutstanding);
+        _tiles.push_back(new Tile(filename, level, matrix, em, parent));
+        _condition.broadcast();
+    }
+
+    /** load all the queued tiles and their children using numThreads threads, reporting progress every reportInterval seconds.*/
+    void run(unsigned int numThreads, double reportInterval)
+    {
+        for(unsigned int i=0; i<numThreads; ++i)
+        {
+            _threads.push_back(new TileThread(*this));
+            _threads.back()->startThread();
+        }
+
+        osg::ElapsedTime elapsedTime;
+        double nextReport = reportInterval;
+        for(;;)
         {
-            osg::Geometry* geom = geode.getDrawable(i)->asGeometry();
-            if (geom)
             {
-                osg::Vec3Array* vertices = dynamic_cast<osg::Vec3Array*>(geom->getVertexArray());
-                if (vertices) updateBound(*vertices);
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+                if ((_tiles.empty() && _numActive==0) || s_ExitApplication) break;
+                _condition.wait(&_mutex, 100);
+            }
+
+            if (elapsedTime.elapsedTime()>=nextReport)
+            {
+                report(elapsedTime.elapsedTime());
+                nextReport += reportInterval;
             }
         }
+
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+            _done = true;
+            _condition.broadcast();
+        }
+
+        for(Threads::iterator itr = _threads.begin(); itr != _threads.end(); ++itr)
+        {
+            (*itr)->join();
+        }
+
+        report(elapsedTime.elapsedTime());
     }
 
+    unsigned int getNumTilesLoaded() const { return _numTilesDownloaded + _numTilesFromCache; }
+    unsigned int getNumSubtreesSkipped() const { return _numSubtreesSkipped; }
+
     osg::ref_ptr<osg::Node> readNodeFileAndWriteToCache(const std::string& filename)
     {
         osg::ref_ptr<osg::Node> node = 0;
         if (_fileCache.valid() )
         {
-            if (_fileCache->existsInCache(filename))
+            bool cached = isTileCached(filename);
+            if (cached || _fileCache->existsInCache(filename))
             {
-                osg::notify(osg::NOTICE)<<"reading from FileCache: "<<filename<<std::endl;
+                osg::notify(osg::INFO)<<"reading from FileCache: "<<filename<<std::endl;
                 node = _fileCache->readNode(filename, osgDB::Registry::instance()->getOptions()).takeNode();
+
+                // a cached copy that can't be read, perhaps left partially written by an interrupted run, is downloaded again.
+                if (node.valid())
+                {
+                    if (!cached) recordCachedTile(filename);
+                    ++_numTilesFromCache;
+                    return node;
+                }
             }
-            else
+
+            osg::notify(osg::INFO)<<"reading : "<<filename<<std::endl;
+
+            node = osgDB::readRefNodeFile(filename);
+            if (node)
             {
-                osg::notify(osg::NOTICE)<<"reading : "<<filename<<std::endl;
+                osg::notify(osg::INFO)<<"write to FileCache : "<<filename<<std::endl;
 
-                node = osgDB::readRefNodeFile(filename);
-                if (node)
+                if (_fileCache->writeNode(*node, filename, osgDB::Registry::instance()->getOptions()).success())
                 {
-                    osg::notify(osg::NOTICE)<<"write to FileCache : "<<filename<<std::endl;
-
-                    _fileCache->writeNode(*node, filename, osgDB::Registry::instance()->getOptions());
+                    recordCachedTile(filename);
                 }
             }
         }
         else
         {
-            osg::notify(osg::NOTICE)<<"reading : "<<filename<<std::endl;
+            osg::notify(osg::INFO)<<"reading : "<<filename<<std::endl;
             node = osgDB::readRefNodeFile(filename);
         }
+
+        if (node.valid()) ++_numTilesDownloaded;
+        else ++_numTilesFailed;
+
         return node;
     }
 
-
 protected:
 
-    inline void pushMatrix(osg::Matrix& matrix) { _matrixStack.push_back(matrix); }
+    class TileThread : public OpenThreads::Thread
+    {
+    public:
+        TileThread(TileQueue& tileQueue): _tileQueue(tileQueue) {}
 
-    inline void popMatrix() { _matrixStack.pop_back(); }
+        virtual void run()
+        {
+            osg::ref_ptr<Tile> tile;
+            while(_tileQueue.takeNext(tile))
+            {
+                osg::ref_ptr<osg::Node> node = _tileQueue.readNodeFileAndWriteToCache(tile->_filename);
+                if (node.valid() && !s_ExitApplication)
+                {
+                    LoadDataVisitor ldv(_tileQueue, tile.get());
+                    node->accept(ldv);
+                }
 
-    void convertXYZToLatLongHeight(osg::EllipsoidModel* em, osg::Vec3d& v)
+                // an interrupted or failed tile's subtree isn't complete so mustn't be recorded as such.
+                if (node.valid() && !s_ExitApplication) _tileQueue.completed(tile.get());
+
+                _tileQueue.finished();
+            }
+        }
+
+        TileQueue& _tileQueue;
+    };
+
+    bool takeNext(osg::ref_ptr<Tile>& tile)
     {
-        em->convertXYZToLatLongHeight(v.x(), v.y(), v.z(),
-                                      v.y(), v.x(), v.z());
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        while(_tiles.empty())
+        {
+            if (_done || s_ExitApplication) return false;
+            _condition.wait(&_mutex, 100);
+        }
+        if (s_ExitApplication) return false;
 
-        v.x() = osg::RadiansToDegrees(v.x());
-        v.y() = osg::RadiansToDegrees(v.y());
+        tile = _tiles.front();
+        _tiles.pop_front();
+        ++_numActive;
+        return true;
     }
 
-    void initBound()
+    void finished()
     {
-        _min.set(DBL_MAX, DBL_MAX);
-        _max.set(-DBL_MAX, -DBL_MAX);
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        --_numActive;
+        _condition.broadcast();
     }
 
-    void updateBound(osg::Vec3d& v)
+    void completed(Tile* tile)
     {
-        if (v.x() < _min.x()) _min.x() = v.x();
-        if (v.y() < _min.y()) _min.y() = v.y();
-        if (v.x() > _max.x()) _max.x() = v.x();
-        if (v.y() > _max.y()) _max.y() = v.y();
+        // record each subtree once all the tiles in it have been loaded, and pass the completion on to the parent.
+        for(; tile && (--(tile->_numOutstanding))==0; tile = tile->_parent.get())
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+            _manifest<<"S "<<tile->_filename<<"\n";
+            _manifest.flush();
+        }
     }
 
-    void updateBound(osg::Vec3Array& vertices)
+    bool isTileCached(const std::string& filename)
     {
-        // set up matrix
-        osg::Matrix matrix;
-        if (!_matrixStack.empty()) matrix = _matrixStack.back();
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        return _cachedTiles.count(filename)!=0;
+    }
 
-        // set up ellipsoid model
-        osg::EllipsoidModel* em = !_csnStack.empty() ?  _csnStack.back()->getEllipsoidModel() : 0;
+    void recordCachedTile(const std::string& filename)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        _cachedTiles.insert(filename);
+        _manifest<<"T "<<filename<<"\n";
+        _manifest.flush();
+    }
 
-        for(osg::Vec3Array::iterator itr = vertices.begin();
-            itr != vertices.end();
-            ++itr)
+    std::string createManifestHeader() const
+    {
+        std::ostringstream header;
+        header.precision(17);
+        header<<"osgfilecache manifest";
+        for(ExtentsList::const_iterator itr = _extentsList.begin(); itr != _extentsList.end(); ++itr)
         {
-            osg::Vec3d v = osg::Vec3d(*itr) * matrix;
-            if (em) convertXYZToLatLongHeight(em, v);
-
-            updateBound(v);
+            header<<" ["<<itr->_maxLevel<<" "<<itr->_min.x()<<" "<<itr->_min.y()<<" "<<itr->_max.x()<<" "<<itr->_max.y()<<"]";
         }
+        return header.str();
     }
 
-    bool intersects()
+    void report(double time)
     {
-        osg::notify(osg::INFO)<<"intersects() _min = "<<_min<<" _max = "<<_max<<std::endl;
-        for(ExtentsList::iterator itr = _extentsList.begin();
-            itr != _extentsList.end();
-            ++itr)
+        unsigned int numTiles = _numTilesDownloaded + _numTilesFromCache;
+        std::cout<<"tiles downloaded "<<_numTilesDownloaded<<", from cache "<<_numTilesFromCache<<", subtrees skipped "<<_numSubtreesSkipped<<", failed "<<_numTilesFailed;
+        if (time>0.0) std::cout<<", "<<double(numTiles)/time<<" tiles/sec";
+        std::cout<<std::endl;
+    }
+
+    typedef std::deque< osg::ref_ptr<Tile> >    Tiles;
+    typedef std::vector<TileThread*>            Threads;
+    typedef std::set<std::string>               FileNames;
+
+    osg::ref_ptr<osgDB::FileCache>  _fileCache;
+    ExtentsList                     _extentsList;
+
+    OpenThreads::Mutex              _mutex;
+    OpenThreads::Condition          _condition;
+    Tiles                           _tiles;
+    Threads                         _threads;
+    unsigned int                    _numActive;
+    bool                            _done;
+
+    osgDB::ofstream                 _manifest;
+    FileNames                       _cachedTiles;
+    FileNames                       _completedSubtrees;
+
+    OpenThreads::Atomic             _numTilesDownloaded;
+    OpenThreads::Atomic             _numTilesFromCache;
+    OpenThreads::Atomic             _numSubtreesSkipped;
+    OpenThreads::Atomic             _numTilesFailed;
+};
+
+LoadDataVisitor::LoadDataVisitor(TileQueue& tileQueue, Tile* tile):
+    osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN),
+    _tileQueue(tileQueue),
+    _tile(tile),
+    _currentLevel(tile->_level)
+{
+    _matrixStack.push_back(tile->_matrix);
+    if (tile->_ellipsoidModel.valid()) _emStack.push_back(tile->_ellipsoidModel.get());
+}
+
+void LoadDataVisitor::apply(osg::PagedLOD& plod)
+{
+    if (s_ExitApplication) return;
+
+    ++_currentLevel;
+
+    initBound();
+
+    // first compute the bounds of this subgraph
+    for(unsigned int i=0; i<plod.getNumFileNames(); ++i)
+    {
+        if (plod.getFileName(i).empty())
         {
-            if (itr->intersects(_currentLevel, _min, _max)) return true;
+            traverse(plod);
         }
-
-        return false;
     }
 
-    typedef std::vector<Extents>                    ExtentsList;
-    typedef std::vector<osg::Matrix>                MatrixStack;
-    typedef std::vector<osg::CoordinateSystemNode*> CSNStack;
+    if (intersects())
+    {
+        osg::Matrix matrix;
+        if (!_matrixStack.empty()) matrix = _matrixStack.back();
 
-    osg::ref_ptr<osgDB::FileCache>  _fileCache;
+        osg::EllipsoidModel* em = !_emStack.empty() ?  _emStack.back() : 0;
+
+        for(unsigned int i=0; i<plod.getNumFileNames(); ++i)
+        {
+            osg::notify(osg::INFO)<<"   filename["<<i<<"] "<<plod.getFileName(i)<<std::endl;
+            if (!plod.getFileName(i).empty())
+            {
+                std::string filename;
+                if (!plod.getDatabasePath().empty())
+                {
+                    filename = plod.getDatabasePath() + plod.getFileName(i);
+                }
+                else
+                {
+                    filename = plod.getFileName(i);
+                }
 
-    ExtentsList     _extentsList;
-    unsigned int    _currentLevel;
-    MatrixStack     _matrixStack;
-    CSNStack        _csnStack;
+                // the children are loaded and traversed by the TileQueue's threads.
+                _tileQueue.add(filename, _currentLevel, matrix, em, _tile);
+            }
+        }
+    }
 
-    osg::Vec2d      _min;
-    osg::Vec2d      _max;
-};
+    --_currentLevel;
+}
+
+bool LoadDataVisitor::intersects()
+{
+    osg::notify(osg::INFO)<<"intersects() _min = "<<_min<<" _max = "<<_max<<std::endl;
+    const ExtentsList& extentsList = _tileQueue.getExtentsList();
+    for(ExtentsList::const_iterator itr = extentsList.begin();
+        itr != extentsList.end();
+        ++itr)
+    {
+        if (itr->intersects(_currentLevel, _min, _max)) return true;
+    }
+
+    return false;
+}
 
 static void signalHandler(int sig)
 {
@@ -415,6 +716,10 @@ int main( int argc, char **argv )
     arguments.getApplicationUsage()->addCommandLineOption("-e level minX minY maxX maxY","Read down to <level> across the extents minX, minY to maxY, maxY.  Note, for geocentric datase X and Y are longitude and latitude respectively.");
     arguments.getApplicationUsage()->addCommandLineOption("-c directory","Shorthand for --file-cache directory.");
     arguments.getApplicationUsage()->addCommandLineOption("--file-cache directory","Set directory as to place cache download files.");
+    arguments.getApplicationUsage()->addCommandLineOption("--threads n","Number of threads used to load tiles, defaults to 4.");
+    arguments.getApplicationUsage()->addCommandLineOption("--manifest filename","Manifest used to record progress so an interrupted run can be resumed, defaults to osgfilecache.manifest in the file cache directory.");
+    arguments.getApplicationUsage()->addCommandLineOption("--restart","Ignore the progress recorded in the manifest by earlier runs.");
+    arguments.getApplicationUsage()->addCommandLineOption("--report-interval seconds","Interval between progress reports, defaults to 10 seconds.");
 
     // if user request help write it out to cout.
     if (arguments.read("-h") || arguments.read("--help"))
@@ -423,8 +728,6 @@ int main( int argc, char **argv )
         return 1;
     }
 
-    LoadDataVisitor ldv;
-
     std::string fileCachePath;
     while(arguments.read("--file-cache",fileCachePath) || arguments.read("-c",fileCachePath)) {}
 
@@ -443,20 +746,32 @@ int main( int argc, char **argv )
         return 1;
     }
 
-    ldv.setFileCache(new osgDB::FileCache(fileCachePath));
+    TileQueue tileQueue(new osgDB::FileCache(fileCachePath));
 
     unsigned int maxLevels = 0;
     while(arguments.read("-l",maxLevels))
     {
-        ldv.addExtents(maxLevels);
+        tileQueue.addExtents(maxLevels);
     }
 
     double minX, maxX, minY, maxY;
     while(arguments.read("-e",maxLevels, minX, minY, maxX, maxY))
     {
-        ldv.addExtents(maxLevels, minX, minY, maxX, maxY);
+        tileQueue.addExtents(maxLevels, minX, minY, maxX, maxY);
     }
 
+    unsigned int numThreads = 4;
+    while(arguments.read("--threads",numThreads)) {}
+    if (numThreads<1) numThreads = 1;
+
+    std::string manifestFileName = osgDB::concatPaths(fileCachePath, "osgfilecache.manifest");
+    while(arguments.read("--manifest",manifestFileName)) {}
+
+    bool restart = false;
+    while(arguments.read("--restart")) { restart = true; }
+
+    double reportInterval = 10.0;
+    while(arguments.read("--report-interval",reportInterval)) {}
 
     std::string filename;
     for(int i=1; i<arguments.argc(); ++i)
@@ -474,21 +789,31 @@ int main( int argc, char **argv )
         return 1;
     }
 
-    osg::ref_ptr<osg::Node> loadedModel = ldv.readNodeFileAndWriteToCache(filename);
-    if (!loadedModel)
+    if (!osgDB::fileExists(osgDB::getFilePath(manifestFileName)) && !osgDB::makeDirectory(osgDB::getFilePath(manifestFileName)))
     {
-        std::cout<<"No data loaded, please specify a database to load"<<std::endl;
+        std::cout<<"Unable to create directory for manifest "<<manifestFileName<<std::endl;
         return 1;
     }
 
+    if (!tileQueue.openManifest(manifestFileName, restart))
+    {
+        std::cout<<"Unable to open manifest "<<manifestFileName<<std::endl;
+        return 1;
+    }
 
-    loadedModel->accept(ldv);
+    tileQueue.add(filename, 0, osg::Matrixd::identity(), 0, 0);
+    tileQueue.run(numThreads, reportInterval);
+
+    if (tileQueue.getNumTilesLoaded()==0 && tileQueue.getNumSubtreesSkipped()==0 && !s_ExitApplication)
+    {
+        std::cout<<"No data loaded, please specify a database to load"<<std::endl;
+        return 1;
+    }
 
     if (s_ExitApplication)
     {
-        std::cout<<"osgfilecache exited in response to signal : "<<s_SigValue<<std::endl;
+        std::cout<<"osgfilecache exited in response to signal : "<<s_SigValue<<", rerun with the same arguments to resume."<<std::endl;
     }
 
     return 0;
 }
-
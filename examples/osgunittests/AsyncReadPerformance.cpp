@@ -0,0 +1,98 @@
+/* OpenSceneGraph example, osgunittests.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include "AsyncReadPerformance.h"
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/Timer>
+#include <osgDB/AsyncReader>
+#include <osgDB/ReadFile>
+#include <osgDB/WriteFile>
+
+#include <OpenThreads/Atomic>
+
+#include <iostream>
+#include <sstream>
+#include <stdio.h>
+
+struct CountCompletedCallback : public osgDB::AsyncReader::CompletionCallback
+{
+    virtual void completed(osgDB::AsyncReader::Request* request)
+    {
+        if (request->getNode()) ++_numLoaded;
+    }
+
+    OpenThreads::Atomic _numLoaded;
+};
+
+void runAsyncReadPerformanceTests(unsigned int numFiles)
+{
+    std::cout<<"**** osgDB::AsyncReader performance tests ******"<<std::endl;
+
+    std::vector<std::string> filenames;
+    for(unsigned int i=0; i<numFiles; ++i)
+    {
+        osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+        osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array(20000);
+        for(unsigned int v=0; v<vertices->size(); ++v) (*vertices)[v].set(float(i), float(v), 0.0f);
+        geometry->setVertexArray(vertices.get());
+        geometry->addPrimitiveSet(new osg::DrawArrays(GL_POINTS, 0, vertices->size()));
+
+        osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+        geode->addDrawable(geometry.get());
+
+        std::ostringstream filename;
+        filename<<"osgunittests_async_read_"<<i<<".osgb";
+        if (osgDB::writeNodeFile(*geode, filename.str())) filenames.push_back(filename.str());
+    }
+
+    osg::ref_ptr<osgDB::Options> options = new osgDB::Options;
+    options->setObjectCacheHint(osgDB::Options::CACHE_NONE);
+
+    osg::ElapsedTime elapsedTime;
+    unsigned int numLoaded = 0;
+    for(std::vector<std::string>::iterator itr = filenames.begin(); itr != filenames.end(); ++itr)
+    {
+        if (osgDB::readRefNodeFile(*itr, options.get()).valid()) ++numLoaded;
+    }
+    std::cout<<"    synchronous reads of "<<filenames.size()<<" files : "<<elapsedTime.elapsedTime_m()<<"ms, "<<numLoaded<<" loaded"<<std::endl;
+
+    osg::ref_ptr<osgDB::AsyncReader> reader = new osgDB::AsyncReader;
+    osg::ref_ptr<CountCompletedCallback> callback = new CountCompletedCallback;
+
+    elapsedTime.reset();
+    std::vector< osg::ref_ptr<osgDB::AsyncReader::Request> > requests;
+    for(unsigned int i=0; i<filenames.size(); ++i)
+    {
+        // request every file twice to exercise merging of duplicate requests
+        requests.push_back(reader->readNode(filenames[i], options.get(), float(i), callback.get()));
+        requests.push_back(reader->readNode(filenames[i], options.get(), float(i)));
+    }
+    for(unsigned int i=0; i<requests.size(); ++i)
+    {
+        requests[i]->block();
+    }
+    std::cout<<"    AsyncReader reads with "<<reader->getNumThreads()<<" threads : "<<elapsedTime.elapsedTime_m()<<"ms, "
+             <<static_cast<unsigned int>(callback->_numLoaded)<<" loaded"<<std::endl;
+
+    for(std::vector<std::string>::iterator itr = filenames.begin(); itr != filenames.end(); ++itr)
+    {
+        remove(itr->c_str());
+    }
+}
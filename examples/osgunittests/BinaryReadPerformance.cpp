@@ -0,0 +1,186 @@
+/* OpenSceneGraph example, osgunittests.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include "BinaryReadPerformance.h"
+
+#include <osg/CopyOp>
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/Timer>
+#include <osgDB/ReadFile>
+#include <osgDB/WriteFile>
+#include <osgDB/Options>
+#include <osgDB/FileUtils>
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static osg::Node* createLargeGeometry(unsigned int numVertices)
+{
+    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array(numVertices);
+    osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array(numVertices);
+    osg::ref_ptr<osg::Vec2Array> texcoords = new osg::Vec2Array(numVertices);
+    osg::ref_ptr<osg::Vec4ubArray> colors = new osg::Vec4ubArray(numVertices);
+    osg::ref_ptr<osg::DrawElementsUInt> triangles = new osg::DrawElementsUInt(GL_TRIANGLES, numVertices);
+
+    for(unsigned int i=0; i<numVertices; ++i)
+    {
+        float f = float(rand())/float(RAND_MAX);
+        (*vertices)[i].set(f*100.0f, float(i), -f);
+        (*normals)[i].set(0.0f, f, 1.0f-f);
+        (*texcoords)[i].set(f, 1.0f-f);
+        (*colors)[i].set(i&0xff, (i>>8)&0xff, (i>>16)&0xff, 255);
+        (*triangles)[i] = numVertices-i-1;
+    }
+
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setVertexArray(vertices.get());
+    geometry->setNormalArray(normals.get(), osg::Array::BIND_PER_VERTEX);
+    geometry->setTexCoordArray(0, texcoords.get());
+    geometry->setColorArray(colors.get(), osg::Array::BIND_PER_VERTEX);
+    geometry->addPrimitiveSet(triangles.get());
+
+    osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+    geode->addDrawable(geometry.get());
+    return geode.release();
+}
+
+static bool sameData(const osg::Array* lhs, const osg::Array* rhs)
+{
+    return lhs && rhs && lhs->getType()==rhs->getType() &&
+           lhs->getTotalDataSize()==rhs->getTotalDataSize() &&
+           memcmp(lhs->getDataPointer(), rhs->getDataPointer(), lhs->getTotalDataSize())==0;
+}
+
+static bool matches(const osg::Node* original, const osg::Node* loaded)
+{
+    const osg::Geode* originalGeode = original ? original->asGeode() : 0;
+    const osg::Geode* loadedGeode = loaded ? loaded->asGeode() : 0;
+    if (!originalGeode || !loadedGeode || loadedGeode->getNumDrawables()!=1) return false;
+
+    const osg::Geometry* lhs = originalGeode->getDrawable(0)->asGeometry();
+    const osg::Geometry* rhs = loadedGeode->getDrawable(0)->asGeometry();
+    if (!lhs || !rhs || rhs->getNumPrimitiveSets()!=1) return false;
+
+    return sameData(lhs->getVertexArray(), rhs->getVertexArray()) &&
+           sameData(lhs->getNormalArray(), rhs->getNormalArray()) &&
+           sameData(lhs->getTexCoordArray(0), rhs->getTexCoordArray(0)) &&
+           sameData(lhs->getColorArray(), rhs->getColorArray()) &&
+           lhs->getPrimitiveSet(0)->getNumIndices()==rhs->getPrimitiveSet(0)->getNumIndices() &&
+           lhs->getPrimitiveSet(0)->index(0)==rhs->getPrimitiveSet(0)->index(0);
+}
+
+static void timeRead(const std::string& filename, const osg::Node* original, const std::string& optionString, const char* description)
+{
+    osg::ref_ptr<osgDB::Options> options = new osgDB::Options(optionString);
+    options->setObjectCacheHint(osgDB::Options::CACHE_NONE);
+
+    const unsigned int numRuns = 5;
+    double bestTime = 0.0;
+    bool ok = true;
+    for(unsigned int i=0; i<numRuns; ++i)
+    {
+        osg::ElapsedTime elapsedTime;
+        osg::ref_ptr<osg::Node> node = osgDB::readRefNodeFile(filename, options.get());
+        double t = elapsedTime.elapsedTime_m();
+
+        if (i==0 || t<bestTime) bestTime = t;
+        ok = ok && matches(original, node.get());
+    }
+
+    std::cout<<"    "<<description<<" : "<<bestTime<<"ms"<<(ok ? "" : "  DATA MISMATCH")<<std::endl;
+}
+
+static void runDeduplicationTest(const osg::Node* node, const std::string& filename)
+{
+    // deep copies share no pointers with the original, so only content deduplication can share them.
+    const unsigned int numCopies = 8;
+    osg::ref_ptr<osg::Group> group = new osg::Group;
+    for(unsigned int i=0; i<numCopies; ++i)
+    {
+        group->addChild(static_cast<osg::Node*>(node->clone(osg::CopyOp::DEEP_COPY_ALL)));
+    }
+
+    const char* optionStrings[] = { "", "DeduplicateContent" };
+    for(unsigned int i=0; i<2; ++i)
+    {
+        osg::ref_ptr<osgDB::Options> options = new osgDB::Options(optionStrings[i]);
+        osg::ElapsedTime elapsedTime;
+        if (!osgDB::writeNodeFile(*group, filename, options.get())) continue;
+        double writeTime = elapsedTime.elapsedTime_m();
+
+        osgDB::ifstream fin(filename.c_str(), std::ios::in|std::ios::binary);
+        fin.seekg(0, std::ios::end);
+        std::streamoff fileSize = fin.tellg();
+        fin.close();
+
+        osg::ref_ptr<osg::Group> loaded = dynamic_cast<osg::Group*>(osgDB::readRefNodeFile(filename).get());
+        bool ok = loaded.valid() && loaded->getNumChildren()==numCopies;
+        for(unsigned int c=0; ok && c<numCopies; ++c)
+        {
+            ok = matches(node, loaded->getChild(c));
+        }
+
+        std::cout<<"    "<<numCopies<<" deep copies"<<(i==0 ? "" : ", deduplicated")<<" : "<<fileSize<<" bytes, written in "<<writeTime<<"ms"
+                 <<(ok ? "" : "  DATA MISMATCH")<<std::endl;
+
+        remove(filename.c_str());
+    }
+}
+
+void runBinaryReadPerformanceTests(unsigned int numVertices)
+{
+    std::cout<<"**** osgb binary read performance tests ******"<<std::endl;
+
+    srand(1);
+    osg::ref_ptr<osg::Node> node = createLargeGeometry(numVertices);
+
+    std::string filename("osgunittests_binary_read.osgb");
+    if (!osgDB::writeNodeFile(*node, filename))
+    {
+        std::cout<<"    Unable to write "<<filename<<", test aborted."<<std::endl;
+        return;
+    }
+
+    std::cout<<"    Reading "<<numVertices<<" vertices, best of 5 runs"<<std::endl;
+    timeRead(filename, node.get(), "", "streamed from file");
+    timeRead(filename, node.get(), "PreloadFile", "preloaded into memory");
+
+    remove(filename.c_str());
+
+    const char* compressors[] = { "zlib", "chunkedzlib" };
+    for(unsigned int i=0; i<sizeof(compressors)/sizeof(compressors[0]); ++i)
+    {
+        osg::ref_ptr<osgDB::Options> writeOptions = new osgDB::Options(std::string("Compressor=")+compressors[i]);
+        osg::ElapsedTime elapsedTime;
+        if (!osgDB::writeNodeFile(*node, filename, writeOptions.get()))
+        {
+            std::cout<<"    Unable to write "<<filename<<" with compressor "<<compressors[i]<<std::endl;
+            continue;
+        }
+        std::cout<<"    "<<compressors[i]<<" compressed write : "<<elapsedTime.elapsedTime_m()<<"ms"<<std::endl;
+
+        timeRead(filename, node.get(), "", (std::string(compressors[i])+" compressed").c_str());
+
+        remove(filename.c_str());
+    }
+
+    runDeduplicationTest(node.get(), filename);
+}
@@ -0,0 +1,125 @@
+/* OpenSceneGraph example, osgunittests.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include "DatabasePagerPerformance.h"
+
+#include <osg/Timer>
+#include <osgDB/DatabasePager>
+
+#include <iostream>
+#include <stdlib.h>
+
+// DatabasePager subclass to get at the protected RequestQueue so that its dequeue cost
+// can be measured in isolation from the reading threads.
+class RequestQueueBenchmark : public osgDB::DatabasePager
+{
+public:
+
+    void run(unsigned int queueDepth, unsigned int numTakes)
+    {
+        osg::ref_ptr<RequestQueue> queue = new RequestQueue(this);
+
+        srand(queueDepth);
+        for(unsigned int i=0; i<queueDepth; ++i)
+        {
+            queue->add(createRequest());
+        }
+
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+        unsigned int numTaken = 0;
+        double previousTimestamp = 1.0;
+        float previousPriority = 1.0f;
+        bool ordered = true;
+        for(unsigned int i=0; i<numTakes; ++i)
+        {
+            osg::ref_ptr<DatabaseRequest> databaseRequest;
+            queue->takeFirst(databaseRequest);
+            if (!databaseRequest) break;
+
+            if (databaseRequest->_timestampLastRequest>previousTimestamp ||
+                (databaseRequest->_timestampLastRequest==previousTimestamp && databaseRequest->_priorityLastRequest>previousPriority))
+            {
+                ordered = false;
+            }
+            previousTimestamp = databaseRequest->_timestampLastRequest;
+            previousPriority = databaseRequest->_priorityLastRequest;
+
+            ++numTaken;
+        }
+
+        osg::Timer_t takeTick = osg::Timer::instance()->tick();
+
+        // re-request every entry with a new priority as the cull traversal does each frame.
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(queue->_requestMutex);
+            OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_dr_mutex);
+            for(RequestQueue::RequestHeap::iterator itr = queue->_requestHeap.begin();
+                itr != queue->_requestHeap.end();
+                ++itr)
+            {
+                itr->_request->_priorityLastRequest = randomValue();
+                queue->priorityChanged(itr->_request.get());
+            }
+        }
+
+        osg::Timer_t updateTick = osg::Timer::instance()->tick();
+
+        osg::ref_ptr<DatabaseRequest> databaseRequest;
+        queue->takeFirst(databaseRequest);
+
+        osg::Timer_t endTick = osg::Timer::instance()->tick();
+
+        std::cout<<"  queue depth "<<queueDepth
+                 <<"\ttakeFirst() "<<osg::Timer::instance()->delta_u(startTick, takeTick)/double(numTaken>0 ? numTaken : 1)<<" us"
+                 <<"\tre-prioritise all "<<osg::Timer::instance()->delta_u(takeTick, updateTick)<<" us"
+                 <<"\ttakeFirst() after re-prioritise "<<osg::Timer::instance()->delta_u(updateTick, endTick)<<" us"
+                 <<(ordered ? "" : "\tERROR: requests not taken in priority order")<<std::endl;
+
+        queue->clear();
+    }
+
+protected:
+
+    float randomValue() const { return float(rand())/float(RAND_MAX); }
+
+    DatabaseRequest* createRequest()
+    {
+        DatabaseRequest* databaseRequest = new DatabaseRequest;
+        databaseRequest->_valid = true;
+        databaseRequest->_frameNumberFirstRequest = _frameNumber;
+        databaseRequest->_frameNumberLastRequest = _frameNumber;
+        // only a handful of distinct time stamps so that the priority ordering gets exercised too
+        databaseRequest->_timestampLastRequest = double(rand()%4)*0.25;
+        databaseRequest->_priorityLastRequest = randomValue();
+        return databaseRequest;
+    }
+};
+
+void runDatabasePagerQueueTests()
+{
+    std::cout<<"**** DatabasePager request queue performance tests  ******"<<std::endl;
+
+    osg::ref_ptr<RequestQueueBenchmark> benchmark = new RequestQueueBenchmark;
+    for(unsigned int queueDepth = 100; queueDepth<=100000; queueDepth *= 10)
+    {
+        benchmark->run(queueDepth, queueDepth/10);
+    }
+
+    std::cout<<std::endl;
+}
@@ -0,0 +1,109 @@
+/* OpenSceneGraph example, osgunittests.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include "FileCachePerformance.h"
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/Timer>
+#include <osgDB/FileCache>
+#include <osgDB/FileUtils>
+
+#include <iostream>
+#include <sstream>
+
+// stands in for a remote server, the FileCache only needs the file names to contain a server address.
+static std::string createServerFileName(unsigned int i)
+{
+    std::ostringstream fileName;
+    fileName<<"http://osgunittests.server/tiles/tile_"<<i<<".osgb";
+    return fileName.str();
+}
+
+static osg::Node* createTile(unsigned int i)
+{
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array(20000);
+    for(unsigned int v=0; v<vertices->size(); ++v) (*vertices)[v].set(float(i), float(v), 0.0f);
+    geometry->setVertexArray(vertices.get());
+    geometry->addPrimitiveSet(new osg::DrawArrays(GL_POINTS, 0, vertices->size()));
+
+    osg::Geode* geode = new osg::Geode;
+    geode->addDrawable(geometry.get());
+    return geode;
+}
+
+static void reportStatistics(const osgDB::FileCache& fileCache)
+{
+    std::cout<<"    hits="<<fileCache.getNumHits()<<" misses="<<fileCache.getNumMisses()<<" writes="<<fileCache.getNumWrites()<<" evictions="<<fileCache.getNumEvictions()<<std::endl;
+}
+
+void runFileCachePerformanceTests(unsigned int numFiles)
+{
+    std::cout<<"**** osgDB::FileCache performance tests ******"<<std::endl;
+
+    std::vector< osg::ref_ptr<osg::Node> > tiles;
+    for(unsigned int i=0; i<numFiles; ++i) tiles.push_back(createTile(i));
+
+    for(unsigned int writeBehind=0; writeBehind<2; ++writeBehind)
+    {
+        std::string cachePath = writeBehind ? "osgunittests_filecache_write_behind" : "osgunittests_filecache";
+        osg::ref_ptr<osgDB::FileCache> fileCache = new osgDB::FileCache(cachePath);
+        fileCache->setWriteBehind(writeBehind!=0);
+
+        osg::ElapsedTime elapsedTime;
+        for(unsigned int i=0; i<numFiles; ++i)
+        {
+            fileCache->writeNode(*tiles[i], createServerFileName(i), 0);
+        }
+        double writeTime = elapsedTime.elapsedTime_m();
+        fileCache->flushWrites();
+        double flushTime = elapsedTime.elapsedTime_m();
+
+        std::cout<<"    "<<(writeBehind ? "write behind" : "synchronous")<<" writes of "<<numFiles<<" files : "<<writeTime<<"ms on the calling thread, "<<flushTime<<"ms until on disk"<<std::endl;
+
+        unsigned int numRead = 0;
+        elapsedTime.reset();
+        for(unsigned int i=0; i<numFiles+numFiles/4; ++i)
+        {
+            if (fileCache->readNode(createServerFileName(i), 0, false).validNode()) ++numRead;
+        }
+        std::cout<<"    reads of "<<numFiles+numFiles/4<<" files : "<<elapsedTime.elapsedTime_m()<<"ms, "<<numRead<<" read"<<std::endl;
+        reportStatistics(*fileCache);
+    }
+
+    // bound the cache to half its current size and check that the least recently accessed files are removed.
+    osg::ref_ptr<osgDB::FileCache> fileCache = new osgDB::FileCache("osgunittests_filecache");
+    fileCache->setMaximumCacheSize(~uint64_t(0));
+    uint64_t cacheSize = fileCache->getCacheSize();
+
+    // access times have a resolution of a second, so wait before reading the second half of the files to make them the most recently used.
+    OpenThreads::Thread::microSleep(1100000);
+    for(unsigned int i=numFiles/2; i<numFiles; ++i) fileCache->readNode(createServerFileName(i), 0, false);
+
+    fileCache->setMaximumCacheSize(cacheSize/2);
+    std::cout<<"    cache of "<<cacheSize<<" bytes limited to "<<cacheSize/2<<" bytes, now "<<fileCache->getCacheSize()<<" bytes"<<std::endl;
+
+    unsigned int numRecentKept = 0;
+    for(unsigned int i=numFiles/2; i<numFiles; ++i)
+    {
+        if (fileCache->existsInCache(createServerFileName(i))) ++numRecentKept;
+    }
+    std::cout<<"    "<<numRecentKept<<" of the "<<numFiles-numFiles/2<<" most recently used files kept"<<std::endl;
+    reportStatistics(*fileCache);
+}
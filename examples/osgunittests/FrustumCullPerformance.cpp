@@ -0,0 +1,104 @@
+/* OpenSceneGraph example, osgunittests.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include "FrustumCullPerformance.h"
+
+#include <osg/Polytope>
+#include <osg/BoundingSphere>
+#include <osg/Matrix>
+#include <osg/Timer>
+
+#include <iostream>
+#include <stdlib.h>
+#include <vector>
+
+static float randomValue(float minValue, float maxValue)
+{
+    return minValue + (maxValue-minValue)*(float(rand())/float(RAND_MAX));
+}
+
+void runFrustumCullPerformanceTests(unsigned int numSpheres)
+{
+    std::cout<<"**** Polytope bounding sphere culling performance tests ******"<<std::endl;
+
+    // perspective view frustum looking down the -z axis, spheres scattered around it so that a
+    // mix of them are inside, outside and straddling the frustum planes.
+    osg::Polytope frustum;
+    frustum.setToUnitFrustum(true, true);
+    frustum.transformProvidingInverse(osg::Matrix::perspective(45.0, 1.5, 1.0, 1000.0));
+    frustum.pushCurrentMask();
+
+    srand(1);
+
+    std::vector<osg::BoundingSphere> spheres(numSpheres);
+    std::vector<osg::Plane::value_type> centerX(numSpheres), centerY(numSpheres), centerZ(numSpheres), radius(numSpheres);
+    for(unsigned int i=0; i<numSpheres; ++i)
+    {
+        osg::BoundingSphere bs(osg::Vec3(randomValue(-800.0f, 800.0f), randomValue(-800.0f, 800.0f), randomValue(-1100.0f, 100.0f)),
+                               randomValue(0.1f, 20.0f));
+        spheres[i] = bs;
+        centerX[i] = bs.center().x();
+        centerY[i] = bs.center().y();
+        centerZ[i] = bs.center().z();
+        radius[i] = bs.radius();
+    }
+
+    std::vector<unsigned char> scalarResults(numSpheres), batchResults(numSpheres);
+
+    const unsigned int numRuns = 20;
+    double scalarTime = 0.0;
+    double batchTime = 0.0;
+
+    for(unsigned int run=0; run<numRuns; ++run)
+    {
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+        for(unsigned int i=0; i<numSpheres; ++i)
+        {
+            scalarResults[i] = frustum.contains(spheres[i]) ? 1 : 0;
+        }
+
+        osg::Timer_t scalarTick = osg::Timer::instance()->tick();
+
+        frustum.contains(&centerX.front(), &centerY.front(), &centerZ.front(), &radius.front(), numSpheres, &batchResults.front());
+
+        osg::Timer_t batchTick = osg::Timer::instance()->tick();
+
+        scalarTime += osg::Timer::instance()->delta_m(startTick, scalarTick);
+        batchTime += osg::Timer::instance()->delta_m(scalarTick, batchTick);
+    }
+
+    unsigned int numVisible = 0;
+    unsigned int numMismatches = 0;
+    for(unsigned int i=0; i<numSpheres; ++i)
+    {
+        if (scalarResults[i]) ++numVisible;
+        if (scalarResults[i]!=batchResults[i]) ++numMismatches;
+    }
+
+    std::cout<<numSpheres<<" spheres, "<<numVisible<<" visible, times in ms averaged over "<<numRuns<<" runs."<<std::endl;
+    std::cout<<"scalar contains()\t"<<scalarTime/numRuns<<std::endl;
+    std::cout<<"batch contains()\t"<<batchTime/numRuns<<std::endl;
+
+    if (numMismatches>0)
+    {
+        std::cout<<"    Error: batch results differ from scalar results for "<<numMismatches<<" spheres"<<std::endl;
+    }
+
+    std::cout<<std::endl;
+}
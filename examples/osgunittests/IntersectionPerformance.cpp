@@ -0,0 +1,310 @@
+/* OpenSceneGraph example, osgunittests.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include "IntersectionPerformance.h"
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/KdTree>
+#include <osg/Timer>
+#include <osgUtil/LineSegmentIntersector>
+#include <osgUtil/IntersectionVisitor>
+#include <osgDB/Registry>
+#include <OpenThreads/Thread>
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+#include <math.h>
+
+static osg::Geode* createTerrain(unsigned int gridSize)
+{
+    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    vertices->reserve((gridSize+1)*(gridSize+1));
+    for(unsigned int r=0; r<=gridSize; ++r)
+    {
+        for(unsigned int c=0; c<=gridSize; ++c)
+        {
+            float x = float(c), y = float(r);
+            vertices->push_back(osg::Vec3(x, y, 10.0f*sinf(x*0.05f)*cosf(y*0.07f) + 2.0f*sinf(x*0.6f+y*0.4f)));
+        }
+    }
+
+    osg::ref_ptr<osg::DrawElementsUInt> triangles = new osg::DrawElementsUInt(GL_TRIANGLES);
+    triangles->reserve(gridSize*gridSize*6);
+    for(unsigned int r=0; r<gridSize; ++r)
+    {
+        for(unsigned int c=0; c<gridSize; ++c)
+        {
+            unsigned int i = r*(gridSize+1)+c;
+            triangles->push_back(i); triangles->push_back(i+1); triangles->push_back(i+gridSize+2);
+            triangles->push_back(i); triangles->push_back(i+gridSize+2); triangles->push_back(i+gridSize+1);
+        }
+    }
+
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setVertexArray(vertices.get());
+    geometry->addPrimitiveSet(triangles.get());
+
+    osg::Geode* geode = new osg::Geode;
+    geode->addDrawable(geometry.get());
+    return geode;
+}
+
+typedef std::vector< std::pair<osg::Vec3d, osg::Vec3d> > Segments;
+
+struct QueryResult
+{
+    QueryResult(): numHits(0), sumOfRatios(0.0), time(0.0) {}
+
+    unsigned int    numHits;
+    double          sumOfRatios;
+    double          time;
+};
+
+static QueryResult runQueries(osg::Node* scene, const Segments& segments, bool useAccelerationStructure)
+{
+    QueryResult result;
+
+    osg::ElapsedTime elapsedTime;
+    for(Segments::const_iterator itr = segments.begin(); itr != segments.end(); ++itr)
+    {
+        osg::ref_ptr<osgUtil::LineSegmentIntersector> intersector = new osgUtil::LineSegmentIntersector(itr->first, itr->second);
+        osgUtil::IntersectionVisitor iv(intersector.get());
+        iv.setUseKdTreeWhenAvailable(useAccelerationStructure);
+        scene->accept(iv);
+
+        const osgUtil::LineSegmentIntersector::Intersections& intersections = intersector->getIntersections();
+        for(osgUtil::LineSegmentIntersector::Intersections::const_iterator hitr = intersections.begin(); hitr != intersections.end(); ++hitr)
+        {
+            ++result.numHits;
+            result.sumOfRatios += hitr->ratio;
+        }
+    }
+    result.time = elapsedTime.elapsedTime_m();
+
+    return result;
+}
+
+static QueryResult runBatchedQueries(osg::Node* scene, const Segments& segments, bool usePacket)
+{
+    QueryResult result;
+
+    osg::ElapsedTime elapsedTime;
+
+    // both issue all the segments in a single traversal, as osgSim::LineOfSight and HeightAboveTerrain do.
+    std::vector< osg::ref_ptr<osgUtil::LineSegmentIntersector> > intersectors;
+    osg::ref_ptr<osgUtil::Intersector> intersector;
+    if (usePacket)
+    {
+        osg::ref_ptr<osgUtil::LineSegmentPacketIntersector> packet = new osgUtil::LineSegmentPacketIntersector;
+        for(Segments::const_iterator itr = segments.begin(); itr != segments.end(); ++itr)
+        {
+            intersectors.push_back(packet->addSegment(itr->first, itr->second));
+        }
+        intersector = packet.get();
+    }
+    else
+    {
+        osg::ref_ptr<osgUtil::IntersectorGroup> group = new osgUtil::IntersectorGroup;
+        for(Segments::const_iterator itr = segments.begin(); itr != segments.end(); ++itr)
+        {
+            intersectors.push_back(new osgUtil::LineSegmentIntersector(itr->first, itr->second));
+            group->addIntersector(intersectors.back().get());
+        }
+        intersector = group.get();
+    }
+
+    osgUtil::IntersectionVisitor iv(intersector.get());
+    scene->accept(iv);
+
+    for(unsigned int i=0; i<intersectors.size(); ++i)
+    {
+        const osgUtil::LineSegmentIntersector::Intersections& intersections = intersectors[i]->getIntersections();
+        for(osgUtil::LineSegmentIntersector::Intersections::const_iterator hitr = intersections.begin(); hitr != intersections.end(); ++hitr)
+        {
+            ++result.numHits;
+            result.sumOfRatios += hitr->ratio;
+        }
+    }
+    result.time = elapsedTime.elapsedTime_m();
+
+    return result;
+}
+
+static void reportQueries(const char* name, const QueryResult& result, const QueryResult& reference)
+{
+    std::cout<<"        "<<name<<" : "<<result.time<<"ms, hits = "<<result.numHits;
+    if (result.numHits!=reference.numHits || fabs(result.sumOfRatios-reference.sumOfRatios)>1e-6*double(reference.numHits+1))
+    {
+        std::cout<<"  ERROR: results differ from the reference, hits = "<<reference.numHits;
+    }
+    std::cout<<std::endl;
+}
+
+void runIntersectionPerformanceTests(unsigned int gridSize)
+{
+    std::cout<<"**** KdTree versus BoundingVolumeHierarchy, single versus packet intersection performance tests ******"<<std::endl;
+    std::cout<<"    terrain grid "<<gridSize<<" x "<<gridSize<<", "<<gridSize*gridSize*2<<" triangles"<<std::endl;
+
+    osg::ref_ptr<osg::Geode> geode = createTerrain(gridSize);
+    osg::Geometry* geometry = geode->getDrawable(0)->asGeometry();
+
+    // height above terrain style vertical segments, and long picking segments from above one corner.
+    unsigned int numSegments = 10000;
+    Segments verticalSegments;
+    Segments pickSegments;
+    srand(1);
+    for(unsigned int i=0; i<numSegments; ++i)
+    {
+        double x = double(gridSize)*double(rand())/double(RAND_MAX);
+        double y = double(gridSize)*double(rand())/double(RAND_MAX);
+        verticalSegments.push_back(Segments::value_type(osg::Vec3d(x, y, 100.0), osg::Vec3d(x, y, -100.0)));
+
+        osg::Vec3d eye(-10.0, -10.0, 40.0);
+        osg::Vec3d target(x, y, 0.0);
+        pickSegments.push_back(Segments::value_type(eye, eye+(target-eye)*2.0));
+    }
+
+    osg::ref_ptr<osg::KdTreeBuilder> kdTreeBuilder = new osg::KdTreeBuilder;
+
+    osg::ElapsedTime elapsedTime;
+    geode->accept(*kdTreeBuilder);
+    double kdTreeBuildTime = elapsedTime.elapsedTime_m();
+    osg::ref_ptr<osg::Shape> kdTree = geometry->getShape();
+
+    geometry->setShape(0);
+    kdTreeBuilder->_structureType = osg::KdTreeBuilder::BOUNDING_VOLUME_HIERARCHY;
+
+    elapsedTime.reset();
+    geode->accept(*kdTreeBuilder);
+    double bvhBuildTime = elapsedTime.elapsedTime_m();
+    osg::ref_ptr<osg::Shape> bvh = geometry->getShape();
+
+    // split the KdTree build between threads, the resulting tree is checked by the queries below.
+    unsigned int numBuildThreads = std::max(4, OpenThreads::GetNumberOfProcessors());
+    geometry->setShape(0);
+    kdTreeBuilder->_structureType = osg::KdTreeBuilder::KDTREE;
+    kdTreeBuilder->_buildOptions._numThreads = numBuildThreads;
+
+    elapsedTime.reset();
+    geode->accept(*kdTreeBuilder);
+    double threadedKdTreeBuildTime = elapsedTime.elapsedTime_m();
+    osg::ref_ptr<osg::Shape> threadedKdTree = geometry->getShape();
+
+    std::cout<<"    build KdTree : "<<kdTreeBuildTime<<"ms"<<std::endl;
+    std::cout<<"    build KdTree with "<<numBuildThreads<<" threads : "<<threadedKdTreeBuildTime<<"ms"<<std::endl;
+    std::cout<<"    build BoundingVolumeHierarchy : "<<bvhBuildTime<<"ms";
+    if (osg::BoundingVolumeHierarchy* hierarchy = dynamic_cast<osg::BoundingVolumeHierarchy*>(bvh.get()))
+    {
+        std::cout<<", "<<hierarchy->getNodes().size()<<" nodes";
+    }
+    std::cout<<std::endl;
+
+    const char* queryNames[] = { "vertical", "pick" };
+    const Segments* querySegments[] = { &verticalSegments, &pickSegments };
+    for(unsigned int q=0; q<2; ++q)
+    {
+        std::cout<<"    "<<numSegments<<" "<<queryNames[q]<<" segments"<<std::endl;
+
+        QueryResult reference;
+        if (gridSize<=256)
+        {
+            reference = runQueries(geode.get(), *querySegments[q], false);
+            reportQueries("no acceleration", reference, reference);
+        }
+
+        geometry->setShape(kdTree.get());
+        QueryResult kdTreeResult = runQueries(geode.get(), *querySegments[q], true);
+        if (gridSize>256) reference = kdTreeResult;
+        reportQueries("KdTree", kdTreeResult, reference);
+
+        geometry->setShape(threadedKdTree.get());
+        reportQueries("KdTree built with threads", runQueries(geode.get(), *querySegments[q], true), reference);
+
+        // time includes building the KdTree on the first intersection test.
+        geometry->setShape(0);
+        kdTreeBuilder->_buildOptions._numThreads = 1;
+        kdTreeBuilder->_buildOnDemand = true;
+        geode->accept(*kdTreeBuilder);
+        kdTreeBuilder->_buildOnDemand = false;
+        reportQueries("KdTree built on demand", runQueries(geode.get(), *querySegments[q], true), reference);
+
+        geometry->setShape(bvh.get());
+        reportQueries("BoundingVolumeHierarchy", runQueries(geode.get(), *querySegments[q], true), reference);
+
+        geometry->setShape(kdTree.get());
+        reportQueries("KdTree, IntersectorGroup", runBatchedQueries(geode.get(), *querySegments[q], false), reference);
+        reportQueries("KdTree, LineSegmentPacketIntersector", runBatchedQueries(geode.get(), *querySegments[q], true), reference);
+
+        geometry->setShape(bvh.get());
+        reportQueries("BoundingVolumeHierarchy, IntersectorGroup", runBatchedQueries(geode.get(), *querySegments[q], false), reference);
+        reportQueries("BoundingVolumeHierarchy, LineSegmentPacketIntersector", runBatchedQueries(geode.get(), *querySegments[q], true), reference);
+    }
+
+    // round trip through the osgb format, a stored KdTree should be reused on load rather than rebuilt.
+    osgDB::ReaderWriter* rw = osgDB::Registry::instance()->getReaderWriterForExtension("osgb");
+    if (!rw)
+    {
+        std::cout<<"    osgb plugin not found, skipping KdTree serialization test"<<std::endl;
+        return;
+    }
+
+    geometry->setShape(kdTree.get());
+    QueryResult reference = runQueries(geode.get(), verticalSegments, true);
+
+    std::stringstream withKdTree;
+    rw->writeNode(*geode, withKdTree);
+
+    geometry->setShape(0);
+    std::stringstream withoutKdTree;
+    rw->writeNode(*geode, withoutKdTree);
+    geometry->setShape(kdTree.get());
+
+    osg::ref_ptr<osgDB::Options> options = new osgDB::Options;
+    options->setBuildKdTreesHint(osgDB::Options::BUILD_KDTREES);
+
+    const char* streamNames[] = { "without KdTree", "with KdTree" };
+    std::stringstream* streams[] = { &withoutKdTree, &withKdTree };
+    for(unsigned int i=0; i<2; ++i)
+    {
+        std::string::size_type streamSize = streams[i]->str().size();
+
+        elapsedTime.reset();
+        osgDB::ReaderWriter::ReadResult rr = rw->readNode(*streams[i], options.get());
+        osgDB::Registry::instance()->_buildKdTreeIfRequired(rr, options.get());
+        double loadTime = elapsedTime.elapsedTime_m();
+
+        osg::ref_ptr<osg::Node> loaded = rr.getNode();
+        osg::Geode* loadedGeode = loaded.valid() ? loaded->asGeode() : 0;
+        osg::Geometry* loadedGeometry = (loadedGeode && loadedGeode->getNumDrawables()>0) ? loadedGeode->getDrawable(0)->asGeometry() : 0;
+        osg::KdTree* loadedKdTree = loadedGeometry ? dynamic_cast<osg::KdTree*>(loadedGeometry->getShape()) : 0;
+
+        std::cout<<"    osgb read "<<streamNames[i]<<" ("<<streamSize<<" bytes) and build KdTrees : "<<loadTime<<"ms";
+        if (!loadedKdTree || !loadedKdTree->validate(loadedGeometry))
+        {
+            std::cout<<"  ERROR: no valid KdTree after loading"<<std::endl;
+            continue;
+        }
+        std::cout<<std::endl;
+
+        reportQueries("loaded KdTree", runQueries(loaded.get(), verticalSegments, true), reference);
+    }
+}
@@ -0,0 +1,174 @@
+/* OpenSceneGraph example, osgunittests.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include "ReferencedPerformance.h"
+
+#include <osg/Referenced>
+#include <osg/observer_ptr>
+#include <osg/ref_ptr>
+#include <osg/Timer>
+
+#include <OpenThreads/Thread>
+#include <OpenThreads/Barrier>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
+
+#include <iostream>
+#include <vector>
+
+// Mutex protected reference count, used as the baseline that the atomic counts are compared against.
+struct MutexCounted
+{
+    MutexCounted(): _refCount(0) {}
+
+    void ref() { OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex); ++_refCount; }
+    void unref() { OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex); --_refCount; }
+
+    OpenThreads::Mutex  _mutex;
+    int                 _refCount;
+};
+
+enum ContentionTestMode
+{
+    MUTEX_REF_UNREF,
+    ATOMIC_REF_UNREF,
+    OBSERVER_PTR_LOCK
+};
+
+class ContentionThread : public OpenThreads::Thread
+{
+public:
+
+    ContentionThread(ContentionTestMode mode, unsigned int numIterations,
+                     MutexCounted* mutexCounted, osg::Referenced* shared, OpenThreads::Barrier* barrier):
+        _mode(mode),
+        _numIterations(numIterations),
+        _mutexCounted(mutexCounted),
+        _shared(shared),
+        _observer(shared),
+        _barrier(barrier),
+        _numFailedLocks(0) {}
+
+    virtual void run()
+    {
+        _barrier->block();
+
+        switch(_mode)
+        {
+            case(MUTEX_REF_UNREF):
+                for(unsigned int i=0; i<_numIterations; ++i)
+                {
+                    _mutexCounted->ref();
+                    _mutexCounted->unref();
+                }
+                break;
+            case(ATOMIC_REF_UNREF):
+                for(unsigned int i=0; i<_numIterations; ++i)
+                {
+                    _shared->ref();
+                    _shared->unref();
+                }
+                break;
+            case(OBSERVER_PTR_LOCK):
+                for(unsigned int i=0; i<_numIterations; ++i)
+                {
+                    osg::ref_ptr<osg::Referenced> locked;
+                    if (!_observer.lock(locked)) ++_numFailedLocks;
+                }
+                break;
+        }
+
+        _barrier->block();
+    }
+
+    unsigned int getNumFailedLocks() const { return _numFailedLocks; }
+
+protected:
+
+    ContentionTestMode                  _mode;
+    unsigned int                        _numIterations;
+    MutexCounted*                       _mutexCounted;
+    osg::Referenced*                    _shared;
+    osg::observer_ptr<osg::Referenced>  _observer;
+    OpenThreads::Barrier*               _barrier;
+    unsigned int                        _numFailedLocks;
+};
+
+static double runContentionTest(ContentionTestMode mode, unsigned int numThreads, unsigned int numIterations, unsigned int& numFailedLocks)
+{
+    MutexCounted mutexCounted;
+    osg::ref_ptr<osg::Referenced> shared = new osg::Referenced;
+
+    OpenThreads::Barrier barrier(numThreads+1);
+
+    std::vector<ContentionThread*> threads;
+    for(unsigned int i=0; i<numThreads; ++i)
+    {
+        threads.push_back(new ContentionThread(mode, numIterations, &mutexCounted, shared.get(), &barrier));
+        threads.back()->start();
+    }
+
+    // release all the threads at once, then wait for them all to complete.
+    barrier.block();
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+    barrier.block();
+    osg::Timer_t endTick = osg::Timer::instance()->tick();
+
+    numFailedLocks = 0;
+    for(std::vector<ContentionThread*>::iterator itr = threads.begin();
+        itr != threads.end();
+        ++itr)
+    {
+        (*itr)->join();
+        numFailedLocks += (*itr)->getNumFailedLocks();
+        delete *itr;
+    }
+
+    if (mode==ATOMIC_REF_UNREF && shared->referenceCount()!=1)
+    {
+        std::cout<<"    Error: reference count not restored, referenceCount()="<<shared->referenceCount()<<std::endl;
+    }
+
+    double numOperations = double(numThreads)*double(numIterations);
+    return numOperations / osg::Timer::instance()->delta_s(startTick, endTick);
+}
+
+void runReferencedContentionTests(unsigned int maxNumThreads)
+{
+    std::cout<<"**** osg::Referenced contention tests ******"<<std::endl;
+    std::cout<<"Operations per second, each thread working on the same shared object."<<std::endl;
+    std::cout<<"threads\tmutex ref/unref\tatomic ref/unref\tobserver_ptr lock"<<std::endl;
+
+    const unsigned int numIterations = 1000000;
+    for(unsigned int numThreads=1; numThreads<=maxNumThreads; numThreads*=2)
+    {
+        unsigned int numFailedLocks = 0;
+        double mutexRate = runContentionTest(MUTEX_REF_UNREF, numThreads, numIterations, numFailedLocks);
+        double atomicRate = runContentionTest(ATOMIC_REF_UNREF, numThreads, numIterations, numFailedLocks);
+        double lockRate = runContentionTest(OBSERVER_PTR_LOCK, numThreads, numIterations, numFailedLocks);
+
+        std::cout<<numThreads<<"\t"<<mutexRate<<"\t"<<atomicRate<<"\t"<<lockRate<<std::endl;
+
+        if (numFailedLocks!=0)
+        {
+            std::cout<<"    Error: "<<numFailedLocks<<" observer_ptr<>::lock() calls failed on a live object"<<std::endl;
+        }
+    }
+
+    std::cout<<std::endl;
+}
@@ -0,0 +1,103 @@
+/* OpenSceneGraph example, osgunittests.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include "RegistryLookupPerformance.h"
+
+#include <osg/Timer>
+#include <osgDB/Registry>
+#include <osgDB/FileUtils>
+
+#include <OpenThreads/Thread>
+
+#include <iostream>
+#include <vector>
+
+class ExtensionLookupThread : public OpenThreads::Thread
+{
+public:
+    ExtensionLookupThread(unsigned int numIterations):
+        _numIterations(numIterations),
+        _numFound(0) {}
+
+    virtual void run()
+    {
+        static const char* extensions[] = { "osgb", "osgt", "osg", "ive" };
+        osgDB::Registry* registry = osgDB::Registry::instance();
+        for(unsigned int i=0; i<_numIterations; ++i)
+        {
+            if (registry->getReaderWriterForExtension(extensions[i%4])) ++_numFound;
+        }
+    }
+
+    unsigned int _numIterations;
+    unsigned int _numFound;
+};
+
+static double timeExtensionLookups(unsigned int numThreads, unsigned int numIterations)
+{
+    std::vector<ExtensionLookupThread*> threads;
+    for(unsigned int i=0; i<numThreads; ++i) threads.push_back(new ExtensionLookupThread(numIterations));
+
+    osg::ElapsedTime elapsedTime;
+    for(unsigned int i=0; i<numThreads; ++i) threads[i]->startThread();
+    for(unsigned int i=0; i<numThreads; ++i) threads[i]->join();
+    double time = elapsedTime.elapsedTime_m();
+
+    for(unsigned int i=0; i<numThreads; ++i) delete threads[i];
+    return time;
+}
+
+static double timeFindDataFile(unsigned int numIterations, const std::string& filename)
+{
+    osg::ElapsedTime elapsedTime;
+    for(unsigned int i=0; i<numIterations; ++i)
+    {
+        osgDB::findDataFile(filename);
+    }
+    return elapsedTime.elapsedTime_m();
+}
+
+void runRegistryLookupPerformanceTests(unsigned int numIterations)
+{
+    std::cout<<"**** osgDB::Registry lookup performance tests ******"<<std::endl;
+
+    osgDB::Registry* registry = osgDB::Registry::instance();
+
+    // make sure the plugins are loaded so that the timings measure the lookup rather than the loading.
+    registry->getReaderWriterForExtension("osgb");
+    registry->getReaderWriterForExtension("osg");
+    registry->getReaderWriterForExtension("ive");
+
+    std::cout<<"    getReaderWriterForExtension() x "<<numIterations<<", 1 thread : "<<timeExtensionLookups(1, numIterations)<<"ms"<<std::endl;
+    std::cout<<"    getReaderWriterForExtension() x "<<numIterations<<", 4 threads : "<<timeExtensionLookups(4, numIterations)<<"ms"<<std::endl;
+
+    bool previousCacheSetting = registry->getCacheFindDataFileResults();
+    unsigned int numFindIterations = numIterations/10 + 1;
+    const char* missingFile = "osgunittests_missing_data_file.osgt";
+    const char* existingFile = "cow.osgt";
+
+    registry->setCacheFindDataFileResults(false);
+    std::cout<<"    findDataFile(\""<<missingFile<<"\") x "<<numFindIterations<<", uncached : "<<timeFindDataFile(numFindIterations, missingFile)<<"ms"<<std::endl;
+    std::cout<<"    findDataFile(\""<<existingFile<<"\") x "<<numFindIterations<<", uncached : "<<timeFindDataFile(numFindIterations, existingFile)<<"ms"<<std::endl;
+
+    registry->setCacheFindDataFileResults(true);
+    std::cout<<"    findDataFile(\""<<missingFile<<"\") x "<<numFindIterations<<", cached : "<<timeFindDataFile(numFindIterations, missingFile)<<"ms"<<std::endl;
+    std::cout<<"    findDataFile(\""<<existingFile<<"\") x "<<numFindIterations<<", cached : "<<timeFindDataFile(numFindIterations, existingFile)<<"ms"<<std::endl;
+
+    registry->setCacheFindDataFileResults(previousCacheSetting);
+}
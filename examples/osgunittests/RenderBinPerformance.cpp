@@ -0,0 +1,266 @@
+/* OpenSceneGraph example, osgunittests.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include "RenderBinPerformance.h"
+
+#include <osgUtil/RenderBin>
+#include <osgUtil/StateGraph>
+#include <osgUtil/RenderLeaf>
+
+#include <osg/Geometry>
+#include <osg/Timer>
+
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+
+// Synthetic scene of numLeaves RenderLeaf spread across a fixed set of StateGraph, allocated in
+// shuffled order so that the leaves are scattered in memory much as they are after a real cull.
+class SyntheticRenderBinContents
+{
+public:
+
+    SyntheticRenderBinContents(unsigned int numLeaves, unsigned int numStateSets):
+        _rootStateGraph(new osgUtil::StateGraph),
+        _drawable(new osg::Geometry),
+        _modelview(new osg::RefMatrix),
+        _projection(new osg::RefMatrix)
+    {
+        srand(numLeaves);
+
+        for(unsigned int i=0; i<numStateSets; ++i)
+        {
+            osg::StateSet* stateset = new osg::StateSet;
+            _stateSets.push_back(stateset);
+            _stateGraphs.push_back(_rootStateGraph->find_or_insert(stateset));
+        }
+
+        for(unsigned int i=0; i<numLeaves; ++i)
+        {
+            float depth = static_cast<float>(rand())/static_cast<float>(RAND_MAX)*1000.0f - 10.0f;
+            _leaves.push_back(new osgUtil::RenderLeaf(_drawable.get(), _projection.get(), _modelview.get(), depth, i));
+        }
+    }
+
+    void fill(osgUtil::RenderBin& bin)
+    {
+        bin.reset();
+
+        for(std::vector< osg::ref_ptr<osgUtil::StateGraph> >::iterator itr = _stateGraphs.begin();
+            itr != _stateGraphs.end();
+            ++itr)
+        {
+            (*itr)->_leaves.clear();
+        }
+
+        for(unsigned int i=0; i<_leaves.size(); ++i)
+        {
+            osgUtil::StateGraph* sg = _stateGraphs[(i*7919) % _stateGraphs.size()].get();
+            if (sg->_leaves.empty()) bin.addStateGraph(sg);
+            sg->addLeaf(_leaves[i].get());
+        }
+    }
+
+protected:
+
+    osg::ref_ptr<osgUtil::StateGraph>                   _rootStateGraph;
+    osg::ref_ptr<osg::Drawable>                         _drawable;
+    osg::ref_ptr<osg::RefMatrix>                        _modelview;
+    osg::ref_ptr<osg::RefMatrix>                        _projection;
+    std::vector< osg::ref_ptr<osg::StateSet> >          _stateSets;
+    std::vector< osg::ref_ptr<osgUtil::StateGraph> >    _stateGraphs;
+    std::vector< osg::ref_ptr<osgUtil::RenderLeaf> >    _leaves;
+};
+
+// Walk the bin in draw order as RenderBin::drawImplementation() does, touching each leaf.
+static double walkDrawOrder(osgUtil::RenderBin& bin, unsigned int& numLeavesVisited)
+{
+    double sum = 0.0;
+    numLeavesVisited = 0;
+
+    osgUtil::RenderBin::RenderLeafList& renderLeafList = bin.getRenderLeafList();
+    for(osgUtil::RenderBin::RenderLeafList::iterator itr = renderLeafList.begin();
+        itr != renderLeafList.end();
+        ++itr)
+    {
+        sum += (*itr)->_depth;
+        ++numLeavesVisited;
+    }
+
+    osgUtil::RenderBin::StateGraphList& stateGraphList = bin.getStateGraphList();
+    for(osgUtil::RenderBin::StateGraphList::iterator oitr = stateGraphList.begin();
+        oitr != stateGraphList.end();
+        ++oitr)
+    {
+        for(osgUtil::StateGraph::LeafList::iterator dw_itr = (*oitr)->_leaves.begin();
+            dw_itr != (*oitr)->_leaves.end();
+            ++dw_itr)
+        {
+            sum += (*dw_itr)->_depth;
+            ++numLeavesVisited;
+        }
+    }
+
+    return sum;
+}
+
+static bool checkDrawOrder(osgUtil::RenderBin& bin)
+{
+    osgUtil::RenderBin::RenderLeafList& renderLeafList = bin.getRenderLeafList();
+    for(unsigned int i=1; i<renderLeafList.size(); ++i)
+    {
+        const osgUtil::RenderLeaf* previous = renderLeafList[i-1];
+        const osgUtil::RenderLeaf* current = renderLeafList[i];
+        switch(bin.getSortMode())
+        {
+            case(osgUtil::RenderBin::SORT_FRONT_TO_BACK): if (current->_depth<previous->_depth) return false; break;
+            case(osgUtil::RenderBin::SORT_BACK_TO_FRONT): if (current->_depth>previous->_depth) return false; break;
+            case(osgUtil::RenderBin::TRAVERSAL_ORDER): if (current->_traversalOrderNumber<previous->_traversalOrderNumber) return false; break;
+            case(osgUtil::RenderBin::SORT_BY_STATE_THEN_FRONT_TO_BACK):
+                if (current->_parent==previous->_parent && current->_depth<previous->_depth) return false;
+                break;
+            default: break;
+        }
+    }
+    return true;
+}
+
+static void runRenderBinTest(SyntheticRenderBinContents& contents, unsigned int numLeaves, osgUtil::RenderBin::SortMode sortMode, const char* sortModeName)
+{
+    const unsigned int numRuns = 10;
+
+    double sortTime[2] = { 0.0, 0.0 };
+    double drawTime[2] = { 0.0, 0.0 };
+    bool ordered[2] = { true, true };
+    unsigned int numLeavesVisited[2] = { 0, 0 };
+
+    for(unsigned int flattened=0; flattened<2; ++flattened)
+    {
+        osg::ref_ptr<osgUtil::RenderBin> bin = new osgUtil::RenderBin(sortMode);
+        bin->setUseFlattenedRenderLeafArray(flattened!=0);
+
+        for(unsigned int run=0; run<numRuns; ++run)
+        {
+            contents.fill(*bin);
+
+            osg::Timer_t startTick = osg::Timer::instance()->tick();
+            bin->sort();
+            osg::Timer_t sortTick = osg::Timer::instance()->tick();
+            walkDrawOrder(*bin, numLeavesVisited[flattened]);
+            osg::Timer_t drawTick = osg::Timer::instance()->tick();
+
+            sortTime[flattened] += osg::Timer::instance()->delta_m(startTick, sortTick);
+            drawTime[flattened] += osg::Timer::instance()->delta_m(sortTick, drawTick);
+
+            if (!checkDrawOrder(*bin)) ordered[flattened] = false;
+        }
+
+        bin->reset();
+    }
+
+    std::cout<<sortModeName<<"\t"
+             <<sortTime[0]/numRuns<<"\t"<<drawTime[0]/numRuns<<"\t"
+             <<sortTime[1]/numRuns<<"\t"<<drawTime[1]/numRuns<<std::endl;
+
+    if (!ordered[0] || !ordered[1])
+    {
+        std::cout<<"    Error: leaves not in "<<sortModeName<<" order, StateGraph tree "<<(ordered[0]?"ok":"failed")
+                 <<", flattened "<<(ordered[1]?"ok":"failed")<<std::endl;
+    }
+
+    if (numLeavesVisited[0]!=numLeavesVisited[1] || numLeavesVisited[1]!=numLeaves)
+    {
+        std::cout<<"    Error: expected "<<numLeaves<<" leaves, StateGraph tree drew "<<numLeavesVisited[0]
+                 <<", flattened drew "<<numLeavesVisited[1]<<std::endl;
+    }
+}
+
+void runRenderBinPerformanceTests(unsigned int numLeaves)
+{
+    std::cout<<"**** RenderBin sort and draw order performance tests ******"<<std::endl;
+    std::cout<<numLeaves<<" leaves, times in ms averaged over 10 frames."<<std::endl;
+    std::cout<<"SortMode\t\t\ttree sort\ttree walk\tflat sort\tflat walk"<<std::endl;
+
+    SyntheticRenderBinContents contents(numLeaves, 256);
+
+    runRenderBinTest(contents, numLeaves, osgUtil::RenderBin::SORT_BY_STATE, "SORT_BY_STATE\t\t");
+    runRenderBinTest(contents, numLeaves, osgUtil::RenderBin::SORT_BY_STATE_THEN_FRONT_TO_BACK, "SORT_BY_STATE_THEN_FRONT_TO_BACK");
+    runRenderBinTest(contents, numLeaves, osgUtil::RenderBin::SORT_FRONT_TO_BACK, "SORT_FRONT_TO_BACK\t");
+    runRenderBinTest(contents, numLeaves, osgUtil::RenderBin::SORT_BACK_TO_FRONT, "SORT_BACK_TO_FRONT\t");
+    runRenderBinTest(contents, numLeaves, osgUtil::RenderBin::TRAVERSAL_ORDER, "TRAVERSAL_ORDER\t\t");
+
+    std::cout<<std::endl;
+}
+
+static void runDepthSortTest(unsigned int numLeaves, osgUtil::RenderBin::SortMode sortMode, const char* sortModeName)
+{
+    const unsigned int numRuns = 10;
+
+    // a single StateGraph, as is typical of a bin of transparent foliage or particles.
+    SyntheticRenderBinContents contents(numLeaves, 1);
+
+    double sortTime[2] = { 0.0, 0.0 };
+    bool ordered[2] = { true, true };
+
+    bool previousUseRadixDepthSort = osgUtil::RenderBin::getUseRadixDepthSort();
+
+    for(unsigned int radix=0; radix<2; ++radix)
+    {
+        osgUtil::RenderBin::setUseRadixDepthSort(radix!=0);
+
+        osg::ref_ptr<osgUtil::RenderBin> bin = new osgUtil::RenderBin(sortMode);
+        bin->setUseFlattenedRenderLeafArray(false);
+
+        for(unsigned int run=0; run<numRuns; ++run)
+        {
+            contents.fill(*bin);
+
+            osg::Timer_t startTick = osg::Timer::instance()->tick();
+            bin->sort();
+            osg::Timer_t sortTick = osg::Timer::instance()->tick();
+
+            sortTime[radix] += osg::Timer::instance()->delta_m(startTick, sortTick);
+
+            if (!checkDrawOrder(*bin) || bin->getRenderLeafList().size()!=numLeaves) ordered[radix] = false;
+        }
+
+        bin->reset();
+    }
+
+    osgUtil::RenderBin::setUseRadixDepthSort(previousUseRadixDepthSort);
+
+    std::cout<<sortModeName<<"\t"<<sortTime[0]/numRuns<<"\t"<<sortTime[1]/numRuns<<std::endl;
+
+    if (!ordered[0] || !ordered[1])
+    {
+        std::cout<<"    Error: leaves not in "<<sortModeName<<" order, std::sort "<<(ordered[0]?"ok":"failed")
+                 <<", radix sort "<<(ordered[1]?"ok":"failed")<<std::endl;
+    }
+}
+
+void runDepthSortPerformanceTests(unsigned int numLeaves)
+{
+    std::cout<<"**** RenderBin depth sort performance tests ******"<<std::endl;
+    std::cout<<numLeaves<<" leaves, times in ms averaged over 10 frames."<<std::endl;
+    std::cout<<"SortMode\t\tstd::sort\tradix sort"<<std::endl;
+
+    runDepthSortTest(numLeaves, osgUtil::RenderBin::SORT_FRONT_TO_BACK, "SORT_FRONT_TO_BACK");
+    runDepthSortTest(numLeaves, osgUtil::RenderBin::SORT_BACK_TO_FRONT, "SORT_BACK_TO_FRONT");
+
+    std::cout<<std::endl;
+}
@@ -0,0 +1,169 @@
+/* OpenSceneGraph example, osgunittests.
+*
+*  Permission is hereby granted, free of charge, to any person obtaining a copy
+*  of this software and associated documentation files (the "Software"), to deal
+*  in the Software without restriction, including without limitation the rights
+*  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+*  copies of the Software, and to permit persons to whom the Software is
+*  furnished to do so, subject to the following conditions:
+*
+*  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+*  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+*  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+*  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+*  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+*  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+*  THE SOFTWARE.
+*/
+
+#include "SimplifierPerformance.h"
+
+#include <osg/Geometry>
+#include <osg/Timer>
+#include <osg/TriangleIndexFunctor>
+#include <osgUtil/Simplifier>
+
+#include <iostream>
+#include <map>
+#include <math.h>
+
+static float height(float x, float y)
+{
+    return 10.0f*sinf(x*0.05f)*cosf(y*0.07f) + 2.0f*sinf(x*0.6f+y*0.4f);
+}
+
+static osg::Geometry* createTerrain(unsigned int gridSize)
+{
+    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array;
+    osg::ref_ptr<osg::Vec2Array> texcoords = new osg::Vec2Array;
+    for(unsigned int r=0; r<=gridSize; ++r)
+    {
+        for(unsigned int c=0; c<=gridSize; ++c)
+        {
+            float x = float(c), y = float(r);
+            vertices->push_back(osg::Vec3(x, y, height(x, y)));
+
+            osg::Vec3 normal(height(x-0.5f, y)-height(x+0.5f, y), height(x, y-0.5f)-height(x, y+0.5f), 1.0f);
+            normal.normalize();
+            normals->push_back(normal);
+
+            texcoords->push_back(osg::Vec2(x/float(gridSize), y/float(gridSize)));
+        }
+    }
+
+    osg::ref_ptr<osg::DrawElementsUInt> triangles = new osg::DrawElementsUInt(GL_TRIANGLES);
+    for(unsigned int r=0; r<gridSize; ++r)
+    {
+        for(unsigned int c=0; c<gridSize; ++c)
+        {
+            unsigned int i = r*(gridSize+1)+c;
+            triangles->push_back(i); triangles->push_back(i+1); triangles->push_back(i+gridSize+2);
+            triangles->push_back(i); triangles->push_back(i+gridSize+2); triangles->push_back(i+gridSize+1);
+        }
+    }
+
+    osg::Geometry* geometry = new osg::Geometry;
+    geometry->setVertexArray(vertices.get());
+    geometry->setNormalArray(normals.get(), osg::Array::BIND_PER_VERTEX);
+    geometry->setTexCoordArray(0, texcoords.get());
+    geometry->addPrimitiveSet(triangles.get());
+    return geometry;
+}
+
+struct CheckTriangleOperator
+{
+    CheckTriangleOperator(): numVertices(0), numTriangles(0), numInvalid(0) {}
+
+    unsigned int numVertices;
+    unsigned int numTriangles;
+    unsigned int numInvalid;
+
+    typedef std::map< std::pair<unsigned int, unsigned int>, unsigned int > EdgeCounts;
+    EdgeCounts edgeCounts;
+
+    inline void addEdge(unsigned int p1, unsigned int p2)
+    {
+        ++edgeCounts[p1<p2 ? std::make_pair(p1, p2) : std::make_pair(p2, p1)];
+    }
+
+    inline void operator()(unsigned int p1, unsigned int p2, unsigned int p3)
+    {
+        ++numTriangles;
+        if (p1>=numVertices || p2>=numVertices || p3>=numVertices || p1==p2 || p2==p3 || p3==p1) ++numInvalid;
+
+        addEdge(p1, p2);
+        addEdge(p2, p3);
+        addEdge(p3, p1);
+    }
+};
+
+static bool onSameBorder(const osg::Vec3& v1, const osg::Vec3& v2, float gridSize)
+{
+    return (v1.x()==0.0f && v2.x()==0.0f) || (v1.x()==gridSize && v2.x()==gridSize) ||
+           (v1.y()==0.0f && v2.y()==0.0f) || (v1.y()==gridSize && v2.y()==gridSize);
+}
+
+// the terrain should stay watertight, with every edge away from the border of the grid shared by exactly two triangles
+static unsigned int countUnmatchedInteriorEdges(const CheckTriangleOperator& checkTriangles, const osg::Vec3Array& vertices, unsigned int gridSize)
+{
+    unsigned int numUnmatched = 0;
+    for(CheckTriangleOperator::EdgeCounts::const_iterator itr = checkTriangles.edgeCounts.begin();
+        itr != checkTriangles.edgeCounts.end();
+        ++itr)
+    {
+        if (itr->second==2) continue;
+        if (itr->first.second>=vertices.size()) continue;
+        if (itr->second==1 && onSameBorder(vertices[itr->first.first], vertices[itr->first.second], float(gridSize))) continue;
+        ++numUnmatched;
+    }
+    return numUnmatched;
+}
+
+static void runSimplifierTest(unsigned int gridSize, float sampleRatio)
+{
+    osg::ref_ptr<osg::Geometry> geometry = createTerrain(gridSize);
+    unsigned int numTrianglesIn = gridSize*gridSize*2;
+
+    osgUtil::Simplifier simplifier(sampleRatio);
+    simplifier.setSmoothing(false);
+    simplifier.setDoTriStrip(false);
+
+    osg::ElapsedTime elapsedTime;
+    simplifier.simplify(*geometry);
+    double simplifyTime = elapsedTime.elapsedTime_m();
+
+    const osg::Vec3Array* vertices = dynamic_cast<const osg::Vec3Array*>(geometry->getVertexArray());
+
+    osg::TriangleIndexFunctor<CheckTriangleOperator> checkTriangles;
+    checkTriangles.numVertices = vertices ? vertices->size() : 0;
+    geometry->accept(checkTriangles);
+
+    // the simplified points should still lie close to the original surface
+    float maxError = 0.0f;
+    unsigned int numUnmatchedEdges = 0;
+    if (vertices)
+    {
+        for(osg::Vec3Array::const_iterator itr = vertices->begin(); itr != vertices->end(); ++itr)
+        {
+            maxError = osg::maximum(maxError, fabsf(itr->z()-height(itr->x(), itr->y())));
+        }
+
+        numUnmatchedEdges = countUnmatchedInteriorEdges(checkTriangles, *vertices, gridSize);
+    }
+
+    std::cout<<"    ratio "<<sampleRatio<<" : "<<simplifyTime<<"ms, triangles in "<<numTrianglesIn<<", out "<<checkTriangles.numTriangles
+             <<", vertices "<<checkTriangles.numVertices<<", invalid triangles "<<checkTriangles.numInvalid
+             <<", unmatched interior edges "<<numUnmatchedEdges<<", max height error "<<maxError<<std::endl;
+}
+
+void runSimplifierPerformanceTests(unsigned int gridSize)
+{
+    std::cout<<"**** Simplifier performance tests ******"<<std::endl;
+    std::cout<<"    terrain grid "<<gridSize<<" x "<<gridSize<<" with normals and texture coordinates"<<std::endl;
+
+    runSimplifierTest(gridSize, 0.5f);
+    runSimplifierTest(gridSize, 0.1f);
+    runSimplifierTest(gridSize, 2.0f);
+    runSimplifierTest(gridSize, 4.0f);
+}
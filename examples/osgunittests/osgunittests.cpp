@@ -30,6 +30,16 @@
 #include "UnitTestFramework.h"
 #include "performance.h"
 #include "MultiThreadRead.h"
+#include "DatabasePagerPerformance.h"
+#include "ReferencedPerformance.h"
+#include "RenderBinPerformance.h"
+#include "FrustumCullPerformance.h"
+#include "BinaryReadPerformance.h"
+#include "AsyncReadPerformance.h"
+#include "RegistryLookupPerformance.h"
+#include "FileCachePerformance.h"
+#include "IntersectionPerformance.h"
+#include "SimplifierPerformance.h"
 
 #include <iostream>
 
@@ -572,6 +582,17 @@ int main( int argc, char** argv )
     arguments.getApplicationUsage()->addCommandLineOption("matrix","Display qualified tests.");
     arguments.getApplicationUsage()->addCommandLineOption("performance","Display qualified tests.");
     arguments.getApplicationUsage()->addCommandLineOption("read-threads <numthreads>","Run multi-thread reading test.");
+    arguments.getApplicationUsage()->addCommandLineOption("pager-queue","Run DatabasePager request queue performance test.");
+    arguments.getApplicationUsage()->addCommandLineOption("renderbin <numleaves>","Run RenderBin sort and draw order performance test.");
+    arguments.getApplicationUsage()->addCommandLineOption("depthsort <numleaves>","Run RenderBin std::sort versus radix depth sort performance test.");
+    arguments.getApplicationUsage()->addCommandLineOption("frustum-cull <numspheres>","Run scalar versus batch Polytope bounding sphere culling performance test.");
+    arguments.getApplicationUsage()->addCommandLineOption("osgb-read <numvertices>","Run .osgb binary read performance test on a synthetic Geometry.");
+    arguments.getApplicationUsage()->addCommandLineOption("async-read <numfiles>","Run synchronous versus osgDB::AsyncReader read performance test.");
+    arguments.getApplicationUsage()->addCommandLineOption("registry-lookup <iterations>","Run osgDB::Registry plugin lookup and findDataFile performance test.");
+    arguments.getApplicationUsage()->addCommandLineOption("filecache <numfiles>","Run osgDB::FileCache write behind, statistics and eviction test.");
+    arguments.getApplicationUsage()->addCommandLineOption("intersect <gridsize>","Run KdTree versus BoundingVolumeHierarchy build, single versus packet line segment intersection and KdTree osgb round trip performance test.");
+    arguments.getApplicationUsage()->addCommandLineOption("simplify <gridsize>","Run Simplifier performance test on a terrain grid.");
+    arguments.getApplicationUsage()->addCommandLineOption("ref-contention <maxnumthreads>","Run contended ref/unref and observer_ptr lock performance test.");
 
 
     if (arguments.argc()<=1)
@@ -610,6 +631,39 @@ int main( int argc, char** argv )
     bool performanceTest = false;
     while (arguments.read("p") || arguments.read("performance")) performanceTest = true;
 
+    bool pagerQueueTest = false;
+    while (arguments.read("pager-queue")) pagerQueueTest = true;
+
+    unsigned int refContentionThreads = 0;
+    while (arguments.read("ref-contention", refContentionThreads)) {}
+
+    unsigned int renderBinLeaves = 0;
+    while (arguments.read("renderbin", renderBinLeaves)) {}
+
+    unsigned int depthSortLeaves = 0;
+    while (arguments.read("depthsort", depthSortLeaves)) {}
+
+    unsigned int frustumCullSpheres = 0;
+    while (arguments.read("frustum-cull", frustumCullSpheres)) {}
+
+    unsigned int osgbReadVertices = 0;
+    while (arguments.read("osgb-read", osgbReadVertices)) {}
+
+    unsigned int asyncReadFiles = 0;
+    while (arguments.read("async-read", asyncReadFiles)) {}
+
+    unsigned int registryLookupIterations = 0;
+    while (arguments.read("registry-lookup", registryLookupIterations)) {}
+
+    unsigned int fileCacheFiles = 0;
+    while (arguments.read("filecache", fileCacheFiles)) {}
+
+    unsigned int intersectGridSize = 0;
+    while (arguments.read("intersect", intersectGridSize)) {}
+
+    unsigned int simplifyGridSize = 0;
+    while (arguments.read("simplify", simplifyGridSize)) {}
+
     // if user request help write it out to cout.
     if (arguments.read("-h") || arguments.read("--help"))
     {
@@ -680,6 +734,61 @@ int main( int argc, char** argv )
         runPerformanceTests();
     }
 
+    if (pagerQueueTest)
+    {
+        runDatabasePagerQueueTests();
+    }
+
+    if (refContentionThreads>0)
+    {
+        runReferencedContentionTests(refContentionThreads);
+    }
+
+    if (renderBinLeaves>0)
+    {
+        runRenderBinPerformanceTests(renderBinLeaves);
+    }
+
+    if (depthSortLeaves>0)
+    {
+        runDepthSortPerformanceTests(depthSortLeaves);
+    }
+
+    if (frustumCullSpheres>0)
+    {
+        runFrustumCullPerformanceTests(frustumCullSpheres);
+    }
+
+    if (osgbReadVertices>0)
+    {
+        runBinaryReadPerformanceTests(osgbReadVertices);
+    }
+
+    if (asyncReadFiles>0)
+    {
+        runAsyncReadPerformanceTests(asyncReadFiles);
+    }
+
+    if (registryLookupIterations>0)
+    {
+        runRegistryLookupPerformanceTests(registryLookupIterations);
+    }
+
+    if (fileCacheFiles>0)
+    {
+        runFileCachePerformanceTests(fileCacheFiles);
+    }
+
+    if (intersectGridSize>0)
+    {
+        runIntersectionPerformanceTests(intersectGridSize);
+    }
+
+    if (simplifyGridSize>0)
+    {
+        runSimplifierPerformanceTests(simplifyGridSize);
+    }
+
     if (numReadThreads>0)
     {
         runMultiThreadReadTests(numReadThreads, arguments);
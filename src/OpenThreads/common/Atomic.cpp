@@ -122,6 +122,19 @@ Atomic::exchange(unsigned value)
 #endif
 }
 
+bool
+Atomic::assign(unsigned valueNew, unsigned valueOld)
+{
+#if defined(_OPENTHREADS_ATOMIC_USE_GCC_BUILTINS)
+    return __sync_bool_compare_and_swap(&_value, valueOld, valueNew);
+#elif defined(_OPENTHREADS_ATOMIC_USE_WIN32_INTERLOCKED)
+    return (long)valueOld == InterlockedCompareExchange(&_value, (long)valueNew, (long)valueOld);
+#elif defined(_OPENTHREADS_ATOMIC_USE_BSD_ATOMIC)
+    return OSAtomicCompareAndSwap32((int32_t)valueOld, (int32_t)valueNew, &_value);
+#else
+# error This implementation should happen inline in the include file
+#endif
+}
 
 Atomic::operator unsigned() const
 {
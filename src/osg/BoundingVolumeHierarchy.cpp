@@ -0,0 +1,426 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osg/BoundingVolumeHierarchy>
+#include <osg/TemplatePrimitiveIndexFunctor>
+#include <osg/Notify>
+
+#include <algorithm>
+#include <float.h>
+#include <string.h>
+
+using namespace osg;
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// BuildBoundingVolumeHierarchy - class used for building a single BoundingVolumeHierarchy
+
+struct BuildBoundingVolumeHierarchy
+{
+    struct Primitive
+    {
+        osg::BoundingBox                            bb;
+        osg::Vec3                                   center;
+        BoundingVolumeHierarchy::Triangle           triangle;
+    };
+    typedef std::vector< Primitive > Primitives;
+
+    struct Bin
+    {
+        osg::BoundingBox    bb;
+        unsigned int        count;
+    };
+    typedef std::vector< Bin > Bins;
+
+    BuildBoundingVolumeHierarchy(BoundingVolumeHierarchy& bvh, BoundingVolumeHierarchy::BuildOptions& options):
+        _bvh(bvh),
+        _options(options),
+        _primitiveIndex(0) {}
+
+    bool build(osg::Geometry* geometry);
+
+    void divide(unsigned int nodeIndex, unsigned int begin, unsigned int end, unsigned int level);
+
+    void createLeaf(unsigned int nodeIndex, unsigned int begin, unsigned int end);
+
+    void addTriangle(unsigned int p0, unsigned int p1, unsigned int p2);
+
+    static inline float surfaceArea(const osg::BoundingBox& bb)
+    {
+        osg::Vec3 dimensions = bb._max-bb._min;
+        return 2.0f*(dimensions.x()*dimensions.y() + dimensions.y()*dimensions.z() + dimensions.z()*dimensions.x());
+    }
+
+    // intersection cost is measured in packets as the triangles are tested four at a time.
+    static inline float numPackets(unsigned int count) { return static_cast<float>((count+3)/4); }
+
+    BoundingVolumeHierarchy&                    _bvh;
+    BoundingVolumeHierarchy::BuildOptions&      _options;
+
+    const osg::Vec3Array*                       _vertices;
+    unsigned int                                _primitiveIndex;
+    Primitives                                  _primitives;
+    Bins                                        _bins;
+    std::vector<float>                          _rightAreas;
+    std::vector<unsigned int>                   _rightCounts;
+
+protected:
+
+    BuildBoundingVolumeHierarchy& operator = (const BuildBoundingVolumeHierarchy&) { return *this; }
+};
+
+struct TriangleCollector
+{
+    TriangleCollector():
+        _build(0)
+    {
+    }
+
+    // points and lines aren't stored, but still count as primitives so the primitive indices match the geometry.
+    inline void operator () (unsigned int)
+    {
+        ++_build->_primitiveIndex;
+    }
+
+    inline void operator () (unsigned int, unsigned int)
+    {
+        ++_build->_primitiveIndex;
+    }
+
+    inline void operator () (unsigned int p0, unsigned int p1, unsigned int p2)
+    {
+        _build->addTriangle(p0, p1, p2);
+        ++_build->_primitiveIndex;
+    }
+
+    // quads are split the same way as the intersectors split them.
+    inline void operator () (unsigned int p0, unsigned int p1, unsigned int p2, unsigned int p3)
+    {
+        _build->addTriangle(p0, p1, p3);
+        _build->addTriangle(p1, p2, p3);
+        ++_build->_primitiveIndex;
+    }
+
+    BuildBoundingVolumeHierarchy* _build;
+};
+
+void BuildBoundingVolumeHierarchy::addTriangle(unsigned int p0, unsigned int p1, unsigned int p2)
+{
+    const osg::Vec3& v0 = (*_vertices)[p0];
+    const osg::Vec3& v1 = (*_vertices)[p1];
+    const osg::Vec3& v2 = (*_vertices)[p2];
+
+    // discard degenerate triangles
+    if (v0==v1 || v1==v2 || v2==v0) return;
+
+    Primitive primitive;
+    primitive.bb.expandBy(v0);
+    primitive.bb.expandBy(v1);
+    primitive.bb.expandBy(v2);
+    primitive.center = primitive.bb.center();
+    primitive.triangle = BoundingVolumeHierarchy::Triangle(_primitiveIndex, p0, p1, p2);
+
+    _primitives.push_back(primitive);
+}
+
+bool BuildBoundingVolumeHierarchy::build(osg::Geometry* geometry)
+{
+    osg::Vec3Array* vertices = dynamic_cast<osg::Vec3Array*>(geometry->getVertexArray());
+    if (!vertices) return false;
+
+    if (vertices->size() <= _options._targetNumTrianglesPerLeaf) return false;
+
+    _vertices = vertices;
+    _bvh.setVertices(vertices);
+
+    _primitives.reserve(vertices->size()*2);
+
+    osg::TemplatePrimitiveIndexFunctor<TriangleCollector> collectTriangles;
+    collectTriangles._build = this;
+    geometry->accept(collectTriangles);
+
+    _options._numVerticesProcessed += vertices->size();
+
+    if (_primitives.empty()) return false;
+
+    unsigned int numBins = osg::clampBetween(_options._numBins, 2u, 256u);
+    _bins.resize(numBins);
+    _rightAreas.resize(numBins);
+    _rightCounts.resize(numBins);
+
+    _bvh.getNodes().reserve(2*_primitives.size()/osg::maximum(_options._targetNumTrianglesPerLeaf, 1u) + 1);
+    _bvh.getTrianglePackets().reserve(_primitives.size()/4 + 1);
+
+    _bvh.getNodes().push_back(BoundingVolumeHierarchy::Node());
+    divide(0, 0, _primitives.size(), 0);
+
+    return true;
+}
+
+void BuildBoundingVolumeHierarchy::divide(unsigned int nodeIndex, unsigned int begin, unsigned int end, unsigned int level)
+{
+    osg::BoundingBox bb;
+    osg::BoundingBox centerBB;
+    for(unsigned int i=begin; i<end; ++i)
+    {
+        bb.expandBy(_primitives[i].bb);
+        centerBB.expandBy(_primitives[i].center);
+    }
+    _bvh.getNodes()[nodeIndex].bb = bb;
+
+    unsigned int count = end-begin;
+    unsigned int maxNumLevels = osg::minimum(_options._maxNumLevels, static_cast<unsigned int>(BoundingVolumeHierarchy::MAXIMUM_DEPTH));
+    if (count<=_options._targetNumTrianglesPerLeaf || level>=maxNumLevels)
+    {
+        createLeaf(nodeIndex, begin, end);
+        return;
+    }
+
+    // find the lowest cost split from binning the primitive centers along each axis.
+    unsigned int numBins = _bins.size();
+    float parentArea = surfaceArea(bb);
+    float inverseParentArea = parentArea>0.0f ? 1.0f/parentArea : 0.0f;
+    float bestCost = FLT_MAX;
+    int bestAxis = -1;
+    unsigned int bestBin = 0;
+
+    for(int axis=0; axis<3; ++axis)
+    {
+        float extent = centerBB._max[axis]-centerBB._min[axis];
+        if (extent<=0.0f) continue;
+
+        float scale = static_cast<float>(numBins)*(1.0f-1e-5f)/extent;
+
+        for(unsigned int b=0; b<numBins; ++b)
+        {
+            _bins[b].bb.init();
+            _bins[b].count = 0;
+        }
+
+        for(unsigned int i=begin; i<end; ++i)
+        {
+            unsigned int b = osg::minimum(static_cast<unsigned int>((_primitives[i].center[axis]-centerBB._min[axis])*scale), numBins-1);
+            _bins[b].bb.expandBy(_primitives[i].bb);
+            ++_bins[b].count;
+        }
+
+        // accumulate the bins right of each split plane, then sweep from the left evaluating each split.
+        osg::BoundingBox rightBB;
+        unsigned int rightCount = 0;
+        for(unsigned int b=numBins-1; b>0; --b)
+        {
+            rightBB.expandBy(_bins[b].bb);
+            rightCount += _bins[b].count;
+            _rightAreas[b-1] = rightBB.valid() ? surfaceArea(rightBB) : 0.0f;
+            _rightCounts[b-1] = rightCount;
+        }
+
+        osg::BoundingBox leftBB;
+        unsigned int leftCount = 0;
+        for(unsigned int b=0; b<numBins-1; ++b)
+        {
+            leftBB.expandBy(_bins[b].bb);
+            leftCount += _bins[b].count;
+            if (leftCount==0 || _rightCounts[b]==0) continue;
+
+            float cost = _options._traversalCost +
+                         (surfaceArea(leftBB)*numPackets(leftCount) + _rightAreas[b]*numPackets(_rightCounts[b]))*inverseParentArea;
+            if (cost<bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = b;
+            }
+        }
+    }
+
+    unsigned int middle = begin;
+    if (bestAxis>=0)
+    {
+        if (bestCost>=numPackets(count) && count<=_options._maxNumTrianglesPerLeaf)
+        {
+            // splitting costs more than testing all the triangles.
+            createLeaf(nodeIndex, begin, end);
+            return;
+        }
+
+        float scale = static_cast<float>(numBins)*(1.0f-1e-5f)/(centerBB._max[bestAxis]-centerBB._min[bestAxis]);
+        float minimum = centerBB._min[bestAxis];
+        for(unsigned int i=begin; i<end; ++i)
+        {
+            unsigned int b = osg::minimum(static_cast<unsigned int>((_primitives[i].center[bestAxis]-minimum)*scale), numBins-1);
+            if (b<=bestBin) std::swap(_primitives[i], _primitives[middle++]);
+        }
+    }
+
+    if (middle==begin || middle==end)
+    {
+        // all the centers coincide so no split can separate them, fall back to splitting the range in half.
+        if (count<=_options._maxNumTrianglesPerLeaf)
+        {
+            createLeaf(nodeIndex, begin, end);
+            return;
+        }
+        middle = begin+count/2;
+    }
+
+    // the first child directly follows its parent, the second is placed after all of the first child's descendants.
+    _bvh.getNodes().push_back(BoundingVolumeHierarchy::Node());
+    divide(nodeIndex+1, begin, middle, level+1);
+
+    unsigned int secondChild = _bvh.getNodes().size();
+    _bvh.getNodes().push_back(BoundingVolumeHierarchy::Node());
+    _bvh.getNodes()[nodeIndex].offset = secondChild;
+    divide(secondChild, middle, end, level+1);
+}
+
+void BuildBoundingVolumeHierarchy::createLeaf(unsigned int nodeIndex, unsigned int begin, unsigned int end)
+{
+    BoundingVolumeHierarchy::TrianglePacketList& packets = _bvh.getTrianglePackets();
+    BoundingVolumeHierarchy::TriangleList& triangles = _bvh.getTriangles();
+
+    BoundingVolumeHierarchy::Node& node = _bvh.getNodes()[nodeIndex];
+    node.offset = packets.size();
+    node.count = end-begin;
+
+    for(unsigned int i=begin; i<end; i+=4)
+    {
+        // unused lanes are left as degenerate triangles which never intersect.
+        BoundingVolumeHierarchy::TrianglePacket packet;
+        memset(&packet, 0, sizeof(packet));
+
+        for(unsigned int lane=0; lane<4; ++lane)
+        {
+            if (i+lane<end)
+            {
+                const BoundingVolumeHierarchy::Triangle& triangle = _primitives[i+lane].triangle;
+                const osg::Vec3& v0 = (*_vertices)[triangle.p0];
+                osg::Vec3 e1 = (*_vertices)[triangle.p1]-v0;
+                osg::Vec3 e2 = (*_vertices)[triangle.p2]-v0;
+                for(int c=0; c<3; ++c)
+                {
+                    packet.v0[c][lane] = v0[c];
+                    packet.e1[c][lane] = e1[c];
+                    packet.e2[c][lane] = e2[c];
+                }
+                triangles.push_back(triangle);
+            }
+            else
+            {
+                triangles.push_back(BoundingVolumeHierarchy::Triangle());
+            }
+        }
+
+        packets.push_back(packet);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// BoundingVolumeHierarchy::BuildOptions
+
+BoundingVolumeHierarchy::BuildOptions::BuildOptions():
+    _numVerticesProcessed(0),
+    _targetNumTrianglesPerLeaf(4),
+    _maxNumTrianglesPerLeaf(16),
+    _maxNumLevels(48),
+    _numBins(16),
+    _traversalCost(1.0f)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// BoundingVolumeHierarchy::Segment
+
+BoundingVolumeHierarchy::Segment::Segment(const osg::Vec3& start, const osg::Vec3& end):
+    _origin(start),
+    _direction(end-start),
+    // enough for the handful of roundings made computing each slab distance.
+    _roundingTolerance(1.0f+4.0f*FLT_EPSILON)
+{
+    for(int axis=0; axis<3; ++axis)
+    {
+        // avoid infinities, which produce NaNs when the segment lies in a slab plane.
+        float d = _direction[axis];
+        if (fabsf(d)<1e-30f) d = (d<0.0f) ? -1e-30f : 1e-30f;
+        _inverseDirection[axis] = 1.0f/d;
+    }
+}
+
+unsigned int BoundingVolumeHierarchy::Segment::intersects(const TrianglePacket& packet) const
+{
+    const float ox = _origin.x(), oy = _origin.y(), oz = _origin.z();
+    const float dx = _direction.x(), dy = _direction.y(), dz = _direction.z();
+
+    // relative tolerance on the barycentric and segment bounds keeps the test conservative,
+    // the functor passed to intersect() makes the exact test on the triangles passed to it.
+    const float tolerance = 1e-5f;
+
+    // evaluate all four lanes with the same branch free arithmetic so the compiler can vectorize the loop.
+    int hit[4];
+    for(int lane=0; lane<4; ++lane)
+    {
+        const float e1x = packet.e1[0][lane], e1y = packet.e1[1][lane], e1z = packet.e1[2][lane];
+        const float e2x = packet.e2[0][lane], e2y = packet.e2[1][lane], e2z = packet.e2[2][lane];
+
+        const float px = dy*e2z - dz*e2y;
+        const float py = dz*e2x - dx*e2z;
+        const float pz = dx*e2y - dy*e2x;
+
+        const float det = px*e1x + py*e1y + pz*e1z;
+
+        const float tx = ox - packet.v0[0][lane];
+        const float ty = oy - packet.v0[1][lane];
+        const float tz = oz - packet.v0[2][lane];
+
+        const float qx = ty*e1z - tz*e1y;
+        const float qy = tz*e1x - tx*e1z;
+        const float qz = tx*e1y - ty*e1x;
+
+        // scale by the sign of the determinant rather than dividing by it.
+        const float sign = det<0.0f ? -1.0f : 1.0f;
+        const float absDet = det*sign;
+        const float u = (px*tx + py*ty + pz*tz)*sign;
+        const float v = (qx*dx + qy*dy + qz*dz)*sign;
+        const float t = (qx*e2x + qy*e2y + qz*e2z)*sign;
+        const float margin = absDet*tolerance;
+
+        hit[lane] = (absDet>0.0f) & (u>=-margin) & (v>=-margin) & (u+v<=absDet+margin) & (t>=-margin) & (t<=absDet+margin);
+    }
+
+    return hit[0] | (hit[1]<<1) | (hit[2]<<2) | (hit[3]<<3);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// BoundingVolumeHierarchy
+
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+{
+}
+
+BoundingVolumeHierarchy::BoundingVolumeHierarchy(const BoundingVolumeHierarchy& rhs, const osg::CopyOp& copyop):
+    Shape(rhs, copyop),
+    _vertices(rhs._vertices),
+    _nodes(rhs._nodes),
+    _trianglePackets(rhs._trianglePackets),
+    _triangles(rhs._triangles)
+{
+}
+
+bool BoundingVolumeHierarchy::build(BuildOptions& options, osg::Geometry* geometry)
+{
+    BuildBoundingVolumeHierarchy build(*this, options);
+    return build.build(geometry);
+}
@@ -16,6 +16,8 @@
 #include <osg/Drawable>
 #include <osg/Geode>
 
+#include <typeinfo>
+
 using namespace osg;
 
 ComputeBoundsVisitor::ComputeBoundsVisitor(TraversalMode traversalMode):
@@ -29,6 +31,22 @@ void ComputeBoundsVisitor::reset()
     _bb.init();
 }
 
+osg::NodeVisitor* ComputeBoundsVisitor::cloneForParallelTraversal() const
+{
+    // cloning a subclass as a plain ComputeBoundsVisitor would slice away its behaviour.
+    if (typeid(*this)!=typeid(ComputeBoundsVisitor)) return 0;
+
+    ComputeBoundsVisitor* cbv = new ComputeBoundsVisitor(getTraversalMode());
+    cbv->_matrixStack = _matrixStack;
+    return cbv;
+}
+
+void ComputeBoundsVisitor::mergeParallelTraversal(osg::NodeVisitor& nv)
+{
+    ComputeBoundsVisitor* cbv = dynamic_cast<ComputeBoundsVisitor*>(&nv);
+    if (cbv) _bb.expandBy(cbv->_bb);
+}
+
 void ComputeBoundsVisitor::getPolytope(osg::Polytope& polytope, float margin) const
 {
     float delta = _bb.radius()*margin;
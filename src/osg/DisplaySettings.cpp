@@ -342,7 +342,7 @@ static ApplicationUsageProxy DisplaySetting_e15(ApplicationUsage::ENVIRONMENTAL_
         "OFF | ON Disable/enable the hint to use osgUtil::SceneView to implement stereo when required..");
 static ApplicationUsageProxy DisplaySetting_e16(ApplicationUsage::ENVIRONMENTAL_VARIABLE,
         "OSG_NUM_DATABASE_THREADS <int>",
-        "Set the hint for the total number of threads to set up in the DatabasePager.");
+        "Set the hint for the total number of threads to set up in the DatabasePager, 0 to size from the number of processors.");
 static ApplicationUsageProxy DisplaySetting_e17(ApplicationUsage::ENVIRONMENTAL_VARIABLE,
         "OSG_NUM_HTTP_DATABASE_THREADS <int>",
         "Set the hint for the total number of threads dedicated to http requests to set up in the DatabasePager.");
@@ -56,6 +56,13 @@ Group::~Group()
 
 void Group::traverse(NodeVisitor& nv)
 {
+    if (nv.getParallelTraversal() &&
+        _children.size()>=nv.getParallelTraversalMinimumNumChildren() &&
+        nv.traverseInParallel(*this))
+    {
+        return;
+    }
+
     for(NodeList::iterator itr=_children.begin();
         itr!=_children.end();
         ++itr)
@@ -82,6 +82,14 @@ void Image::DataIterator::operator ++ ()
         return;
     }
 
+    if (_image->isMipmap() && (_image->getRowLength()==0 || _image->getRowLength()==_image->s()))
+    {
+        // the rows of each level are contiguous so each level is a single block
+        ++_mipmapNum;
+        assign();
+        return;
+    }
+
     if (_image->isMipmap())
     {
         // advance to next row
@@ -157,6 +165,25 @@ void Image::DataIterator::assign()
 
     //OSG_NOTICE<<"DataIterator::assign C"<<std::endl;
 
+    if (_image->isMipmap() && (_image->getRowLength()==0 || _image->getRowLength()==_image->s()))
+    {
+        // the mipmap levels aren't packed together, but the rows within each level are.
+        if (_mipmapNum>=_image->getNumMipmapLevels())
+        {
+            _currentPtr = 0;
+            _currentSize = 0;
+            return;
+        }
+
+        int s = osg::maximum(_image->s()>>_mipmapNum, 1);
+        int t = osg::maximum(_image->t()>>_mipmapNum, 1);
+        int r = osg::maximum(_image->r()>>_mipmapNum, 1);
+
+        _currentPtr = _image->getMipmapData(_mipmapNum);
+        _currentSize = Image::computeImageSizeInBytes(s, t, r, _image->getPixelFormat(), _image->getDataType(), _image->getPacking());
+        return;
+    }
+
     if (_image->isMipmap())
     {
         //OSG_NOTICE<<"DataIterator::assign D"<<std::endl;
@@ -248,6 +275,21 @@ Image::Image(const Image& image,const CopyOp& copyop):
                 memcpy(dest_ptr, itr.data(), itr.size());
                 dest_ptr += itr.size();
             }
+
+            // the mipmap levels are copied back to back, so drop any gaps there were between them.
+            int s = _s;
+            int t = _t;
+            int r = _r;
+            unsigned int offset = 0;
+            for(unsigned int i=0; i<_mipmapData.size(); ++i)
+            {
+                offset += computeImageSizeInBytes(s, t, r, _pixelFormat, _dataType, _packing);
+                _mipmapData[i] = offset;
+
+                s = osg::maximum(s>>1, 1);
+                t = osg::maximum(t>>1, 1);
+                r = osg::maximum(r>>1, 1);
+            }
         }
         else
         {
@@ -268,6 +310,7 @@ void Image::deallocateData()
         else if (_allocationMode==USE_MALLOC_FREE) ::free(_data);
         _data = 0;
     }
+    _dataOwner = 0;
 }
 
 int Image::compare(const Image& rhs) const
@@ -1151,6 +1194,24 @@ bool Image::isCompressed() const
     }
 }
 
+bool Image::areMipmapLevelsPacked() const
+{
+    int s = _s;
+    int t = _t;
+    int r = _r;
+    unsigned int offset = 0;
+    for(unsigned int i=0; i<_mipmapData.size(); ++i)
+    {
+        offset += computeImageSizeInBytes(s, t, r, _pixelFormat, _dataType, _packing);
+        if (_mipmapData[i]!=offset) return false;
+
+        s = osg::maximum(s>>1, 1);
+        t = osg::maximum(t>>1, 1);
+        r = osg::maximum(r>>1, 1);
+    }
+    return true;
+}
+
 unsigned int Image::getTotalSizeInBytesIncludingMipmaps() const
 {
     if (_mipmapData.empty())
@@ -1572,6 +1633,7 @@ void Image::swap(osg::Image& rhs)
     std::swap(_pixelAspectRatio, rhs._pixelAspectRatio);
 
     std::swap(_allocationMode, rhs._allocationMode);
+    _dataOwner.swap(rhs._dataOwner);
     std::swap(_data, rhs._data);
 
     std::swap(_mipmapData, rhs._mipmapData);
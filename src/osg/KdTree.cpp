@@ -16,9 +16,15 @@
 #include <osg/TriangleIndexFunctor>
 #include <osg/TemplatePrimitiveIndexFunctor>
 #include <osg/Timer>
+#include <osg/Types>
+#include <osg/OperationThread>
 
 #include <osg/io_utils>
 
+#include <OpenThreads/ScopedLock>
+
+#include <algorithm>
+
 using namespace osg;
 
 //#define VERBOSE_OUTPUT
@@ -31,7 +37,8 @@ using namespace osg;
 struct BuildKdTree
 {
     BuildKdTree(KdTree& kdTree):
-        _kdTree(kdTree) {}
+        _kdTree(kdTree),
+        _numThreadedLevels(0) {}
 
     typedef std::vector< osg::Vec3 >            CenterList;
     typedef std::vector< unsigned int >           Indices;
@@ -41,9 +48,17 @@ struct BuildKdTree
 
     void computeDivisions(KdTree::BuildOptions& options);
 
-    int divide(KdTree::BuildOptions& options, osg::BoundingBox& bb, int nodeIndex, unsigned int level);
+    int divide(KdTree::BuildOptions& options, KdTree::KdNodeList& nodes, osg::BoundingBox& bb, int nodeIndex, unsigned int level);
+
+    static int addNode(KdTree::KdNodeList& nodes, const KdTree::KdNode& node)
+    {
+        int num = static_cast<int>(nodes.size());
+        nodes.push_back(node);
+        return num;
+    }
 
     KdTree&             _kdTree;
+    unsigned int        _numThreadedLevels;
 
     osg::BoundingBox    _bb;
     AxisStack           _axisStack;
@@ -160,6 +175,96 @@ struct PrimitiveIndicesCollector
 
 };
 
+// Divides one subtree into its own node list so that it can be built alongside the rest of the tree,
+// index 0 of the list is reserved so that a child index of 0 still means "no child".
+class DivideSubTree
+{
+public:
+
+    DivideSubTree(BuildKdTree& buildKdTree, KdTree::BuildOptions& options, const osg::BoundingBox& bb, const KdTree::KdNode& node, unsigned int level):
+        _buildKdTree(buildKdTree),
+        _options(options),
+        _bb(bb),
+        _level(level)
+    {
+        _nodes.push_back(KdTree::KdNode());
+        _nodes.push_back(node);
+    }
+
+    void divide()
+    {
+        _buildKdTree.divide(_options, _nodes, _bb, 1, _level);
+    }
+
+    // append the subtree to nodes, returning the index of its root
+    int merge(KdTree::KdNodeList& nodes)
+    {
+        int offset = static_cast<int>(nodes.size())-1;
+        for(unsigned int i=1; i<_nodes.size(); ++i)
+        {
+            KdTree::KdNode node = _nodes[i];
+            if (node.first>=0)
+            {
+                if (node.first>0) node.first += offset;
+                if (node.second>0) node.second += offset;
+            }
+            nodes.push_back(node);
+        }
+        return 1+offset;
+    }
+
+protected:
+
+    DivideSubTree& operator = (const DivideSubTree&) { return *this; }
+
+    BuildKdTree&            _buildKdTree;
+    KdTree::BuildOptions&   _options;
+    osg::BoundingBox        _bb;
+    unsigned int            _level;
+    KdTree::KdNodeList      _nodes;
+};
+
+// Divides the left subtree into the parent's node list alongside the right subtree dividing into its own list,
+// run as a pair of jobs on the shared osg::OperationThreadPool.
+class DivideSubTreesJobs : public osg::OperationThreadPool::Jobs
+{
+public:
+
+    DivideSubTreesJobs(BuildKdTree& buildKdTree, KdTree::BuildOptions& options, KdTree::KdNodeList& nodes, const osg::BoundingBox& leftBB, int leftNodeIndex, DivideSubTree& rightSubTree, unsigned int level):
+        _buildKdTree(buildKdTree),
+        _options(options),
+        _nodes(nodes),
+        _leftBB(leftBB),
+        _leftNodeIndex(leftNodeIndex),
+        _leftChildIndex(0),
+        _rightSubTree(rightSubTree),
+        _level(level) {}
+
+    virtual void runJob(unsigned int job)
+    {
+        if (job==0) _leftChildIndex = _buildKdTree.divide(_options, _nodes, _leftBB, _leftNodeIndex, _level);
+        else _rightSubTree.divide();
+    }
+
+    int getLeftChildIndex() const { return _leftChildIndex; }
+
+protected:
+
+    DivideSubTreesJobs& operator = (const DivideSubTreesJobs&) { return *this; }
+
+    BuildKdTree&            _buildKdTree;
+    KdTree::BuildOptions&   _options;
+    KdTree::KdNodeList&     _nodes;
+    osg::BoundingBox        _leftBB;
+    int                     _leftNodeIndex;
+    int                     _leftChildIndex;
+    DivideSubTree&          _rightSubTree;
+    unsigned int            _level;
+};
+
+// minimum number of primitives in a subtree before it's worth dividing as a separate job
+static const int s_minNumPrimitivesPerJob = 4096;
+
 
 ////////////////////////////////////////////////////////////////////////////////
 //
@@ -207,8 +312,11 @@ bool BuildKdTree::build(KdTree::BuildOptions& options, osg::Geometry* geometry)
 
     int nodeNum = _kdTree.addNode(node);
 
+    _numThreadedLevels = 0;
+    while((1u<<_numThreadedLevels) < options._numThreads && _numThreadedLevels<_axisStack.size()) ++_numThreadedLevels;
+
     osg::BoundingBox bb = _bb;
-    nodeNum = divide(options, bb, nodeNum, 0);
+    nodeNum = divide(options, _kdTree.getNodes(), bb, nodeNum, 0);
 
     osg::KdTree::Indices& primitiveIndices = _kdTree.getPrimitiveIndices();
 
@@ -271,9 +379,9 @@ void BuildKdTree::computeDivisions(KdTree::BuildOptions& options)
 #endif
 }
 
-int BuildKdTree::divide(KdTree::BuildOptions& options, osg::BoundingBox& bb, int nodeIndex, unsigned int level)
+int BuildKdTree::divide(KdTree::BuildOptions& options, KdTree::KdNodeList& nodes, osg::BoundingBox& bb, int nodeIndex, unsigned int level)
 {
-    KdTree::KdNode& node = _kdTree.getNode(nodeIndex);
+    KdTree::KdNode& node = nodes[nodeIndex];
 
     bool needToDivide = level < _axisStack.size() &&
                         (node.first<0 && static_cast<unsigned int>(node.second)>options._targetNumTrianglesPerLeaf);
@@ -353,6 +461,7 @@ int BuildKdTree::divide(KdTree::BuildOptions& options, osg::BoundingBox& bb, int
         int originalLeftChildIndex = 0;
         int originalRightChildIndex = 0;
         bool insitueDivision = false;
+        DivideSubTree* rightSubTree = 0;
 
         {
             //osg::Vec3Array* vertices = kdTree._vertices.get();
@@ -400,34 +509,62 @@ int BuildKdTree::divide(KdTree::BuildOptions& options, osg::BoundingBox& bb, int
             }
             else
             {
-                originalLeftChildIndex = _kdTree.addNode(leftLeaf);
-                originalRightChildIndex = _kdTree.addNode(rightLeaf);
+                originalLeftChildIndex = addNode(nodes, leftLeaf);
+
+                if (level<_numThreadedLevels && rightLeaf.second>=s_minNumPrimitivesPerJob)
+                {
+                    // the right subtree covers a disjoint range of _primitiveIndices so can be divided alongside the left
+                    osg::BoundingBox rightBB = bb;
+                    rightBB._min[axis] = mid;
+                    rightSubTree = new DivideSubTree(*this, options, rightBB, rightLeaf, level+1);
+                }
+                else
+                {
+                    originalRightChildIndex = addNode(nodes, rightLeaf);
+                }
             }
         }
 
 
-        float restore = bb._max[axis];
-        bb._max[axis] = mid;
+        int leftChildIndex = 0;
+        int rightChildIndex = 0;
+        if (rightSubTree)
+        {
+            osg::BoundingBox leftBB = bb;
+            leftBB._max[axis] = mid;
+
+            DivideSubTreesJobs jobs(*this, options, nodes, leftBB, originalLeftChildIndex, *rightSubTree, level+1);
+            osg::OperationThreadPool::instance()->runJobs(jobs, 2);
+
+            leftChildIndex = jobs.getLeftChildIndex();
+            rightChildIndex = rightSubTree->merge(nodes);
+            delete rightSubTree;
+        }
+        else
+        {
+            float restore = bb._max[axis];
+            bb._max[axis] = mid;
 
-        //OSG_NOTICE<<"  divide leftLeaf "<<kdTree.getNode(nodeNum).first<<std::endl;
-        int leftChildIndex = originalLeftChildIndex!=0 ? divide(options, bb, originalLeftChildIndex, level+1) : 0;
+            //OSG_NOTICE<<"  divide leftLeaf "<<kdTree.getNode(nodeNum).first<<std::endl;
+            leftChildIndex = originalLeftChildIndex!=0 ? divide(options, nodes, bb, originalLeftChildIndex, level+1) : 0;
 
-        bb._max[axis] = restore;
+            bb._max[axis] = restore;
 
-        restore = bb._min[axis];
-        bb._min[axis] = mid;
+            restore = bb._min[axis];
+            bb._min[axis] = mid;
 
-        //OSG_NOTICE<<"  divide rightLeaf "<<kdTree.getNode(nodeNum).second<<std::endl;
-        int rightChildIndex = originalRightChildIndex!=0 ? divide(options, bb, originalRightChildIndex, level+1) : 0;
+            //OSG_NOTICE<<"  divide rightLeaf "<<kdTree.getNode(nodeNum).second<<std::endl;
+            rightChildIndex = originalRightChildIndex!=0 ? divide(options, nodes, bb, originalRightChildIndex, level+1) : 0;
 
-        bb._min[axis] = restore;
+            bb._min[axis] = restore;
+        }
 
 
         if (!insitueDivision)
         {
             // take a second reference to node we are working on as the std::vector<> resize could
             // have invalidate the previous node ref.
-            KdTree::KdNode& newNodeRef = _kdTree.getNode(nodeIndex);
+            KdTree::KdNode& newNodeRef = nodes[nodeIndex];
 
             newNodeRef.first = leftChildIndex;
             newNodeRef.second = rightChildIndex;
@@ -435,8 +572,8 @@ int BuildKdTree::divide(KdTree::BuildOptions& options, osg::BoundingBox& bb, int
             insitueDivision = true;
 
             newNodeRef.bb.init();
-            if (leftChildIndex!=0) newNodeRef.bb.expandBy(_kdTree.getNode(leftChildIndex).bb);
-            if (rightChildIndex!=0) newNodeRef.bb.expandBy(_kdTree.getNode(rightChildIndex).bb);
+            if (leftChildIndex!=0) newNodeRef.bb.expandBy(nodes[leftChildIndex].bb);
+            if (rightChildIndex!=0) newNodeRef.bb.expandBy(nodes[rightChildIndex].bb);
 
             if (!newNodeRef.bb.valid())
             {
@@ -449,13 +586,13 @@ int BuildKdTree::divide(KdTree::BuildOptions& options, osg::BoundingBox& bb, int
 
                 if (leftChildIndex!=0)
                 {
-                    OSG_NOTICE<<"  getNode(leftChildIndex).bb min = "<<_kdTree.getNode(leftChildIndex).bb._min<<std::endl;
-                    OSG_NOTICE<<"                                 max = "<<_kdTree.getNode(leftChildIndex).bb._max<<std::endl;
+                    OSG_NOTICE<<"  getNode(leftChildIndex).bb min = "<<nodes[leftChildIndex].bb._min<<std::endl;
+                    OSG_NOTICE<<"                                 max = "<<nodes[leftChildIndex].bb._max<<std::endl;
                 }
                 if (rightChildIndex!=0)
                 {
-                    OSG_NOTICE<<"  getNode(rightChildIndex).bb min = "<<_kdTree.getNode(rightChildIndex).bb._min<<std::endl;
-                    OSG_NOTICE<<"                              max = "<<_kdTree.getNode(rightChildIndex).bb._max<<std::endl;
+                    OSG_NOTICE<<"  getNode(rightChildIndex).bb min = "<<nodes[rightChildIndex].bb._min<<std::endl;
+                    OSG_NOTICE<<"                              max = "<<nodes[rightChildIndex].bb._max<<std::endl;
                 }
             }
         }
@@ -476,7 +613,8 @@ int BuildKdTree::divide(KdTree::BuildOptions& options, osg::BoundingBox& bb, int
 KdTree::BuildOptions::BuildOptions():
         _numVerticesProcessed(0),
         _targetNumTrianglesPerLeaf(4),
-        _maxNumLevels(32)
+        _maxNumLevels(32),
+        _numThreads(1)
 {
 }
 
@@ -494,7 +632,9 @@ KdTree::KdTree(const KdTree& rhs, const osg::CopyOp& copyop):
     _vertices(rhs._vertices),
     _primitiveIndices(rhs._primitiveIndices),
     _vertexIndices(rhs._vertexIndices),
-    _kdNodes(rhs._kdNodes)
+    _kdNodes(rhs._kdNodes),
+    _onDemandBuildOptions(rhs._onDemandBuildOptions),
+    _buildPending(rhs.getBuildPending() ? 1 : 0)
 {
 }
 
@@ -504,31 +644,266 @@ bool KdTree::build(BuildOptions& options, osg::Geometry* geometry)
     return build.build(options, geometry);
 }
 
+void KdTree::setBuildOnDemand(const BuildOptions& buildOptions)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_buildMutex);
+    _onDemandBuildOptions = buildOptions;
+    _buildPending.exchange(1);
+}
+
+bool KdTree::buildIfRequired(osg::Geometry* geometry)
+{
+    if (_buildPending!=0)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_buildMutex);
+
+        // check again now we hold the lock as another thread may have completed the build while we waited for it.
+        if (_buildPending!=0)
+        {
+            if (geometry)
+            {
+                osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+                build(_onDemandBuildOptions, geometry);
+
+                OSG_INFO<<"KdTree::buildIfRequired() built "<<_kdNodes.size()<<" nodes in "<<osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick())<<"ms"<<std::endl;
+            }
+
+            _buildPending.exchange(0);
+        }
+    }
+
+    return !_kdNodes.empty();
+}
+
+bool KdTree::validate(const osg::Geometry* geometry) const
+{
+    if (!_vertices || _kdNodes.empty()) return false;
+
+    if (geometry && geometry->getVertexArray()!=_vertices.get()) return false;
+
+    unsigned int numVertices = _vertices->size();
+    unsigned int numVertexIndices = _vertexIndices.size();
+    for(Indices::const_iterator itr = _primitiveIndices.begin();
+        itr != _primitiveIndices.end();
+        ++itr)
+    {
+        // each primitive is packed as original primitive index, number of vertices, then the vertex indices.
+        // comparisons are made against the space remaining after primitiveIndex so that they can't wrap.
+        unsigned int primitiveIndex = *itr;
+        if (primitiveIndex>=numVertexIndices || numVertexIndices-primitiveIndex<2) return false;
+
+        unsigned int numPrimitiveVertices = _vertexIndices[primitiveIndex+1];
+        if (numPrimitiveVertices<1 || numPrimitiveVertices>4 || numVertexIndices-primitiveIndex<2+numPrimitiveVertices) return false;
+
+        for(unsigned int i=0; i<numPrimitiveVertices; ++i)
+        {
+            if (_vertexIndices[primitiveIndex+2+i]>=numVertices) return false;
+        }
+    }
+
+    int numNodes = static_cast<int>(_kdNodes.size());
+    int numPrimitives = static_cast<int>(_primitiveIndices.size());
+    for(int i=0; i<numNodes; ++i)
+    {
+        const KdNode& node = _kdNodes[i];
+        if (node.first<0)
+        {
+            // widen to 64 bits so that neither the negation nor the sum can overflow.
+            int64_t istart = -static_cast<int64_t>(node.first)-1;
+            if (node.second<0 || istart+node.second>numPrimitives) return false;
+        }
+        else
+        {
+            // children are always added after their parent, which also rules out cycles.
+            if (node.first!=0 && (node.first<=i || node.first>=numNodes)) return false;
+            if (node.second!=0 && (node.second<=i || node.second>=numNodes)) return false;
+        }
+    }
+
+    return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 // KdTreeBuilder
 KdTreeBuilder::KdTreeBuilder():
-    osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN)
+    osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN),
+    _structureType(KDTREE),
+    _buildOnDemand(false),
+    _traversalDepth(0)
 {
     _kdTreePrototype = new osg::KdTree;
+    _bvhPrototype = new osg::BoundingVolumeHierarchy;
 }
 
 KdTreeBuilder::KdTreeBuilder(const KdTreeBuilder& rhs):
     osg::Object(rhs),
     osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN),
+    _structureType(rhs._structureType),
     _buildOptions(rhs._buildOptions),
-    _kdTreePrototype(rhs._kdTreePrototype)
+    _kdTreePrototype(rhs._kdTreePrototype),
+    _bvhBuildOptions(rhs._bvhBuildOptions),
+    _bvhPrototype(rhs._bvhPrototype),
+    _buildOnDemand(rhs._buildOnDemand),
+    _traversalDepth(0)
 {
 }
 
+void KdTreeBuilder::apply(osg::Node& node)
+{
+    ++_traversalDepth;
+
+    traverse(node);
+
+    --_traversalDepth;
+
+    if (_traversalDepth==0 && !_pendingGeometries.empty())
+    {
+        GeometryList geometries;
+        geometries.swap(_pendingGeometries);
+        build(geometries);
+    }
+}
+
 void KdTreeBuilder::apply(osg::Geometry& geometry)
+{
+    if (_traversalDepth>0 && _buildOptions._numThreads>1 && !_buildOnDemand)
+    {
+        // defer until the traversal completes so that the geometries can be built concurrently.
+        _pendingGeometries.push_back(&geometry);
+        return;
+    }
+
+    buildGeometry(geometry, _buildOptions, _bvhBuildOptions);
+}
+
+namespace
+{
+
+struct LargerGeometry
+{
+    bool operator() (const osg::ref_ptr<osg::Geometry>& lhs, const osg::ref_ptr<osg::Geometry>& rhs) const
+    {
+        unsigned int lhsSize = lhs->getVertexArray() ? lhs->getVertexArray()->getNumElements() : 0;
+        unsigned int rhsSize = rhs->getVertexArray() ? rhs->getVertexArray()->getNumElements() : 0;
+        return lhsSize>rhsSize;
+    }
+};
+
+}
+
+class KdTreeBuilder::BuildGeometriesJobs : public osg::OperationThreadPool::Jobs
+{
+public:
+
+    BuildGeometriesJobs(KdTreeBuilder& builder, const GeometryList& geometries, const KdTree::BuildOptions& buildOptions):
+        _builder(builder),
+        _geometries(geometries),
+        _buildOptions(buildOptions),
+        _numVerticesProcessed(geometries.size(), 0),
+        _numBVHVerticesProcessed(geometries.size(), 0) {}
+
+    virtual void runJob(unsigned int job)
+    {
+        KdTree::BuildOptions buildOptions(_buildOptions);
+        BoundingVolumeHierarchy::BuildOptions bvhBuildOptions(_builder._bvhBuildOptions);
+        buildOptions._numVerticesProcessed = 0;
+        bvhBuildOptions._numVerticesProcessed = 0;
+
+        _builder.buildGeometry(*_geometries[job], buildOptions, bvhBuildOptions);
+
+        _numVerticesProcessed[job] = buildOptions._numVerticesProcessed;
+        _numBVHVerticesProcessed[job] = bvhBuildOptions._numVerticesProcessed;
+    }
+
+    KdTreeBuilder&              _builder;
+    const GeometryList&         _geometries;
+    KdTree::BuildOptions        _buildOptions;
+    std::vector<unsigned int>   _numVerticesProcessed;
+    std::vector<unsigned int>   _numBVHVerticesProcessed;
+
+protected:
+
+    BuildGeometriesJobs& operator = (const BuildGeometriesJobs&) { return *this; }
+};
+
+void KdTreeBuilder::build(const GeometryList& geometries)
+{
+    unsigned int numThreads = std::min(static_cast<unsigned int>(geometries.size()), _buildOptions._numThreads);
+    if (numThreads<=1 || _buildOnDemand)
+    {
+        for(GeometryList::const_iterator itr = geometries.begin();
+            itr != geometries.end();
+            ++itr)
+        {
+            buildGeometry(*(*itr), _buildOptions, _bvhBuildOptions);
+        }
+        return;
+    }
+
+    // remove duplicates, as Geometry may be shared, and then start with the largest so the builds finish together.
+    GeometryList sortedGeometries(geometries);
+    std::sort(sortedGeometries.begin(), sortedGeometries.end());
+    sortedGeometries.erase(std::unique(sortedGeometries.begin(), sortedGeometries.end()), sortedGeometries.end());
+    std::stable_sort(sortedGeometries.begin(), sortedGeometries.end(), LargerGeometry());
+
+    numThreads = std::min(static_cast<unsigned int>(sortedGeometries.size()), numThreads);
+
+    // threads not needed for building geometries concurrently are used to split the individual kdtree builds.
+    KdTree::BuildOptions jobBuildOptions(_buildOptions);
+    jobBuildOptions._numThreads = std::max(1u, _buildOptions._numThreads/numThreads);
+
+    // the builds are spread over the shared osg::OperationThreadPool and the calling thread.
+    BuildGeometriesJobs jobs(*this, sortedGeometries, jobBuildOptions);
+    osg::OperationThreadPool::instance()->runJobs(jobs, static_cast<unsigned int>(sortedGeometries.size()));
+
+    for(unsigned int i=0; i<sortedGeometries.size(); ++i)
+    {
+        _buildOptions._numVerticesProcessed += jobs._numVerticesProcessed[i];
+        _bvhBuildOptions._numVerticesProcessed += jobs._numBVHVerticesProcessed[i];
+    }
+}
+
+void KdTreeBuilder::buildGeometry(osg::Geometry& geometry, KdTree::BuildOptions& buildOptions, BoundingVolumeHierarchy::BuildOptions& bvhBuildOptions)
 {
     osg::KdTree* previous = dynamic_cast<osg::KdTree*>(geometry.getShape());
-    if (previous) return;
+    if (previous)
+    {
+        // reuse KdTrees that are awaiting an on demand build or, like those read from file, still match the geometry.
+        if (previous->getBuildPending() || previous->validate(&geometry)) return;
+
+        OSG_INFO<<"KdTreeBuilder rebuilding KdTree that does not match its Geometry."<<std::endl;
+    }
+
+    if (dynamic_cast<osg::BoundingVolumeHierarchy*>(geometry.getShape())) return;
+
+    if (_structureType==BOUNDING_VOLUME_HIERARCHY)
+    {
+        osg::ref_ptr<osg::BoundingVolumeHierarchy> bvh = osg::clone(_bvhPrototype.get());
+
+        if (bvh->build(bvhBuildOptions, &geometry))
+        {
+            geometry.setShape(bvh.get());
+        }
+        return;
+    }
 
     osg::ref_ptr<osg::KdTree> kdTree = osg::clone(_kdTreePrototype.get());
 
-    if (kdTree->build(_buildOptions, &geometry))
+    if (_buildOnDemand)
+    {
+        // only worth deferring if build() would succeed, so apply the same cheap checks up front.
+        osg::Vec3Array* vertices = dynamic_cast<osg::Vec3Array*>(geometry.getVertexArray());
+        if (vertices && vertices->size() > buildOptions._targetNumTrianglesPerLeaf)
+        {
+            kdTree->setBuildOnDemand(buildOptions);
+            geometry.setShape(kdTree.get());
+        }
+        return;
+    }
+
+    if (kdTree->build(buildOptions, &geometry))
     {
         geometry.setShape(kdTree.get());
     }
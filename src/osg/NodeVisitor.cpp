@@ -35,11 +35,51 @@
 #include <osg/Camera>
 #include <osg/CameraView>
 #include <osg/Geometry>
+#include <osg/OperationThread>
 
 #include <stdlib.h>
+#include <vector>
 
 using namespace osg;
 
+namespace
+{
+
+/** Traverses one contiguous range of a Group's children per job, each with its own visitor.*/
+class ParallelTraversalJobs : public OperationThreadPool::Jobs
+{
+public:
+
+    typedef std::vector<NodeVisitor*> Visitors;
+
+    ParallelTraversalJobs(Group& group, const Visitors& visitors):
+        _group(group),
+        _visitors(visitors),
+        _chunkSize(group.getNumChildren()/static_cast<unsigned int>(visitors.size())),
+        _remainder(group.getNumChildren()%static_cast<unsigned int>(visitors.size())) {}
+
+    virtual void runJob(unsigned int job)
+    {
+        unsigned int begin = job*_chunkSize + osg::minimum(job, _remainder);
+        unsigned int end = begin + _chunkSize + (job<_remainder ? 1 : 0);
+        for(unsigned int i=begin; i<end; ++i)
+        {
+            _group.getChild(i)->accept(*_visitors[job]);
+        }
+    }
+
+protected:
+
+    ParallelTraversalJobs& operator = (const ParallelTraversalJobs&) { return *this; }
+
+    Group&          _group;
+    const Visitors& _visitors;
+    unsigned int    _chunkSize;
+    unsigned int    _remainder;
+};
+
+}
+
 NodeVisitor::NodeVisitor(TraversalMode tm):
     Object(true)
 {
@@ -49,6 +89,9 @@ NodeVisitor::NodeVisitor(TraversalMode tm):
     _traversalMode = tm;
     _traversalMask = 0xffffffff;
     _nodeMaskOverride = 0x0;
+
+    _parallelTraversal = false;
+    _parallelTraversalMinimumNumChildren = 64;
 }
 
 NodeVisitor::NodeVisitor(VisitorType type,TraversalMode tm):
@@ -60,6 +103,9 @@ NodeVisitor::NodeVisitor(VisitorType type,TraversalMode tm):
     _traversalMode = tm;
     _traversalMask = 0xffffffff;
     _nodeMaskOverride = 0x0;
+
+    _parallelTraversal = false;
+    _parallelTraversalMinimumNumChildren = 64;
 }
 
 NodeVisitor::NodeVisitor(const NodeVisitor& nv, const osg::CopyOp& copyop):
@@ -68,7 +114,9 @@ NodeVisitor::NodeVisitor(const NodeVisitor& nv, const osg::CopyOp& copyop):
     _traversalNumber(nv._traversalNumber),
     _traversalMode(nv._traversalMode),
     _traversalMask(nv._traversalMask),
-    _nodeMaskOverride(nv._nodeMaskOverride)
+    _nodeMaskOverride(nv._nodeMaskOverride),
+    _parallelTraversal(nv._parallelTraversal),
+    _parallelTraversalMinimumNumChildren(nv._parallelTraversalMinimumNumChildren)
 {
 }
 
@@ -77,6 +125,59 @@ NodeVisitor::~NodeVisitor()
     // if (_traversalVisitor) detach from _traversalVisitor;
 }
 
+bool NodeVisitor::traverseInParallel(Group& group)
+{
+    unsigned int numChildren = group.getNumChildren();
+    if (numChildren<2) return false;
+
+    OperationThreadPool* threadPool = OperationThreadPool::instance();
+    unsigned int numChunks = osg::minimum(threadPool->getNumThreads()+1, numChildren);
+
+    // create one visitor per chunk other than the first, which is traversed by this visitor.
+    typedef std::vector< ref_ptr<NodeVisitor> > Visitors;
+    Visitors clones;
+    ParallelTraversalJobs::Visitors visitors;
+    visitors.push_back(this);
+    for(unsigned int i=1; i<numChunks; ++i)
+    {
+        ref_ptr<NodeVisitor> nv = cloneForParallelTraversal();
+        if (!nv) return false;
+
+        nv->_traversalNumber = _traversalNumber;
+        nv->_frameStamp = _frameStamp;
+        nv->_traversalMode = _traversalMode;
+        nv->_traversalMask = _traversalMask;
+        nv->_nodeMaskOverride = _nodeMaskOverride;
+        nv->_nodePath = _nodePath;
+        nv->_databaseRequestHandler = _databaseRequestHandler;
+        nv->_imageRequestHandler = _imageRequestHandler;
+
+        // only fan out at the top most Group, the pool is already busy below it.
+        nv->_parallelTraversal = false;
+
+        clones.push_back(nv);
+        visitors.push_back(nv.get());
+    }
+
+    // compute any dirty bounds below the group up front, so that the concurrent traversals only ever read them.
+    group.getBound();
+
+    ParallelTraversalJobs jobs(group, visitors);
+
+    _parallelTraversal = false;
+    threadPool->runJobs(jobs, numChunks);
+    _parallelTraversal = true;
+
+    for(Visitors::iterator itr = clones.begin();
+        itr != clones.end();
+        ++itr)
+    {
+        mergeParallelTraversal(**itr);
+    }
+
+    return true;
+}
+
 void NodeVisitor::apply(Node& node)
 {
     traverse(node);
@@ -14,6 +14,8 @@
 #include <osg/ObserverNodePath>
 #include <osg/Notify>
 
+#include <OpenThreads/Thread>
+
 using namespace osg;
 
 Observer::Observer()
@@ -51,6 +53,21 @@ void ObserverSet::removeObserver(Observer* observer)
 
 Referenced* ObserverSet::addRefLock()
 {
+#if defined(_OSG_REFERENCED_USE_ATOMIC_OPERATIONS)
+    // Register as an active lock so that signalObjectDeleted() can't return, and hence the
+    // observed object can't be destructed, while we are still looking at it.
+    ++_numActiveLocks;
+
+    Referenced* observedObject = static_cast<Referenced*>(_observedObject.get());
+
+    // Only take a reference if the object isn't already on its way to being deleted, a
+    // reference count of 0 means the final unref() has happened and objectDeleted() is pending.
+    if (observedObject && observedObject->ref_if_nonzero()==0) observedObject = 0;
+
+    --_numActiveLocks;
+
+    return observedObject;
+#else
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
 
     if (!_observedObject) return 0;
@@ -66,20 +83,36 @@ Referenced* ObserverSet::addRefLock()
     }
 
     return _observedObject;
+#endif
 }
 
 void ObserverSet::signalObjectDeleted(void* ptr)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
-
-    for(Observers::iterator itr = _observers.begin();
-        itr != _observers.end();
-        ++itr)
     {
-        (*itr)->objectDeleted(ptr);
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+
+        for(Observers::iterator itr = _observers.begin();
+            itr != _observers.end();
+            ++itr)
+        {
+            (*itr)->objectDeleted(ptr);
+        }
+        _observers.clear();
+
+        // reset the observed object so that we know that it's now detached.
+#if defined(_OSG_REFERENCED_USE_ATOMIC_OPERATIONS)
+        _observedObject.assign(0, _observedObject.get());
+#else
+        _observedObject = 0;
+#endif
     }
-    _observers.clear();
 
-    // reset the observed object so that we know that it's now detached.
-    _observedObject = 0;
+#if defined(_OSG_REFERENCED_USE_ATOMIC_OPERATIONS)
+    // wait for any addRefLock() that read the observed object before it was reset,
+    // these complete in a handful of instructions so a yield loop is sufficient.
+    while (_numActiveLocks!=0)
+    {
+        OpenThreads::Thread::YieldCurrentThread();
+    }
+#endif
 }
@@ -15,6 +15,9 @@
 #include <osg/OperationThread>
 #include <osg/GraphicsContext>
 #include <osg/Notify>
+#include <osg/Math>
+
+#include <OpenThreads/ScopedLock>
 
 using namespace osg;
 using namespace OpenThreads;
@@ -458,3 +461,123 @@ void OperationThread::run()
     OSG_INFO<<"exit loop "<<this<<" isRunning()="<<isRunning()<<std::endl;
 
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  OperationThreadPool
+//
+
+namespace
+{
+
+/** Jobs shared between the calling thread and pool threads in OperationThreadPool::runJobs(), each taking the next
+  * job until none are left. Only the count is touched once all jobs are taken, so late operations are harmless.*/
+class JobsState : public osg::Referenced
+{
+public:
+
+    JobsState(OperationThreadPool::Jobs& jobs, unsigned int numJobs):
+        _jobs(jobs),
+        _numJobs(numJobs),
+        _blockCount(new RefBlockCount(numJobs))
+    {
+        _blockCount->reset();
+    }
+
+    void runJobs()
+    {
+        for(unsigned int job = (++_nextJob)-1; job<_numJobs; job = (++_nextJob)-1)
+        {
+            _jobs.runJob(job);
+            _blockCount->completed();
+        }
+    }
+
+    void block() { _blockCount->block(); }
+
+protected:
+
+    virtual ~JobsState() {}
+
+    JobsState& operator = (const JobsState&) { return *this; }
+
+    OperationThreadPool::Jobs&  _jobs;
+    unsigned int                _numJobs;
+    OpenThreads::Atomic         _nextJob;
+    ref_ptr<RefBlockCount>      _blockCount;
+};
+
+class JobsOperation : public osg::Operation
+{
+public:
+
+    JobsOperation(JobsState* state):
+        osg::Operation("Jobs", false),
+        _state(state) {}
+
+    virtual void operator () (Object*) { _state->runJobs(); }
+
+protected:
+
+    ref_ptr<JobsState> _state;
+};
+
+}
+
+OperationThreadPool::OperationThreadPool(unsigned int numThreads):
+    _operationQueue(new OperationQueue)
+{
+    for(unsigned int i=0; i<numThreads; ++i)
+    {
+        OperationThread* thread = new OperationThread;
+        thread->setOperationQueue(_operationQueue.get());
+        thread->startThread();
+        _threads.push_back(thread);
+    }
+}
+
+OperationThreadPool::~OperationThreadPool()
+{
+    for(Threads::iterator itr = _threads.begin();
+        itr != _threads.end();
+        ++itr)
+    {
+        (*itr)->setDone(true);
+    }
+}
+
+OperationThreadPool* OperationThreadPool::instance()
+{
+    static OpenThreads::Mutex s_mutex;
+    static ref_ptr<OperationThreadPool> s_threadPool;
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(s_mutex);
+    if (!s_threadPool)
+    {
+        int numProcessors = OpenThreads::GetNumberOfProcessors();
+        s_threadPool = new OperationThreadPool(numProcessors>1 ? static_cast<unsigned int>(numProcessors-1) : 1);
+    }
+    return s_threadPool.get();
+}
+
+void OperationThreadPool::runJobs(Jobs& jobs, unsigned int numJobs)
+{
+    if (numJobs==0) return;
+    if (numJobs==1)
+    {
+        jobs.runJob(0);
+        return;
+    }
+
+    unsigned int numOperations = osg::minimum(getNumThreads(), numJobs-1);
+
+    ref_ptr<JobsState> state = new JobsState(jobs, numJobs);
+    for(unsigned int i=0; i<numOperations; ++i)
+    {
+        _operationQueue->add(new JobsOperation(state.get()));
+    }
+
+    // any jobs the pool hasn't got round to are run here, so the only wait is on jobs already running.
+    state->runJobs();
+    state->block();
+}
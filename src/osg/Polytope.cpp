@@ -99,3 +99,38 @@ bool Polytope::contains(const osg::Vec3f& v0, const osg::Vec3f& v1, const osg::V
     //OSG_NOTICE<<"Polytope::contains() triangle within Polytope, src.size()="<<src.size()<<std::endl;
     return true;
 }
+
+void Polytope::contains(const Plane::value_type* centerX, const Plane::value_type* centerY, const Plane::value_type* centerZ,
+                        const Plane::value_type* radius, unsigned int numSpheres, unsigned char* result) const
+{
+    for(unsigned int i=0; i<numSpheres; ++i)
+    {
+        result[i] = 1;
+    }
+
+    ClippingMask mask = _maskStack.back();
+    if (!mask) return;
+
+    ClippingMask selector_mask = 0x1;
+    for(PlaneList::const_iterator itr=_planeList.begin();
+        itr!=_planeList.end();
+        ++itr)
+    {
+        if (mask&selector_mask)
+        {
+            const Plane::value_type a = (*itr)[0];
+            const Plane::value_type b = (*itr)[1];
+            const Plane::value_type c = (*itr)[2];
+            const Plane::value_type d = (*itr)[3];
+
+            // same arithmetic as Plane::intersect(const BoundingSphere&) so the batched and
+            // single sphere tests agree exactly, written without branches to allow vectorization.
+            for(unsigned int i=0; i<numSpheres; ++i)
+            {
+                float distance = a*centerX[i] + b*centerY[i] + c*centerZ[i] + d;
+                result[i] &= static_cast<unsigned char>(!(distance < -static_cast<float>(radius[i])));
+            }
+        }
+        selector_mask <<= 1;
+    }
+}
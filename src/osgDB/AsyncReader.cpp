@@ -0,0 +1,334 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osgDB/AsyncReader>
+#include <osgDB/Registry>
+
+#include <osg/ApplicationUsage>
+#include <osg/Notify>
+
+#include <OpenThreads/ScopedLock>
+
+#include <algorithm>
+#include <stdlib.h>
+
+using namespace osgDB;
+
+static osg::ApplicationUsageProxy AsyncReader_e0(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_NUM_ASYNC_READ_THREADS <value>","Set the number of threads used by osgDB::AsyncReader when not set explicitly.");
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Request
+//
+AsyncReader::Request::Request(ReadType readType, const std::string& fileName, const Options* options, float priority):
+    _readType(readType),
+    _fileName(fileName),
+    _options(options),
+    _priority(priority),
+    _sequenceNumber(0),
+    _status(PENDING),
+    _readResult(ReaderWriter::ReadResult::NOT_IMPLEMENTED),
+    _block(new osg::RefBlock)
+{
+    _block->set(false);
+}
+
+AsyncReader::Request::~Request()
+{
+}
+
+float AsyncReader::Request::getPriority() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    return _priority;
+}
+
+AsyncReader::Request::Status AsyncReader::Request::getStatus() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+    return _status;
+}
+
+void AsyncReader::Request::addCompletionCallback(CompletionCallback* callback)
+{
+    if (!callback) return;
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        if (_status==PENDING || _status==READING)
+        {
+            _completionCallbacks.push_back(callback);
+            return;
+        }
+    }
+
+    callback->completed(this);
+}
+
+void AsyncReader::Request::complete(Status status)
+{
+    CompletionCallbacks callbacks;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_mutex);
+        _status = status;
+        callbacks.swap(_completionCallbacks);
+    }
+
+    _block->release();
+
+    for(CompletionCallbacks::iterator itr = callbacks.begin();
+        itr != callbacks.end();
+        ++itr)
+    {
+        (*itr)->completed(this);
+    }
+}
+
+bool AsyncReader::Request::matches(ReadType readType, const std::string& fileName, const Options* options) const
+{
+    if (_readType!=readType || _fileName!=fileName) return false;
+
+    // compare Options the same way as the ObjectCache does
+    if (_options.valid()) return options && *_options==*options;
+    return options==0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  ReadThread
+//
+class AsyncReader::ReadThread : public osg::Referenced, public OpenThreads::Thread
+{
+public:
+
+    ReadThread(AsyncReader* reader):
+        _reader(reader) {}
+
+    virtual void run()
+    {
+        while(true)
+        {
+            _reader->_block->block();
+
+            osg::ref_ptr<Request> request;
+            _reader->takeNext(request);
+
+            if (!request)
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_reader->_requestMutex);
+                if (_reader->_done) break;
+                continue;
+            }
+
+            const Options* options = request->getOptions();
+            switch(request->getReadType())
+            {
+                case(READ_OBJECT): request->_readResult = Registry::instance()->readObject(request->getFileName(), options); break;
+                case(READ_IMAGE): request->_readResult = Registry::instance()->readImage(request->getFileName(), options); break;
+                case(READ_NODE): request->_readResult = Registry::instance()->readNode(request->getFileName(), options); break;
+            }
+
+            _reader->completed(request.get());
+        }
+    }
+
+protected:
+
+    virtual ~ReadThread() {}
+
+    // the AsyncReader joins its threads before it is destructed.
+    AsyncReader* _reader;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  AsyncReader
+//
+AsyncReader::AsyncReader(unsigned int numThreads):
+    _numThreads(numThreads),
+    _done(false),
+    _sequenceNumber(0),
+    _block(new osg::RefBlock)
+{
+    if (_numThreads==0)
+    {
+        const char* str = getenv("OSG_NUM_ASYNC_READ_THREADS");
+        if (str) _numThreads = static_cast<unsigned int>(osg::maximum(atoi(str), 0));
+    }
+
+    if (_numThreads==0)
+    {
+        _numThreads = static_cast<unsigned int>(osg::maximum(OpenThreads::GetNumberOfProcessors(), 1));
+    }
+
+    _block->set(false);
+}
+
+AsyncReader::~AsyncReader()
+{
+    cancelAll();
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
+        _done = true;
+        updateBlock();
+    }
+
+    for(ReadThreads::iterator itr = _readThreads.begin();
+        itr != _readThreads.end();
+        ++itr)
+    {
+        (*itr)->join();
+    }
+}
+
+void AsyncReader::startThreads()
+{
+    for(unsigned int i=0; i<_numThreads; ++i)
+    {
+        ReadThread* thread = new ReadThread(this);
+        _readThreads.push_back(thread);
+        thread->startThread();
+    }
+}
+
+osg::ref_ptr<AsyncReader::Request> AsyncReader::request(ReadType readType, const std::string& fileName, const Options* options, float priority, CompletionCallback* callback)
+{
+    osg::ref_ptr<Request> request;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
+
+        // merge with a request for the same file that is already pending or being read.
+        for(RequestList::iterator itr = _pendingRequests.begin();
+            itr != _pendingRequests.end() && !request;
+            ++itr)
+        {
+            if ((*itr)->matches(readType, fileName, options))
+            {
+                request = *itr;
+                if (priority>request->_priority)
+                {
+                    // also held so that getPriority() can read it without the AsyncReader's _requestMutex.
+                    OpenThreads::ScopedLock<OpenThreads::Mutex> requestLock(request->_mutex);
+                    request->_priority = priority;
+                }
+            }
+        }
+
+        for(RequestList::iterator itr = _activeRequests.begin();
+            itr != _activeRequests.end() && !request;
+            ++itr)
+        {
+            if ((*itr)->matches(readType, fileName, options)) request = *itr;
+        }
+
+        if (!request)
+        {
+            request = new Request(readType, fileName, options, priority);
+            request->_sequenceNumber = _sequenceNumber++;
+            _pendingRequests.push_back(request);
+
+            if (_readThreads.empty()) startThreads();
+
+            updateBlock();
+        }
+    }
+
+    request->addCompletionCallback(callback);
+    return request;
+}
+
+void AsyncReader::takeNext(osg::ref_ptr<Request>& request)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
+
+    if (_pendingRequests.empty()) return;
+
+    RequestList::iterator best = _pendingRequests.begin();
+    for(RequestList::iterator itr = best+1;
+        itr != _pendingRequests.end();
+        ++itr)
+    {
+        if ((*itr)->_priority>(*best)->_priority ||
+            ((*itr)->_priority==(*best)->_priority && (*itr)->_sequenceNumber<(*best)->_sequenceNumber))
+        {
+            best = itr;
+        }
+    }
+
+    request = *best;
+    _pendingRequests.erase(best);
+    _activeRequests.push_back(request);
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> requestLock(request->_mutex);
+        request->_status = Request::READING;
+    }
+
+    updateBlock();
+}
+
+void AsyncReader::completed(Request* request)
+{
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
+        RequestList::iterator itr = std::find(_activeRequests.begin(), _activeRequests.end(), request);
+        if (itr!=_activeRequests.end()) _activeRequests.erase(itr);
+    }
+
+    request->complete(Request::COMPLETED);
+}
+
+bool AsyncReader::cancel(Request* request)
+{
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
+        RequestList::iterator itr = std::find(_pendingRequests.begin(), _pendingRequests.end(), request);
+        if (itr==_pendingRequests.end()) return false;
+
+        _pendingRequests.erase(itr);
+        updateBlock();
+    }
+
+    request->complete(Request::CANCELLED);
+    return true;
+}
+
+void AsyncReader::cancelAll()
+{
+    RequestList cancelled;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
+        cancelled.swap(_pendingRequests);
+        updateBlock();
+    }
+
+    for(RequestList::iterator itr = cancelled.begin();
+        itr != cancelled.end();
+        ++itr)
+    {
+        (*itr)->complete(Request::CANCELLED);
+    }
+}
+
+unsigned int AsyncReader::getNumPendingRequests() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
+    return static_cast<unsigned int>(_pendingRequests.size());
+}
+
+unsigned int AsyncReader::getNumActiveRequests() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
+    return static_cast<unsigned int>(_activeRequests.size());
+}
@@ -13,9 +13,11 @@
 // Written by Wang Rui, (C) 2010
 
 #include <osg/Notify>
+#include <osg/OperationThread>
 #include <osgDB/Registry>
 #include <osgDB/Registry>
 #include <osgDB/ObjectWrapper>
+#include <algorithm>
 #include <sstream>
 
 using namespace osgDB;
@@ -173,4 +175,378 @@ public:
 
 REGISTER_COMPRESSOR( "zlib", ZLibCompressor )
 
+// Chunked compressor, splitting the data into independently compressed chunks so that they can be
+// compressed and decompressed in parallel, and decompressed on demand while the stream is read.
+//
+// Layout: codec, chunk count, then an index of (decompressed size, compressed size) per chunk followed by
+// the compressed chunks, with all integers stored as little endian 32 bit values.
+
+namespace
+{
+
+enum ChunkCodec
+{
+    CHUNK_CODEC_ZLIB = 1
+};
+
+static void writeUInt32( std::ostream& fout, unsigned int value )
+{
+    unsigned char bytes[4] = { (unsigned char)(value&0xff), (unsigned char)((value>>8)&0xff),
+                               (unsigned char)((value>>16)&0xff), (unsigned char)((value>>24)&0xff) };
+    fout.write( (const char*)bytes, 4 );
+}
+
+static bool readUInt32( std::istream& fin, unsigned int& value )
+{
+    unsigned char bytes[4];
+    fin.read( (char*)bytes, 4 );
+    if ( fin.gcount()!=4 ) return false;
+    value = bytes[0] | (bytes[1]<<8) | (bytes[2]<<16) | ((unsigned int)bytes[3]<<24);
+    return true;
+}
+
+/** A chunk to compress or decompress, source and target sizes are fixed before the job is run.*/
+struct ChunkJob
+{
+    ChunkJob(): source(0), sourceSize(0), target(0), targetSize(0), compressChunk(false), result(false) {}
+
+    void run()
+    {
+        if ( compressChunk )
+        {
+            uLongf size = compressBound( sourceSize );
+            target->resize( size );
+            result = compress2( (Bytef*)&((*target)[0]), &size, (const Bytef*)source, sourceSize, 6 )==Z_OK;
+            target->resize( result ? size : 0 );
+        }
+        else
+        {
+            uLongf size = targetSize;
+            target->resize( targetSize );
+            result = uncompress( (Bytef*)&((*target)[0]), &size, (const Bytef*)source, sourceSize )==Z_OK &&
+                     size==targetSize;
+        }
+    }
+
+    const char*     source;
+    unsigned int    sourceSize;
+    std::string*    target;
+    unsigned int    targetSize;
+    bool            compressChunk;
+    bool            result;
+};
+
+typedef std::vector<ChunkJob> ChunkJobs;
+
+/** Runs the chunk jobs across the shared osg::OperationThreadPool and the calling thread.*/
+class ChunkJobList : public osg::OperationThreadPool::Jobs
+{
+public:
+    ChunkJobList(ChunkJobs& jobs): _jobs(jobs) {}
+
+    virtual void runJob(unsigned int job) { _jobs[job].run(); }
+
+    void run() { osg::OperationThreadPool::instance()->runJobs( *this, static_cast<unsigned int>(_jobs.size()) ); }
+
+protected:
+    ChunkJobList& operator = (const ChunkJobList&) { return *this; }
+
+    ChunkJobs& _jobs;
+};
+
+/** Read only streambuf decompressing chunks on demand, a batch of chunks at a time in parallel.
+  * Only the index is read up front, each batch of compressed chunks is read from the source stream when
+  * needed, so seeking back to an earlier chunk requires the source stream to be seekable.*/
+class chunked_streambuf : public std::streambuf
+{
+public:
+
+    chunked_streambuf():
+        _source(0),
+        _compressedStart(-1),
+        _sourcePosition(0),
+        _totalSize(0),
+        _batchBegin(0),
+        _currentChunk(0),
+        _valid(false) {}
+
+    bool readIndex( std::istream& fin )
+    {
+        unsigned int codec = 0, numChunks = 0;
+        if ( !readUInt32(fin, codec) || codec!=CHUNK_CODEC_ZLIB ) return false;
+        if ( !readUInt32(fin, numChunks) ) return false;
+
+        // the index and compressed chunks must fit in what remains of the stream, when its length can be found.
+        std::streamoff remaining = remainingLength( fin );
+        if ( remaining>=0 && static_cast<std::streamoff>(numChunks)*8 > remaining ) return false;
+        std::streamoff maxCompressedSize = remaining>=0 ? remaining - static_cast<std::streamoff>(numChunks)*8 : -1;
+
+        // grow the index as it is read so that a corrupt count can't force a huge allocation up front.
+        _decompressedOffsets.clear();
+        _compressedOffsets.clear();
+        _decompressedOffsets.reserve( std::min(numChunks, 1u<<16) + 1 );
+        _compressedOffsets.reserve( std::min(numChunks, 1u<<16) + 1 );
+        _decompressedOffsets.push_back( 0 );
+        _compressedOffsets.push_back( 0 );
+        for(unsigned int i=0; i<numChunks; ++i)
+        {
+            unsigned int decompressedSize = 0, compressedSize = 0;
+            if ( !readUInt32(fin, decompressedSize) || !readUInt32(fin, compressedSize) ) return false;
+
+            // deflate can't expand a chunk beyond compressBound() or compress it more than 1032:1.
+            if ( compressedSize>compressBound(decompressedSize) ) return false;
+            if ( decompressedSize/1032 > compressedSize ) return false;
+
+            std::streamoff compressedOffset = _compressedOffsets.back() + compressedSize;
+            if ( maxCompressedSize>=0 && compressedOffset>maxCompressedSize ) return false;
+
+            _decompressedOffsets.push_back( _decompressedOffsets.back() + decompressedSize );
+            _compressedOffsets.push_back( compressedOffset );
+        }
+        _totalSize = _decompressedOffsets.back();
+
+        _source = &fin;
+        _compressedStart = fin.tellg();
+        _sourcePosition = 0;
+        _valid = true;
+        return true;
+    }
+
+    /** Return the number of bytes left in a seekable stream, or -1 if it can't be determined.*/
+    static std::streamoff remainingLength( std::istream& fin )
+    {
+        std::streampos current = fin.tellg();
+        if ( current==std::streampos(-1) ) return -1;
+
+        fin.seekg( 0, std::ios_base::end );
+        std::streampos end = fin.tellg();
+        fin.clear();
+        fin.seekg( current );
+        if ( end==std::streampos(-1) || fin.fail() ) return -1;
+
+        return end - current;
+    }
+
+    unsigned int getNumChunks() const { return _decompressedOffsets.empty() ? 0 : static_cast<unsigned int>(_decompressedOffsets.size()-1); }
+
+protected:
+
+    bool loadChunk( unsigned int chunk )
+    {
+        if ( !_valid || chunk>=getNumChunks() ) return false;
+
+        if ( chunk<_batchBegin || chunk>=_batchBegin+_batch.size() )
+        {
+            unsigned int batchSize = std::min(osg::OperationThreadPool::instance()->getNumThreads()+1, getNumChunks()-chunk);
+            if ( !readCompressed(chunk, chunk+batchSize) )
+            {
+                OSG_WARN << "Failed to read compressed chunks " << chunk << " to " << (chunk+batchSize-1) << " of stream." << std::endl;
+                _batch.clear();
+                _valid = false;
+                return false;
+            }
+
+            _batchBegin = chunk;
+            _batch.resize( batchSize );
+
+            ChunkJobs jobs( batchSize );
+            for(unsigned int i=0; i<batchSize; ++i)
+            {
+                unsigned int c = chunk+i;
+                jobs[i].source = _compressed.data() + (_compressedOffsets[c] - _compressedOffsets[chunk]);
+                jobs[i].sourceSize = static_cast<unsigned int>(_compressedOffsets[c+1] - _compressedOffsets[c]);
+                jobs[i].target = &_batch[i];
+                jobs[i].targetSize = static_cast<unsigned int>(_decompressedOffsets[c+1] - _decompressedOffsets[c]);
+            }
+            ChunkJobList(jobs).run();
+
+            for(unsigned int i=0; i<batchSize; ++i)
+            {
+                if ( !jobs[i].result )
+                {
+                    OSG_WARN << "Failed to decompress chunk " << (chunk+i) << " of stream." << std::endl;
+                    _batch.clear();
+                    _valid = false;
+                    return false;
+                }
+            }
+        }
+
+        std::string& data = _batch[chunk-_batchBegin];
+        char* begin = data.empty() ? 0 : &data[0];
+        setg( begin, begin, begin+data.size() );
+        _currentChunk = chunk;
+        return true;
+    }
+
+    /** Read the compressed data of chunks begin to end-1 from the source stream, seeking only when not
+      * continuing on from the previous read.*/
+    bool readCompressed( unsigned int begin, unsigned int end )
+    {
+        std::streamoff position = _compressedOffsets[begin];
+        std::streamoff size = _compressedOffsets[end] - position;
+
+        if ( position!=_sourcePosition )
+        {
+            if ( _compressedStart==std::streampos(-1) ) return false;
+
+            _source->clear();
+            _source->seekg( _compressedStart + position );
+            if ( _source->fail() ) return false;
+            _sourcePosition = position;
+        }
+
+        _compressed.resize( static_cast<size_t>(size) );
+        if ( size>0 )
+        {
+            _source->read( &_compressed[0], size );
+            if ( _source->gcount()!=size ) return false;
+        }
+        _sourcePosition += size;
+        return true;
+    }
+
+    virtual int_type underflow()
+    {
+        if ( gptr()<egptr() ) return traits_type::to_int_type(*gptr());
+
+        unsigned int next = eback() ? _currentChunk+1 : 0;
+        while ( next<getNumChunks() )
+        {
+            if ( !loadChunk(next) ) return traits_type::eof();
+            if ( gptr()<egptr() ) return traits_type::to_int_type(*gptr());
+            ++next;
+        }
+        return traits_type::eof();
+    }
+
+    virtual std::streampos seekoff (std::streamoff off, std::ios_base::seekdir way,
+                   std::ios_base::openmode which = std::ios_base::in)
+    {
+        if ( (which & std::ios_base::in)==0 || !_valid ) return -1;
+
+        std::streamoff current = eback() ? _decompressedOffsets[_currentChunk] + (gptr()-eback()) : 0;
+        std::streamoff newpos;
+        if ( way == std::ios_base::beg ) newpos = off;
+        else if ( way == std::ios_base::cur ) newpos = current + off;
+        else if ( way == std::ios_base::end ) newpos = _totalSize + off;
+        else return -1;
+
+        if ( newpos<0 || newpos>_totalSize ) return -1;
+        if ( newpos==current ) return newpos;
+        if ( getNumChunks()==0 ) return newpos;
+
+        std::vector<std::streamoff>::const_iterator itr = std::upper_bound( _decompressedOffsets.begin(), _decompressedOffsets.end()-1, newpos );
+        unsigned int chunk = static_cast<unsigned int>(itr - _decompressedOffsets.begin()) - 1;
+        if ( !loadChunk(chunk) ) return -1;
+
+        setg( eback(), eback() + (newpos - _decompressedOffsets[chunk]), egptr() );
+        return newpos;
+    }
+
+    virtual std::streampos seekpos (std::streampos sp, std::ios_base::openmode which = std::ios_base::in)
+    {
+        return seekoff(sp, std::ios_base::beg, which);
+    }
+
+    std::istream*               _source;
+    std::streampos              _compressedStart;
+    std::streamoff              _sourcePosition;
+
+    std::string                 _compressed;
+    std::vector<std::streamoff> _compressedOffsets;
+    std::vector<std::streamoff> _decompressedOffsets;
+    std::streamoff              _totalSize;
+
+    std::vector<std::string>    _batch;
+    unsigned int                _batchBegin;
+    unsigned int                _currentChunk;
+    bool                        _valid;
+};
+
+/** istream owning the chunked_streambuf that it reads from.*/
+class ChunkedDecompressionStream : public std::istream
+{
+public:
+    ChunkedDecompressionStream( std::istream& fin ):
+        std::istream(0)
+    {
+        rdbuf( &_buffer );
+        if ( !_buffer.readIndex(fin) ) setstate( std::ios::failbit );
+    }
+
+protected:
+    chunked_streambuf _buffer;
+};
+
+}
+
+class ChunkedZLibCompressor : public BaseCompressor
+{
+public:
+    ChunkedZLibCompressor(): _chunkSize(1<<20) {}
+
+    void setChunkSize( unsigned int size ) { _chunkSize = size>0 ? size : 1; }
+    unsigned int getChunkSize() const { return _chunkSize; }
+
+    virtual bool compress( std::ostream& fout, const std::string& src )
+    {
+        size_t numChunks = (src.size() + _chunkSize - 1) / _chunkSize;
+        std::vector<std::string> compressed( numChunks );
+
+        ChunkJobs jobs( numChunks );
+        for(size_t i=0; i<numChunks; ++i)
+        {
+            size_t offset = i*_chunkSize;
+            jobs[i].source = src.data() + offset;
+            jobs[i].sourceSize = static_cast<unsigned int>(std::min(src.size()-offset, static_cast<size_t>(_chunkSize)));
+            jobs[i].target = &compressed[i];
+            jobs[i].compressChunk = true;
+        }
+        ChunkJobList(jobs).run();
+
+        // don't write anything unless every chunk compressed.
+        for(size_t i=0; i<numChunks; ++i)
+        {
+            if ( !jobs[i].result ) return false;
+        }
+
+        writeUInt32( fout, CHUNK_CODEC_ZLIB );
+        writeUInt32( fout, static_cast<unsigned int>(numChunks) );
+        for(size_t i=0; i<numChunks; ++i)
+        {
+            writeUInt32( fout, jobs[i].sourceSize );
+            writeUInt32( fout, static_cast<unsigned int>(compressed[i].size()) );
+        }
+        for(size_t i=0; i<numChunks; ++i)
+        {
+            fout.write( compressed[i].data(), compressed[i].size() );
+        }
+        return !fout.fail();
+    }
+
+    virtual bool decompress( std::istream& fin, std::string& target )
+    {
+        ChunkedDecompressionStream stream( fin );
+        if ( stream.fail() ) return false;
+
+        char buffer[CHUNK];
+        while ( stream.read(buffer, CHUNK) || stream.gcount()>0 )
+        {
+            target.append( buffer, stream.gcount() );
+        }
+        return stream.eof() && !stream.bad();
+    }
+
+    virtual std::istream* createDecompressionStream( std::istream& fin )
+    {
+        return new ChunkedDecompressionStream( fin );
+    }
+
+protected:
+    unsigned int _chunkSize;
+};
+
+REGISTER_COMPRESSOR( "chunkedzlib", ChunkedZLibCompressor )
+
 #endif
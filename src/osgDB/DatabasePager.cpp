@@ -243,7 +243,7 @@ public:
 class DatabasePager::FindCompileableGLObjectsVisitor : public osgUtil::StateToCompile
 {
 public:
-    FindCompileableGLObjectsVisitor(const DatabasePager* pager, osg::Object* markerObject):
+    FindCompileableGLObjectsVisitor(const DatabasePager* pager, osg::Object* markerObject, const Options* loadOptions=0):
             osgUtil::StateToCompile(osgUtil::GLObjectsVisitor::COMPILE_DISPLAY_LISTS|osgUtil::GLObjectsVisitor::COMPILE_STATE_ATTRIBUTES, markerObject),
             _pager(pager),
             _changeAutoUnRef(false), _valueAutoUnRef(false),
@@ -278,10 +278,15 @@ public:
                 break;
         }
 
-        if (osgDB::Registry::instance()->getBuildKdTreesHint()==osgDB::Options::BUILD_KDTREES &&
+        osgDB::Options::BuildKdTreesHint kdTreesHint = (loadOptions && loadOptions->getBuildKdTreesHint()!=osgDB::Options::NO_PREFERENCE) ?
+            loadOptions->getBuildKdTreesHint() :
+            osgDB::Registry::instance()->getBuildKdTreesHint();
+
+        if ((kdTreesHint==osgDB::Options::BUILD_KDTREES || kdTreesHint==osgDB::Options::BUILD_KDTREES_ON_DEMAND) &&
             osgDB::Registry::instance()->getKdTreeBuilder())
         {
             _kdTreeBuilder = osgDB::Registry::instance()->getKdTreeBuilder()->clone();
+            if (kdTreesHint==osgDB::Options::BUILD_KDTREES_ON_DEMAND) _kdTreeBuilder->_buildOnDemand = true;
         }
     }
 
@@ -289,11 +294,23 @@ public:
 
     bool requiresCompilation() const { return !empty(); }
 
+    /** Build the KdTrees for the geometries collected during the traversal, done as one batch so that the
+      * KdTreeBuilder can build them concurrently.*/
+    void buildKdTrees()
+    {
+        if (_kdTreeBuilder.valid() && !_kdTreeGeometries.empty())
+        {
+            _kdTreeBuilder->build(_kdTreeGeometries);
+            _kdTreeGeometries.clear();
+        }
+    }
+
     virtual void apply(osg::Drawable& drawable)
     {
         if (_kdTreeBuilder.valid() && _markerObject.get()!=drawable.getUserData())
         {
-            drawable.accept(*_kdTreeBuilder);
+            osg::Geometry* geometry = drawable.asGeometry();
+            if (geometry) _kdTreeGeometries.push_back(geometry);
         }
 
         StateToCompile::apply(drawable);
@@ -337,6 +354,7 @@ public:
     bool                                    _changeAnisotropy;
     float                                   _valueAnisotropy;
     osg::ref_ptr<osg::KdTreeBuilder>        _kdTreeBuilder;
+    osg::KdTreeBuilder::GeometryList        _kdTreeGeometries;
 
 protected:
 
@@ -344,22 +362,6 @@ protected:
 };
 
 
-/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-//
-//  SortFileRequestFunctor
-//
-struct DatabasePager::SortFileRequestFunctor
-{
-    bool operator() (const osg::ref_ptr<DatabasePager::DatabaseRequest>& lhs,const osg::ref_ptr<DatabasePager::DatabaseRequest>& rhs) const
-    {
-        if (lhs->_timestampLastRequest>rhs->_timestampLastRequest) return true;
-        else if (lhs->_timestampLastRequest<rhs->_timestampLastRequest) return false;
-        else return (lhs->_priorityLastRequest>rhs->_priorityLastRequest);
-    }
-};
-
-
-
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 //  DatabaseRequest
@@ -386,11 +388,13 @@ DatabasePager::RequestQueue::RequestQueue(DatabasePager* pager):
 DatabasePager::RequestQueue::~RequestQueue()
 {
     OSG_INFO<<"DatabasePager::RequestQueue::~RequestQueue() Destructing queue."<<std::endl;
-    for(RequestList::iterator itr = _requestList.begin();
-        itr != _requestList.end();
+    for(RequestHeap::iterator itr = _requestHeap.begin();
+        itr != _requestHeap.end();
         ++itr)
     {
-        invalidate(itr->get());
+        itr->_request->_requestQueue = 0;
+        itr->_request->_requestQueuePriorityChanged = false;
+        invalidate(itr->_request.get());
     }
 }
 
@@ -408,6 +412,130 @@ void DatabasePager::RequestQueue::invalidate(DatabaseRequest* dr)
     dr->invalidate();
 }
 
+void DatabasePager::RequestQueue::placeNoLock(unsigned int index, const RequestHeapEntry& entry)
+{
+    _requestHeap[index] = entry;
+    entry._request->_requestQueueIndex = index;
+}
+
+void DatabasePager::RequestQueue::siftUpNoLock(unsigned int index)
+{
+    RequestHeapEntry entry = _requestHeap[index];
+    while(index>0)
+    {
+        unsigned int parent = (index-1)/2;
+        if (!entry.higherPriority(_requestHeap[parent])) break;
+
+        placeNoLock(index, _requestHeap[parent]);
+        index = parent;
+    }
+    placeNoLock(index, entry);
+}
+
+void DatabasePager::RequestQueue::siftDownNoLock(unsigned int index)
+{
+    unsigned int size = _requestHeap.size();
+    RequestHeapEntry entry = _requestHeap[index];
+    for(;;)
+    {
+        unsigned int child = index*2+1;
+        if (child>=size) break;
+
+        if (child+1<size && _requestHeap[child+1].higherPriority(_requestHeap[child])) ++child;
+        if (!_requestHeap[child].higherPriority(entry)) break;
+
+        placeNoLock(index, _requestHeap[child]);
+        index = child;
+    }
+    placeNoLock(index, entry);
+}
+
+void DatabasePager::RequestQueue::rebuildHeapNoLock()
+{
+    for(unsigned int i=0; i<_requestHeap.size(); ++i)
+    {
+        _requestHeap[i]._request->_requestQueueIndex = i;
+    }
+
+    for(unsigned int i=_requestHeap.size()/2; i>0; --i)
+    {
+        siftDownNoLock(i-1);
+    }
+}
+
+void DatabasePager::RequestQueue::pushNoLock(DatabaseRequest* databaseRequest)
+{
+    databaseRequest->_requestQueue = this;
+    databaseRequest->_requestQueueIndex = _requestHeap.size();
+    _requestHeap.push_back(RequestHeapEntry(databaseRequest));
+    siftUpNoLock(_requestHeap.size()-1);
+}
+
+void DatabasePager::RequestQueue::eraseNoLock(unsigned int index)
+{
+    // keep a reference to the request whilst we detach it, as the heap entry may be the last reference
+    osg::ref_ptr<DatabaseRequest> databaseRequest = _requestHeap[index]._request;
+    databaseRequest->_requestQueue = 0;
+    databaseRequest->_requestQueuePriorityChanged = false;
+
+    unsigned int last = _requestHeap.size()-1;
+    if (index!=last)
+    {
+        DatabaseRequest* moved = _requestHeap[last]._request.get();
+        placeNoLock(index, _requestHeap[last]);
+        _requestHeap.pop_back();
+
+        siftUpNoLock(index);
+        if (moved->_requestQueueIndex==index) siftDownNoLock(index);
+    }
+    else
+    {
+        _requestHeap.pop_back();
+    }
+}
+
+void DatabasePager::RequestQueue::priorityChanged(DatabaseRequest* databaseRequest)
+{
+    if (databaseRequest->_requestQueue==this && !databaseRequest->_requestQueuePriorityChanged)
+    {
+        databaseRequest->_requestQueuePriorityChanged = true;
+        _priorityChangedList.push_back(databaseRequest);
+    }
+}
+
+void DatabasePager::RequestQueue::updatePrioritiesNoLock()
+{
+    if (_priorityChangedList.empty()) return;
+
+    // once a good fraction of the heap needs repositioning, as happens each frame when the cull
+    // traversal re-requests the outstanding tiles, a single O(n) heapify beats individual sifts.
+    bool rebuild = _priorityChangedList.size() > _requestHeap.size()/4;
+
+    for(RequestPointerList::iterator itr = _priorityChangedList.begin();
+        itr != _priorityChangedList.end();
+        ++itr)
+    {
+        DatabaseRequest* databaseRequest = *itr;
+        if (databaseRequest->_requestQueue!=this || !databaseRequest->_requestQueuePriorityChanged) continue;
+
+        databaseRequest->_requestQueuePriorityChanged = false;
+
+        unsigned int index = databaseRequest->_requestQueueIndex;
+        RequestHeapEntry& entry = _requestHeap[index];
+        entry._timestamp = databaseRequest->_timestampLastRequest;
+        entry._priority = databaseRequest->_priorityLastRequest;
+
+        if (!rebuild)
+        {
+            siftUpNoLock(index);
+            siftDownNoLock(databaseRequest->_requestQueueIndex);
+        }
+    }
+
+    _priorityChangedList.clear();
+
+    if (rebuild) rebuildHeapNoLock();
+}
 
 bool DatabasePager::RequestQueue::pruneOldRequestsAndCheckIfEmpty()
 {
@@ -416,57 +544,76 @@ bool DatabasePager::RequestQueue::pruneOldRequestsAndCheckIfEmpty()
     unsigned int frameNumber = _pager->_frameNumber;
     if (_frameNumberLastPruned != frameNumber)
     {
-        for(RequestQueue::RequestList::iterator citr = _requestList.begin();
-            citr != _requestList.end();
-            )
+        OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
+
+        updatePrioritiesNoLock();
+
+        RequestHeap currentRequests;
+        currentRequests.reserve(_requestHeap.size());
+        for(RequestHeap::iterator itr = _requestHeap.begin();
+            itr != _requestHeap.end();
+            ++itr)
         {
-            OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
-            if ((*citr)->isRequestCurrent(frameNumber))
+            if (itr->_request->isRequestCurrent(frameNumber))
             {
-                ++citr;
+                currentRequests.push_back(*itr);
             }
             else
             {
-                invalidate(citr->get());
+                itr->_request->_requestQueue = 0;
+                itr->_request->_requestQueuePriorityChanged = false;
+                invalidate(itr->_request.get());
 
-                OSG_INFO<<"DatabasePager::RequestQueue::pruneOldRequestsAndCheckIfEmpty(): Pruning "<<(*citr)<<std::endl;
-                citr = _requestList.erase(citr);
+                OSG_INFO<<"DatabasePager::RequestQueue::pruneOldRequestsAndCheckIfEmpty(): Pruning "<<itr->_request.get()<<std::endl;
             }
         }
 
+        if (currentRequests.size()!=_requestHeap.size())
+        {
+            _requestHeap.swap(currentRequests);
+            rebuildHeapNoLock();
+        }
+
         _frameNumberLastPruned = frameNumber;
 
         updateBlock();
     }
 
-    return _requestList.empty();
+    return _requestHeap.empty();
 }
 
 bool DatabasePager::RequestQueue::empty()
 {
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
-    return _requestList.empty();
+    return _requestHeap.empty();
 }
 
 unsigned int DatabasePager::RequestQueue::size()
 {
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
-    return _requestList.size();
+    return _requestHeap.size();
 }
 
 void DatabasePager::RequestQueue::clear()
 {
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
 
-    for(RequestList::iterator citr = _requestList.begin();
-        citr != _requestList.end();
-        ++citr)
     {
         OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
-        invalidate(citr->get());
+
+        for(RequestHeap::iterator itr = _requestHeap.begin();
+            itr != _requestHeap.end();
+            ++itr)
+        {
+            itr->_request->_requestQueue = 0;
+            itr->_request->_requestQueuePriorityChanged = false;
+            invalidate(itr->_request.get());
+        }
+
+        _priorityChangedList.clear();
     }
 
-    _requestList.clear();
+    _requestHeap.clear();
 
     _frameNumberLastPruned = _pager->_frameNumber;
 
@@ -485,83 +632,140 @@ void DatabasePager::RequestQueue::remove(DatabasePager::DatabaseRequest* databas
 {
     // OSG_NOTICE<<"DatabasePager::RequestQueue::remove(DatabaseRequest* databaseRequest)"<<std::endl;
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
-    for(RequestList::iterator citr = _requestList.begin();
-        citr != _requestList.end();
-        ++citr)
+    OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
+
+    updatePrioritiesNoLock();
+
+    if (databaseRequest->_requestQueue==this)
     {
-        if (citr->get()==databaseRequest)
-        {
-            // OSG_NOTICE<<"  done remove(DatabaseRequest* databaseRequest)"<<std::endl;
-            _requestList.erase(citr);
-            return;
-        }
+        // OSG_NOTICE<<"  done remove(DatabaseRequest* databaseRequest)"<<std::endl;
+        eraseNoLock(databaseRequest->_requestQueueIndex);
     }
 }
 
 
 void DatabasePager::RequestQueue::addNoLock(DatabasePager::DatabaseRequest* databaseRequest)
 {
-    _requestList.push_back(databaseRequest);
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
+
+        updatePrioritiesNoLock();
+
+        if (databaseRequest->_requestQueue==this)
+        {
+            // already queued so just reposition it against its latest priority.
+            priorityChanged(databaseRequest);
+            updatePrioritiesNoLock();
+        }
+        else
+        {
+            pushNoLock(databaseRequest);
+        }
+    }
+
     updateBlock();
 }
 
 void DatabasePager::RequestQueue::swap(RequestList& requestList)
 {
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
-    _requestList.swap(requestList);
+    OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
+
+    updatePrioritiesNoLock();
+
+    RequestList previousRequests;
+    while(!_requestHeap.empty())
+    {
+        previousRequests.push_back(_requestHeap.front()._request);
+        eraseNoLock(0);
+    }
+
+    for(RequestList::iterator itr = requestList.begin();
+        itr != requestList.end();
+        ++itr)
+    {
+        if ((*itr)->_requestQueue!=this) pushNoLock(itr->get());
+    }
+
+    requestList.swap(previousRequests);
+}
+
+bool DatabasePager::RequestQueue::takeFirstNoLock(osg::ref_ptr<DatabaseRequest>& databaseRequest, int frameNumber)
+{
+    while(!_requestHeap.empty())
+    {
+        osg::ref_ptr<DatabaseRequest> highest = _requestHeap.front()._request;
+        eraseNoLock(0);
+
+        if (highest->isRequestCurrent(frameNumber))
+        {
+            databaseRequest = highest;
+            return true;
+        }
+
+        invalidate(highest.get());
+
+        OSG_INFO<<"DatabasePager::RequestQueue::takeFirst(): Pruning "<<highest.get()<<std::endl;
+    }
+    return false;
 }
 
 void DatabasePager::RequestQueue::takeFirst(osg::ref_ptr<DatabaseRequest>& databaseRequest)
 {
     OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
 
-    if (!_requestList.empty())
+    if (!_requestHeap.empty())
     {
-        DatabasePager::SortFileRequestFunctor highPriority;
-
-        RequestQueue::RequestList::iterator selected_itr = _requestList.end();
-
         int frameNumber = _pager->_frameNumber;
 
-        for(RequestQueue::RequestList::iterator citr = _requestList.begin();
-            citr != _requestList.end();
-            )
         {
             OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
-            if ((*citr)->isRequestCurrent(frameNumber))
-            {
-                if (selected_itr==_requestList.end() || highPriority(*citr, *selected_itr))
-                {
-                    selected_itr = citr;
-                }
 
-                ++citr;
-            }
-            else
-            {
-                invalidate(citr->get());
-
-                OSG_INFO<<"DatabasePager::RequestQueue::takeFirst(): Pruning "<<(*citr)<<std::endl;
-                citr = _requestList.erase(citr);
-            }
+            updatePrioritiesNoLock();
 
+            takeFirstNoLock(databaseRequest, frameNumber);
         }
 
-        _frameNumberLastPruned = frameNumber;
-
-        if (selected_itr != _requestList.end())
+        if (databaseRequest.valid())
         {
-            databaseRequest = *selected_itr;
-            _requestList.erase(selected_itr);
-            OSG_INFO<<" DatabasePager::RequestQueue::takeFirst() Found DatabaseRequest size()="<<_requestList.size()<<std::endl;
+            OSG_INFO<<" DatabasePager::RequestQueue::takeFirst() Found DatabaseRequest size()="<<_requestHeap.size()<<std::endl;
         }
         else
         {
-            OSG_INFO<<" DatabasePager::RequestQueue::takeFirst() No suitable DatabaseRequest found size()="<<_requestList.size()<<std::endl;
+            OSG_INFO<<" DatabasePager::RequestQueue::takeFirst() No suitable DatabaseRequest found size()="<<_requestHeap.size()<<std::endl;
         }
+    }
 
-        updateBlock();
+    // always refresh the block, as a ReadQueue's block also depends on its thread queues having emptied.
+    updateBlock();
+}
+
+unsigned int DatabasePager::RequestQueue::takeFirst(RequestList& requestList, unsigned int maxNumRequests)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
+
+    unsigned int numTaken = 0;
+    if (!_requestHeap.empty())
+    {
+        int frameNumber = _pager->_frameNumber;
+
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> drLock(_pager->_dr_mutex);
+
+            updatePrioritiesNoLock();
+
+            osg::ref_ptr<DatabaseRequest> databaseRequest;
+            while(numTaken<maxNumRequests && takeFirstNoLock(databaseRequest, frameNumber))
+            {
+                requestList.push_back(databaseRequest);
+                ++numTaken;
+            }
+        }
     }
+
+    updateBlock();
+
+    return numTaken;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -577,10 +781,156 @@ DatabasePager::ReadQueue::ReadQueue(DatabasePager* pager, const std::string& nam
 
 void DatabasePager::ReadQueue::updateBlock()
 {
-    _block->set((!_requestList.empty() || !_childrenToDeleteList.empty()) &&
+    _block->set((!_requestHeap.empty() || !_childrenToDeleteList.empty() || _numThreadQueuesWithRequests>0) &&
                 !_pager->_databasePagerThreadPaused);
 }
 
+void DatabasePager::ReadQueue::clear()
+{
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_threadQueuesMutex);
+        for(RequestQueueList::iterator itr = _threadQueues.begin();
+            itr != _threadQueues.end();
+            ++itr)
+        {
+            (*itr)->clear();
+        }
+    }
+
+    RequestQueue::clear();
+}
+
+DatabasePager::RequestQueue* DatabasePager::ReadQueue::addThreadQueue()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_threadQueuesMutex);
+    _threadQueues.push_back(new ThreadQueue(_pager, this));
+    return _threadQueues.back().get();
+}
+
+void DatabasePager::ReadQueue::removeThreadQueue(RequestQueue* threadQueue)
+{
+    osg::ref_ptr<RequestQueue> keepAlive = threadQueue;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_threadQueuesMutex);
+        for(RequestQueueList::iterator itr = _threadQueues.begin();
+            itr != _threadQueues.end();
+            ++itr)
+        {
+            if (itr->get()==threadQueue)
+            {
+                _threadQueues.erase(itr);
+                break;
+            }
+        }
+    }
+
+    RequestList requestList;
+    threadQueue->swap(requestList);
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_requestMutex);
+    for(RequestList::iterator itr = requestList.begin();
+        itr != requestList.end();
+        ++itr)
+    {
+        addNoLock(itr->get());
+    }
+    updateBlock();
+}
+
+bool DatabasePager::ReadQueue::takeFirstForThread(RequestQueue* threadQueue, osg::ref_ptr<DatabaseRequest>& databaseRequest)
+{
+    threadQueue->takeFirst(databaseRequest);
+    if (databaseRequest.valid()) return false;
+
+    unsigned int numThreadQueues = 1;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_threadQueuesMutex);
+        if (_threadQueues.size()>1) numThreadQueues = _threadQueues.size();
+    }
+
+    // top up this thread's queue with a batch from the shared queue, large enough to cut contention
+    // on _requestMutex but small enough that the outstanding requests stay spread across the threads.
+    RequestList requestList;
+    takeFirst(requestList, osg::clampBetween(size()/(numThreadQueues*2), 1u, 8u));
+
+    if (!requestList.empty())
+    {
+        databaseRequest = requestList.front();
+        requestList.pop_front();
+
+        if (!requestList.empty())
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(threadQueue->_requestMutex);
+            for(RequestList::iterator itr = requestList.begin();
+                itr != requestList.end();
+                ++itr)
+            {
+                threadQueue->addNoLock(itr->get());
+            }
+        }
+        return false;
+    }
+
+    // shared queue is empty too so steal the highest priority request held by another thread,
+    // starting the search after our own queue so that the victims are spread out.
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_threadQueuesMutex);
+
+    RequestQueueList::iterator start = std::find(_threadQueues.begin(), _threadQueues.end(), threadQueue);
+    if (start != _threadQueues.end()) ++start;
+
+    for(unsigned int i=0; i<_threadQueues.size(); ++i, ++start)
+    {
+        if (start==_threadQueues.end()) start = _threadQueues.begin();
+        if (start->get()==threadQueue) continue;
+
+        (*start)->takeFirst(databaseRequest);
+        if (databaseRequest.valid()) return true;
+    }
+
+    return false;
+}
+
+unsigned int DatabasePager::ReadQueue::sizeIncludingThreadQueues()
+{
+    unsigned int numRequests = size();
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_threadQueuesMutex);
+    for(RequestQueueList::iterator itr = _threadQueues.begin();
+        itr != _threadQueues.end();
+        ++itr)
+    {
+        numRequests += (*itr)->size();
+    }
+    return numRequests;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  ThreadQueue
+//
+DatabasePager::ThreadQueue::ThreadQueue(DatabasePager* pager, ReadQueue* readQueue):
+    RequestQueue(pager),
+    _readQueue(readQueue),
+    _hasRequests(false)
+{
+}
+
+void DatabasePager::ThreadQueue::updateBlock()
+{
+    bool hasRequests = !_requestHeap.empty();
+    if (hasRequests==_hasRequests) return;
+
+    _hasRequests = hasRequests;
+
+    // update the count and the ReadQueue's block while holding its _requestMutex, so that a thread finding the
+    // ReadQueue empty can't block it again just after we've released it. Releasing the block wakes up any idle
+    // threads so that they can steal from us.
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_readQueue->_requestMutex);
+    if (hasRequests) ++(_readQueue->_numThreadQueuesWithRequests);
+    else --(_readQueue->_numThreadQueuesWithRequests);
+    _readQueue->updateBlock();
+}
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 //  DatabaseThread
@@ -590,7 +940,8 @@ DatabasePager::DatabaseThread::DatabaseThread(DatabasePager* pager, Mode mode, c
     _active(false),
     _pager(pager),
     _mode(mode),
-    _name(name)
+    _name(name),
+    _totalTimeReading(0.0)
 {
 }
 
@@ -599,8 +950,24 @@ DatabasePager::DatabaseThread::DatabaseThread(const DatabaseThread& dt, Database
     _active(false),
     _pager(pager),
     _mode(dt._mode),
-    _name(dt._name)
+    _name(dt._name),
+    _totalTimeReading(0.0)
+{
+}
+
+void DatabasePager::DatabaseThread::resetStats()
+{
+    _numRequestsRead.exchange(0);
+    _numRequestsStolen.exchange(0);
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_statsMutex);
+    _totalTimeReading = 0.0;
+}
+
+double DatabasePager::DatabaseThread::getTotalTimeReading() const
 {
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_statsMutex);
+    return _totalTimeReading;
 }
 
 DatabasePager::DatabaseThread::~DatabaseThread()
@@ -664,11 +1031,18 @@ void DatabasePager::DatabaseThread::run()
     }
 
 
+    // our own work-stealing queue, topped up from read_queue and stolen from by the other threads servicing it
+    osg::ref_ptr<DatabasePager::RequestQueue> thread_queue = read_queue->addThreadQueue();
+
     do
     {
         _active = false;
 
-        read_queue->block();
+        // only wait on the shared queue once we have run out of requests of our own.
+        if (thread_queue->empty() || _pager->_databasePagerThreadPaused)
+        {
+            read_queue->block();
+        }
 
         if (_done)
         {
@@ -702,7 +1076,10 @@ void DatabasePager::DatabaseThread::run()
         // load any subgraphs that are required.
         //
         osg::ref_ptr<DatabaseRequest> databaseRequest;
-        read_queue->takeFirst(databaseRequest);
+        if (read_queue->takeFirstForThread(thread_queue.get(), databaseRequest))
+        {
+            ++_numRequestsStolen;
+        }
 
         bool readFromFileCache = false;
 
@@ -854,11 +1231,19 @@ void DatabasePager::DatabaseThread::run()
             //osg::Timer_t before = osg::Timer::instance()->tick();
 
 
+            osg::Timer_t readStartTick = osg::Timer::instance()->tick();
+
             // assume that readNode is thread safe...
             ReaderWriter::ReadResult rr = readFromFileCache ?
                         fileCache->readNode(fileName, dr_loadOptions.get(), false) :
                         Registry::instance()->readNode(fileName, dr_loadOptions.get(), false);
 
+            ++_numRequestsRead;
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_statsMutex);
+                _totalTimeReading += osg::Timer::instance()->delta_s(readStartTick, osg::Timer::instance()->tick());
+            }
+
             osg::ref_ptr<osg::Node> loadedModel;
             if (rr.validNode()) loadedModel = rr.getNode();
             if (!rr.success()) OSG_WARN<<"Error in reading file "<<fileName<<" : "<<rr.statusMessage() << std::endl;
@@ -891,9 +1276,11 @@ void DatabasePager::DatabaseThread::run()
                 if (!rr.loadedFromCache())
                 {
                     // find all the compileable rendering objects
-                    DatabasePager::FindCompileableGLObjectsVisitor stateToCompile(_pager, _pager->getMarkerObject());
+                    DatabasePager::FindCompileableGLObjectsVisitor stateToCompile(_pager, _pager->getMarkerObject(), dr_loadOptions.get());
                     loadedModel->accept(stateToCompile);
 
+                    stateToCompile.buildKdTrees();
+
                     loadedObjectsNeedToBeCompiled = _pager->_doPreCompile &&
                                                     _pager->_incrementalCompileOperation.valid() &&
                                                     _pager->_incrementalCompileOperation->requiresCompile(stateToCompile);
@@ -961,6 +1348,9 @@ void DatabasePager::DatabaseThread::run()
         }
 
     } while (!testCancel() && !_done);
+
+    // hand back any requests we haven't got round to.
+    read_queue->removeThreadQueue(thread_queue.get());
 }
 
 
@@ -1210,6 +1600,15 @@ void DatabasePager::setUpThreads(unsigned int totalNumThreads, unsigned int numH
 {
     _databaseThreads.clear();
 
+    if (totalNumThreads==0)
+    {
+        // leave a core free for the viewer's own threads.
+        int numProcessors = OpenThreads::GetNumberOfProcessors();
+        totalNumThreads = numHttpThreads + (numProcessors>2 ? numProcessors-1 : 1);
+
+        OSG_INFO<<"DatabasePager::setUpThreads() sizing from "<<numProcessors<<" processors, totalNumThreads="<<totalNumThreads<<std::endl;
+    }
+
     unsigned int numGeneralThreads = numHttpThreads < totalNumThreads ?
         totalNumThreads - numHttpThreads :
         1;
@@ -1330,6 +1729,13 @@ void DatabasePager::resetStats()
     _maximumTimeToMergeTile = -DBL_MAX;
     _totalTimeToMergeTiles = 0.0;
     _numTilesMerges = 0;
+
+    for(DatabaseThreadList::iterator dt_itr = _databaseThreads.begin();
+        dt_itr != _databaseThreads.end();
+        ++dt_itr)
+    {
+        (*dt_itr)->resetStats();
+    }
 }
 
 bool DatabasePager::getRequestsInProgress() const
@@ -1434,6 +1840,9 @@ void DatabasePager::requestNodeFile(const std::string& fileName, osg::NodePath&
                 databaseRequest->_priorityLastRequest = priority;
                 ++(databaseRequest->_numOfRequests);
 
+                // let the queue holding the request, if any, reposition it against its new priority
+                if (databaseRequest->_requestQueue) databaseRequest->_requestQueue->priorityChanged(databaseRequest);
+
                 foundEntry = true;
 
                 if (databaseRequestRef->referenceCount()==1)
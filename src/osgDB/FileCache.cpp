@@ -11,27 +11,122 @@
  * OpenSceneGraph Public License for more details.
 */
 
+#include <osg/ApplicationUsage>
+
 #include <osgDB/FileCache>
 #include <osgDB/FileUtils>
 #include <osgDB/FileNameUtils>
 #include <osgDB/ReadFile>
 #include <osgDB/WriteFile>
+#include <osgDB/fstream>
+
+#include <OpenThreads/ScopedLock>
+
+#include <sstream>
+#include <algorithm>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(WIN32) && !defined(__CYGWIN__)
+    #include <sys/types.h>
+    #include <sys/stat.h>
+    #include <sys/utime.h>
+
+    typedef struct _stati64 FileStat;
+    static int getFileStat(const std::string& fileName, FileStat& fileStat) { return _stati64(fileName.c_str(), &fileStat); }
+    static void setFileTimeToNow(const std::string& fileName) { _utime(fileName.c_str(), 0); }
+#else
+    #include <sys/types.h>
+    #include <sys/stat.h>
+    #include <utime.h>
+
+    typedef struct stat FileStat;
+    static int getFileStat(const std::string& fileName, FileStat& fileStat) { return stat(fileName.c_str(), &fileStat); }
+    static void setFileTimeToNow(const std::string& fileName) { utime(fileName.c_str(), 0); }
+#endif
 
 using namespace osgDB;
 
+static osg::ApplicationUsageProxy FileCache_e0(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_FILE_CACHE_WRITE_BEHIND on/off","Enable/disable writing files to the OSG_FILE_CACHE on a background thread.");
+static osg::ApplicationUsageProxy FileCache_e1(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_FILE_CACHE_MAX_SIZE <megabytes>","Maximum size of the OSG_FILE_CACHE, least recently used files are removed once exceeded.");
+
+////////////////////////////////////////////////////////////////////////////////////////////
+//
+// WriteThread
+//
+class FileCache::WriteThread : public OpenThreads::Thread
+{
+public:
+
+    WriteThread(const FileCache* fileCache):
+        _fileCache(fileCache) {}
+
+    virtual void run()
+    {
+        osg::ref_ptr<PendingWrite> pendingWrite;
+        while(_fileCache->takeNextPendingWrite(pendingWrite))
+        {
+            _fileCache->writePendingWrite(pendingWrite.get());
+            _fileCache->completedPendingWrite(pendingWrite.get());
+        }
+    }
+
+protected:
+
+    // the FileCache joins the thread before it is destructed.
+    const FileCache* _fileCache;
+};
+
 ////////////////////////////////////////////////////////////////////////////////////////////
 //
 // FileCache
 //
 FileCache::FileCache(const std::string& path):
     osg::Referenced(true),
-    _fileCachePath(path)
+    _fileCachePath(path),
+    _writeBehind(false),
+    _maximumWriteQueueSize(64*1024*1024),
+    _writeQueueSize(0),
+    _numWritesInProgress(0),
+    _writeThreadDone(false),
+    _writeThread(0),
+    _maximumCacheSize(0),
+    _cacheIndexBuilt(false),
+    _cacheSize(0)
 {
     OSG_INFO<<"Constructed FileCache : "<<path<<std::endl;
+
+    const char* str = getenv("OSG_FILE_CACHE_WRITE_BEHIND");
+    if (str)
+    {
+        _writeBehind = (strcmp(str, "on")==0 || strcmp(str, "ON")==0 || strcmp(str, "On")==0 );
+    }
+
+    str = getenv("OSG_FILE_CACHE_MAX_SIZE");
+    if (str)
+    {
+        _maximumCacheSize = static_cast<uint64_t>(osg::asciiToDouble(str)*1024.0*1024.0);
+    }
 }
 
 FileCache::~FileCache()
 {
+    // write out anything still queued before stopping the background thread.
+    if (_writeThread)
+    {
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_writeQueueMutex);
+            _writeThreadDone = true;
+            _writeQueueCondition.broadcast();
+        }
+
+        _writeThread->join();
+        delete _writeThread;
+    }
+
     OSG_INFO<<"Destructed FileCache "<<std::endl;
 }
 
@@ -54,205 +149,466 @@ std::string FileCache::createCacheFileName(const std::string& originalFileName)
 
 bool FileCache::existsInCache(const std::string& originalFileName) const
 {
-    if (osgDB::fileExists(createCacheFileName(originalFileName)))
+    std::string cacheFileName = createCacheFileName(originalFileName);
+    if (getPendingWrite(cacheFileName).valid() || osgDB::fileExists(cacheFileName))
     {
-        return !isCachedFileBlackListed(originalFileName);
+        if (!isCachedFileBlackListed(originalFileName)) return true;
     }
+    ++_numMisses;
     return false;
 }
 
-ReaderWriter::ReadResult FileCache::readObject(const std::string& originalFileName, const osgDB::Options* options) const
+ReaderWriter::ReadResult FileCache::read(CacheObjectType type, const std::string& originalFileName, const osgDB::Options* options, bool buildKdTreeIfRequired) const
 {
     std::string cacheFileName = createCacheFileName(originalFileName);
-    if (!cacheFileName.empty() && osgDB::fileExists(cacheFileName))
-    {
-        OSG_INFO<<"FileCache::readObjectFromCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
-        return osgDB::Registry::instance()->readObject(cacheFileName, options);
-    }
-    else
+    if (!cacheFileName.empty())
     {
-        return 0;
+        // files still waiting to be written are read back from their encoded copy.
+        osg::ref_ptr<PendingWrite> pendingWrite = getPendingWrite(cacheFileName);
+        ReaderWriter* rw = pendingWrite.valid() ? Registry::instance()->getReaderWriterForExtension(getLowerCaseFileExtension(cacheFileName)) : 0;
+        if (rw)
+        {
+            OSG_INFO<<"FileCache::read("<<originalFileName<<") from pending write of "<<cacheFileName<<std::endl;
+
+            // external files are looked for alongside the cache file, as they would be when reading the file itself.
+            osg::ref_ptr<Options> local_opt = options ? static_cast<Options*>(options->clone(osg::CopyOp::SHALLOW_COPY)) : new Options;
+            local_opt->getDatabasePathList().push_front(osgDB::getFilePath(cacheFileName));
+
+            std::istringstream istr(pendingWrite->_data);
+            ReaderWriter::ReadResult rr;
+            switch(type)
+            {
+                case(CACHE_OBJECT): rr = rw->readObject(istr, local_opt.get()); break;
+                case(CACHE_IMAGE): rr = rw->readImage(istr, local_opt.get()); break;
+                case(CACHE_HEIGHTFIELD): rr = rw->readHeightField(istr, local_opt.get()); break;
+                case(CACHE_NODE): rr = rw->readNode(istr, local_opt.get()); break;
+                case(CACHE_SHADER): rr = rw->readShader(istr, local_opt.get()); break;
+            }
+
+            if (rr.success())
+            {
+                if (buildKdTreeIfRequired) Registry::instance()->_buildKdTreeIfRequired(rr, options);
+                ++_numHits;
+                return rr;
+            }
+        }
+        else if (osgDB::fileExists(cacheFileName))
+        {
+            OSG_INFO<<"FileCache::read("<<originalFileName<<") as "<<cacheFileName<<std::endl;
+
+            ReaderWriter::ReadResult rr;
+            switch(type)
+            {
+                case(CACHE_OBJECT): rr = Registry::instance()->readObject(cacheFileName, options); break;
+                case(CACHE_IMAGE): rr = Registry::instance()->readImage(cacheFileName, options); break;
+                case(CACHE_HEIGHTFIELD): rr = Registry::instance()->readHeightField(cacheFileName, options); break;
+                case(CACHE_NODE): rr = Registry::instance()->readNode(cacheFileName, options, buildKdTreeIfRequired); break;
+                case(CACHE_SHADER): rr = Registry::instance()->readShader(cacheFileName, options); break;
+            }
+
+            if (rr.success()) recordHit(cacheFileName);
+            else ++_numMisses;
+            return rr;
+        }
     }
+
+    ++_numMisses;
+    return 0;
 }
 
-ReaderWriter::WriteResult FileCache::writeObject(const osg::Object& object, const std::string& originalFileName, const osgDB::Options* options) const
+ReaderWriter::WriteResult FileCache::write(CacheObjectType type, const osg::Object& object, const std::string& originalFileName, const osgDB::Options* options) const
 {
     std::string cacheFileName = createCacheFileName(originalFileName);
-    if (!cacheFileName.empty())
-    {
-        std::string path = osgDB::getFilePath(cacheFileName);
+    if (cacheFileName.empty()) return ReaderWriter::WriteResult::FILE_NOT_HANDLED;
 
-        if (!osgDB::fileExists(path) && !osgDB::makeDirectory(path))
+    // a WriteFileCallback expects to see the file name of each write, so only bypass the Registry when there isn't one.
+    ReaderWriter* rw = (_writeBehind && !Registry::instance()->getWriteFileCallback()) ?
+        Registry::instance()->getReaderWriterForExtension(getLowerCaseFileExtension(cacheFileName)) : 0;
+    if (rw)
+    {
+        // stream writes can't see the file extension, so pass on the format that the osg plugin would pick from it.
+        osg::ref_ptr<Options> local_opt = options ? options->cloneOptions() : new Options;
+        std::string ext = getLowerCaseFileExtension(cacheFileName);
+        if (ext=="osgt") local_opt->setPluginStringData("fileType", "Ascii");
+        else if (ext=="osgx") local_opt->setPluginStringData("fileType", "XML");
+        else if (ext=="osgb") local_opt->setPluginStringData("fileType", "Binary");
+
+        std::ostringstream ostr(std::ios::out | std::ios::binary);
+        ReaderWriter::WriteResult result;
+        switch(type)
         {
-            OSG_NOTICE<<"Could not create cache directory: "<<path<<std::endl;
-            return ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
+            case(CACHE_OBJECT): result = rw->writeObject(object, ostr, local_opt.get()); break;
+            case(CACHE_IMAGE): result = rw->writeImage(static_cast<const osg::Image&>(object), ostr, local_opt.get()); break;
+            case(CACHE_HEIGHTFIELD): result = rw->writeHeightField(static_cast<const osg::HeightField&>(object), ostr, local_opt.get()); break;
+            case(CACHE_NODE): result = rw->writeNode(static_cast<const osg::Node&>(object), ostr, local_opt.get()); break;
+            case(CACHE_SHADER): result = rw->writeShader(static_cast<const osg::Shader&>(object), ostr, local_opt.get()); break;
         }
 
-        OSG_INFO<<"FileCache::writeObjectToCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
-        ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeObject(object, cacheFileName, options);
         if (result.success())
         {
-            removeFileFromBlackListed(originalFileName);
+            osg::ref_ptr<PendingWrite> pendingWrite = new PendingWrite;
+            pendingWrite->_originalFileName = originalFileName;
+            pendingWrite->_cacheFileName = cacheFileName;
+            pendingWrite->_data = ostr.str();
+
+            if (queuePendingWrite(pendingWrite.get())) return ReaderWriter::WriteResult::FILE_SAVED;
+
+            // the write queue is full so write the encoded file on this thread.
+            return writePendingWrite(pendingWrite.get()) ? ReaderWriter::WriteResult::FILE_SAVED : ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
         }
-        return result;
     }
-    return ReaderWriter::WriteResult::FILE_NOT_HANDLED;
-}
 
-ReaderWriter::ReadResult FileCache::readImage(const std::string& originalFileName, const osgDB::Options* options) const
-{
-    std::string cacheFileName = createCacheFileName(originalFileName);
-    if (!cacheFileName.empty() && osgDB::fileExists(cacheFileName))
+    std::string path = osgDB::getFilePath(cacheFileName);
+    if (!osgDB::fileExists(path) && !osgDB::makeDirectory(path))
     {
-        OSG_INFO<<"FileCache::readImageFromCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
-        return osgDB::Registry::instance()->readImage(cacheFileName, options);
+        OSG_NOTICE<<"Could not create cache directory: "<<path<<std::endl;
+        return ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
     }
-    else
+
+    OSG_INFO<<"FileCache::write("<<originalFileName<<") as "<<cacheFileName<<std::endl;
+
+    ReaderWriter::WriteResult result;
+    switch(type)
+    {
+        case(CACHE_OBJECT): result = Registry::instance()->writeObject(object, cacheFileName, options); break;
+        case(CACHE_IMAGE): result = Registry::instance()->writeImage(static_cast<const osg::Image&>(object), cacheFileName, options); break;
+        case(CACHE_HEIGHTFIELD): result = Registry::instance()->writeHeightField(static_cast<const osg::HeightField&>(object), cacheFileName, options); break;
+        case(CACHE_NODE): result = Registry::instance()->writeNode(static_cast<const osg::Node&>(object), cacheFileName, options); break;
+        case(CACHE_SHADER): result = Registry::instance()->writeShader(static_cast<const osg::Shader&>(object), cacheFileName, options); break;
+    }
+
+    if (result.success())
     {
-        return 0;
+        recordWrite(originalFileName, cacheFileName);
     }
+    return result;
+}
+
+ReaderWriter::ReadResult FileCache::readObject(const std::string& originalFileName, const osgDB::Options* options) const
+{
+    return read(CACHE_OBJECT, originalFileName, options, false);
+}
+
+ReaderWriter::WriteResult FileCache::writeObject(const osg::Object& object, const std::string& originalFileName, const osgDB::Options* options) const
+{
+    return write(CACHE_OBJECT, object, originalFileName, options);
+}
+
+ReaderWriter::ReadResult FileCache::readImage(const std::string& originalFileName, const osgDB::Options* options) const
+{
+    return read(CACHE_IMAGE, originalFileName, options, false);
 }
 
 ReaderWriter::WriteResult FileCache::writeImage(const osg::Image& image, const std::string& originalFileName, const osgDB::Options* options) const
 {
-    std::string cacheFileName = createCacheFileName(originalFileName);
-    if (!cacheFileName.empty())
+    return write(CACHE_IMAGE, image, originalFileName, options);
+}
+
+ReaderWriter::ReadResult FileCache::readHeightField(const std::string& originalFileName, const osgDB::Options* options) const
+{
+    return read(CACHE_HEIGHTFIELD, originalFileName, options, false);
+}
+
+ReaderWriter::WriteResult FileCache::writeHeightField(const osg::HeightField& hf, const std::string& originalFileName, const osgDB::Options* options) const
+{
+    return write(CACHE_HEIGHTFIELD, hf, originalFileName, options);
+}
+
+ReaderWriter::ReadResult FileCache::readNode(const std::string& originalFileName, const osgDB::Options* options, bool buildKdTreeIfRequired) const
+{
+    return read(CACHE_NODE, originalFileName, options, buildKdTreeIfRequired);
+}
+
+ReaderWriter::WriteResult FileCache::writeNode(const osg::Node& node, const std::string& originalFileName, const osgDB::Options* options) const
+{
+    return write(CACHE_NODE, node, originalFileName, options);
+}
+
+ReaderWriter::ReadResult FileCache::readShader(const std::string& originalFileName, const osgDB::Options* options) const
+{
+    return read(CACHE_SHADER, originalFileName, options, false);
+}
+
+ReaderWriter::WriteResult FileCache::writeShader(const osg::Shader& shader, const std::string& originalFileName, const osgDB::Options* options) const
+{
+    return write(CACHE_SHADER, shader, originalFileName, options);
+}
+
+void FileCache::setWriteBehind(bool flag)
+{
+    if (_writeBehind==flag) return;
+
+    if (!flag) flushWrites();
+    _writeBehind = flag;
+}
+
+void FileCache::flushWrites()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_writeQueueMutex);
+    while(!_writeQueue.empty() || _numWritesInProgress>0)
     {
-        std::string path = osgDB::getFilePath(cacheFileName);
+        _writeQueueCondition.wait(&_writeQueueMutex);
+    }
+}
 
-        if (!osgDB::fileExists(path) && !osgDB::makeDirectory(path))
-        {
-            OSG_NOTICE<<"Could not create cache directory: "<<path<<std::endl;
-            return ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
-        }
+bool FileCache::queuePendingWrite(PendingWrite* pendingWrite) const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_writeQueueMutex);
 
-        OSG_INFO<<"FileCache::writeImageToCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
-        ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeImage(image, cacheFileName, options);
-        if (result.success())
+    unsigned int size = static_cast<unsigned int>(pendingWrite->_data.size());
+    if (!_writeQueue.empty() && _writeQueueSize+size>_maximumWriteQueueSize) return false;
+
+    // replace any earlier write of the same file that hasn't been started yet.
+    PendingWriteMap::iterator itr = _pendingWrites.find(pendingWrite->_cacheFileName);
+    if (itr!=_pendingWrites.end())
+    {
+        WriteQueue::iterator qitr = std::find(_writeQueue.begin(), _writeQueue.end(), itr->second);
+        if (qitr!=_writeQueue.end())
         {
-            removeFileFromBlackListed(originalFileName);
+            _writeQueueSize -= static_cast<unsigned int>((*qitr)->_data.size());
+            _writeQueue.erase(qitr);
         }
-        return result;
     }
-    return ReaderWriter::WriteResult::FILE_NOT_HANDLED;
-}
 
-ReaderWriter::ReadResult FileCache::readHeightField(const std::string& originalFileName, const osgDB::Options* options) const
-{
-    std::string cacheFileName = createCacheFileName(originalFileName);
-    if (!cacheFileName.empty() && osgDB::fileExists(cacheFileName))
+    _writeQueue.push_back(pendingWrite);
+    _pendingWrites[pendingWrite->_cacheFileName] = pendingWrite;
+    _writeQueueSize += size;
+
+    if (!_writeThread)
     {
-        OSG_INFO<<"FileCache::readHeightFieldFromCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
-        return osgDB::Registry::instance()->readHeightField(cacheFileName, options);
+        _writeThread = new WriteThread(this);
+        _writeThread->startThread();
     }
-    else
+
+    _writeQueueCondition.broadcast();
+    return true;
+}
+
+bool FileCache::takeNextPendingWrite(osg::ref_ptr<PendingWrite>& pendingWrite) const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_writeQueueMutex);
+    while(_writeQueue.empty())
     {
-        return 0;
+        if (_writeThreadDone) return false;
+        _writeQueueCondition.wait(&_writeQueueMutex);
     }
+
+    pendingWrite = _writeQueue.front();
+    _writeQueue.pop_front();
+    _writeQueueSize -= static_cast<unsigned int>(pendingWrite->_data.size());
+    ++_numWritesInProgress;
+    return true;
 }
 
-ReaderWriter::WriteResult FileCache::writeHeightField(const osg::HeightField& hf, const std::string& originalFileName, const osgDB::Options* options) const
+void FileCache::completedPendingWrite(PendingWrite* pendingWrite) const
 {
-    std::string cacheFileName = createCacheFileName(originalFileName);
-    if (!cacheFileName.empty())
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_writeQueueMutex);
+
+    // a newer write of the same file may have been queued in the meantime, in which case keep that one.
+    PendingWriteMap::iterator itr = _pendingWrites.find(pendingWrite->_cacheFileName);
+    if (itr!=_pendingWrites.end() && itr->second==pendingWrite) _pendingWrites.erase(itr);
+
+    --_numWritesInProgress;
+    _writeQueueCondition.broadcast();
+}
+
+osg::ref_ptr<FileCache::PendingWrite> FileCache::getPendingWrite(const std::string& cacheFileName) const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_writeQueueMutex);
+    if (_pendingWrites.empty()) return 0;
+
+    PendingWriteMap::iterator itr = _pendingWrites.find(cacheFileName);
+    return itr!=_pendingWrites.end() ? itr->second : 0;
+}
+
+bool FileCache::writePendingWrite(PendingWrite* pendingWrite) const
+{
+    const std::string& cacheFileName = pendingWrite->_cacheFileName;
+
+    std::string path = osgDB::getFilePath(cacheFileName);
+    if (!osgDB::fileExists(path) && !osgDB::makeDirectory(path))
     {
-        std::string path = osgDB::getFilePath(cacheFileName);
+        OSG_NOTICE<<"Could not create cache directory: "<<path<<std::endl;
+        return false;
+    }
 
-        if (!osgDB::fileExists(path) && !osgDB::makeDirectory(path))
-        {
-            OSG_NOTICE<<"Could not create cache directory: "<<path<<std::endl;
-            return ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
-        }
+    OSG_INFO<<"FileCache::writePendingWrite("<<pendingWrite->_originalFileName<<") as "<<cacheFileName<<std::endl;
 
-        OSG_INFO<<"FileCache::writeHeightFieldToCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
-        ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeHeightField(hf, cacheFileName, options);
-        if (result.success())
+    // write to a temporary file first so that readers never see a partially written file, the name is
+    // made unique as a full write queue can lead to the same file being written by two threads at once.
+    static OpenThreads::Atomic s_tempFileCount;
+    std::ostringstream tempFileName;
+    tempFileName<<cacheFileName<<"."<<(++s_tempFileCount)<<".tmp";
+    {
+        osgDB::ofstream fout(tempFileName.str().c_str(), std::ios::out | std::ios::binary);
+        fout.write(pendingWrite->_data.c_str(), pendingWrite->_data.size());
+        if (!fout)
         {
-            removeFileFromBlackListed(originalFileName);
+            OSG_NOTICE<<"Could not write cache file: "<<cacheFileName<<std::endl;
+            fout.close();
+            remove(tempFileName.str().c_str());
+            return false;
         }
-        return result;
     }
-    return ReaderWriter::WriteResult::FILE_NOT_HANDLED;
-}
 
-ReaderWriter::ReadResult FileCache::readNode(const std::string& originalFileName, const osgDB::Options* options, bool buildKdTreeIfRequired) const
-{
-    std::string cacheFileName = createCacheFileName(originalFileName);
-    if (!cacheFileName.empty() && osgDB::fileExists(cacheFileName))
+#if defined(_WIN32)
+    // rename() won't replace an existing file on Windows, elsewhere it replaces it atomically.
+    remove(cacheFileName.c_str());
+#endif
+    if (rename(tempFileName.str().c_str(), cacheFileName.c_str())!=0)
     {
-        OSG_INFO<<"FileCache::readNodeFromCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
-        return osgDB::Registry::instance()->readNode(cacheFileName, options, buildKdTreeIfRequired);
+        OSG_NOTICE<<"Could not write cache file: "<<cacheFileName<<std::endl;
+        remove(tempFileName.str().c_str());
+        return false;
     }
-    else
+
+    recordWrite(pendingWrite->_originalFileName, cacheFileName);
+    return true;
+}
+
+void FileCache::setMaximumCacheSize(uint64_t bytes)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_cacheIndexMutex);
+    _maximumCacheSize = bytes;
+    if (_maximumCacheSize>0)
     {
-        return 0;
+        buildCacheIndex();
+        if (_cacheSize>_maximumCacheSize) evictFiles();
     }
 }
 
-ReaderWriter::WriteResult FileCache::writeNode(const osg::Node& node, const std::string& originalFileName, const osgDB::Options* options) const
+uint64_t FileCache::getCacheSize() const
 {
-    std::string cacheFileName = createCacheFileName(originalFileName);
-    if (!cacheFileName.empty())
-    {
-        std::string path = osgDB::getFilePath(cacheFileName);
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_cacheIndexMutex);
+    if (_maximumCacheSize>0) buildCacheIndex();
+    return _cacheSize;
+}
 
-        if (!osgDB::fileExists(path) && !osgDB::makeDirectory(path))
-        {
-            OSG_NOTICE<<"Could not create cache directory: "<<path<<std::endl;
-            return ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
-        }
+void FileCache::resetStatistics()
+{
+    _numHits.exchange(0);
+    _numMisses.exchange(0);
+    _numWrites.exchange(0);
+    _numEvictions.exchange(0);
+}
 
-        OSG_INFO<<"FileCache::writeNodeToCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
-        ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeNode(node, cacheFileName, options);
-        if (result.success())
-        {
-            removeFileFromBlackListed(originalFileName);
-        }
-        return result;
-    }
-    return ReaderWriter::WriteResult::FILE_NOT_HANDLED;
+void FileCache::recordHit(const std::string& cacheFileName) const
+{
+    ++_numHits;
+
+    if (_maximumCacheSize==0) return;
+
+    // record the access on the file itself so that the least recently used order survives between runs.
+    setFileTimeToNow(cacheFileName);
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_cacheIndexMutex);
+    CacheIndex::iterator itr = _cacheIndex.find(cacheFileName);
+    if (itr!=_cacheIndex.end()) itr->second._accessTime = static_cast<double>(time(0));
 }
 
+void FileCache::recordWrite(const std::string& originalFileName, const std::string& cacheFileName) const
+{
+    ++_numWrites;
 
-ReaderWriter::ReadResult FileCache::readShader(const std::string& originalFileName, const osgDB::Options* options) const
+    removeFileFromBlackListed(originalFileName);
+
+    if (_maximumCacheSize==0) return;
+
+    FileStat fileStat;
+    if (getFileStat(cacheFileName, fileStat)!=0) return;
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_cacheIndexMutex);
+    buildCacheIndex();
+
+    CacheEntry& entry = _cacheIndex[cacheFileName];
+    _cacheSize -= entry._size;
+    entry = CacheEntry(static_cast<uint64_t>(fileStat.st_size), static_cast<double>(time(0)));
+    _cacheSize += entry._size;
+
+    if (_cacheSize>_maximumCacheSize) evictFiles();
+}
+
+static bool isCacheMetaDataFile(const std::string& fileName)
 {
-    std::string cacheFileName = createCacheFileName(originalFileName);
-    if (!cacheFileName.empty() && osgDB::fileExists(cacheFileName))
+    std::string ext = getLowerCaseFileExtension(fileName);
+    return ext=="revisions" || ext=="added" || ext=="removed" || ext=="modified" || ext=="tmp";
+}
+
+static void scanCacheDirectory(const std::string& directory, std::vector<std::string>& files)
+{
+    DirectoryContents contents = getDirectoryContents(directory);
+    for(DirectoryContents::iterator itr = contents.begin();
+        itr != contents.end();
+        ++itr)
     {
-        OSG_INFO<<"FileCache::readShaderFromCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
-        return osgDB::Registry::instance()->readShader(cacheFileName, options);
+        if (*itr=="." || *itr=="..") continue;
+
+        std::string fileName = concatPaths(directory, *itr);
+        switch(fileType(fileName))
+        {
+            case(DIRECTORY): scanCacheDirectory(fileName, files); break;
+            case(REGULAR_FILE): if (!isCacheMetaDataFile(fileName)) files.push_back(fileName); break;
+            default: break;
+        }
     }
-    else
+}
+
+void FileCache::buildCacheIndex() const
+{
+    // called with _cacheIndexMutex locked.
+    if (_cacheIndexBuilt) return;
+    _cacheIndexBuilt = true;
+
+    std::vector<std::string> files;
+    scanCacheDirectory(_fileCachePath, files);
+
+    for(std::vector<std::string>::iterator itr = files.begin();
+        itr != files.end();
+        ++itr)
     {
-        return 0;
+        FileStat fileStat;
+        if (getFileStat(*itr, fileStat)!=0) continue;
+
+        CacheEntry& entry = _cacheIndex[*itr];
+        _cacheSize -= entry._size;
+        entry = CacheEntry(static_cast<uint64_t>(fileStat.st_size), static_cast<double>(fileStat.st_mtime));
+        _cacheSize += entry._size;
     }
+
+    OSG_INFO<<"FileCache::buildCacheIndex() "<<_cacheIndex.size()<<" files, "<<_cacheSize<<" bytes"<<std::endl;
 }
 
-ReaderWriter::WriteResult FileCache::writeShader(const osg::Shader& shader, const std::string& originalFileName, const osgDB::Options* options) const
+void FileCache::evictFiles() const
 {
-    std::string cacheFileName = createCacheFileName(originalFileName);
-    if (!cacheFileName.empty())
+    // called with _cacheIndexMutex locked, remove down to 90% of the limit so that eviction isn't required on every write.
+    uint64_t targetSize = _maximumCacheSize - _maximumCacheSize/10;
+
+    typedef std::vector< std::pair<double, std::string> > AccessOrder;
+    AccessOrder accessOrder;
+    accessOrder.reserve(_cacheIndex.size());
+    for(CacheIndex::iterator itr = _cacheIndex.begin();
+        itr != _cacheIndex.end();
+        ++itr)
     {
-        std::string path = osgDB::getFilePath(cacheFileName);
+        accessOrder.push_back(AccessOrder::value_type(itr->second._accessTime, itr->first));
+    }
+    std::sort(accessOrder.begin(), accessOrder.end());
 
-        if (!osgDB::fileExists(path) && !osgDB::makeDirectory(path))
-        {
-            OSG_NOTICE<<"Could not create cache directory: "<<path<<std::endl;
-            return ReaderWriter::WriteResult::ERROR_IN_WRITING_FILE;
-        }
+    for(AccessOrder::iterator itr = accessOrder.begin();
+        itr != accessOrder.end() && _cacheSize>targetSize;
+        ++itr)
+    {
+        CacheIndex::iterator citr = _cacheIndex.find(itr->second);
 
-        OSG_INFO<<"FileCache::writeShaderToCache("<<originalFileName<<") as "<<cacheFileName<<std::endl;
-        ReaderWriter::WriteResult result = osgDB::Registry::instance()->writeShader(shader, cacheFileName, options);
-        if (result.success())
-        {
-            removeFileFromBlackListed(originalFileName);
-        }
-        return result;
+        OSG_INFO<<"FileCache::evictFiles() removing "<<itr->second<<std::endl;
+        if (remove(itr->second.c_str())!=0 && osgDB::fileExists(itr->second)) continue;
+
+        _cacheSize -= citr->second._size;
+        _cacheIndex.erase(citr);
+        ++_numEvictions;
     }
-    return ReaderWriter::WriteResult::FILE_NOT_HANDLED;
 }
 
-
 bool FileCache::isCachedFileBlackListed(const std::string& originalFileName) const
 {
     for(DatabaseRevisionsList::const_iterator itr = _databaseRevisionsList.begin();
@@ -1046,11 +1046,20 @@ void InputStream::decompress()
             return;
         }
 
-        if ( !compressor->decompress(*(_in->getStream()), data) )
-            throwException( "InputStream: Failed to decompress stream." );
-        if ( getException() ) return;
+        _dataDecompress = compressor->createDecompressionStream(*(_in->getStream()));
+        if ( !_dataDecompress )
+        {
+            if ( !compressor->decompress(*(_in->getStream()), data) )
+                throwException( "InputStream: Failed to decompress stream." );
+            if ( getException() ) return;
 
-        _dataDecompress = new std::stringstream(data);
+            _dataDecompress = new std::stringstream(data);
+        }
+        else if ( _dataDecompress->fail() )
+        {
+            throwException( "InputStream: Failed to decompress stream." );
+            return;
+        }
         _in->setStream( _dataDecompress );
         _fields.pop_back();
     }
@@ -0,0 +1,109 @@
+/* -*-c++-*- OpenSceneGraph - Copyright (C) 1998-2006 Robert Osfield
+ *
+ * This library is open source and may be redistributed and/or modified under
+ * the terms of the OpenSceneGraph Public License (OSGPL) version 0.0 or
+ * (at your option) any later version.  The full license is in LICENSE file
+ * included with this distribution, and on the openscenegraph.org website.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * OpenSceneGraph Public License for more details.
+*/
+
+#include <osgDB/MappedFile>
+#include <osgDB/ConvertUTF>
+#include <osg/Notify>
+#include <osg/Config>
+
+#if defined(_WIN32) && !defined(__CYGWIN__)
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+using namespace osgDB;
+
+osg::ref_ptr<MappedFile> MappedFile::open(const std::string& filename)
+{
+#if defined(_WIN32) && !defined(__CYGWIN__)
+    #ifdef OSG_USE_UTF8_FILENAME
+    HANDLE file = CreateFileW(osgDB::convertUTF8toUTF16(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    #else
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    #endif
+    if (file==INVALID_HANDLE_VALUE) return 0;
+
+    // the whole file has to fit in the address space, which very large files won't on 32 bit builds.
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart<=0 ||
+        static_cast<unsigned long long>(fileSize.QuadPart)>static_cast<unsigned long long>(static_cast<size_t>(-1)))
+    {
+        CloseHandle(file);
+        return 0;
+    }
+
+    // PAGE_WRITECOPY lets the view be mapped copy-on-write, the view keeps its own references to the file.
+    HANDLE mapping = CreateFileMapping(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    CloseHandle(file);
+    if (!mapping) return 0;
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!data) return 0;
+
+    size_t size = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd<0) return 0;
+
+    // the whole file has to fit in the address space, which very large files won't on 32 bit builds.
+    struct stat fileStat;
+    if (fstat(fd, &fileStat)!=0 || fileStat.st_size<=0 ||
+        static_cast<unsigned long long>(fileStat.st_size)>static_cast<unsigned long long>(static_cast<size_t>(-1)))
+    {
+        ::close(fd);
+        return 0;
+    }
+
+    size_t size = static_cast<size_t>(fileStat.st_size);
+    void* data = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+    // the mapping keeps its own reference to the file.
+    ::close(fd);
+
+    if (data==MAP_FAILED) return 0;
+#endif
+
+    OSG_DEBUG<<"MappedFile::open("<<filename<<") mapped "<<size<<" bytes"<<std::endl;
+
+    return new MappedFile(filename, static_cast<unsigned char*>(data), size);
+}
+
+MappedFile::MappedFile(const std::string& filename, unsigned char* data, size_t size):
+    _fileName(filename),
+    _data(data),
+    _size(size)
+{
+}
+
+MappedFile::MappedFile(const MappedFile&):
+    osg::Referenced(),
+    _data(0),
+    _size(0)
+{
+}
+
+MappedFile::~MappedFile()
+{
+    if (!_data) return;
+
+#if defined(_WIN32) && !defined(__CYGWIN__)
+    UnmapViewOfFile(_data);
+#else
+    munmap(_data, _size);
+#endif
+}
@@ -12,37 +12,22 @@
 */
 
 #include <osg/Texture>
+#include <osg/Geometry>
+#include <osg/Image>
 #include <osgDB/ObjectCache>
 #include <osgDB/Options>
 
-using namespace osgDB;
-
-bool ObjectCache::ClassComp::operator() (const ObjectCache::FileNameOptionsPair& lhs, const ObjectCache::FileNameOptionsPair& rhs) const
-{
-    // check if filename are the same
-    if (lhs.first < rhs.first) return true;
-    if (rhs.first < lhs.first) return false;
+#include <set>
 
-    // check if Options pointers are the same.
-    if (lhs.second == rhs.second) return false;
-
-    // need to compare Options pointers
-    if (lhs.second.valid() && rhs.second.valid())
-    {
-        // lhs & rhs have valid Options objects
-        return *lhs.second < *rhs.second;
-    }
-
-    // finally use pointer comparison, expecting at least one will be NULL pointer
-    return lhs.second < rhs.second;
-}
+using namespace osgDB;
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 //
 // ObjectCache
 //
 ObjectCache::ObjectCache():
-    osg::Referenced(true)
+    osg::Referenced(true),
+    _maximumSizeInBytes(0)
 {
 //    OSG_NOTICE<<"Constructed ObjectCache"<<std::endl;
 }
@@ -52,141 +37,294 @@ ObjectCache::~ObjectCache()
 //    OSG_NOTICE<<"Destructed ObjectCache"<<std::endl;
 }
 
-void ObjectCache::addObjectCache(ObjectCache* objectCache)
+ObjectCache::Shard& ObjectCache::getShard(const std::string& fileName)
 {
-    // don't allow a cache to be added to itself.
-    if (objectCache==this) return;
-
-    // lock both ObjectCache to prevent their contents from being modified by other threads while we merge.
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock1(_objectCacheMutex);
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock2(objectCache->_objectCacheMutex);
+    // FNV-1a hash of the file name
+    unsigned int hash = 2166136261u;
+    for(std::string::const_iterator itr = fileName.begin(); itr != fileName.end(); ++itr)
+    {
+        hash = (hash ^ static_cast<unsigned char>(*itr)) * 16777619u;
+    }
+    return _shards[hash % NUM_SHARDS];
+}
 
-    OSG_DEBUG<<"Inserting objects to main ObjectCache "<<objectCache->_objectCache.size()<<std::endl;
+ObjectCache::CacheEntry* ObjectCache::find(Shard& shard, const std::string& fileName, const osgDB::Options* options)
+{
+    ObjectCacheMap::iterator mitr = shard._objectCache.find(fileName);
+    if (mitr==shard._objectCache.end()) return 0;
 
-    _objectCache.insert(objectCache->_objectCache.begin(), objectCache->_objectCache.end());
+    for(CacheEntryList::iterator eitr = mitr->second.begin();
+        eitr != mitr->second.end();
+        ++eitr)
+    {
+        if (eitr->_options.valid())
+        {
+            if (options && *(eitr->_options)==*options) return &(*eitr);
+        }
+        else if (!options) return &(*eitr);
+    }
+    return 0;
 }
 
-
-void ObjectCache::addEntryToObjectCache(const std::string& filename, osg::Object* object, double timestamp, const Options *options)
+void ObjectCache::insert(Shard& shard, const CacheEntry& entry)
 {
-    if (!object) return;
+    CacheEntryList& entries = shard._objectCache[entry._fileName];
+    entries.push_back(entry);
 
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-    _objectCache[FileNameOptionsPair(filename, options ? osg::clone(options) : 0)] = ObjectTimeStampPair(object,timestamp);
-    OSG_DEBUG<<"Adding "<<filename<<" with options '"<<(options ? options->getOptionString() : "")<<"' to ObjectCache "<<this<<std::endl;
+    CacheEntry& inserted = entries.back();
+    shard._lruList.push_front(&inserted);
+    inserted._lruItr = shard._lruList.begin();
+    shard._sizeInBytes += inserted._sizeInBytes;
 }
 
-ObjectCache::ObjectCacheMap::iterator ObjectCache::find(const std::string& fileName, const osgDB::Options* options)
+void ObjectCache::erase(Shard& shard, CacheEntry* entry)
 {
-    for(ObjectCacheMap::iterator itr = _objectCache.begin();
-        itr != _objectCache.end();
-        ++itr)
+    ObjectCacheMap::iterator mitr = shard._objectCache.find(entry->_fileName);
+    for(CacheEntryList::iterator eitr = mitr->second.begin();
+        eitr != mitr->second.end();
+        ++eitr)
     {
-        if (itr->first.first==fileName)
+        if (&(*eitr)==entry)
         {
-            if (itr->first.second.valid())
-            {
-                if (options && *(itr->first.second)==*options) return itr;
-            }
-            else if (!options) return itr;
+            shard._sizeInBytes -= entry->_sizeInBytes;
+            shard._lruList.erase(entry->_lruItr);
+
+            mitr->second.erase(eitr);
+            if (mitr->second.empty()) shard._objectCache.erase(mitr);
+            return;
         }
     }
-    return _objectCache.end();
 }
 
+void ObjectCache::setMaximumSizeInBytes(size_t size)
+{
+    _maximumSizeInBytes = size;
 
-osg::Object* ObjectCache::getFromObjectCache(const std::string& fileName, const Options *options)
+    for(unsigned int i=0; i<NUM_SHARDS; ++i)
+    {
+        Shard& shard = _shards[i];
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
+        evict(shard);
+    }
+}
+
+void ObjectCache::evict(Shard& shard)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-    ObjectCacheMap::iterator itr = find(fileName, options);
-    if (itr!=_objectCache.end())
+    if (_maximumSizeInBytes==0) return;
+
+    size_t shardBudget = _maximumSizeInBytes/NUM_SHARDS;
+
+    // walk from the least recently used end, skipping entries that are still referenced from outside the
+    // cache as evicting them wouldn't release any memory.
+    LRUList::iterator litr = shard._lruList.end();
+    while(shard._sizeInBytes>shardBudget && litr!=shard._lruList.begin())
     {
-        osg::ref_ptr<const osgDB::Options> o = itr->first.second;
-        if (o.valid())
-        {
-            OSG_DEBUG<<"Found "<<fileName<<" with options '"<< o->getOptionString()<< "' in ObjectCache "<<this<<std::endl;
-        }
-        else
+        --litr;
+
+        CacheEntry* entry = *litr;
+        if (entry->_object->referenceCount()>1) continue;
+
+        OSG_DEBUG<<"Evicting "<<entry->_fileName<<" from ObjectCache "<<this<<std::endl;
+
+        LRUList::iterator next = litr;
+        ++next;
+        erase(shard, entry);
+        litr = next;
+
+        ++_numEvictions;
+    }
+}
+
+void ObjectCache::addObjectCache(ObjectCache* objectCache)
+{
+    // don't allow a cache to be added to itself.
+    if (objectCache==this) return;
+
+    for(unsigned int i=0; i<NUM_SHARDS; ++i)
+    {
+        // file names hash to the same shard in both caches, so only one pair of shards need be locked at a time.
+        Shard& shard = _shards[i];
+        Shard& otherShard = objectCache->_shards[i];
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock1(shard._mutex);
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock2(otherShard._mutex);
+
+        OSG_DEBUG<<"Inserting objects to main ObjectCache "<<otherShard._lruList.size()<<std::endl;
+
+        // insert in least recently used order so that the relative order is kept.
+        for(LRUList::reverse_iterator litr = otherShard._lruList.rbegin();
+            litr != otherShard._lruList.rend();
+            ++litr)
         {
-            OSG_DEBUG<<"Found "<<fileName<<" in ObjectCache "<<this<<std::endl;
+            const CacheEntry* entry = *litr;
+            if (!find(shard, entry->_fileName, entry->_options.get())) insert(shard, *entry);
         }
-        return itr->second.first.get();
+
+        evict(shard);
+    }
+}
+
+
+void ObjectCache::addEntryToObjectCache(const std::string& filename, osg::Object* object, double timestamp, const Options *options)
+{
+    if (!object) return;
+
+    // sizes are always estimated so that the totals are right whenever a budget is set later on.
+    size_t sizeInBytes = computeSizeInBytes(object);
+
+    Shard& shard = getShard(filename);
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
+
+    CacheEntry* entry = find(shard, filename, options);
+    if (entry)
+    {
+        shard._sizeInBytes += sizeInBytes;
+        shard._sizeInBytes -= entry->_sizeInBytes;
+
+        entry->_object = object;
+        entry->_timestamp = timestamp;
+        entry->_sizeInBytes = sizeInBytes;
+
+        shard._lruList.splice(shard._lruList.begin(), shard._lruList, entry->_lruItr);
+    }
+    else
+    {
+        CacheEntry newEntry;
+        newEntry._fileName = filename;
+        newEntry._options = options ? osg::clone(options) : 0;
+        newEntry._object = object;
+        newEntry._timestamp = timestamp;
+        newEntry._sizeInBytes = sizeInBytes;
+        insert(shard, newEntry);
     }
-    else return 0;
+
+    OSG_DEBUG<<"Adding "<<filename<<" with options '"<<(options ? options->getOptionString() : "")<<"' to ObjectCache "<<this<<std::endl;
+
+    evict(shard);
+}
+
+osg::Object* ObjectCache::getFromObjectCache(const std::string& fileName, const Options *options)
+{
+    return getRefFromObjectCache(fileName, options).get();
 }
 
 osg::ref_ptr<osg::Object> ObjectCache::getRefFromObjectCache(const std::string& fileName, const Options *options)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-    ObjectCacheMap::iterator itr = find(fileName, options);
-    if (itr!=_objectCache.end())
+    Shard& shard = getShard(fileName);
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
+
+    CacheEntry* entry = find(shard, fileName, options);
+    if (entry)
     {
-        osg::ref_ptr<const osgDB::Options> o = itr->first.second;
-        if (o.valid())
+        if (entry->_options.valid())
         {
-            OSG_DEBUG<<"Found "<<fileName<<" with options '"<< o->getOptionString()<< "' in ObjectCache "<<this<<std::endl;
+            OSG_DEBUG<<"Found "<<fileName<<" with options '"<< entry->_options->getOptionString()<< "' in ObjectCache "<<this<<std::endl;
         }
         else
         {
             OSG_DEBUG<<"Found "<<fileName<<" in ObjectCache "<<this<<std::endl;
         }
-        return itr->second.first.get();
+
+        ++_numHits;
+        shard._lruList.splice(shard._lruList.begin(), shard._lruList, entry->_lruItr);
+
+        return entry->_object.get();
+    }
+    else
+    {
+        ++_numMisses;
+        return 0;
     }
-    else return 0;
 }
 
 void ObjectCache::updateTimeStampOfObjectsInCacheWithExternalReferences(double referenceTime)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-
-    // look for objects with external references and update their time stamp.
-    for(ObjectCacheMap::iterator itr=_objectCache.begin();
-        itr!=_objectCache.end();
-        ++itr)
+    for(unsigned int i=0; i<NUM_SHARDS; ++i)
     {
-        // if ref count is greater the 1 the object has an external reference.
-        if (itr->second.first->referenceCount()>1)
+        Shard& shard = _shards[i];
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
+
+        // look for objects with external references and update their time stamp.
+        for(LRUList::iterator litr = shard._lruList.begin();
+            litr != shard._lruList.end();
+            ++litr)
         {
-            // so update it time stamp.
-            itr->second.second = referenceTime;
+            // if ref count is greater the 1 the object has an external reference.
+            if ((*litr)->_object->referenceCount()>1)
+            {
+                // so update it time stamp.
+                (*litr)->_timestamp = referenceTime;
+            }
         }
     }
 }
 
 void ObjectCache::removeExpiredObjectsInCache(double expiryTime)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-
-    // Remove expired entries from object cache
-    ObjectCacheMap::iterator oitr = _objectCache.begin();
-    while(oitr != _objectCache.end())
+    for(unsigned int i=0; i<NUM_SHARDS; ++i)
     {
-        if (oitr->second.second<=expiryTime)
-        {
-#if __cplusplus > 199711L
-            oitr = _objectCache.erase(oitr);
-#else
-            _objectCache.erase(oitr++);
-#endif
-        }
-        else
+        Shard& shard = _shards[i];
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
+
+        // Remove expired entries from object cache
+        for(LRUList::iterator litr = shard._lruList.begin();
+            litr != shard._lruList.end();
+            )
         {
-            ++oitr;
+            CacheEntry* entry = *(litr++);
+            if (entry->_timestamp<=expiryTime) erase(shard, entry);
         }
     }
 }
 
 void ObjectCache::removeFromObjectCache(const std::string& fileName, const Options *options)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-    ObjectCacheMap::iterator itr = find(fileName, options);
-    if (itr!=_objectCache.end()) _objectCache.erase(itr);
+    Shard& shard = getShard(fileName);
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
+
+    CacheEntry* entry = find(shard, fileName, options);
+    if (entry) erase(shard, entry);
 }
 
 void ObjectCache::clear()
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-    _objectCache.clear();
+    for(unsigned int i=0; i<NUM_SHARDS; ++i)
+    {
+        Shard& shard = _shards[i];
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
+        shard._objectCache.clear();
+        shard._lruList.clear();
+        shard._sizeInBytes = 0;
+    }
+}
+
+size_t ObjectCache::getSizeInBytes() const
+{
+    size_t sizeInBytes = 0;
+    for(unsigned int i=0; i<NUM_SHARDS; ++i)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_shards[i]._mutex);
+        sizeInBytes += _shards[i]._sizeInBytes;
+    }
+    return sizeInBytes;
+}
+
+unsigned int ObjectCache::getNumEntries() const
+{
+    unsigned int numEntries = 0;
+    for(unsigned int i=0; i<NUM_SHARDS; ++i)
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_shards[i]._mutex);
+        numEntries += _shards[i]._lruList.size();
+    }
+    return numEntries;
+}
+
+void ObjectCache::resetStats()
+{
+    _numHits.exchange(0);
+    _numMisses.exchange(0);
+    _numEvictions.exchange(0);
 }
 
 namespace ObjectCacheUtils
@@ -252,32 +390,134 @@ struct ContainsUnreffedTextures : public osg::NodeVisitor
     }
 };
 
+struct ComputeSizeInBytesVisitor : public osg::NodeVisitor
+{
+    ComputeSizeInBytesVisitor() :
+        osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN),
+        sizeInBytes(0)
+    {}
+
+    size_t sizeInBytes;
+
+    // shared state and arrays are only counted once
+    std::set<const osg::Object*> visited;
+
+    bool firstVisit(const osg::Object* object)
+    {
+        return object && visited.insert(object).second;
+    }
+
+    void apply(const osg::Image* image)
+    {
+        if (firstVisit(image)) sizeInBytes += sizeof(osg::Image) + image->getTotalSizeInBytesIncludingMipmaps();
+    }
+
+    void apply(const osg::Texture* texture)
+    {
+        if (!firstVisit(texture)) return;
+
+        sizeInBytes += sizeof(osg::Texture);
+        for(unsigned int i=0; i<texture->getNumImages(); ++i)
+        {
+            apply(texture->getImage(i));
+        }
+    }
+
+    void apply(const osg::StateSet* stateset)
+    {
+        if (!firstVisit(stateset)) return;
+
+        sizeInBytes += sizeof(osg::StateSet);
+        for(unsigned int i=0; i<stateset->getNumTextureAttributeLists(); ++i)
+        {
+            const osg::StateAttribute* sa = stateset->getTextureAttribute(i, osg::StateAttribute::TEXTURE);
+            if (sa) apply(sa->asTexture());
+        }
+    }
+
+    void apply(const osg::Object* object)
+    {
+        if (!object) return;
+
+        if (const osg::Image* image = dynamic_cast<const osg::Image*>(object)) apply(image);
+        else if (object->asStateAttribute()) apply(dynamic_cast<const osg::Texture*>(object));
+        else if (object->asStateSet()) apply(object->asStateSet());
+        else if (object->asNode()) const_cast<osg::Node*>(object->asNode())->accept(*this);
+        else sizeInBytes += sizeof(osg::Object);
+    }
+
+    virtual void apply(osg::Node& node)
+    {
+        apply(node.getStateSet());
+        traverse(node);
+    }
+
+    virtual void apply(osg::Drawable& drawable)
+    {
+        if (!firstVisit(&drawable)) return;
+
+        sizeInBytes += sizeof(osg::Drawable);
+        apply(drawable.getStateSet());
+    }
+
+    virtual void apply(osg::Geometry& geometry)
+    {
+        if (!firstVisit(&geometry)) return;
+
+        sizeInBytes += sizeof(osg::Geometry);
+        apply(geometry.getStateSet());
+
+        osg::Geometry::ArrayList arrays;
+        geometry.getArrayList(arrays);
+        for(osg::Geometry::ArrayList::iterator itr = arrays.begin();
+            itr != arrays.end();
+            ++itr)
+        {
+            if (firstVisit(itr->get())) sizeInBytes += (*itr)->getTotalDataSize();
+        }
+
+        for(unsigned int i=0; i<geometry.getNumPrimitiveSets(); ++i)
+        {
+            const osg::PrimitiveSet* primitiveSet = geometry.getPrimitiveSet(i);
+            if (firstVisit(primitiveSet)) sizeInBytes += sizeof(osg::PrimitiveSet) + primitiveSet->getTotalDataSize();
+        }
+    }
+};
+
 } // ObjectCacheUtils
 
 void ObjectCache::releaseGLObjects(osg::State* state)
 {
-    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_objectCacheMutex);
-
     ObjectCacheUtils::ContainsUnreffedTextures cut;
 
-    for(ObjectCacheMap::iterator itr = _objectCache.begin();
-        itr != _objectCache.end();
-        )
+    for(unsigned int i=0; i<NUM_SHARDS; ++i)
     {
-        ObjectCacheMap::iterator curr_itr = itr;
-
-        // get object and advance iterator to next item
-        osg::Object* object = itr->second.first.get();
+        Shard& shard = _shards[i];
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(shard._mutex);
 
-        bool needToRemoveEntry = cut.check(itr->second.first.get());
+        for(LRUList::iterator litr = shard._lruList.begin();
+            litr != shard._lruList.end();
+            )
+        {
+            // get object and advance iterator to next item
+            CacheEntry* entry = *(litr++);
+            osg::Object* object = entry->_object.get();
 
-        object->releaseGLObjects(state);
+            bool needToRemoveEntry = cut.check(object);
 
-        ++itr;
+            object->releaseGLObjects(state);
 
-        if (needToRemoveEntry)
-        {
-            _objectCache.erase(curr_itr);
+            if (needToRemoveEntry)
+            {
+                erase(shard, entry);
+            }
         }
     }
 }
+
+size_t ObjectCache::computeSizeInBytes(const osg::Object* object) const
+{
+    ObjectCacheUtils::ComputeSizeInBytesVisitor csv;
+    csv.apply(object);
+    return csv.sizeInBytes;
+}
@@ -14,6 +14,8 @@
 
 #include <osg/Version>
 #include <osg/Notify>
+#include <osg/Image>
+#include <osg/StateSet>
 #include <osgDB/ConvertBase64>
 #include <osgDB/FileUtils>
 #include <osgDB/WriteFile>
@@ -22,11 +24,13 @@
 #include <osgDB/fstream>
 #include <sstream>
 #include <stdlib.h>
+#include <string.h>
+#include <typeinfo>
 
 using namespace osgDB;
 
 OutputStream::OutputStream( const osgDB::Options* options )
-:   _writeImageHint(WRITE_USE_IMAGE_HINT), _useSchemaData(false), _useRobustBinaryFormat(true), _targetFileVersion(OPENSCENEGRAPH_SOVERSION)
+:   _deduplicateContent(false), _writeImageHint(WRITE_USE_IMAGE_HINT), _useSchemaData(false), _useRobustBinaryFormat(true), _targetFileVersion(OPENSCENEGRAPH_SOVERSION)
 {
     BEGIN_BRACKET.set( "{", +INDENT_VALUE );
     END_BRACKET.set( "}", -INDENT_VALUE );
@@ -38,6 +42,8 @@ OutputStream::OutputStream( const osgDB::Options* options )
         _useRobustBinaryFormat = false;
     if ( options->getPluginStringData("SchemaData")=="true" )
         _useSchemaData = true;
+    if ( options->getPluginStringData("DeduplicateContent")=="true" )
+        _deduplicateContent = true;
     if ( !options->getPluginStringData("SchemaFile").empty() )
         _schemaName = options->getPluginStringData("SchemaFile");
     if ( !options->getPluginStringData("Compressor").empty() )
@@ -960,9 +966,194 @@ void OutputStream::writeArrayImplementation( const T* a, int write_size, unsigne
     *this << END_BRACKET << std::endl;
 }
 
+// 64 bit MurmurHash2 (MurmurHash64A) by Austin Appleby, placed in the public domain.
+static uint64_t hashBytes( const void* key, size_t len, uint64_t seed )
+{
+    const uint64_t m = (uint64_t(0xc6a4a793)<<32) | uint64_t(0x5bd1e995);
+    const int r = 47;
+
+    uint64_t h = seed ^ (len * m);
+
+    const unsigned char* data = (const unsigned char*)key;
+    const unsigned char* end = data + (len/8)*8;
+    while ( data!=end )
+    {
+        uint64_t k;
+        memcpy( &k, data, 8 );
+        data += 8;
+
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+
+        h ^= k;
+        h *= m;
+    }
+
+    switch ( len & 7 )
+    {
+    case 7: h ^= uint64_t(data[6]) << 48; // fall through
+    case 6: h ^= uint64_t(data[5]) << 40; // fall through
+    case 5: h ^= uint64_t(data[4]) << 32; // fall through
+    case 4: h ^= uint64_t(data[3]) << 24; // fall through
+    case 3: h ^= uint64_t(data[2]) << 16; // fall through
+    case 2: h ^= uint64_t(data[1]) << 8; // fall through
+    case 1: h ^= uint64_t(data[0]);
+            h *= m;
+    };
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+template<typename T>
+static uint64_t hashValue( const T& value, uint64_t seed )
+{
+    return hashBytes( &value, sizeof(T), seed );
+}
+
+static uint64_t hashString( const std::string& str, uint64_t seed )
+{
+    return hashBytes( str.data(), str.size(), seed );
+}
+
+// Only plain objects without user data are candidates, so that the fields common to all Objects
+// reduce to the name and data variance.
+static bool isDeduplicationCandidate( const osg::Object* obj )
+{
+    if ( obj->getUserDataContainer() ) return false;
+    if ( dynamic_cast<const osg::Array*>(obj) ) return true;
+    if ( typeid(*obj)==typeid(osg::Image) ) return true;
+    if ( typeid(*obj)==typeid(osg::StateSet) )
+    {
+        const osg::StateSet* ss = static_cast<const osg::StateSet*>(obj);
+        return !ss->getUpdateCallback() && !ss->getEventCallback();
+    }
+    return false;
+}
+
+static uint64_t hashContent( const osg::Object* obj )
+{
+    uint64_t h = hashString( obj->className(), 0 );
+    h = hashString( obj->getName(), h );
+    h = hashValue( obj->getDataVariance(), h );
+
+    if ( const osg::Array* array = dynamic_cast<const osg::Array*>(obj) )
+    {
+        h = hashValue( array->getBinding(), h );
+        h = hashValue( array->getNormalize(), h );
+        if ( array->getTotalDataSize()>0 ) h = hashBytes( array->getDataPointer(), array->getTotalDataSize(), h );
+    }
+    else if ( const osg::Image* image = dynamic_cast<const osg::Image*>(obj) )
+    {
+        h = hashString( image->getFileName(), h );
+        h = hashValue( image->s(), h );
+        h = hashValue( image->t(), h );
+        h = hashValue( image->r(), h );
+        h = hashValue( image->getPixelFormat(), h );
+        h = hashValue( image->getDataType(), h );
+        if ( image->data() ) h = hashBytes( image->data(), image->getTotalSizeInBytesIncludingMipmaps(), h );
+    }
+    else if ( const osg::StateSet* ss = dynamic_cast<const osg::StateSet*>(obj) )
+    {
+        h = hashValue( ss->getRenderingHint(), h );
+        h = hashValue( ss->getBinNumber(), h );
+        h = hashValue( ss->getModeList().size(), h );
+        h = hashValue( ss->getAttributeList().size(), h );
+        h = hashValue( ss->getTextureAttributeList().size(), h );
+        h = hashValue( ss->getUniformList().size(), h );
+        const osg::StateSet::AttributeList& attributes = ss->getAttributeList();
+        for ( osg::StateSet::AttributeList::const_iterator itr=attributes.begin(); itr!=attributes.end(); ++itr )
+            h = hashValue( itr->first, h );
+        const osg::StateSet::ModeList& modes = ss->getModeList();
+        for ( osg::StateSet::ModeList::const_iterator itr=modes.begin(); itr!=modes.end(); ++itr )
+        {
+            h = hashValue( itr->first, h );
+            h = hashValue( itr->second, h );
+        }
+    }
+    return h;
+}
+
+static bool sameContent( const osg::Object* lhs, const osg::Object* rhs )
+{
+    if ( typeid(*lhs)!=typeid(*rhs) ) return false;
+    if ( lhs->getName()!=rhs->getName() || lhs->getDataVariance()!=rhs->getDataVariance() ) return false;
+
+    if ( const osg::Array* lhsArray = dynamic_cast<const osg::Array*>(lhs) )
+    {
+        const osg::Array* rhsArray = static_cast<const osg::Array*>(rhs);
+        return lhsArray->getType()==rhsArray->getType() &&
+               lhsArray->getBinding()==rhsArray->getBinding() &&
+               lhsArray->getNormalize()==rhsArray->getNormalize() &&
+               lhsArray->getPreserveDataType()==rhsArray->getPreserveDataType() &&
+               lhsArray->getTotalDataSize()==rhsArray->getTotalDataSize() &&
+               (lhsArray->getTotalDataSize()==0 ||
+                memcmp(lhsArray->getDataPointer(), rhsArray->getDataPointer(), lhsArray->getTotalDataSize())==0);
+    }
+    else if ( const osg::Image* lhsImage = dynamic_cast<const osg::Image*>(lhs) )
+    {
+        const osg::Image* rhsImage = static_cast<const osg::Image*>(rhs);
+        if ( lhsImage->getFileName()!=rhsImage->getFileName() ||
+             lhsImage->getWriteHint()!=rhsImage->getWriteHint() ||
+             lhsImage->s()!=rhsImage->s() || lhsImage->t()!=rhsImage->t() || lhsImage->r()!=rhsImage->r() ||
+             lhsImage->getInternalTextureFormat()!=rhsImage->getInternalTextureFormat() ||
+             lhsImage->getPixelFormat()!=rhsImage->getPixelFormat() ||
+             lhsImage->getDataType()!=rhsImage->getDataType() ||
+             lhsImage->getPacking()!=rhsImage->getPacking() ||
+             lhsImage->getRowLength()!=rhsImage->getRowLength() ||
+             lhsImage->getOrigin()!=rhsImage->getOrigin() ||
+             lhsImage->getAllocationMode()!=rhsImage->getAllocationMode() ||
+             lhsImage->getMipmapLevels()!=rhsImage->getMipmapLevels() ) return false;
+
+        // images without data are only the same when they refer to the same file
+        if ( !lhsImage->data() || !rhsImage->data() )
+            return !lhsImage->data() && !rhsImage->data() && !lhsImage->getFileName().empty();
+
+        return memcmp(lhsImage->data(), rhsImage->data(), lhsImage->getTotalSizeInBytesIncludingMipmaps())==0;
+    }
+    else if ( const osg::StateSet* lhsStateSet = dynamic_cast<const osg::StateSet*>(lhs) )
+    {
+        const osg::StateSet* rhsStateSet = static_cast<const osg::StateSet*>(rhs);
+        return lhsStateSet->getRenderingHint()==rhsStateSet->getRenderingHint() &&
+               lhsStateSet->getNestRenderBins()==rhsStateSet->getNestRenderBins() &&
+               lhsStateSet->compare(*rhsStateSet, true)==0;
+    }
+    return false;
+}
+
+const osg::Object* OutputStream::findDuplicateContent( const osg::Object* obj )
+{
+    if ( !isDeduplicationCandidate(obj) ) return obj;
+
+    uint64_t hash = hashContent( obj );
+    std::pair<ContentHashMap::iterator, ContentHashMap::iterator> range = _contentHashMap.equal_range( hash );
+    for ( ContentHashMap::iterator itr=range.first; itr!=range.second; ++itr )
+    {
+        if ( sameContent(itr->second, obj) ) return itr->second;
+    }
+
+    _contentHashMap.insert( ContentHashMap::value_type(hash, obj) );
+    return obj;
+}
+
 unsigned int OutputStream::findOrCreateArrayID( const osg::Array* array, bool& newID )
 {
     ArrayMap::iterator itr = _arrayMap.find( array );
+    if ( itr==_arrayMap.end() && _deduplicateContent )
+    {
+        const osg::Array* original = static_cast<const osg::Array*>(findDuplicateContent(array));
+        if ( original!=array ) itr = _arrayMap.find( original );
+        if ( itr!=_arrayMap.end() )
+        {
+            _arrayMap[array] = itr->second;
+            newID = false;
+            return itr->second;
+        }
+    }
+
     if ( itr==_arrayMap.end() )
     {
         unsigned int id = _arrayMap.size()+1;
@@ -977,6 +1168,18 @@ unsigned int OutputStream::findOrCreateArrayID( const osg::Array* array, bool& n
 unsigned int OutputStream::findOrCreateObjectID( const osg::Object* obj, bool& newID )
 {
     ObjectMap::iterator itr = _objectMap.find( obj );
+    if ( itr==_objectMap.end() && _deduplicateContent )
+    {
+        const osg::Object* original = findDuplicateContent(obj);
+        if ( original!=obj ) itr = _objectMap.find( original );
+        if ( itr!=_objectMap.end() )
+        {
+            _objectMap[obj] = itr->second;
+            newID = false;
+            return itr->second;
+        }
+    }
+
     if ( itr==_objectMap.end() )
     {
         unsigned int id = _objectMap.size()+1;
@@ -62,7 +62,10 @@ static osg::ApplicationUsageProxy Registry_e0(osg::ApplicationUsage::ENVIRONMENT
 static osg::ApplicationUsageProxy Registry_e1(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_LIBRARY_PATH <path>[;path]..","Paths for locating libraries/ plugins");
 #endif
 
-static osg::ApplicationUsageProxy Registry_e2(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_BUILD_KDTREES on/off","Enable/disable the automatic building of KdTrees for each loaded Geometry.");
+static osg::ApplicationUsageProxy Registry_e2(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_BUILD_KDTREES on/off/ondemand","Enable/disable the automatic building of KdTrees for each loaded Geometry, ondemand defers each build until the first intersection test.");
+static osg::ApplicationUsageProxy Registry_e3(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_CACHE_FIND_DATA_FILE on/off","Enable/disable the caching of data file search results.");
+static osg::ApplicationUsageProxy Registry_e4(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_KDTREE_TYPE KDTREE/BVH","Set whether KdTrees or bounding volume hierarchies are built to accelerate intersections with each loaded Geometry.");
+static osg::ApplicationUsageProxy Registry_e5(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_KDTREE_BUILD_THREADS <numThreads>","Set the number of threads used to build the KdTrees of each loaded model, default is 1.");
 
 
 // from MimeTypes.cpp
@@ -72,9 +75,10 @@ extern const char* builtinMimeTypeExtMappings[];
 class Registry::AvailableReaderWriterIterator
 {
 public:
-    AvailableReaderWriterIterator(Registry::ReaderWriterList& rwList, OpenThreads::ReentrantMutex& pluginMutex):
-        _rwList(rwList),
-        _pluginMutex(pluginMutex) {}
+    AvailableReaderWriterIterator(Registry& registry):
+        _registry(registry),
+        _index(registry.getReaderWriterIndex()),
+        _position(0) {}
 
 
     ReaderWriter& operator * () { return *get(); }
@@ -84,7 +88,7 @@ public:
 
     void operator ++()
     {
-        _rwUsed.insert(get());
+        if (get()) ++_position;
     }
 
 
@@ -92,23 +96,34 @@ protected:
 
     AvailableReaderWriterIterator& operator = (const AvailableReaderWriterIterator&) { return *this; }
 
-    Registry::ReaderWriterList&     _rwList;
-    OpenThreads::ReentrantMutex&    _pluginMutex;
+    Registry&                                   _registry;
+    const Registry::ReaderWriterIndex*          _index;
+    unsigned int                                _position;
 
-    std::set<ReaderWriter*>         _rwUsed;
+    std::set<ReaderWriter*>                     _rwUsed;
 
     ReaderWriter* get()
     {
-        OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_pluginMutex);
-        Registry::ReaderWriterList::iterator itr=_rwList.begin();
-        for(;itr!=_rwList.end();++itr)
+        const Registry::ReaderWriterIndex* index = _registry.getReaderWriterIndex();
+        if (index!=_index)
         {
-            if (_rwUsed.find(itr->get())==_rwUsed.end())
+            // the ReaderWriter list has changed since the last call, typically due to a plugin being loaded,
+            // so record the ReaderWriters already visited and continue with the unvisited entries of the new index.
+            for(unsigned int i=0; i<_position; ++i)
             {
-                return itr->get();
+                _rwUsed.insert(_index->_readerWriters[i]);
             }
+            _index = index;
+            _position = 0;
         }
-        return 0;
+
+        const Registry::ReaderWriterIndex::ReaderWriters& rwList = _index->_readerWriters;
+        if (!_rwUsed.empty())
+        {
+            while(_position<rwList.size() && _rwUsed.count(rwList[_position])!=0) ++_position;
+        }
+
+        return _position<rwList.size() ? rwList[_position] : 0;
     }
 
 };
@@ -224,6 +239,15 @@ Registry::Registry()
     // comment out because it was causing problems under OSX - causing it to crash osgconv when constructing ostream in osg::notify().
     // OSG_INFO << "Constructing osg::Registry"<<std::endl;
 
+    _rwIndex.assign(new ReaderWriterIndex, 0);
+
+    _cacheFindDataFileResults = false;
+    const char* cacheFindDataFile_str = getenv("OSG_CACHE_FIND_DATA_FILE");
+    if (cacheFindDataFile_str)
+    {
+        _cacheFindDataFileResults = (strcmp(cacheFindDataFile_str, "on")==0 || strcmp(cacheFindDataFile_str, "ON")==0 || strcmp(cacheFindDataFile_str, "On")==0 );
+    }
+
     _buildKdTreesHint = Options::NO_PREFERENCE;
     _kdTreeBuilder = new osg::KdTreeBuilder;
 
@@ -231,10 +255,26 @@ Registry::Registry()
     if (kdtree_str)
     {
         bool switchOff = (strcmp(kdtree_str, "off")==0 || strcmp(kdtree_str, "OFF")==0 || strcmp(kdtree_str, "Off")==0 );
+        bool onDemand = (strcmp(kdtree_str, "ondemand")==0 || strcmp(kdtree_str, "ONDEMAND")==0 || strcmp(kdtree_str, "OnDemand")==0 );
         if (switchOff) _buildKdTreesHint = Options::DO_NOT_BUILD_KDTREES;
+        else if (onDemand) _buildKdTreesHint = Options::BUILD_KDTREES_ON_DEMAND;
         else _buildKdTreesHint = Options::BUILD_KDTREES;
     }
 
+    const char* kdtreeThreads_str = getenv("OSG_KDTREE_BUILD_THREADS");
+    if (kdtreeThreads_str)
+    {
+        int numThreads = atoi(kdtreeThreads_str);
+        _kdTreeBuilder->_buildOptions._numThreads = numThreads>1 ? static_cast<unsigned int>(numThreads) : 1u;
+    }
+
+    const char* kdtreeType_str = getenv("OSG_KDTREE_TYPE");
+    if (kdtreeType_str)
+    {
+        bool useBVH = (strcmp(kdtreeType_str, "bvh")==0 || strcmp(kdtreeType_str, "BVH")==0);
+        _kdTreeBuilder->_structureType = useBVH ? osg::KdTreeBuilder::BOUNDING_VOLUME_HIERARCHY : osg::KdTreeBuilder::KDTREE;
+    }
+
     const char* ptr=0;
 
     _expiryDelay = 10.0;
@@ -482,12 +522,23 @@ Registry::Registry()
 Registry::~Registry()
 {
     destruct();
+
+    delete static_cast<ReaderWriterIndex*>(_rwIndex.get());
+    for(std::vector<ReaderWriterIndex*>::iterator itr = _retiredRWIndices.begin();
+        itr != _retiredRWIndices.end();
+        ++itr)
+    {
+        delete *itr;
+    }
 }
 
 void Registry::destruct()
 {
     // OSG_NOTICE<<"Registry::destruct()"<<std::endl;
 
+    // stop the AsyncReader threads before the plugins they may be using are unloaded
+    _asyncReader = 0;
+
     // clean up the SharedStateManager
     _sharedStateManager = 0;
 
@@ -614,6 +665,7 @@ void Registry::addReaderWriter(ReaderWriter* rw)
 
     _rwList.push_back(rw);
 
+    updateReaderWriterIndex();
 }
 
 
@@ -631,6 +683,52 @@ void Registry::removeReaderWriter(ReaderWriter* rw)
         _rwList.erase(rwitr);
     }
 
+    updateReaderWriterIndex();
+}
+
+void Registry::updateReaderWriterIndex()
+{
+    OpenThreads::ScopedLock<OpenThreads::ReentrantMutex> lock(_pluginMutex);
+
+    ReaderWriterIndex* index = new ReaderWriterIndex;
+    index->_readerWriters.reserve(_rwList.size());
+    for(ReaderWriterList::iterator itr=_rwList.begin();
+        itr!=_rwList.end();
+        ++itr)
+    {
+        index->_readerWriters.push_back(itr->get());
+    }
+
+    // map each extension to the first ReaderWriter in the list that accepts it, matching getReaderWriterForExtension()'s search order
+    for(ReaderWriterList::iterator itr=_rwList.begin();
+        itr!=_rwList.end();
+        ++itr)
+    {
+        ReaderWriter::FormatDescriptionMap extensions = (*itr)->supportedExtensions();
+        for(ReaderWriter::FormatDescriptionMap::iterator eitr = extensions.begin();
+            eitr != extensions.end();
+            ++eitr)
+        {
+            std::string ext = convertToLowerCase(eitr->first);
+            if (index->_extensionMap.count(ext)!=0) continue;
+
+            for(ReaderWriterList::iterator ritr=_rwList.begin();
+                ritr!=_rwList.end();
+                ++ritr)
+            {
+                if ((*ritr)->acceptsExtension(ext))
+                {
+                    index->_extensionMap[ext] = ritr->get();
+                    break;
+                }
+            }
+        }
+    }
+
+    // the previous index may still be in use by reads in other threads so retire it rather than deleting it.
+    ReaderWriterIndex* previous = static_cast<ReaderWriterIndex*>(_rwIndex.get());
+    _rwIndex.assign(index, previous);
+    _retiredRWIndices.push_back(previous);
 }
 
 ImageProcessor* Registry::getImageProcessor()
@@ -870,6 +968,11 @@ DynamicLibrary* Registry::getLibrary(const std::string& fileName)
 
 ReaderWriter* Registry::getReaderWriterForExtension(const std::string& ext)
 {
+    // check the index of the installed loaders first, avoiding the lock for the common case of an already loaded plugin.
+    const ReaderWriterIndex* index = getReaderWriterIndex();
+    ReaderWriterIndex::ExtensionMap::const_iterator eitr = index->_extensionMap.find(convertToLowerCase(ext));
+    if (eitr != index->_extensionMap.end()) return eitr->second;
+
     // record the existing reader writer.
     std::set<ReaderWriter*> rwOriginal;
 
@@ -1023,7 +1126,65 @@ void Registry::addArchiveExtension(const std::string ext)
     _archiveExtList.push_back(ext);
 }
 
+void Registry::setCacheFindDataFileResults(bool flag)
+{
+    _cacheFindDataFileResults = flag;
+    if (!flag) clearFindDataFileCache();
+}
+
+void Registry::clearFindDataFileCache()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_findDataFileCacheMutex);
+    _findDataFileCache.clear();
+    _findDataFileCachePaths.clear();
+}
+
 std::string Registry::findDataFileImplementation(const std::string& filename, const Options* options, CaseSensitivity caseSensitivity)
+{
+    if (!_cacheFindDataFileResults || filename.empty() || containsServerAddress(filename))
+    {
+        return findDataFileInPaths(filename, options, caseSensitivity);
+    }
+
+    // the search result depends on the filename, case sensitivity and both the Options' and Registry's path lists.
+    std::string key = filename;
+    key += (caseSensitivity==CASE_SENSITIVE) ? "\nS" : "\nI";
+    if (options)
+    {
+        const FilePathList& optionPaths = options->getDatabasePathList();
+        for(FilePathList::const_iterator itr = optionPaths.begin(); itr != optionPaths.end(); ++itr)
+        {
+            key += '\n';
+            key += *itr;
+        }
+    }
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_findDataFileCacheMutex);
+
+        // getDataFilePathList() allows the list to be modified in place so detect changes by comparing with the list the cache was built for.
+        if (_findDataFileCachePaths != _dataFilePath)
+        {
+            _findDataFileCache.clear();
+            _findDataFileCachePaths = _dataFilePath;
+        }
+
+        FindDataFileCache::iterator itr = _findDataFileCache.find(key);
+        if (itr != _findDataFileCache.end()) return itr->second;
+    }
+
+    std::string fileFound = findDataFileInPaths(filename, options, caseSensitivity);
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(_findDataFileCacheMutex);
+    if (_findDataFileCachePaths == _dataFilePath)
+    {
+        _findDataFileCache[key] = fileFound;
+    }
+
+    return fileFound;
+}
+
+std::string Registry::findDataFileInPaths(const std::string& filename, const Options* options, CaseSensitivity caseSensitivity)
 {
     if (filename.empty()) return filename;
 
@@ -1187,7 +1348,7 @@ ReaderWriter::ReadResult Registry::read(const ReadFunctor& readFunctor)
     Results results;
 
     // first attempt to load the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::ReadResult rr = readFunctor.doRead(*itr);
@@ -1343,7 +1504,7 @@ ReaderWriter::WriteResult Registry::writeObjectImplementation(const Object& obj,
     Results results;
 
     // first attempt to load the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::WriteResult rr = itr->writeObject(obj,fileName,options);
@@ -1389,7 +1550,7 @@ ReaderWriter::WriteResult Registry::writeImageImplementation(const Image& image,
     Results results;
 
     // first attempt to load the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::WriteResult rr = itr->writeImage(image,fileName,options);
@@ -1434,7 +1595,7 @@ ReaderWriter::WriteResult Registry::writeHeightFieldImplementation(const HeightF
     Results results;
 
     // first attempt to load the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::WriteResult rr = itr->writeHeightField(HeightField,fileName,options);
@@ -1491,7 +1652,7 @@ ReaderWriter::WriteResult Registry::writeNodeImplementation(const Node& node,con
     Results results;
 
     // first attempt to write the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::WriteResult rr = itr->writeNode(node,fileName,options);
@@ -1537,7 +1698,7 @@ ReaderWriter::WriteResult Registry::writeShaderImplementation(const Shader& shad
     Results results;
 
     // first attempt to load the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::WriteResult rr = itr->writeShader(shader,fileName,options);
@@ -1584,7 +1745,7 @@ ReaderWriter::WriteResult Registry::writeScriptImplementation(const Script& imag
     Results results;
 
     // first attempt to load the file from existing ReaderWriter's
-    AvailableReaderWriterIterator itr(_rwList, _pluginMutex);
+    AvailableReaderWriterIterator itr(*this);
     for(;itr.valid();++itr)
     {
         ReaderWriter::WriteResult rr = itr->writeScript(image,fileName,options);
@@ -1704,6 +1865,13 @@ SharedStateManager* Registry::getOrCreateSharedStateManager()
     return _sharedStateManager.get();
 }
 
+AsyncReader* Registry::getOrCreateAsyncReader()
+{
+    if (!_asyncReader) _asyncReader = new AsyncReader;
+
+    return _asyncReader.get();
+}
+
 
 void Registry::registerProtocol(const std::string& protocol)
 {
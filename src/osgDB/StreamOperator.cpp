@@ -14,8 +14,66 @@
 #include <osgDB/StreamOperator>
 #include <osgDB/InputStream>
 
+#include <osg/Types>
+
+#include <string.h>
+
 using namespace osgDB;
 
+static inline uint32_t swap32( uint32_t v )
+{
+    return ((v&0x000000ffu)<<24) | ((v&0x0000ff00u)<<8) | ((v&0x00ff0000u)>>8) | ((v&0xff000000u)>>24);
+}
+
+// Swap the byte order of a packed array of 2, 4 or 8 byte components.  The loops are kept free of
+// branches and calls so that the compiler can vectorize them.
+static void swapComponentBytes( char* s, unsigned int numComponents, unsigned int componentSizeInBytes )
+{
+    switch(componentSizeInBytes)
+    {
+        case 2:
+        {
+            for(unsigned int i=0; i<numComponents; ++i)
+            {
+                uint16_t v; memcpy(&v, s+i*2, 2);
+                v = (uint16_t)((v<<8) | (v>>8));
+                memcpy(s+i*2, &v, 2);
+            }
+            break;
+        }
+        case 4:
+        {
+            for(unsigned int i=0; i<numComponents; ++i)
+            {
+                uint32_t v; memcpy(&v, s+i*4, 4);
+                v = swap32(v);
+                memcpy(s+i*4, &v, 4);
+            }
+            break;
+        }
+        case 8:
+        {
+            for(unsigned int i=0; i<numComponents; ++i)
+            {
+                uint64_t v; memcpy(&v, s+i*8, 8);
+                v = ((uint64_t)swap32((uint32_t)v)<<32) | (uint64_t)swap32((uint32_t)(v>>32));
+                memcpy(s+i*8, &v, 8);
+            }
+            break;
+        }
+        default:
+        {
+            char* ptr = s;
+            for(unsigned int i=0; i<numComponents; ++i)
+            {
+                osg::swapBytes( ptr, componentSizeInBytes );
+                ptr += componentSizeInBytes;
+            }
+            break;
+        }
+    }
+}
+
 void InputIterator::checkStream() const
 {
     if (_in->rdstate()&_in->failbit)
@@ -35,15 +93,7 @@ void InputIterator::readComponentArray( char* s, unsigned int numElements, unsig
 
         if (_byteSwap && componentSizeInBytes>1)
         {
-            char* ptr = s;
-            for(unsigned int i=0; i<numElements; ++i)
-            {
-                for(unsigned int j=0; j<numComponentsPerElements; ++j)
-                {
-                    osg::swapBytes( ptr, componentSizeInBytes );
-                    ptr += componentSizeInBytes;
-                }
-            }
+            swapComponentBytes( s, numElements * numComponentsPerElements, componentSizeInBytes );
         }
     }
 }
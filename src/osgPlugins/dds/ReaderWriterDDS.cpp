@@ -31,6 +31,7 @@
 #include <osgDB/FileNameUtils>
 #include <osgDB/FileUtils>
 #include <osgDB/fstream>
+#include <osgDB/MappedFile>
 #include <iomanip>
 #include <stdio.h>
 #include <string.h>
@@ -412,7 +413,7 @@ static unsigned int ComputeImageSizeInBytes( int width, int height, int depth,
     return osg::Image::computeImageSizeInBytes(width, height, depth, pixelFormat, pixelType, packing, slice_packing, image_packing);
 }
 
-osg::Image* ReadDDSFile(std::istream& _istream, bool flipDDSRead)
+osg::Image* ReadDDSFile(std::istream& _istream, bool flipDDSRead, osgDB::MappedFile* mappedFile = 0)
 {
     DDSURFACEDESC2 ddsd;
 
@@ -1005,52 +1006,69 @@ osg::Image* ReadDDSFile(std::istream& _istream, bool flipDDSRead)
         }
     }
 
-    unsigned char* imageData = new unsigned char [sizeWithMipmaps];
-    if(!imageData)
+    // when the file is memory mapped point the image directly at its pixel data rather than copying it,
+    // palette indexed images still need converting so always go through the copy.
+    bool usingMappedData = false;
+    if (mappedFile && !(ddsd.ddpfPixelFormat.dwFlags & DDPF_PALETTEINDEXED8))
     {
-        OSG_WARN << "ReadDDSFile warning: imageData == NULL" << std::endl;
-        return NULL;
+        std::streamoff offset = _istream.tellg();
+        if (offset>=0 && static_cast<size_t>(offset)+sizeWithMipmaps<=mappedFile->getSize())
+        {
+            osgImage->setImage(s,t,r, internalFormat, pixelFormat, dataType, mappedFile->getData()+offset, osg::Image::NO_DELETE, packing);
+            osgImage->setDataOwner(mappedFile);
+            usingMappedData = true;
+        }
     }
 
-    // Read pixels in two chunks. First main image, next mipmaps.
-    if ( !_istream.read( (char*)imageData, size ) )
+    if (!usingMappedData)
     {
-        delete [] imageData;
-        OSG_WARN << "ReadDDSFile warning: couldn't read imageData" << std::endl;
-        return NULL;
-    }
+        unsigned char* imageData = new unsigned char [sizeWithMipmaps];
+        if(!imageData)
+        {
+            OSG_WARN << "ReadDDSFile warning: imageData == NULL" << std::endl;
+            return NULL;
+        }
 
-    // If loading mipmaps in second chunk fails we may still use main image
-    if ( size < sizeWithMipmaps && !_istream.read( (char*)imageData + size, sizeWithMipmaps - size ) )
-    {
-        sizeWithMipmaps = size;
-        mipmap_offsets.resize( 0 );
-        OSG_WARN << "ReadDDSFile warning: couldn't read mipmapData" << std::endl;
+        // Read pixels in two chunks. First main image, next mipmaps.
+        if ( !_istream.read( (char*)imageData, size ) )
+        {
+            delete [] imageData;
+            OSG_WARN << "ReadDDSFile warning: couldn't read imageData" << std::endl;
+            return NULL;
+        }
 
-        // if mipmaps read failed we leave some not used overhead memory allocated past main image
-        // this memory will not be used but it will not cause leak in worst meaning of this word.
-    }
+        // If loading mipmaps in second chunk fails we may still use main image
+        if ( size < sizeWithMipmaps && !_istream.read( (char*)imageData + size, sizeWithMipmaps - size ) )
+        {
+            sizeWithMipmaps = size;
+            mipmap_offsets.resize( 0 );
+            OSG_WARN << "ReadDDSFile warning: couldn't read mipmapData" << std::endl;
 
-    if (ddsd.ddpfPixelFormat.dwFlags & DDPF_PALETTEINDEXED8)
-    {
-        // Now we need to substitute the indexed image data with full RGBA image data.
-        unsigned char * convertedData = new unsigned char [sizeWithMipmaps * 4];
-        unsigned char * pconvertedData = convertedData;
-        for (unsigned int i = 0; i < sizeWithMipmaps; i++)
+            // if mipmaps read failed we leave some not used overhead memory allocated past main image
+            // this memory will not be used but it will not cause leak in worst meaning of this word.
+        }
+
+        if (ddsd.ddpfPixelFormat.dwFlags & DDPF_PALETTEINDEXED8)
         {
-            memcpy(pconvertedData, &palette[ imageData[i] * 4], sizeof(unsigned char) * 4 );
-            pconvertedData += 4;
+            // Now we need to substitute the indexed image data with full RGBA image data.
+            unsigned char * convertedData = new unsigned char [sizeWithMipmaps * 4];
+            unsigned char * pconvertedData = convertedData;
+            for (unsigned int i = 0; i < sizeWithMipmaps; i++)
+            {
+                memcpy(pconvertedData, &palette[ imageData[i] * 4], sizeof(unsigned char) * 4 );
+                pconvertedData += 4;
+            }
+            delete [] imageData;
+            for (unsigned int i = 0; i < mipmap_offsets.size(); i++)
+                mipmap_offsets[i] *= 4;
+            internalFormat = GL_RGBA;
+            pixelFormat = GL_RGBA;
+            osgImage->setImage(s,t,r, internalFormat, pixelFormat, dataType, convertedData, osg::Image::USE_NEW_DELETE, packing);
+        }
+        else
+        {
+            osgImage->setImage(s,t,r, internalFormat, pixelFormat, dataType, imageData, osg::Image::USE_NEW_DELETE, packing);
         }
-        delete [] imageData;
-        for (unsigned int i = 0; i < mipmap_offsets.size(); i++)
-            mipmap_offsets[i] *= 4;
-        internalFormat = GL_RGBA;
-        pixelFormat = GL_RGBA;
-        osgImage->setImage(s,t,r, internalFormat, pixelFormat, dataType, convertedData, osg::Image::USE_NEW_DELETE, packing);
-    }
-    else
-    {
-        osgImage->setImage(s,t,r, internalFormat, pixelFormat, dataType, imageData, osg::Image::USE_NEW_DELETE, packing);
     }
 
     if (mipmap_offsets.size()>0) osgImage->setMipmapLevels(mipmap_offsets);
@@ -1363,6 +1381,7 @@ public:
         supportsOption("dds_dxt1_rgba","Set the pixel format of DXT1 encoded images to be RGBA variant of DXT1");
         supportsOption("dds_dxt1_detect_rgba","For DXT1 encode images set the pixel format according to presence of transparent pixels");
         supportsOption("dds_flip","Flip the image about the horizontal axis");
+        supportsOption("noMemoryMap","Read files through a stream into a new buffer rather than memory mapping them.");
         supportsOption("ddsNoAutoFlipWrite", "(Write option) Avoid automatically flipping the image vertically when writing, depending on the origin (Image::getOrigin()).");
     }
 
@@ -1392,12 +1411,25 @@ public:
 
         osgDB::ifstream stream(fileName.c_str(), std::ios::in | std::ios::binary);
         if(!stream) return ReadResult::FILE_NOT_HANDLED;
-        ReadResult rr = readImage(stream, options);
+
+        // the header is still parsed from the stream, only the pixel data comes from the mapping.
+        osg::ref_ptr<osgDB::MappedFile> mappedFile;
+        if (!options || options->getOptionString().find("noMemoryMap")==std::string::npos)
+        {
+            mappedFile = osgDB::MappedFile::open(fileName);
+        }
+
+        ReadResult rr = readDDSImage(stream, options, mappedFile.get());
         if(rr.validImage()) rr.getImage()->setFileName(file);
         return rr;
     }
 
     virtual ReadResult readImage(std::istream& fin, const Options* options) const
+    {
+        return readDDSImage(fin, options, 0);
+    }
+
+    ReadResult readDDSImage(std::istream& fin, const Options* options, osgDB::MappedFile* mappedFile) const
     {
         bool dds_flip(false);
         bool dds_dxt1_rgba(false);
@@ -1415,7 +1447,7 @@ public:
                 if (opt == "dds_dxt1_detect_rgba") dds_dxt1_detect_rgba = true;
             }
         }
-        osg::Image* osgImage = ReadDDSFile(fin, dds_flip);
+        osg::Image* osgImage = ReadDDSFile(fin, dds_flip, mappedFile);
         if (osgImage==NULL) return ReadResult::FILE_NOT_HANDLED;
 
         if (osgImage->getPixelFormat()==GL_COMPRESSED_RGB_S3TC_DXT1_EXT ||
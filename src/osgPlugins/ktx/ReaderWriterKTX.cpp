@@ -42,6 +42,7 @@ const unsigned char ReaderWriterKTX::FileSignature[12] = {
 ReaderWriterKTX::ReaderWriterKTX()
 {
     supportsExtension("ktx", "KTX image format");
+    supportsOption("noMemoryMap", "Read files through a stream into a new buffer rather than memory mapping them.");
 }
 
 const char* ReaderWriterKTX::className() const { return "KTX Image Reader/Writer"; }
@@ -61,7 +62,7 @@ bool ReaderWriterKTX::correctByteOrder(KTXTexHeader& header) const
     return true;
 }
 
-osgDB::ReaderWriter::ReadResult ReaderWriterKTX::readKTXStream(std::istream& fin) const
+osgDB::ReaderWriter::ReadResult ReaderWriterKTX::readKTXStream(std::istream& fin, osgDB::MappedFile* mappedFile) const
 {
     KTXTexHeader header;
     fin.seekg(0, std::ios::end);
@@ -119,6 +120,59 @@ osgDB::ReaderWriter::ReadResult ReaderWriterKTX::readKTXStream(std::istream& fin
     fin.ignore(header.bytesOfKeyValueData);
 
     uint32_t imageSize;
+    bool byteswapImageData = (header.glTypeSize > 1) && (header.endianness != MyEndian);
+
+    // the image data can be used in place from a memory mapped file, with the offsets of any mipmap levels
+    // measured from the first level's data so that they skip the size stored in front of each level.
+    if (mappedFile && !byteswapImageData)
+    {
+        std::streamoff offset = fin.tellg();
+        std::streamoff dataStart = offset + static_cast<std::streamoff>(sizeof(imageSize));
+        osg::Image::MipmapDataType mappedMipmapData;
+        bool valid = offset >= 0;
+
+        for(uint32_t mipmapLevel = 0; valid && mipmapLevel < header.numberOfMipmapLevels; mipmapLevel++)
+        {
+            if (static_cast<size_t>(offset) + sizeof(imageSize) > mappedFile->getSize())
+            {
+                valid = false;
+                break;
+            }
+
+            memcpy(&imageSize, mappedFile->getData() + offset, sizeof(imageSize));
+            if (header.endianness != MyEndian)
+                osg::swapBytes4(reinterpret_cast<char*>(&imageSize));
+
+            offset += sizeof(imageSize);
+            if (static_cast<size_t>(offset) + imageSize > mappedFile->getSize())
+            {
+                valid = false;
+                break;
+            }
+
+            if (mipmapLevel > 0)
+                mappedMipmapData.push_back(static_cast<unsigned int>(offset - dataStart));
+
+            offset += imageSize;
+            if (mipmapLevel < (header.numberOfMipmapLevels - 1))
+                offset += 3 - (imageSize + 3) % 4;
+        }
+
+        if (valid)
+        {
+            osg::ref_ptr<osg::Image> image = new osg::Image;
+            image->setImage(header.pixelWidth, header.pixelHeight, header.pixelDepth,
+                header.glInternalFormat, header.glFormat,
+                header.glType, mappedFile->getData() + dataStart, osg::Image::NO_DELETE);
+            image->setDataOwner(mappedFile);
+
+            if (header.numberOfMipmapLevels > 1)
+                image->setMipmapLevels(mappedMipmapData);
+
+            return image.get();
+        }
+    }
+
     uint32_t totalImageSize = fileLength -
             (sizeof(KTXTexHeader) + header.bytesOfKeyValueData +
                     (sizeof(imageSize) * header.numberOfMipmapLevels));
@@ -128,7 +182,6 @@ osgDB::ReaderWriter::ReadResult ReaderWriterKTX::readKTXStream(std::istream& fin
         return ReadResult::INSUFFICIENT_MEMORY_TO_LOAD;
 
     char* imageData = (char*)totalImageData;
-    bool byteswapImageData = (header.glTypeSize > 1) && (header.endianness != MyEndian);
 
     uint32_t totalOffset = 0;
     osg::Image::MipmapDataType mipmapData;
@@ -294,7 +347,12 @@ osgDB::ReaderWriter::ReadResult ReaderWriterKTX::readImage(const std::string& fi
     if(!istream)
         return ReadResult::ERROR_IN_READING_FILE;
 
-    ReadResult rr = readKTXStream(istream);
+    // the header is still parsed from the stream, only the pixel data comes from the mapping.
+    osg::ref_ptr<osgDB::MappedFile> mappedFile;
+    if (!options || options->getOptionString().find("noMemoryMap") == std::string::npos)
+        mappedFile = osgDB::MappedFile::open(fileName);
+
+    ReadResult rr = readKTXStream(istream, mappedFile.get());
     if(rr.validImage())
         rr.getImage()->setFileName(file);
 
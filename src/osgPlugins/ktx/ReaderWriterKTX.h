@@ -12,6 +12,7 @@
 */
 
 #include <osgDB/ReaderWriter>
+#include <osgDB/MappedFile>
 #include <osg/Types>
 
 struct KTXTexHeader
@@ -62,7 +63,7 @@ public:
     virtual WriteResult writeImage(const osg::Image &image, const std::string& file, const osgDB::ReaderWriter::Options* options) const;
     virtual WriteResult writeImage(const osg::Image& image, std::ostream& fout, const Options* options) const;
 
-    ReadResult readKTXStream(std::istream& fin) const;
+    ReadResult readKTXStream(std::istream& fin, osgDB::MappedFile* mappedFile = 0) const;
     bool writeKTXStream(const osg::Image *img, std::ostream& fout) const;
 private:
     bool correctByteOrder(KTXTexHeader& header) const;
@@ -14,9 +14,11 @@
 
 #include <osgDB/FileNameUtils>
 #include <osgDB/FileUtils>
+#include <osgDB/MappedFile>
 #include <osgDB/Registry>
 #include <osgDB/ObjectWrapper>
 #include <stdlib.h>
+#include <vector>
 #include "AsciiStreamOperator.h"
 #include "BinaryStreamOperator.h"
 #include "XmlStreamOperator.h"
@@ -115,6 +117,31 @@ OutputIterator* writeOutputIterator( std::ostream& fout, const Options* options
     }
 }
 
+// Binary files are loaded into memory in one go before parsing when PreloadFile is set, so that the binary
+// reader pulls its data from a contiguous buffer rather than through many small reads of the file.
+static bool preloadFile( const std::string& fileName, const Options* options, std::vector<char>& buffer )
+{
+    if ( !options || options->getPluginStringData("fileType")!="Binary" ) return false;
+    if ( options->getPluginStringData("PreloadFile")!="true" ) return false;
+
+    osgDB::ifstream fin( fileName.c_str(), std::ios::in|std::ios::binary );
+    if ( !fin ) return false;
+
+    fin.seekg( 0, std::ios::end );
+    std::streamoff length = fin.tellg();
+    fin.seekg( 0, std::ios::beg );
+    if ( length<=0 ) return false;
+
+    buffer.resize( static_cast<size_t>(length) );
+    fin.read( &buffer.front(), length );
+    if ( fin.gcount()!=length )
+    {
+        buffer.clear();
+        return false;
+    }
+    return true;
+}
+
 class ReaderWriterOSG2 : public osgDB::ReaderWriter
 {
 public:
@@ -128,9 +155,11 @@ public:
         supportsOption( "Ascii", "Import/Export option: Force reading/writing ascii file" );
         supportsOption( "XML", "Import/Export option: Force reading/writing XML file" );
         supportsOption( "ForceReadingImage", "Import option: Load an empty image instead if required file missed" );
+        supportsOption( "PreloadFile=<true/false>", "Import option: Load a whole binary file into memory before parsing it, false by default" );
         supportsOption( "SchemaData", "Export option: Record inbuilt schema data into a binary file" );
         supportsOption( "SchemaFile=<file>", "Import/Export option: Use/Record an ascii schema file" );
         supportsOption( "Compressor=<name>", "Export option: Use an inbuilt or user-defined compressor" );
+        supportsOption( "DeduplicateContent", "Export option: Write arrays, images and StateSets with identical contents only once" );
         supportsOption( "WriteImageHint=<hint>", "Export option: Hint of writing image to stream: "
                         "<IncludeData> writes Image::data() directly; "
                         "<IncludeFile> writes the image file itself to stream; "
@@ -182,6 +211,14 @@ public:
         Options* local_opt = prepareReading( result, fileName, mode, options );
         if ( !result.success() ) return result;
 
+        std::vector<char> buffer;
+        if ( preloadFile(fileName, local_opt, buffer) )
+        {
+            osgDB::MemoryStreamBuf sb( &buffer.front(), buffer.size() );
+            std::istream istream( &sb );
+            return readObject( istream, local_opt );
+        }
+
         osgDB::ifstream istream( fileName.c_str(), mode );
         return readObject( istream, local_opt );
     }
@@ -213,6 +250,14 @@ public:
         Options* local_opt = prepareReading( result, fileName, mode, options );
         if ( !result.success() ) return result;
 
+        std::vector<char> buffer;
+        if ( preloadFile(fileName, local_opt, buffer) )
+        {
+            osgDB::MemoryStreamBuf sb( &buffer.front(), buffer.size() );
+            std::istream istream( &sb );
+            return readImage( istream, local_opt );
+        }
+
         osgDB::ifstream istream( fileName.c_str(), mode );
         return readImage( istream, local_opt );
     }
@@ -244,6 +289,14 @@ public:
         Options* local_opt = prepareReading( result, fileName, mode, options );
         if ( !result.success() ) return result;
 
+        std::vector<char> buffer;
+        if ( preloadFile(fileName, local_opt, buffer) )
+        {
+            osgDB::MemoryStreamBuf sb( &buffer.front(), buffer.size() );
+            std::istream istream( &sb );
+            return readNode( istream, local_opt );
+        }
+
         osgDB::ifstream istream( fileName.c_str(), mode );
         return readNode( istream, local_opt );
     }
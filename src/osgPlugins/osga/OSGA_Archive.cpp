@@ -320,7 +320,8 @@ void OSGA_Archive::IndexBlock::setPositionNextIndexBlock(pos_type position)
 
 OSGA_Archive::OSGA_Archive():
     _version(0.0f),
-    _status(READ)
+    _status(READ),
+    _useMemoryMap(true)
 {
 }
 
@@ -341,7 +342,15 @@ bool OSGA_Archive::open(const std::string& filename, ArchiveStatus status, unsig
         _status = status;
         _input.open(filename.c_str(), std::ios_base::binary | std::ios_base::in);
 
-        return _open(_input);
+        if (!_open(_input)) return false;
+
+        // the index has been read via the stream, the files themselves are read from the mapping when available.
+        if (_useMemoryMap && !mapArchive(filename))
+        {
+            OSG_INFO<<"OSGA_Archive::open("<<filename<<") unable to memory map archive, reads will be serialized."<<std::endl;
+        }
+
+        return true;
     }
     else
     {
@@ -375,6 +384,7 @@ bool OSGA_Archive::open(const std::string& filename, ArchiveStatus status, unsig
                 }
             }
             _input.close();
+            unmapArchive();
             _status = WRITE;
 
             osgDB::open(_output, filename.c_str(), std::ios_base::binary | std::ios_base::in | std::ios_base::out);
@@ -493,6 +503,7 @@ void OSGA_Archive::close()
 {
     SERIALIZER();
 
+    unmapArchive();
     _input.close();
 
     if (_status==WRITE)
@@ -502,6 +513,25 @@ void OSGA_Archive::close()
     }
 }
 
+bool OSGA_Archive::mapArchive(const std::string& filename)
+{
+    unmapArchive();
+
+    // the whole archive has to fit in the address space, which large archives won't on 32 bit builds.
+    _mappedFile = MappedFile::open(filename);
+    if (!_mappedFile) return false;
+
+    OSG_INFO<<"OSGA_Archive::mapArchive("<<filename<<") mapped "<<_mappedFile->getSize()<<" bytes"<<std::endl;
+
+    return true;
+}
+
+void OSGA_Archive::unmapArchive()
+{
+    // reads still in progress keep their own reference, so the mapping is only released once they complete.
+    _mappedFile = 0;
+}
+
 std::string OSGA_Archive::getMasterFileName() const
 {
     return _masterFileName;
@@ -726,6 +756,9 @@ struct OSGA_Archive::ReadShaderFunctor : public OSGA_Archive::ReadFunctor
 
 ReaderWriter::ReadResult OSGA_Archive::read(const ReadFunctor& readFunctor)
 {
+    // mapped reads only serialize the index lookup, the parsing itself runs concurrently.
+    if (isMemoryMapped()) return readMapped(readFunctor);
+
     SERIALIZER();
 
     if (_status!=READ)
@@ -764,6 +797,52 @@ ReaderWriter::ReadResult OSGA_Archive::read(const ReadFunctor& readFunctor)
     return result;
 }
 
+ReaderWriter::ReadResult OSGA_Archive::readMapped(const ReadFunctor& readFunctor)
+{
+    osg::ref_ptr<MappedFile> mappedFile;
+    pos_type position = 0;
+    size_type size = 0;
+    {
+        SERIALIZER();
+
+        // the archive may have been closed or reopened since the caller checked.
+        if (!_mappedFile) return read(readFunctor);
+
+        FileNamePositionMap::const_iterator itr = _indexMap.find(readFunctor._filename);
+        if (itr==_indexMap.end())
+        {
+            OSG_INFO<<"OSGA_Archive::readObject(obj, "<<readFunctor._filename<<") failed, file not found in archive"<<std::endl;
+            return ReadResult(ReadResult::FILE_NOT_FOUND);
+        }
+
+        // hold on to the mapping so that a concurrent close() can't unmap it while it is being read from.
+        mappedFile = _mappedFile;
+        position = itr->second.first;
+        size = itr->second.second;
+    }
+
+    if (position<0 || size<0 || static_cast<unsigned long long>(position+size)>static_cast<unsigned long long>(mappedFile->getSize()))
+    {
+        OSG_INFO<<"OSGA_Archive::readObject(obj, "<<readFunctor._filename<<") failed, file extends beyond end of archive"<<std::endl;
+        return ReadResult(ReadResult::ERROR_IN_READING_FILE);
+    }
+
+    ReaderWriter* rw = osgDB::Registry::instance()->getReaderWriterForExtension(getLowerCaseFileExtension(readFunctor._filename));
+    if (!rw)
+    {
+        OSG_INFO<<"OSGA_Archive::readObject(obj, "<<readFunctor._filename<<") failed to find appropriate plugin to read file."<<std::endl;
+        return ReadResult(ReadResult::FILE_NOT_HANDLED);
+    }
+
+    OSG_INFO<<"OSGA_Archive::readObject(obj, "<<readFunctor._filename<<") from memory map"<<std::endl;
+
+    // each read gets its own stream over the mapped file, so concurrent reads don't interfere.
+    MemoryStreamBuf mystreambuf(reinterpret_cast<const char*>(mappedFile->getData())+position, size);
+    std::istream ins(&mystreambuf);
+
+    return readFunctor.doRead(*rw, ins);
+}
+
 ReaderWriter::ReadResult OSGA_Archive::readObject(const std::string& fileName,const Options* options) const
 {
     return const_cast<OSGA_Archive*>(this)->read(ReadObjectFunctor(fileName, options));
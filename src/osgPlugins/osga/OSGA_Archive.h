@@ -14,6 +14,7 @@
 #include <osg/Notify>
 #include <osgDB/Archive>
 #include <osgDB/FileNameUtils>
+#include <osgDB/MappedFile>
 
 #include <OpenThreads/ScopedLock>
 #include <OpenThreads/ReentrantMutex>
@@ -41,6 +42,15 @@ class OSGA_Archive : public osgDB::Archive
         /** open the archive for reading.*/
         virtual bool open(std::istream& fin);
 
+        /** Set whether an archive opened for reading from file is memory mapped, so that concurrent reads are served
+          * from their own stream over the mapping rather than taking turns on the shared input stream.
+          * Must be set before the archive is opened, defaults to true.*/
+        void setUseMemoryMap(bool flag) { _useMemoryMap = flag; }
+        bool getUseMemoryMap() const { return _useMemoryMap; }
+
+        /** return true if the archive is open for reading and memory mapped.*/
+        bool isMemoryMapped() const { return _mappedFile.valid(); }
+
         /** close the archive.*/
         virtual void close();
 
@@ -203,6 +213,7 @@ class OSGA_Archive : public osgDB::Archive
 
 
         osgDB::ReaderWriter::ReadResult read(const ReadFunctor& readFunctor);
+        osgDB::ReaderWriter::ReadResult readMapped(const ReadFunctor& readFunctor);
         osgDB::ReaderWriter::WriteResult write(const WriteFunctor& writeFunctor);
 
         typedef std::list< osg::ref_ptr<IndexBlock> >   IndexBlockList;
@@ -213,6 +224,9 @@ class OSGA_Archive : public osgDB::Archive
 
         bool addFileReference(pos_type position, size_type size, const std::string& fileName);
 
+        bool mapArchive(const std::string& filename);
+        void unmapArchive();
+
         static float        s_currentSupportedVersion;
         float               _version;
         ArchiveStatus       _status;
@@ -224,6 +238,9 @@ class OSGA_Archive : public osgDB::Archive
         IndexBlockList      _indexBlockList;
         FileNamePositionMap _indexMap;
 
+        bool                _useMemoryMap;
+        osg::ref_ptr<osgDB::MappedFile> _mappedFile;
+
 
         template <typename T>
         static inline void _write(char* ptr, const T& value)
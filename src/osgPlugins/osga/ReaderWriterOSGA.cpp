@@ -12,6 +12,7 @@ public:
     ReaderWriterOSGA()
     {
         supportsExtension("osga","OpenSceneGraph Archive format");
+        supportsOption("noMemoryMap","Read files from the archive through a single shared stream rather than memory mapping the archive.");
     }
 
     virtual const char* className() const { return "OpenSceneGraph Archive Reader/Writer"; }
@@ -30,6 +31,11 @@ public:
         }
 
         osg::ref_ptr<OSGA_Archive> archive = new OSGA_Archive;
+        if (options && options->getOptionString().find("noMemoryMap")!=std::string::npos)
+        {
+            archive->setUseMemoryMap(false);
+        }
+
         if (!archive->open(fileName, status, indexBlockSize))
         {
             return ReadResult(ReadResult::FILE_NOT_HANDLED);
@@ -61,7 +67,7 @@ public:
 
     virtual ReadResult readMasterFile(ReadType type, const std::string& file, const Options* options) const
     {
-        ReadResult result = openArchive(file, osgDB::Archive::READ);
+        ReadResult result = openArchive(file, osgDB::Archive::READ, 4096, options);
 
         if (!result.validArchive()) return result;
 
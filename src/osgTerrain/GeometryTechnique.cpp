@@ -1266,13 +1266,15 @@ void GeometryTechnique::generateGeometry(BufferData& buffer, Locator* masterLoca
     }
 #endif
 
-    if (osgDB::Registry::instance()->getBuildKdTreesHint()==osgDB::ReaderWriter::Options::BUILD_KDTREES &&
+    osgDB::ReaderWriter::Options::BuildKdTreesHint kdTreesHint = osgDB::Registry::instance()->getBuildKdTreesHint();
+    if ((kdTreesHint==osgDB::ReaderWriter::Options::BUILD_KDTREES || kdTreesHint==osgDB::ReaderWriter::Options::BUILD_KDTREES_ON_DEMAND) &&
         osgDB::Registry::instance()->getKdTreeBuilder())
     {
 
         //osg::Timer_t before = osg::Timer::instance()->tick();
         //OSG_NOTICE<<"osgTerrain::GeometryTechnique::build kd tree"<<std::endl;
         osg::ref_ptr<osg::KdTreeBuilder> builder = osgDB::Registry::instance()->getKdTreeBuilder()->clone();
+        if (kdTreesHint==osgDB::ReaderWriter::Options::BUILD_KDTREES_ON_DEMAND) builder->_buildOnDemand = true;
         buffer._geode->accept(*builder);
         //osg::Timer_t after = osg::Timer::instance()->tick();
         //OSG_NOTICE<<"KdTree build time "<<osg::Timer::instance()->delta_m(before, after)<<std::endl;
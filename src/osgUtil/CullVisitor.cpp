@@ -27,11 +27,17 @@
 #include <osg/TemplatePrimitiveFunctor>
 #include <osg/Geometry>
 #include <osg/io_utils>
+#include <osg/ApplicationUsage>
+#include <osg/OperationThread>
 
 #include <osgUtil/CullVisitor>
 
 #include <float.h>
+#include <stdlib.h>
+#include <string.h>
 #include <algorithm>
+#include <new>
+#include <typeinfo>
 
 #include <osg/Timer>
 
@@ -43,6 +49,45 @@ inline float MAX_F(float a, float b)
 inline int EQUAL_F(float a, float b)
     { return a == b || fabsf(a-b) <= MAX_F(fabsf(a),fabsf(b))*1e-3f; }
 
+static osg::ApplicationUsageProxy CullVisitor_e0(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_PARALLEL_CAMERA_CULLING <mode>","ON | OFF - cull PRE_RENDER and POST_RENDER Cameras in parallel on a shared thread pool.");
+
+static bool getDefaultParallelCameraCulling()
+{
+    static bool s_parallelCameraCulling = false;
+    static bool s_parallelCameraCullingInitialized = false;
+    if (!s_parallelCameraCullingInitialized)
+    {
+        s_parallelCameraCullingInitialized = true;
+
+        const char* str = getenv("OSG_PARALLEL_CAMERA_CULLING");
+        if (str)
+        {
+            if (strcmp(str,"ON")==0) s_parallelCameraCulling = true;
+            else if (strcmp(str,"OFF")==0) s_parallelCameraCulling = false;
+        }
+    }
+    return s_parallelCameraCulling;
+}
+
+/** Culls the subgraph of a Camera with the CullVisitor set up for it by CullVisitor::startParallelCameraCull(),
+  * unless the cull thread has already claimed it, in which case the operation does nothing.*/
+struct CullVisitor::ParallelCameraCullOperation : public osg::Operation
+{
+    ParallelCameraCullOperation(CullVisitor* cv):
+        osg::Operation("ParallelCameraCull", false),
+        _cv(cv) {}
+
+    virtual void operator () (osg::Object*)
+    {
+        if (_cv->_parallelCameraCullClaimed.exchange(1)!=0) return;
+
+        _cv->cullParallelCamera(*(_cv->_parallelCameraCullCamera));
+        _cv->_parallelCameraCullBlock->release();
+    }
+
+    osg::ref_ptr<CullVisitor>   _cv;
+};
+
 
 CullVisitor::CullVisitor():
     osg::NodeVisitor(CULL_VISITOR,TRAVERSE_ACTIVE_CHILDREN),
@@ -51,7 +96,13 @@ CullVisitor::CullVisitor():
     _computed_znear(FLT_MAX),
     _computed_zfar(-FLT_MAX),
     _traversalOrderNumber(0),
-    _currentReuseRenderLeafIndex(0),
+    _renderLeafPool(new RenderLeafPool),
+    _numRenderLeavesAllocated(0),
+    _numStateGraphsAllocated(0),
+    _batchCullingMinimumNumChildren(16),
+    _parallelCameraCulling(getDefaultParallelCameraCulling()),
+    _numParallelCameraCulls(0),
+    _parallelCameraCullTime(0.0),
     _numberOfEncloseOverrideRenderBinDetails(0)
 {
     _identifier = new Identifier;
@@ -66,7 +117,13 @@ CullVisitor::CullVisitor(const CullVisitor& rhs):
     _computed_znear(FLT_MAX),
     _computed_zfar(-FLT_MAX),
     _traversalOrderNumber(0),
-    _currentReuseRenderLeafIndex(0),
+    _renderLeafPool(new RenderLeafPool),
+    _numRenderLeavesAllocated(0),
+    _numStateGraphsAllocated(0),
+    _batchCullingMinimumNumChildren(rhs._batchCullingMinimumNumChildren),
+    _parallelCameraCulling(rhs._parallelCameraCulling),
+    _numParallelCameraCulls(0),
+    _parallelCameraCullTime(0.0),
     _numberOfEncloseOverrideRenderBinDetails(0),
     _identifier(rhs._identifier)
 {
@@ -93,6 +150,10 @@ CullVisitor* CullVisitor::create()
 
 void CullVisitor::reset()
 {
+    // make sure no Camera is still being culled into a RenderStage from the last traversal.
+    completeParallelCameraCulls();
+    _parallelCameraCullTimes.clear();
+
     //
     // first unref all referenced objects and then empty the containers.
     //
@@ -120,16 +181,10 @@ void CullVisitor::reset()
     _bbCornerNear = (~_bbCornerFar)&7;
 
     // Only reset the RenderLeaf objects used last frame.
-    for(RenderLeafList::iterator itr=_reuseRenderLeafList.begin(),
-        iter_end=_reuseRenderLeafList.begin()+_currentReuseRenderLeafIndex;
-        itr!=iter_end;
-        ++itr)
-    {
-        (*itr)->reset();
-    }
+    _renderLeafPool->reset();
 
-    // reset the resuse lists.
-    _currentReuseRenderLeafIndex = 0;
+    _numRenderLeavesAllocated = 0;
+    _numStateGraphsAllocated = 0;
 
     _nearPlaneCandidateMap.clear();
     _farPlaneCandidateMap.clear();
@@ -1145,7 +1200,19 @@ void CullVisitor::apply(Group& node)
     StateSet* node_state = node.getStateSet();
     if (node_state) pushStateSet(node_state);
 
-    handle_cull_callbacks_and_traverse(node);
+    // plain Groups with many children have their children frustum culled as a batch,
+    // subclasses are left to their own traverse() implementations.
+    if (_batchCullingMinimumNumChildren>0 &&
+        node.getNumChildren()>=_batchCullingMinimumNumChildren &&
+        !node.getCullCallback() &&
+        typeid(node)==typeid(osg::Group))
+    {
+        traverseBatchCulled(node);
+    }
+    else
+    {
+        handle_cull_callbacks_and_traverse(node);
+    }
 
     // pop the node's state off the render graph stack.
     if (node_state) popStateSet();
@@ -1154,6 +1221,61 @@ void CullVisitor::apply(Group& node)
     popCurrentMask();
 }
 
+/** Return true if the node is an osg::Group rather than a subclass, going by the class it reports so that
+  * subclasses which dispatch to their own apply() aren't mistaken for one.*/
+static inline bool isPlainGroup(const osg::Node& node)
+{
+    return node.asGroup() && strcmp(node.className(), "Group")==0 && strcmp(node.libraryName(), "osg")==0;
+}
+
+void CullVisitor::traverseBatchCulled(osg::Group& group)
+{
+    unsigned int numChildren = group.getNumChildren();
+
+    _batchCullCenterX.resize(numChildren);
+    _batchCullCenterY.resize(numChildren);
+    _batchCullCenterZ.resize(numChildren);
+    _batchCullRadius.resize(numChildren);
+
+    // results are kept on a stack as nested Groups are culled while traversing this one's children.
+    unsigned int base = static_cast<unsigned int>(_batchCullResults.size());
+    _batchCullResults.resize(base+numChildren);
+
+    for(unsigned int i=0; i<numChildren; ++i)
+    {
+        const osg::BoundingSphere& bs = group.getChild(i)->getBound();
+        _batchCullCenterX[i] = bs.center().x();
+        _batchCullCenterY[i] = bs.center().y();
+        _batchCullCenterZ[i] = bs.center().z();
+        _batchCullRadius[i] = bs.radius();
+    }
+
+    getCurrentCullingSet().frustumContains(&_batchCullCenterX.front(), &_batchCullCenterY.front(), &_batchCullCenterZ.front(),
+                                           &_batchCullRadius.front(), numChildren, &_batchCullResults[base]);
+
+    for(unsigned int i=0; i<numChildren; ++i)
+    {
+        osg::Node* child = group.getChild(i);
+
+        // only skip children whose apply() would have culled them against the same bounding sphere before
+        // doing anything else, nodes such as Camera, LightSource and ClipNode are always visited, as are
+        // Drawables with a cull callback since apply() runs it before culling.
+        if (!_batchCullResults[base+i] &&
+            child->isCullingActive() &&
+            (child->asGeode() ||
+             (child->asDrawable() && !child->getCullCallback()) ||
+             isPlainGroup(*child) ||
+             (child->asTransform() && !child->asCamera())))
+        {
+            continue;
+        }
+
+        child->accept(*this);
+    }
+
+    _batchCullResults.resize(base);
+}
+
 void CullVisitor::apply(Transform& node)
 {
     if (isCulled(node)) return;
@@ -1504,6 +1626,9 @@ void CullVisitor::apply(osg::Camera& camera)
             camera.setRenderingCache(rsCache.get());
         }
 
+        // subclasses would be sliced by clone(), so only a plain CullVisitor culls Cameras in parallel.
+        bool cullInParallel = _parallelCameraCulling && typeid(*this)==typeid(CullVisitor);
+
         osg::ref_ptr<osgUtil::RenderStage> rtts = rsCache->getRenderStage(this);
         if (!rtts)
         {
@@ -1536,6 +1661,10 @@ void CullVisitor::apply(osg::Camera& camera)
         }
         else
         {
+            // a Camera instanced more than once in the scene graph may still be being culled into this
+            // RenderStage by the thread pool, so wait for that cull to finish and cull this instance serially.
+            if (waitForParallelCameraCull(rtts.get())) cullInParallel = false;
+
             // reusing render to texture stage, so need to reset it to empty it from previous frames contents.
             rtts->reset();
         }
@@ -1616,23 +1745,30 @@ void CullVisitor::apply(osg::Camera& camera)
         setCurrentRenderBin(rtts.get());
 
         // traverse the subgraph
+        if (cullInParallel)
         {
+            // the subgraph is traversed, and the StateGraph pruned, by another CullVisitor on the thread pool.
+            startParallelCameraCull(camera, rtts.get());
+        }
+        else
+        {
+            rtts->setRenderLeafPool(_renderLeafPool.get());
             handle_cull_callbacks_and_traverse(camera);
+
+            if (rtts->getStateGraphList().size()==0 && rtts->getRenderBinList().size()==0)
+            {
+                // getting to this point means that all the subgraph has been
+                // culled by small feature culling or is beyond LOD ranges.
+            }
+
+            _rootStateGraph->prune();
         }
 
         // restore the previous renderbin.
         setCurrentRenderBin(previousRenderBin);
 
 
-        if (rtts->getStateGraphList().size()==0 && rtts->getRenderBinList().size()==0)
-        {
-            // getting to this point means that all the subgraph has been
-            // culled by small feature culling or is beyond LOD ranges.
-        }
-
-
         // restore cache of the StateGraph
-        _rootStateGraph->prune();
         _rootStateGraph = previous_rootStateGraph;
         _currentStateGraph = previous_currentStateGraph;
 
@@ -1680,6 +1816,136 @@ void CullVisitor::apply(osg::Camera& camera)
 
 }
 
+void CullVisitor::startParallelCameraCull(osg::Camera& camera, RenderStage* rtts)
+{
+    if (_numParallelCameraCulls>=_parallelCameraCullVisitors.size())
+    {
+        osg::ref_ptr<CullVisitor> cv = clone();
+
+        // give each CullVisitor its own identity so per view data, such as that kept by shadow techniques,
+        // isn't shared between threads.
+        cv->setIdentifier(new Identifier);
+        cv->_parallelCameraCulling = false;
+        cv->_parallelCameraCullBlock = new osg::RefBlock;
+
+        _parallelCameraCullVisitors.push_back(cv);
+    }
+
+    // Cameras are handed out in traversal order so each keeps the same CullVisitor, and with it the
+    // RenderStages of any Cameras nested below it, from frame to frame.
+    CullVisitor* cv = _parallelCameraCullVisitors[_numParallelCameraCulls++].get();
+
+    cv->reset();
+    cv->setCullSettings(*this);
+    cv->setOccluderList(_occluderList);
+
+    cv->_traversalNumber = _traversalNumber;
+    cv->_frameStamp = _frameStamp;
+    cv->_traversalMask = _traversalMask;
+    cv->_nodeMaskOverride = _nodeMaskOverride;
+    cv->_nodePath = _nodePath;
+    cv->_databaseRequestHandler = _databaseRequestHandler;
+    cv->_imageRequestHandler = _imageRequestHandler;
+    cv->_renderInfo = _renderInfo;
+    cv->_rootRenderStage = _rootRenderStage;
+    cv->_batchCullingMinimumNumChildren = _batchCullingMinimumNumChildren;
+    cv->_numberOfEncloseOverrideRenderBinDetails = _numberOfEncloseOverrideRenderBinDetails;
+
+    // replicate the view set up for the Camera by apply(osg::Camera&).
+    cv->pushViewport(getViewport());
+    cv->pushProjectionMatrix(getProjectionMatrix());
+    cv->pushModelViewMatrix(getModelViewMatrix(), camera.getReferenceFrame());
+    cv->_eyePointStack.back() = _eyePointStack.back();
+    cv->_referenceViewPoints.back() = _referenceViewPoints.back();
+    cv->_viewPointStack.back() = _viewPointStack.back();
+
+    cv->_rootStateGraph = _rootStateGraph;
+    cv->_currentStateGraph = _currentStateGraph;
+    cv->setCurrentRenderBin(rtts);
+    cv->_parallelCameraCullStage = rtts;
+    rtts->setRenderLeafPool(cv->_renderLeafPool.get());
+
+    cv->_parallelCameraCullCamera = &camera;
+
+    _parallelCameraCullTimes.push_back(CameraCullTime(&camera, 0.0));
+
+    // the claim is only cleared once the cull is set up, so an operation left in the queue from a previous frame
+    // that runs from now on culls this Camera just as the new one would.
+    cv->_parallelCameraCullBlock->reset();
+    cv->_parallelCameraCullClaimed.exchange(0);
+    osg::OperationThreadPool::instance()->getOperationQueue()->add(new ParallelCameraCullOperation(cv));
+}
+
+void CullVisitor::finishParallelCameraCull()
+{
+    // cull on this thread rather than wait for the operation to reach the front of the shared queue.
+    if (_parallelCameraCullClaimed.exchange(1)==0)
+    {
+        cullParallelCamera(*_parallelCameraCullCamera);
+        _parallelCameraCullBlock->release();
+    }
+    else
+    {
+        _parallelCameraCullBlock->block();
+    }
+}
+
+void CullVisitor::cullParallelCamera(osg::Camera& camera)
+{
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+
+    handle_cull_callbacks_and_traverse(camera);
+
+    // popping the projection matrix clamps it to the computed near and far planes.
+    popModelViewMatrix();
+    popProjectionMatrix();
+    popViewport();
+
+    _rootStateGraph->prune();
+    _rootStateGraph = 0;
+    _currentStateGraph = 0;
+    setCurrentRenderBin(0);
+
+    _parallelCameraCullTime = osg::Timer::instance()->delta_s(startTick, osg::Timer::instance()->tick());
+}
+
+bool CullVisitor::waitForParallelCameraCull(RenderStage* rtts)
+{
+    for(unsigned int i=0; i<_numParallelCameraCulls; ++i)
+    {
+        CullVisitor* cv = _parallelCameraCullVisitors[i].get();
+        if (cv->_parallelCameraCullStage==rtts)
+        {
+            cv->finishParallelCameraCull();
+            return true;
+        }
+    }
+    return false;
+}
+
+void CullVisitor::completeParallelCameraCulls()
+{
+    if (_numParallelCameraCulls==0) return;
+
+    // only the culls started by this traversal are run or waited on, operations queued by other traversals
+    // sharing the thread pool are left to the pool.
+    unsigned int base = static_cast<unsigned int>(_parallelCameraCullTimes.size()) - _numParallelCameraCulls;
+    for(unsigned int i=0; i<_numParallelCameraCulls; ++i)
+    {
+        CullVisitor* cv = _parallelCameraCullVisitors[i].get();
+        cv->finishParallelCameraCull();
+        cv->_parallelCameraCullCamera = 0;
+        cv->_parallelCameraCullStage = 0;
+
+        _parallelCameraCullTimes[base+i].second = cv->_parallelCameraCullTime;
+
+        _numRenderLeavesAllocated += cv->_numRenderLeavesAllocated;
+        _numStateGraphsAllocated += cv->_numStateGraphsAllocated;
+    }
+
+    _numParallelCameraCulls = 0;
+}
+
 void CullVisitor::apply(osg::OccluderNode& node)
 {
     // need to check if occlusion node is in the occluder
@@ -19,6 +19,7 @@
 #include <osg/io_utils>
 #include <osg/TriangleFunctor>
 #include <osg/KdTree>
+#include <osg/BoundingVolumeHierarchy>
 #include <osg/Timer>
 #include <osg/TexMat>
 #include <osg/TemplatePrimitiveFunctor>
@@ -402,6 +403,169 @@ struct IntersectFunctor
     }
 };
 
+/** Drives one IntersectFunctor per segment of a LineSegmentPacketIntersector through a single KdTree or
+  * BoundingVolumeHierarchy traversal, so that nodes and leaves are visited once for all the segments.*/
+template<typename Functor>
+struct PacketIntersectFunctor
+{
+    typedef std::vector<Functor> Functors;
+
+    PacketIntersectFunctor(Functors& functors):
+        _functors(functors)
+    {
+        osg::BoundingBoxd bound;
+        for(unsigned int i=0; i<_functors.size(); ++i)
+        {
+            _active.push_back(i);
+            expandBound(bound, i);
+        }
+        _rangeStarts.push_back(0);
+        _rangeBounds.push_back(bound);
+    }
+
+    void expandBound(osg::BoundingBoxd& bound, unsigned int index) const
+    {
+        const typename Functor::StartEnd& startend = _functors[index]._startEndStack.back();
+        bound.expandBy(startend.first.x(), startend.first.y(), startend.first.z());
+        bound.expandBy(startend.second.x(), startend.second.y(), startend.second.z());
+    }
+
+    // KdTree traversal, nodes outside the bound of all the active segments are rejected up front,
+    // otherwise each segment is clipped to the node's bound by its own functor and only the segments
+    // that intersect it are active within the node.
+    bool enter(const osg::BoundingBox& bb)
+    {
+        const osg::BoundingBoxd& bound = _rangeBounds.back();
+        if (bound.xMin()>bb.xMax() || bound.xMax()<bb.xMin() ||
+            bound.yMin()>bb.yMax() || bound.yMax()<bb.yMin() ||
+            bound.zMin()>bb.zMax() || bound.zMax()<bb.zMin())
+        {
+            return false;
+        }
+
+        osg::BoundingBoxd clippedBound;
+        unsigned int begin = _rangeStarts.back();
+        unsigned int end = _active.size();
+        for(unsigned int i=begin; i<end; ++i)
+        {
+            unsigned int index = _active[i];
+            if (_functors[index].enter(bb))
+            {
+                _active.push_back(index);
+                expandBound(clippedBound, index);
+            }
+        }
+
+        if (_active.size()==end) return false;
+
+        _rangeStarts.push_back(end);
+        _rangeBounds.push_back(clippedBound);
+        return true;
+    }
+
+    void leave()
+    {
+        for(unsigned int i=_rangeStarts.back(); i<_active.size(); ++i)
+        {
+            _functors[_active[i]].leave();
+        }
+        _active.resize(_rangeStarts.back());
+        _rangeStarts.pop_back();
+        _rangeBounds.pop_back();
+    }
+
+    void intersect(const osg::Vec3Array* vertices, int primitiveIndex, unsigned int p0)
+    {
+        for(unsigned int i=_rangeStarts.back(); i<_active.size(); ++i) _functors[_active[i]].intersect(vertices, primitiveIndex, p0);
+    }
+
+    void intersect(const osg::Vec3Array* vertices, int primitiveIndex, unsigned int p0, unsigned int p1)
+    {
+        for(unsigned int i=_rangeStarts.back(); i<_active.size(); ++i) _functors[_active[i]].intersect(vertices, primitiveIndex, p0, p1);
+    }
+
+    void intersect(const osg::Vec3Array* vertices, int primitiveIndex, unsigned int p0, unsigned int p1, unsigned int p2)
+    {
+        for(unsigned int i=_rangeStarts.back(); i<_active.size(); ++i) _functors[_active[i]].intersect(vertices, primitiveIndex, p0, p1, p2);
+    }
+
+    void intersect(const osg::Vec3Array* vertices, int primitiveIndex, unsigned int p0, unsigned int p1, unsigned int p2, unsigned int p3)
+    {
+        for(unsigned int i=_rangeStarts.back(); i<_active.size(); ++i) _functors[_active[i]].intersect(vertices, primitiveIndex, p0, p1, p2, p3);
+    }
+
+    // BoundingVolumeHierarchy packet traversal, which culls the segments itself.
+    void intersect(unsigned int segmentIndex, const osg::Vec3Array* vertices, int primitiveIndex, unsigned int p0, unsigned int p1, unsigned int p2)
+    {
+        _functors[segmentIndex].intersect(vertices, primitiveIndex, p0, p1, p2);
+    }
+
+    Functors&                       _functors;
+    std::vector<unsigned int>       _active;
+    std::vector<unsigned int>       _rangeStarts;
+    std::vector<osg::BoundingBoxd>  _rangeBounds;
+
+protected:
+
+    PacketIntersectFunctor& operator = (const PacketIntersectFunctor&) { return *this; }
+};
+
+struct ClippedSegment
+{
+    ClippedSegment(osgUtil::LineSegmentIntersector* lsi, const osg::Vec3d& s, const osg::Vec3d& e):
+        intersector(lsi), start(s), end(e) {}
+
+    osgUtil::LineSegmentIntersector*    intersector;
+    osg::Vec3d                          start;
+    osg::Vec3d                          end;
+};
+typedef std::vector<ClippedSegment> ClippedSegments;
+
+template<typename Vec3, typename value_type>
+void intersectPacket(osgUtil::IntersectionVisitor& iv, osg::Drawable* drawable, osg::KdTree* kdTree, osg::BoundingVolumeHierarchy* bvh, const ClippedSegments& segments)
+{
+    typedef IntersectFunctor<Vec3, value_type> Functor;
+
+    osg::ref_ptr<osg::Vec3Array> vertices;
+    osg::Geometry* geometry = drawable->asGeometry();
+    if (geometry) vertices = dynamic_cast<osg::Vec3Array*>(geometry->getVertexArray());
+
+    // the functors keep pointers to their settings, so both are sized up front.
+    std::vector<Settings> settings(segments.size());
+    std::vector<Functor> functors(segments.size());
+    for(unsigned int i=0; i<segments.size(); ++i)
+    {
+        osgUtil::LineSegmentIntersector* lsi = segments[i].intersector;
+        osgUtil::Intersector::IntersectionLimit limit = lsi->getIntersectionLimit();
+
+        settings[i]._lineSegIntersector = lsi;
+        settings[i]._iv = &iv;
+        settings[i]._drawable = drawable;
+        settings[i]._vertices = vertices;
+        settings[i]._limitOneIntersection = (limit == osgUtil::Intersector::LIMIT_ONE_PER_DRAWABLE || limit == osgUtil::Intersector::LIMIT_ONE);
+
+        functors[i].set(segments[i].start, segments[i].end, &settings[i]);
+    }
+
+    PacketIntersectFunctor<Functor> packet(functors);
+
+    if (kdTree)
+    {
+        kdTree->intersect(packet, kdTree->getNode(0));
+    }
+    else
+    {
+        std::vector<osg::BoundingVolumeHierarchy::Segment> bvhSegments;
+        bvhSegments.reserve(segments.size());
+        for(unsigned int i=0; i<segments.size(); ++i)
+        {
+            bvhSegments.push_back(osg::BoundingVolumeHierarchy::Segment(segments[i].start, segments[i].end));
+        }
+
+        bvh->intersect(packet, bvhSegments);
+    }
+}
+
 } // namespace LineSegmentIntersectorUtils
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -531,6 +695,9 @@ void LineSegmentIntersector::intersect(osgUtil::IntersectionVisitor& iv, osg::Dr
     }
 
     osg::KdTree* kdTree = iv.getUseKdTreeWhenAvailable() ? dynamic_cast<osg::KdTree*>(drawable->getShape()) : 0;
+    if (kdTree && !kdTree->buildIfRequired(geometry)) kdTree = 0;
+
+    osg::BoundingVolumeHierarchy* bvh = iv.getUseKdTreeWhenAvailable() ? dynamic_cast<osg::BoundingVolumeHierarchy*>(drawable->getShape()) : 0;
 
     if (getPrecisionHint()==USE_DOUBLE_CALCULATIONS)
     {
@@ -538,6 +705,7 @@ void LineSegmentIntersector::intersect(osgUtil::IntersectionVisitor& iv, osg::Dr
         intersector.set(s,e, &settings);
 
         if (kdTree) kdTree->intersect(intersector, kdTree->getNode(0));
+        else if (bvh) bvh->intersect(intersector, s, e);
         else drawable->accept(intersector);
     }
     else
@@ -546,6 +714,7 @@ void LineSegmentIntersector::intersect(osgUtil::IntersectionVisitor& iv, osg::Dr
         intersector.set(s,e, &settings);
 
         if (kdTree) kdTree->intersect(intersector, kdTree->getNode(0));
+        else if (bvh) bvh->intersect(intersector, s, e);
         else drawable->accept(intersector);
     }
 }
@@ -838,3 +1007,200 @@ osg::Texture* LineSegmentIntersector::Intersection::getTextureLookUp(osg::Vec3&
     }
     return 0;
 }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  LineSegmentPacketIntersector
+//
+
+LineSegmentPacketIntersector::LineSegmentPacketIntersector(CoordinateFrame cf, IntersectionLimit intersectionLimit):
+    Intersector(cf, intersectionLimit),
+    _packetBoundDirty(true)
+{
+}
+
+LineSegmentIntersector* LineSegmentPacketIntersector::addSegment(const osg::Vec3d& start, const osg::Vec3d& end)
+{
+    osg::ref_ptr<LineSegmentIntersector> lsi = new LineSegmentIntersector(_coordinateFrame, start, end, 0, _intersectionLimit);
+    lsi->setPrecisionHint(getPrecisionHint());
+    addIntersector(lsi.get());
+    return lsi.get();
+}
+
+void LineSegmentPacketIntersector::addIntersector(LineSegmentIntersector* intersector)
+{
+    _intersectors.push_back(intersector);
+    _packetBoundDirty = true;
+}
+
+void LineSegmentPacketIntersector::clear()
+{
+    _intersectors.clear();
+    _activeIndices.clear();
+    _rangeStarts.clear();
+    _packetBoundDirty = true;
+}
+
+void LineSegmentPacketIntersector::computePacketBound()
+{
+    _packetBound.init();
+    for(Intersectors::iterator itr = _intersectors.begin();
+        itr != _intersectors.end();
+        ++itr)
+    {
+        _packetBound.expandBy((*itr)->getStart());
+        _packetBound.expandBy((*itr)->getEnd());
+    }
+    _packetBoundDirty = false;
+}
+
+Intersector* LineSegmentPacketIntersector::clone(osgUtil::IntersectionVisitor& iv)
+{
+    osg::ref_ptr<LineSegmentPacketIntersector> packet = new LineSegmentPacketIntersector(_coordinateFrame, _intersectionLimit);
+    packet->setPrecisionHint(getPrecisionHint());
+
+    // only the segments still active at the point of the clone can intersect anything below it.
+    if (_rangeStarts.empty())
+    {
+        for(Intersectors::iterator itr = _intersectors.begin();
+            itr != _intersectors.end();
+            ++itr)
+        {
+            packet->addIntersector(static_cast<LineSegmentIntersector*>((*itr)->clone(iv)));
+        }
+    }
+    else
+    {
+        for(unsigned int i=_rangeStarts.back(); i<_activeIndices.size(); ++i)
+        {
+            packet->addIntersector(static_cast<LineSegmentIntersector*>(_intersectors[_activeIndices[i]]->clone(iv)));
+        }
+    }
+
+    return packet.release();
+}
+
+bool LineSegmentPacketIntersector::enter(const osg::Node& node)
+{
+    if (_intersectors.empty()) return false;
+
+    if (_packetBoundDirty) computePacketBound();
+
+    // cheaply reject nodes outside the bound of the whole packet before testing the individual segments.
+    const osg::BoundingSphere& bs = node.getBound();
+    if (node.isCullingActive() && bs.valid() && _packetBound.valid())
+    {
+        osg::Vec3d center(bs.center());
+        osg::Vec3d nearest(osg::clampBetween(center.x(), _packetBound.xMin(), _packetBound.xMax()),
+                           osg::clampBetween(center.y(), _packetBound.yMin(), _packetBound.yMax()),
+                           osg::clampBetween(center.z(), _packetBound.zMin(), _packetBound.zMax()));
+        if ((nearest-center).length2() > double(bs.radius())*double(bs.radius())) return false;
+    }
+
+    unsigned int begin = 0;
+    unsigned int end = _intersectors.size();
+    bool topLevel = _rangeStarts.empty();
+    if (!topLevel)
+    {
+        begin = _rangeStarts.back();
+        end = _activeIndices.size();
+    }
+
+    unsigned int newBegin = _activeIndices.size();
+    for(unsigned int i=begin; i<end; ++i)
+    {
+        unsigned int index = topLevel ? i : _activeIndices[i];
+        if (_intersectors[index]->enter(node)) _activeIndices.push_back(index);
+    }
+
+    if (_activeIndices.size()==newBegin) return false;
+
+    _rangeStarts.push_back(newBegin);
+    return true;
+}
+
+void LineSegmentPacketIntersector::leave()
+{
+    if (_rangeStarts.empty()) return;
+
+    _activeIndices.resize(_rangeStarts.back());
+    _rangeStarts.pop_back();
+}
+
+void LineSegmentPacketIntersector::intersect(osgUtil::IntersectionVisitor& iv, osg::Drawable* drawable)
+{
+    unsigned int begin = 0;
+    unsigned int end = _intersectors.size();
+    bool topLevel = _rangeStarts.empty();
+    if (!topLevel)
+    {
+        begin = _rangeStarts.back();
+        end = _activeIndices.size();
+    }
+
+    LineSegmentIntersectorUtils::ClippedSegments segments;
+    for(unsigned int i=begin; i<end; ++i)
+    {
+        LineSegmentIntersector* lsi = _intersectors[topLevel ? i : _activeIndices[i]].get();
+        if (lsi->reachedLimit()) continue;
+
+        osg::Vec3d s(lsi->getStart()), e(lsi->getEnd());
+        if ( drawable->isCullingActive() && !lsi->intersectAndClip( s, e, drawable->getBoundingBox() ) ) continue;
+
+        segments.push_back(LineSegmentIntersectorUtils::ClippedSegment(lsi, s, e));
+    }
+
+    if (segments.empty() || iv.getDoDummyTraversal()) return;
+
+    osg::KdTree* kdTree = iv.getUseKdTreeWhenAvailable() ? dynamic_cast<osg::KdTree*>(drawable->getShape()) : 0;
+    if (kdTree && !kdTree->buildIfRequired(drawable->asGeometry())) kdTree = 0;
+
+    osg::BoundingVolumeHierarchy* bvh = iv.getUseKdTreeWhenAvailable() ? dynamic_cast<osg::BoundingVolumeHierarchy*>(drawable->getShape()) : 0;
+
+    if ((!kdTree && !bvh) || segments.size()==1)
+    {
+        // nothing to share between the segments, so intersect each with the drawable in turn.
+        for(LineSegmentIntersectorUtils::ClippedSegments::iterator itr = segments.begin();
+            itr != segments.end();
+            ++itr)
+        {
+            itr->intersector->intersect(iv, drawable, itr->start, itr->end);
+        }
+        return;
+    }
+
+    if (getPrecisionHint()==USE_DOUBLE_CALCULATIONS)
+    {
+        LineSegmentIntersectorUtils::intersectPacket<osg::Vec3d, double>(iv, drawable, kdTree, bvh, segments);
+    }
+    else
+    {
+        LineSegmentIntersectorUtils::intersectPacket<osg::Vec3f, float>(iv, drawable, kdTree, bvh, segments);
+    }
+}
+
+void LineSegmentPacketIntersector::reset()
+{
+    Intersector::reset();
+
+    _activeIndices.clear();
+    _rangeStarts.clear();
+
+    for(Intersectors::iterator itr = _intersectors.begin();
+        itr != _intersectors.end();
+        ++itr)
+    {
+        (*itr)->reset();
+    }
+}
+
+bool LineSegmentPacketIntersector::containsIntersections()
+{
+    for(Intersectors::iterator itr = _intersectors.begin();
+        itr != _intersectors.end();
+        ++itr)
+    {
+        if ((*itr)->containsIntersections()) return true;
+    }
+    return false;
+}
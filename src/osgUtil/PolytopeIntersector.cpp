@@ -558,6 +558,7 @@ void PolytopeIntersector::intersect(osgUtil::IntersectionVisitor& iv, osg::Drawa
     settings->_primitiveMask = _primitiveMask;
 
     osg::KdTree* kdTree = iv.getUseKdTreeWhenAvailable() ? dynamic_cast<osg::KdTree*>(drawable->getShape()) : 0;
+    if (kdTree && !kdTree->buildIfRequired(drawable->asGeometry())) kdTree = 0;
 
     if (getPrecisionHint()==USE_DOUBLE_CALCULATIONS)
     {
@@ -142,6 +142,60 @@ RenderBin::SortMode RenderBin::getDefaultRenderBinSortMode()
     return s_defaultBinSortMode;
 }
 
+static bool s_defaultUseFlattenedRenderLeafArrayInitialized = false;
+static bool s_defaultUseFlattenedRenderLeafArray = false;
+static osg::ApplicationUsageProxy RenderBin_e1(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_FLATTENED_RENDER_BINS <mode>","ON | OFF - sort and draw RenderBin contents via a flattened, radix sorted array of render leaves.");
+
+void RenderBin::setDefaultUseFlattenedRenderLeafArray(bool flag)
+{
+    s_defaultUseFlattenedRenderLeafArrayInitialized = true;
+    s_defaultUseFlattenedRenderLeafArray = flag;
+}
+
+bool RenderBin::getDefaultUseFlattenedRenderLeafArray()
+{
+    if (!s_defaultUseFlattenedRenderLeafArrayInitialized)
+    {
+        s_defaultUseFlattenedRenderLeafArrayInitialized = true;
+
+        const char* str = getenv("OSG_FLATTENED_RENDER_BINS");
+        if (str)
+        {
+            if (strcmp(str,"ON")==0) s_defaultUseFlattenedRenderLeafArray = true;
+            else if (strcmp(str,"OFF")==0) s_defaultUseFlattenedRenderLeafArray = false;
+        }
+    }
+
+    return s_defaultUseFlattenedRenderLeafArray;
+}
+
+static bool s_useRadixDepthSortInitialized = false;
+static bool s_useRadixDepthSort = false;
+static osg::ApplicationUsageProxy RenderBin_e2(osg::ApplicationUsage::ENVIRONMENTAL_VARIABLE,"OSG_RADIX_DEPTH_SORT <mode>","ON | OFF - use a radix sort for SORT_FRONT_TO_BACK and SORT_BACK_TO_FRONT bins.");
+
+void RenderBin::setUseRadixDepthSort(bool flag)
+{
+    s_useRadixDepthSortInitialized = true;
+    s_useRadixDepthSort = flag;
+}
+
+bool RenderBin::getUseRadixDepthSort()
+{
+    if (!s_useRadixDepthSortInitialized)
+    {
+        s_useRadixDepthSortInitialized = true;
+
+        const char* str = getenv("OSG_RADIX_DEPTH_SORT");
+        if (str)
+        {
+            if (strcmp(str,"ON")==0) s_useRadixDepthSort = true;
+            else if (strcmp(str,"OFF")==0) s_useRadixDepthSort = false;
+        }
+    }
+
+    return s_useRadixDepthSort;
+}
+
 RenderBin::RenderBin()
 {
     _binNum = 0;
@@ -149,6 +203,7 @@ RenderBin::RenderBin()
     _stage = NULL;
     _sorted = false;
     _sortMode = getDefaultRenderBinSortMode();
+    _useFlattenedRenderLeafArray = getDefaultUseFlattenedRenderLeafArray();
 }
 
 RenderBin::RenderBin(SortMode mode)
@@ -158,6 +213,7 @@ RenderBin::RenderBin(SortMode mode)
     _stage = NULL;
     _sorted = false;
     _sortMode = mode;
+    _useFlattenedRenderLeafArray = getDefaultUseFlattenedRenderLeafArray();
 
 #if 1
     if (_sortMode==SORT_BACK_TO_FRONT)
@@ -187,6 +243,7 @@ RenderBin::RenderBin(const RenderBin& rhs,const CopyOp& copyop):
         _renderLeafList(rhs._renderLeafList),
         _sorted(rhs._sorted),
         _sortMode(rhs._sortMode),
+        _useFlattenedRenderLeafArray(rhs._useFlattenedRenderLeafArray),
         _sortCallback(rhs._sortCallback),
         _drawCallback(rhs._drawCallback),
         _stateset(rhs._stateset)
@@ -202,6 +259,7 @@ void RenderBin::reset()
 {
     _stateGraphList.clear();
     _renderLeafList.clear();
+    _sortedRenderLeafList.clear();
     _bins.clear();
     _sorted = false;
 }
@@ -233,6 +291,12 @@ void RenderBin::setSortMode(SortMode mode)
 
 void RenderBin::sortImplementation()
 {
+    if (_useFlattenedRenderLeafArray)
+    {
+        sortFlattened();
+        return;
+    }
+
     switch(_sortMode)
     {
         case(SORT_BY_STATE):
@@ -305,6 +369,12 @@ void RenderBin::sortFrontToBack()
 {
     copyLeavesFromStateGraphListToRenderLeafList();
 
+    if (getUseRadixDepthSort())
+    {
+        radixSortRenderLeafListByDepth(false);
+        return;
+    }
+
     // now sort the list into acending depth order.
     std::sort(_renderLeafList.begin(),_renderLeafList.end(),FrontToBackSortFunctor());
 
@@ -323,7 +393,13 @@ void RenderBin::sortBackToFront()
 {
     copyLeavesFromStateGraphListToRenderLeafList();
 
-    // now sort the list into acending depth order.
+    if (getUseRadixDepthSort())
+    {
+        radixSortRenderLeafListByDepth(true);
+        return;
+    }
+
+    // now sort the list into decending depth order.
     std::sort(_renderLeafList.begin(),_renderLeafList.end(),BackToFrontSortFunctor());
 
 //    cout << "sort back to front"<<endl;
@@ -346,6 +422,179 @@ void RenderBin::sortTraversalOrder()
     std::sort(_renderLeafList.begin(),_renderLeafList.end(),TraversalOrderFunctor());
 }
 
+namespace
+{
+
+/** Map a float onto an unsigned int whose unsigned ordering matches the float ordering.*/
+inline uint32_t floatToSortKey(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+}
+
+/** Stable least significant digit radix sort on the 64 bit keys, one 8 bit digit per pass.
+  * Passes where every key shares the same digit are skipped, so keys that only use their
+  * low 32 bits cost four passes. scratch is used as the ping-pong buffer.*/
+void radixSort(RenderBin::SortedRenderLeafList& leaves, RenderBin::SortedRenderLeafList& scratch)
+{
+    const unsigned int numLeaves = leaves.size();
+    if (numLeaves<2) return;
+
+    unsigned int histograms[8][256];
+    memset(histograms, 0, sizeof(histograms));
+
+    for(RenderBin::SortedRenderLeafList::const_iterator itr = leaves.begin();
+        itr != leaves.end();
+        ++itr)
+    {
+        uint64_t key = itr->_key;
+        for(unsigned int pass=0; pass<8; ++pass)
+        {
+            ++histograms[pass][(key >> (pass*8)) & 0xff];
+        }
+    }
+
+    scratch.resize(numLeaves);
+
+    RenderBin::SortedRenderLeaf* source = &leaves.front();
+    RenderBin::SortedRenderLeaf* destination = &scratch.front();
+    for(unsigned int pass=0; pass<8; ++pass)
+    {
+        unsigned int* histogram = histograms[pass];
+        if (histogram[(source[0]._key >> (pass*8)) & 0xff]==numLeaves) continue;
+
+        unsigned int offset = 0;
+        for(unsigned int i=0; i<256; ++i)
+        {
+            unsigned int count = histogram[i];
+            histogram[i] = offset;
+            offset += count;
+        }
+
+        for(unsigned int i=0; i<numLeaves; ++i)
+        {
+            destination[histogram[(source[i]._key >> (pass*8)) & 0xff]++] = source[i];
+        }
+
+        std::swap(source, destination);
+    }
+
+    if (source!=&leaves.front()) leaves.swap(scratch);
+}
+
+}
+
+void RenderBin::sortFlattened()
+{
+    // the depth and traversal order sorts rebuild the RenderLeafList from the StateGraph leaves, as per
+    // copyLeavesFromStateGraphListToRenderLeafList(), while the state sorts leave any existing RenderLeafList
+    // entries to be drawn ahead of the StateGraph leaves.
+    bool rebuildRenderLeafList = (_sortMode!=SORT_BY_STATE && _sortMode!=SORT_BY_STATE_THEN_FRONT_TO_BACK);
+    if (rebuildRenderLeafList) _renderLeafList.clear();
+
+    unsigned int totalsize=0;
+    for(StateGraphList::iterator itr=_stateGraphList.begin();
+        itr!=_stateGraphList.end();
+        ++itr)
+    {
+        totalsize += (*itr)->_leaves.size();
+    }
+
+    _sortedRenderLeafList.clear();
+    _sortedRenderLeafList.reserve(totalsize);
+
+    // order of the StateGraph for SORT_BY_STATE_THEN_FRONT_TO_BACK, by minimum distance.
+    typedef std::vector<uint64_t> StateGraphKeys;
+    StateGraphKeys stateGraphKeys;
+    if (_sortMode==SORT_BY_STATE_THEN_FRONT_TO_BACK)
+    {
+        stateGraphKeys.reserve(_stateGraphList.size());
+        for(unsigned int i=0; i<_stateGraphList.size(); ++i)
+        {
+            stateGraphKeys.push_back((uint64_t(floatToSortKey(_stateGraphList[i]->getMinimumDistance()))<<32) | i);
+        }
+        std::sort(stateGraphKeys.begin(), stateGraphKeys.end());
+    }
+
+    bool detectedNaN = false;
+    for(unsigned int i=0; i<_stateGraphList.size(); ++i)
+    {
+        unsigned int stateGraphIndex = stateGraphKeys.empty() ? i : static_cast<unsigned int>(stateGraphKeys[i] & 0xffffffff);
+        StateGraph::LeafList& leaves = _stateGraphList[stateGraphIndex]->_leaves;
+
+        for(StateGraph::LeafList::iterator dw_itr = leaves.begin();
+            dw_itr != leaves.end();
+            ++dw_itr)
+        {
+            RenderLeaf* rl = dw_itr->get();
+
+            if (rebuildRenderLeafList && osg::isNaN(rl->_depth))
+            {
+                detectedNaN = true;
+                continue;
+            }
+
+            SortedRenderLeaf srl;
+            srl._leaf = rl;
+            switch(_sortMode)
+            {
+                case(SORT_BY_STATE_THEN_FRONT_TO_BACK): srl._key = (uint64_t(i)<<32) | floatToSortKey(rl->_depth); break;
+                case(SORT_FRONT_TO_BACK): srl._key = floatToSortKey(rl->_depth); break;
+                case(SORT_BACK_TO_FRONT): srl._key = ~floatToSortKey(rl->_depth); break;
+                case(TRAVERSAL_ORDER): srl._key = rl->_traversalOrderNumber; break;
+                default: srl._key = 0; break;
+            }
+            _sortedRenderLeafList.push_back(srl);
+        }
+    }
+
+    if (detectedNaN) OSG_NOTICE<<"Warning: RenderBin::sortFlattened() detected NaN depth values, database may be corrupted."<<std::endl;
+
+    // SORT_BY_STATE keeps the StateGraph order the leaves were gathered in so needs no sorting.
+    if (_sortMode!=SORT_BY_STATE)
+    {
+        radixSort(_sortedRenderLeafList, _sortedRenderLeafListScratch);
+    }
+
+    _renderLeafList.reserve(_renderLeafList.size() + _sortedRenderLeafList.size());
+    for(SortedRenderLeafList::iterator itr = _sortedRenderLeafList.begin();
+        itr != _sortedRenderLeafList.end();
+        ++itr)
+    {
+        _renderLeafList.push_back(itr->_leaf);
+    }
+
+    // empty the render graph list to prevent it being drawn along side the render leaf list (see drawImplementation.)
+    _stateGraphList.clear();
+}
+
+void RenderBin::radixSortRenderLeafListByDepth(bool backToFront)
+{
+    _sortedRenderLeafList.resize(_renderLeafList.size());
+
+    // pack the depths into keys, only the low 32 bits are used so the sort takes at most four passes.
+    SortedRenderLeafList::iterator sitr = _sortedRenderLeafList.begin();
+    for(RenderLeafList::iterator itr = _renderLeafList.begin();
+        itr != _renderLeafList.end();
+        ++itr, ++sitr)
+    {
+        uint32_t depthKey = floatToSortKey((*itr)->_depth);
+        sitr->_key = backToFront ? ~depthKey : depthKey;
+        sitr->_leaf = *itr;
+    }
+
+    radixSort(_sortedRenderLeafList, _sortedRenderLeafListScratch);
+
+    RenderLeafList::iterator itr = _renderLeafList.begin();
+    for(sitr = _sortedRenderLeafList.begin();
+        sitr != _sortedRenderLeafList.end();
+        ++sitr, ++itr)
+    {
+        *itr = sitr->_leaf;
+    }
+}
+
 void RenderBin::copyLeavesFromStateGraphListToRenderLeafList()
 {
     _renderLeafList.clear();
@@ -14,9 +14,109 @@
 #include <osgUtil/StateGraph>
 #include <osg/Notify>
 
+#include <new>
+
 using namespace osg;
 using namespace osgUtil;
 
+namespace
+{
+
+/** Header stored in front of each RenderLeaf, sized to keep the RenderLeaf that follows it aligned.*/
+union RenderLeafHeader
+{
+    osg::Referenced*    block;
+    void*               alignPointer;
+    double              alignDouble;
+    long double         alignLongDouble;
+};
+
+// size of the storage for a RenderLeaf and its header in a RenderLeafPool block, rounded up to keep each slot aligned.
+const std::size_t s_renderLeafSlotSize = ((sizeof(RenderLeaf)+sizeof(RenderLeafHeader)-1)/sizeof(RenderLeafHeader) + 1)*sizeof(RenderLeafHeader);
+
+}
+
+void* RenderLeaf::operator new(std::size_t size)
+{
+    char* memory = static_cast<char*>(::operator new(sizeof(RenderLeafHeader)+size));
+    reinterpret_cast<RenderLeafHeader*>(memory)->block = 0;
+    return memory + sizeof(RenderLeafHeader);
+}
+
+void RenderLeaf::operator delete(void* ptr)
+{
+    if (!ptr) return;
+
+    RenderLeafHeader* header = reinterpret_cast<RenderLeafHeader*>(static_cast<char*>(ptr) - sizeof(RenderLeafHeader));
+    if (header->block) header->block->unref();
+    else ::operator delete(header);
+}
+
+/** Storage for RenderLeaf, referenced by the RenderLeafPool while it is filling it and by each RenderLeaf constructed in it.*/
+class RenderLeafPool::Block : public osg::Referenced
+{
+    public:
+
+        Block(unsigned int capacity):
+            _memory(static_cast<char*>(::operator new(capacity*s_renderLeafSlotSize))),
+            _capacity(capacity),
+            _size(0) {}
+
+        bool full() const { return _size==_capacity; }
+
+        char* allocateSlot() { return _memory + (_size++)*s_renderLeafSlotSize; }
+
+    protected:
+
+        virtual ~Block() { ::operator delete(_memory); }
+
+        char*           _memory;
+        unsigned int    _capacity;
+        unsigned int    _size;
+};
+
+RenderLeafPool::RenderLeafPool():
+    _currentIndex(0),
+    _currentBlockCapacity(0)
+{
+}
+
+RenderLeafPool::~RenderLeafPool()
+{
+}
+
+void RenderLeafPool::reset()
+{
+    // Only reset the RenderLeaf objects used since the last reset.
+    for(RenderLeafList::iterator itr=_renderLeaves.begin(),
+        iter_end=_renderLeaves.begin()+_currentIndex;
+        itr!=iter_end;
+        ++itr)
+    {
+        (*itr)->reset();
+    }
+
+    _currentIndex = 0;
+}
+
+RenderLeaf* RenderLeafPool::allocateRenderLeaf(osg::Drawable* drawable,osg::RefMatrix* projection,osg::RefMatrix* modelview, float depth, unsigned int traversalOrderNumber)
+{
+    if (!_currentBlock || _currentBlock->full())
+    {
+        // blocks double in size up to a limit, so large scenes settle on a handful of blocks.
+        _currentBlockCapacity = _currentBlockCapacity==0 ? 64 : osg::minimum(_currentBlockCapacity*2, 4096u);
+        _currentBlock = new Block(_currentBlockCapacity);
+    }
+
+    char* slot = _currentBlock->allocateSlot();
+    reinterpret_cast<RenderLeafHeader*>(slot)->block = _currentBlock.get();
+
+    // each RenderLeaf keeps its block alive until it is deleted.
+    _currentBlock->ref();
+
+    return new (slot+sizeof(RenderLeafHeader)) RenderLeaf(drawable,projection,modelview,depth,traversalOrderNumber);
+}
+
 void RenderLeaf::render(osg::RenderInfo& renderInfo,RenderLeaf* previous)
 {
     osg::State& state = *renderInfo.getState();
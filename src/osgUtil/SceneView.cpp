@@ -119,6 +119,8 @@ SceneView::SceneView(DisplaySettings* ds)
 
     _prioritizeTextures = false;
 
+    _numFramesToRetainEmptyStateGraphs = 0;
+
     setCamera(new Camera);
     _camera->setViewport(new Viewport);
     _camera->setClearColor(osg::Vec4(0.2f, 0.2f, 0.4f, 1.0f));
@@ -159,6 +161,8 @@ SceneView::SceneView(const SceneView& rhs, const osg::CopyOp& copyop):
 
     _prioritizeTextures = rhs._prioritizeTextures;
 
+    _numFramesToRetainEmptyStateGraphs = rhs._numFramesToRetainEmptyStateGraphs;
+
     _camera = rhs._camera;
     _cameraWithOwnership = rhs._cameraWithOwnership;
 
@@ -893,6 +897,9 @@ bool SceneView::cullStage(const osg::Matrixd& projection,const osg::Matrixd& mod
        else cullVisitor->traverse(*_camera);
     }
 
+    // wait for any Cameras culled in parallel to complete their RenderStages.
+    cullVisitor->completeParallelCameraCulls();
+
 
     cullVisitor->popModelViewMatrix();
     cullVisitor->popProjectionMatrix();
@@ -909,8 +916,10 @@ bool SceneView::cullStage(const osg::Matrixd& projection,const osg::Matrixd& mod
     // note, this would be not required if the rendergraph had been
     // reset at the start of each frame (see top of this method) but
     // a clean has been used instead to try to minimize the amount of
-    // allocation and deleting of the StateGraph nodes.
-    rendergraph->prune();
+    // allocation and deleting of the StateGraph nodes, for the same
+    // reason children are only pruned once they have been empty for
+    // a number of frames.
+    rendergraph->prune(_numFramesToRetainEmptyStateGraphs);
 
     // set the number of dynamic objects in the scene.
     _dynamicObjectCount += renderStage->computeNumberOfDynamicRenderLeaves();
@@ -18,1406 +18,499 @@
 #include <osgUtil/SmoothingVisitor>
 #include <osgUtil/MeshOptimizers>
 
-#include <set>
-#include <list>
 #include <algorithm>
+#include <utility>
 
-#include <iterator>
+#include <float.h>
+#include <math.h>
 
 using namespace osgUtil;
 
-struct dereference_less
-{
-    template<class T, class U>
-    inline bool operator() (const T& lhs,const U& rhs) const
-    {
-        return *lhs < *rhs;
-    }
-};
-
-template<class T>
-bool dereference_check_less(const T& lhs,const T& rhs)
-{
-    if (lhs==rhs) return false;
-    if (!lhs) return true;
-    if (!rhs) return false;
-    return *lhs < *rhs;
-}
-
-struct dereference_clear
-{
-    template<class T>
-    inline void operator() (const T& t)
-    {
-        T& non_const_t = const_cast<T&>(t);
-        non_const_t->clear();
-    }
-};
-
+////////////////////////////////////////////////////////////////////////////////
+//
+// EdgeCollapse - the indexed mesh that the Simplifier works on.
+//
+// Points that share the same vertex and per vertex attributes are welded together, the
+// triangles are held as a flat list of point indices and each point keeps a singly linked
+// list of the triangle corners that reference it.  Dead corners are unlinked as edges are
+// collapsed, a corner is only live while its triangle hasn't been removed and it still
+// references the point.
+//
+// Down sampling collapses edges in order of their quadric error, the candidate collapses are
+// held in a binary heap and entries aren't updated when a collapse changes their cost, instead
+// each point has a version that is incremented on every change so that stale entries can be
+// discarded when they reach the top of the heap.  Up sampling divides the longest edges.
+//
 class EdgeCollapse
 {
 public:
 
-
-#if 1
-    typedef float error_type;
-#else
-    typedef double error_type;
-#endif
-
-    struct Triangle;
-    struct Edge;
-    struct Point;
-
-
     EdgeCollapse():
         _geometry(0),
-        _computeErrorMetricUsingLength(false)  {}
-
-    ~EdgeCollapse();
-
-    void setGeometry(osg::Geometry* geometry, const Simplifier::IndexList& protectedPoints);
-    osg::Geometry* getGeometry() { return _geometry; }
-
-    void setComputeErrorMetricUsingLength(bool flag) { _computeErrorMetricUsingLength = flag; }
-    bool getComputeErrorMetricUsingLength() const { return _computeErrorMetricUsingLength; }
+        _numAttributes(0),
+        _numTriangles(0),
+        _markValue(0) {}
 
-    unsigned int getNumOfTriangles() { return _triangleSet.size(); }
+    bool setGeometry(osg::Geometry* geometry, const Simplifier::IndexList& protectedPoints);
 
-    Point* computeInterpolatedPoint(Edge* edge,float r) const
-    {
-        Point* p1 = edge->_p1.get();
-        Point* p2 = edge->_p2.get();
+    unsigned int getNumTriangles() const { return _numTriangles; }
 
-        if (p1==0 || p2==0)
-        {
-            OSG_NOTICE<<"Error computeInterpolatedPoint("<<edge<<",r) p1 and/or p2==0"<<std::endl;
-            return 0;
-        }
+    void initCollapses();
+    bool getNextCollapseError(float& error);
+    bool collapseNextEdge();
 
-        Point* point = new Point;
-        float r1 = 1.0f-r;
-        float r2 = r;
-
-        point->_vertex = p1->_vertex * r1 + p2->_vertex * r2;
-        unsigned int s = osg::minimum(p1->_attributes.size(),p2->_attributes.size());
-        for(unsigned int i=0;i<s;++i)
-        {
-            point->_attributes.push_back(p1->_attributes[i]*r1 + p2->_attributes[i]*r2);
-        }
-        return point;
-    }
-
-    Point* computeOptimalPoint(Edge* edge) const
-    {
-        return computeInterpolatedPoint(edge,0.5f);
-    }
+    void initDivisions();
+    bool getNextDivisionLength(float& length);
+    bool divideNextEdge();
 
-    error_type computeErrorMetric(Edge* edge,Point* point) const
-    {
-        if (_computeErrorMetricUsingLength)
-        {
-            error_type dx = error_type(edge->_p1->_vertex.x()) - error_type(edge->_p2->_vertex.x());
-            error_type dy = error_type(edge->_p1->_vertex.y()) - error_type(edge->_p2->_vertex.y());
-            error_type dz = error_type(edge->_p1->_vertex.z()) - error_type(edge->_p2->_vertex.z());
-            return sqrt(dx*dx + dy*dy + dz*dz);
-        }
-        else if (point)
-        {
-            typedef std::set< osg::ref_ptr<Triangle> > LocalTriangleSet ;
-            LocalTriangleSet triangles;
-            std::copy( edge->_p1->_triangles.begin(), edge->_p1->_triangles.end(), std::inserter(triangles,triangles.begin()));
-            std::copy( edge->_p2->_triangles.begin(), edge->_p2->_triangles.end(), std::inserter(triangles,triangles.begin()));
+    void copyBackToGeometry();
 
-            const osg::Vec3& vertex = point->_vertex;
-            error_type error = 0.0;
+    typedef std::vector<unsigned int>   IndexList;
+    typedef std::vector<float>          FloatList;
+    typedef std::vector<osg::Vec3>      VertexList;
+    typedef std::vector<osg::Array*>    ArrayList;
 
-            if (triangles.empty()) return 0.0;
+    enum { INVALID_INDEX = 0xffffffff };
 
-            for(LocalTriangleSet::iterator itr=triangles.begin();
-                itr!=triangles.end();
-                ++itr)
-            {
-                error += fabs( (*itr)->distance(vertex) );
-            }
-
-            // use average of error
-            error /= error_type(triangles.size());
-
-            return error;
-        }
-        else
-        {
-            return 0;
-        }
-    }
+protected:
 
-    void updateErrorMetricForEdge(Edge* edge)
+    /** Symmetric 4x4 quadric measuring the sum of squared distances to a set of planes, each weighted by the area of its triangle.*/
+    struct Quadric
     {
-        if (!edge->_p1 || !edge->_p2)
-        {
-            OSG_NOTICE<<"Error updateErrorMetricForEdge("<<edge<<") p1 and/or p2==0"<<std::endl;
-            return;
-        }
-
-
-        osg::ref_ptr<Edge> keep_local_reference_to_edge(edge);
+        Quadric():
+            a00(0.0), a01(0.0), a02(0.0), a11(0.0), a12(0.0), a22(0.0),
+            b0(0.0), b1(0.0), b2(0.0), c(0.0), w(0.0) {}
 
-        if (_edgeSet.count(keep_local_reference_to_edge)!=0)
+        void addPlane(const osg::Vec3d& n, double d, double weight)
         {
-            _edgeSet.erase(keep_local_reference_to_edge);
+            a00 += weight*n.x()*n.x(); a01 += weight*n.x()*n.y(); a02 += weight*n.x()*n.z();
+            a11 += weight*n.y()*n.y(); a12 += weight*n.y()*n.z(); a22 += weight*n.z()*n.z();
+            b0 += weight*n.x()*d; b1 += weight*n.y()*d; b2 += weight*n.z()*d;
+            c += weight*d*d;
+            w += weight;
         }
 
-        edge->_proposedPoint = computeOptimalPoint(edge);
-
-        if (_computeErrorMetricUsingLength)
+        Quadric& operator += (const Quadric& rhs)
         {
-            edge->setErrorMetric( computeErrorMetric( edge, edge->_proposedPoint.get()));
+            a00 += rhs.a00; a01 += rhs.a01; a02 += rhs.a02;
+            a11 += rhs.a11; a12 += rhs.a12; a22 += rhs.a22;
+            b0 += rhs.b0; b1 += rhs.b1; b2 += rhs.b2;
+            c += rhs.c;
+            w += rhs.w;
+            return *this;
         }
-        else
-        {
-            edge->updateMaxNormalDeviationOnEdgeCollapse();
-
-            if (edge->getMaxNormalDeviationOnEdgeCollapse()<=1.0 && !edge->isAdjacentToBoundary())
-                edge->setErrorMetric( computeErrorMetric( edge, edge->_proposedPoint.get()));
-            else
-                edge->setErrorMetric( FLT_MAX );
-         }
 
-        _edgeSet.insert(keep_local_reference_to_edge);
-    }
-
-    void updateErrorMetricForAllEdges()
-    {
-        typedef std::vector< osg::ref_ptr<Edge> > LocalEdgeList ;
-        LocalEdgeList edges;
-        std::copy( _edgeSet.begin(), _edgeSet.end(), std::back_inserter(edges));
-
-        _edgeSet.clear();
-
-        for(LocalEdgeList::iterator itr=edges.begin();
-            itr!=edges.end();
-            ++itr)
+        osg::Vec3d multiply(const osg::Vec3d& v) const
         {
-            Edge* edge = itr->get();
-
-            if (_computeErrorMetricUsingLength)
-            {
-                edge->setErrorMetric( computeErrorMetric( edge, edge->_proposedPoint.get()));
-            }
-            else
-            {
-                edge->_proposedPoint = computeOptimalPoint(edge);
-                edge->updateMaxNormalDeviationOnEdgeCollapse();
-
-                if (edge->getMaxNormalDeviationOnEdgeCollapse()<=1.0 && !edge->isAdjacentToBoundary())
-                    edge->setErrorMetric( computeErrorMetric( edge, edge->_proposedPoint.get()));
-                else
-                    edge->setErrorMetric( FLT_MAX );
-
-            }
-            _edgeSet.insert(edge);
+            return osg::Vec3d(a00*v.x() + a01*v.y() + a02*v.z(),
+                              a01*v.x() + a11*v.y() + a12*v.z(),
+                              a02*v.x() + a12*v.y() + a22*v.z());
         }
-    }
 
-    bool collapseMinimumErrorEdge()
-    {
-        if (!_edgeSet.empty())
+        double evaluate(const osg::Vec3d& v) const
         {
-            Edge* edge = const_cast<Edge*>(_edgeSet.begin()->get());
-
-            if (edge->getErrorMetric()==FLT_MAX)
-            {
-                OSG_INFO<<"collapseMinimumErrorEdge() return false due to edge->getErrorMetric()==FLT_MAX"<<std::endl;
-                return false;
-            }
-
-            osg::ref_ptr<Point> pNew = edge->_proposedPoint.valid()? edge->_proposedPoint.get() : computeInterpolatedPoint(edge,0.5f);
-            return (collapseEdge(edge,pNew.get()));
+            return v*multiply(v) + 2.0*(b0*v.x() + b1*v.y() + b2*v.z()) + c;
         }
-        OSG_INFO<<"collapseMinimumErrorEdge() return false due to _edgeSet.empty()"<<std::endl;
-        return false;
-    }
 
+        double a00, a01, a02, a11, a12, a22;
+        double b0, b1, b2;
+        double c;
+        double w;
+    };
 
-    bool divideLongestEdge()
+    /** Candidate collapse of point p1 into point p0, valid while both points are unchanged.*/
+    struct Collapse
     {
-        if (!_edgeSet.empty())
-        {
-            Edge* edge = const_cast<Edge*>(_edgeSet.rbegin()->get());
-
-            if (edge->getErrorMetric()==FLT_MAX)
-            {
-                OSG_INFO<<"divideLongestEdge() return false due to edge->getErrorMetric()==FLT_MAX"<<std::endl;
-                return false;
-            }
-
-            osg::ref_ptr<Point> pNew = edge->_proposedPoint.valid()? edge->_proposedPoint.get() : computeInterpolatedPoint(edge,0.5f);
-            return (divideEdge(edge,pNew.get()));
-        }
-        OSG_INFO<<"divideLongestEdge() return false due to _edgeSet.empty()"<<std::endl;
-        return false;
-    }
-
-    void copyBackToGeometry();
-
-    typedef std::vector<float>                                                  FloatList;
-    typedef std::set<osg::ref_ptr<Edge>,dereference_less >                      EdgeSet;
-    typedef std::set< osg::ref_ptr<Point>,dereference_less >                    PointSet;
-    typedef std::vector< osg::ref_ptr<Point> >                                  PointList;
-    typedef std::list< osg::ref_ptr<Triangle> >                                 TriangleList;
-    typedef std::set< osg::ref_ptr<Triangle> >                                  TriangleSet;
+        float           error;
+        unsigned int    p0;
+        unsigned int    p1;
+        unsigned int    version0;
+        unsigned int    version1;
+    };
 
-    struct Point : public osg::Referenced
+    struct CollapseGreater
     {
-        Point(): _protected(false), _index(0) {}
-
-        bool _protected;
-
-        unsigned int _index;
-
-        osg::Vec3           _vertex;
-        FloatList           _attributes;
-        TriangleSet         _triangles;
-
-        void clear()
-        {
-            _attributes.clear();
-            _triangles.clear();
-        }
-
-        bool operator < ( const Point& rhs) const
-        {
-            if (_vertex < rhs._vertex) return true;
-            if (rhs._vertex < _vertex) return false;
-
-            return _attributes < rhs._attributes;
-        }
-
-        bool isBoundaryPoint() const
-        {
-            if (_protected) return true;
-
-            for(TriangleSet::const_iterator itr=_triangles.begin();
-                itr!=_triangles.end();
-                ++itr)
-            {
-                const Triangle* triangle = itr->get();
-                if ((triangle->_e1->_p1==this || triangle->_e1->_p2==this) && triangle->_e1->isBoundaryEdge()) return true;
-                if ((triangle->_e2->_p1==this || triangle->_e2->_p2==this) && triangle->_e2->isBoundaryEdge()) return true;
-                if ((triangle->_e3->_p1==this || triangle->_e3->_p2==this) && triangle->_e3->isBoundaryEdge()) return true;
-
-                //if ((*itr)->isBoundaryTriangle()) return true;
-            }
-            return false;
-        }
-
+        bool operator() (const Collapse& lhs, const Collapse& rhs) const { return lhs.error > rhs.error; }
     };
 
-    struct Edge : public osg::Referenced
+    struct Division
     {
-        Edge(): _errorMetric(0.0), _maximumDeviation(1.0) {}
-
-        void clear()
-        {
-            _p1 = 0;
-            _p2 = 0;
-            _triangles.clear();
-        }
-
-        osg::ref_ptr<Point> _p1;
-        osg::ref_ptr<Point> _p2;
-
-        TriangleSet _triangles;
-
-        error_type _errorMetric;
-        error_type _maximumDeviation;
-
-        osg::ref_ptr<Point> _proposedPoint;
-
-        void setErrorMetric(error_type errorMetric) { _errorMetric = errorMetric; }
-        error_type getErrorMetric() const { return _errorMetric; }
-
-        bool operator < ( const Edge& rhs) const
-        {
-            // both error metrics are computed
-            if (getErrorMetric()<rhs.getErrorMetric()) return true;
-            else if (rhs.getErrorMetric()<getErrorMetric()) return false;
-
-            if (dereference_check_less(_p1,rhs._p1)) return true;
-            if (dereference_check_less(rhs._p1,_p1)) return false;
-
-            return dereference_check_less(_p2,rhs._p2);
-        }
-
-        bool operator == ( const Edge& rhs) const
-        {
-            if (&rhs==this) return true;
-            if (*this<rhs) return false;
-            if (rhs<*this) return false;
-            return true;
-        }
-
-        bool operator != ( const Edge& rhs) const
-        {
-            if (&rhs==this) return false;
-            if (*this<rhs) return true;
-            if (rhs<*this) return true;
-            return false;
-        }
-
-        void addTriangle(Triangle* triangle)
-        {
-            _triangles.insert(triangle);
-            // if (_triangles.size()>2) OSG_NOTICE<<"Warning too many triangles ("<<_triangles.size()<<") sharing edge "<<std::endl;
-        }
-
-        bool isBoundaryEdge() const
-        {
-            return _triangles.size()<=1;
-        }
-
-        bool isAdjacentToBoundary() const
-        {
-            return isBoundaryEdge() || _p1->isBoundaryPoint() || _p2->isBoundaryPoint();
-        }
-
-
-        void updateMaxNormalDeviationOnEdgeCollapse()
-        {
-            //OSG_NOTICE<<"updateMaxNormalDeviationOnEdgeCollapse()"<<std::endl;
-            _maximumDeviation = 0.0f;
-            for(TriangleSet::iterator itr1=_p1->_triangles.begin();
-                itr1!=_p1->_triangles.end();
-                ++itr1)
-            {
-                if (_triangles.count(*itr1)==0)
-                {
-                    _maximumDeviation = osg::maximum(_maximumDeviation, (*itr1)->computeNormalDeviationOnEdgeCollapse(this,_proposedPoint.get()));
-                }
-            }
-            for(TriangleSet::iterator itr2=_p2->_triangles.begin();
-                itr2!=_p2->_triangles.end();
-                ++itr2)
-            {
-                if (_triangles.count(*itr2)==0)
-                {
-                    _maximumDeviation = osg::maximum(_maximumDeviation, (*itr2)->computeNormalDeviationOnEdgeCollapse(this,_proposedPoint.get()));
-                }
-            }
-        }
-
-        error_type getMaxNormalDeviationOnEdgeCollapse() const { return _maximumDeviation; }
-
+        float           length;
+        unsigned int    p0;
+        unsigned int    p1;
     };
 
-    struct Triangle : public osg::Referenced
+    struct DivisionLess
     {
-        Triangle() {}
-
-        void clear()
-        {
-            _p1 = 0;
-            _p2 = 0;
-            _p3 = 0;
-
-            _e1 = 0;
-            _e2 = 0;
-            _e3 = 0;
-        }
-
-        inline bool operator < (const Triangle& rhs) const
-        {
-            if (dereference_check_less(_p1,rhs._p1)) return true;
-            if (dereference_check_less(rhs._p1,_p1)) return false;
-
-
-            const Point* lhs_lower = dereference_check_less(_p2,_p3) ? _p2.get() : _p3.get();
-            const Point* rhs_lower = dereference_check_less(rhs._p2,rhs._p3) ? rhs._p2.get() : rhs._p3.get();
-
-            if (dereference_check_less(lhs_lower,rhs_lower)) return true;
-            if (dereference_check_less(rhs_lower,lhs_lower)) return false;
-
-            const Point* lhs_upper = dereference_check_less(_p2,_p3) ? _p3.get() : _p2.get();
-            const Point* rhs_upper = dereference_check_less(rhs._p2,rhs._p3) ? rhs._p3.get() : rhs._p2.get();
-
-            return dereference_check_less(lhs_upper,rhs_upper);
-        }
-
-
-        void setOrderedPoints(Point* p1, Point* p2, Point* p3)
-        {
-            Point* points[3];
-            points[0] = p1;
-            points[1] = p2;
-            points[2] = p3;
-
-            // find the lowest value point in the list.
-            unsigned int lowest = 0;
-            if (dereference_check_less(points[1],points[lowest])) lowest = 1;
-            if (dereference_check_less(points[2],points[lowest])) lowest = 2;
-
-            _p1 = points[lowest];
-            _p2 = points[(lowest+1)%3];
-            _p3 = points[(lowest+2)%3];
-        }
-
-        void update()
-        {
-            _plane.set(_p1->_vertex,_p2->_vertex,_p3->_vertex);
-
-        }
-
-        osg::Plane computeNewPlaneOnEdgeCollapse(Edge* edge,Point* pNew) const
-        {
-            const Point* p1 = (_p1==edge->_p1 || _p1==edge->_p2) ? pNew : _p1.get();
-            const Point* p2 = (_p2==edge->_p1 || _p2==edge->_p2) ? pNew : _p2.get();
-            const Point* p3 = (_p3==edge->_p1 || _p3==edge->_p2) ? pNew : _p3.get();
-
-            return osg::Plane(p1->_vertex,p2->_vertex,p3->_vertex);
-        }
-
-        // note return 1 - dotproduct, so that deviation is in the range of 0.0 to 2.0, where 0 is coincident, 1.0 is 90 degrees, and 2.0 is 180 degrees.
-        error_type computeNormalDeviationOnEdgeCollapse(Edge* edge,Point* pNew) const
-        {
-            const Point* p1 = (_p1==edge->_p1 || _p1==edge->_p2) ? pNew : _p1.get();
-            const Point* p2 = (_p2==edge->_p1 || _p2==edge->_p2) ? pNew : _p2.get();
-            const Point* p3 = (_p3==edge->_p1 || _p3==edge->_p2) ? pNew : _p3.get();
-
-            osg::Vec3 new_normal = (p2->_vertex - p1->_vertex) ^ (p3->_vertex - p2->_vertex);
-            new_normal.normalize();
-
-            error_type result = 1.0 - (new_normal.x() * _plane[0] + new_normal.y() * _plane[1] + new_normal.z() * _plane[2]);
-            return result;
-        }
-
-        error_type distance(const osg::Vec3& vertex) const
-        {
-            return error_type(_plane[0])*error_type(vertex.x())+
-                   error_type(_plane[1])*error_type(vertex.y())+
-                   error_type(_plane[2])*error_type(vertex.z())+
-                   error_type(_plane[3]);
-        }
-
-        bool isBoundaryTriangle() const
-        {
-            return (_e1->isBoundaryEdge() || _e2->isBoundaryEdge() ||  _e3->isBoundaryEdge());
-        }
-
-
-        osg::ref_ptr<Point> _p1;
-        osg::ref_ptr<Point> _p2;
-        osg::ref_ptr<Point> _p3;
-
-        osg::ref_ptr<Edge> _e1;
-        osg::ref_ptr<Edge> _e2;
-        osg::ref_ptr<Edge> _e3;
-
-        osg::Plane _plane;
-
+        bool operator() (const Division& lhs, const Division& rhs) const { return lhs.length < rhs.length; }
     };
 
+    typedef std::pair<unsigned int, unsigned int>   EdgeKey;
+    typedef std::vector<EdgeKey>                    EdgeKeyList;
 
-    Triangle* addTriangle(unsigned int p1, unsigned int p2, unsigned int p3)
+    inline bool isLiveCorner(unsigned int corner, unsigned int point) const
     {
-        //OSG_NOTICE<<"addTriangle("<<p1<<","<<p2<<","<<p3<<")"<<std::endl;
-
-        // detect if triangle is degenerate.
-        if (p1==p2 || p2==p3 || p1==p3) return 0;
-
-        Triangle* triangle = new Triangle;
-
-        Point* points[3];
-        points[0] = addPoint(triangle, p1);
-        points[1] = addPoint(triangle, p2);
-        points[2] = addPoint(triangle, p3);
-
-        // find the lowest value point in the list.
-        unsigned int lowest = 0;
-        if (dereference_check_less(points[1],points[lowest])) lowest = 1;
-        if (dereference_check_less(points[2],points[lowest])) lowest = 2;
-
-        triangle->_p1 = points[lowest];
-        triangle->_p2 = points[(lowest+1)%3];
-        triangle->_p3 = points[(lowest+2)%3];
-
-        triangle->_e1 = addEdge(triangle, triangle->_p1.get(), triangle->_p2.get());
-        triangle->_e2 = addEdge(triangle, triangle->_p2.get(), triangle->_p3.get());
-        triangle->_e3 = addEdge(triangle, triangle->_p3.get(), triangle->_p1.get());
-
-        triangle->update();
-
-        _triangleSet.insert(triangle);
-
-        return triangle;
+        return _triangles[corner]==point && !_triangleRemoved[corner/3];
     }
 
-    Triangle* addTriangle(Point* p1, Point* p2, Point* p3)
+    inline bool triangleContains(unsigned int triangle, unsigned int point) const
     {
-        // OSG_NOTICE<<"      addTriangle("<<p1<<","<<p2<<","<<p3<<")"<<std::endl;
-
-        // detect if triangle is degenerate.
-        if (p1==p2 || p2==p3 || p1==p3)
-        {
-            // OSG_NOTICE<<"    **** addTriangle failed - p1==p2 || p2==p3 || p1==p3"<<std::endl;
-            return 0;
-        }
-
-        Triangle* triangle = new Triangle;
-
-        Point* points[3];
-        points[0] = addPoint(triangle, p1);
-        points[1] = addPoint(triangle, p2);
-        points[2] = addPoint(triangle, p3);
-
-        // find the lowest value point in the list.
-        unsigned int lowest = 0;
-        if (dereference_check_less(points[1],points[lowest])) lowest = 1;
-        if (dereference_check_less(points[2],points[lowest])) lowest = 2;
-
-        triangle->_p1 = points[lowest];
-        triangle->_p2 = points[(lowest+1)%3];
-        triangle->_p3 = points[(lowest+2)%3];
-
-        triangle->_e1 = addEdge(triangle, triangle->_p1.get(), triangle->_p2.get());
-        triangle->_e2 = addEdge(triangle, triangle->_p2.get(), triangle->_p3.get());
-        triangle->_e3 = addEdge(triangle, triangle->_p3.get(), triangle->_p1.get());
-
-        triangle->update();
-
-        _triangleSet.insert(triangle);
-
-        return triangle;
+        const unsigned int* t = &_triangles[triangle*3];
+        return t[0]==point || t[1]==point || t[2]==point;
     }
 
-    void removeTriangle(Triangle* triangle)
-    {
-        if (triangle->_p1.valid()) removePoint(triangle,triangle->_p1.get());
-        if (triangle->_p2.valid()) removePoint(triangle,triangle->_p2.get());
-        if (triangle->_p3.valid()) removePoint(triangle,triangle->_p3.get());
+    unsigned int newMark();
 
-        if (triangle->_e1.valid()) removeEdge(triangle,triangle->_e1.get());
-        if (triangle->_e2.valid()) removeEdge(triangle,triangle->_e2.get());
-        if (triangle->_e3.valid()) removeEdge(triangle,triangle->_e3.get());
+    void addCorner(unsigned int corner);
 
-        _triangleSet.erase(triangle);
-    }
+    void removeCorner(unsigned int corner);
 
-    void replaceTrianglePoint(Triangle* triangle, Point* pOriginal, Point* pNew)
-    {
-        if (triangle->_p1==pOriginal || triangle->_p2==pOriginal || triangle->_p3==pOriginal)
-        {
-            // fix the corner points to use the new point
-            if (triangle->_p1==pOriginal) triangle->_p1=pNew;
-            if (triangle->_p2==pOriginal) triangle->_p2=pNew;
-            if (triangle->_p3==pOriginal) triangle->_p3=pNew;
-
-            // fixes the edges so they point to use the new point
-            triangle->_e1 = replaceEdgePoint(triangle->_e1.get(),pOriginal,pNew);
-            triangle->_e2 = replaceEdgePoint(triangle->_e2.get(),pOriginal,pNew);
-            triangle->_e3 = replaceEdgePoint(triangle->_e3.get(),pOriginal,pNew);
+    unsigned int addPoint(const osg::Vec3& vertex);
 
-            // remove the triangle form the original point, and possibly the point if its the last triangle to use it
-            removePoint(triangle, pOriginal);
+    void collectNeighbours(unsigned int point, IndexList& neighbours);
 
-            // add the triangle to that point
-            addPoint(triangle,pNew);
-        }
+    void collectEdges(EdgeKeyList& edges) const;
 
-    }
+    float computeCollapse(unsigned int p0, unsigned int p1, osg::Vec3& position, float& ratio) const;
 
-    unsigned int testTriangle(Triangle* triangle)
-    {
-        unsigned int result = 0;
-        if (!(triangle->_p1))
-        {
-            OSG_NOTICE<<"testTriangle("<<triangle<<") _p1==NULL"<<std::endl;
-            ++result;
-        }
-        else if (triangle->_p1->_triangles.count(triangle)==0)
-        {
-            OSG_NOTICE<<"testTriangle("<<triangle<<") _p1->_triangles does not contain triangle"<<std::endl;
-            ++result;
-        }
+    bool computeCollapse(unsigned int pa, unsigned int pb, Collapse& collapse) const;
 
-        if (!(triangle->_p2))
-        {
-            OSG_NOTICE<<"testTriangle("<<triangle<<") _p2==NULL"<<std::endl;
-            ++result;
-        }
-        else if (triangle->_p2->_triangles.count(triangle)==0)
-        {
-            OSG_NOTICE<<"testTriangle("<<triangle<<") _p2->_triangles does not contain triangle"<<std::endl;
-            ++result;
-        }
+    bool satisfiesLinkCondition(unsigned int p0, unsigned int p1);
 
-        if (!(triangle->_p3))
-        {
-            OSG_NOTICE<<"testTriangle("<<triangle<<") _p3==NULL"<<std::endl;
-            ++result;
-        }
-        else if (triangle->_p3->_triangles.count(triangle)==0)
-        {
-            OSG_NOTICE<<"testTriangle("<<triangle<<") _p3->_triangles does not contain triangle"<<std::endl;
-            ++result;
-        }
+    bool flipsTriangles(unsigned int point, unsigned int other, const osg::Vec3& position) const;
 
-        if (testEdge(triangle->_e1.get()))
-        {
-            ++result;
-            OSG_NOTICE<<"testTriangle("<<triangle<<") _e1 test failed"<<std::endl;
-        }
+    void pushDivision(unsigned int pa, unsigned int pb);
 
-        if (testEdge(triangle->_e2.get()))
-        {
-            ++result;
-            OSG_NOTICE<<"testTriangle("<<triangle<<") _e2 test failed"<<std::endl;
-        }
+    osg::Geometry*                      _geometry;
 
-        if (testEdge(triangle->_e3.get()))
-        {
-            OSG_NOTICE<<"testTriangle("<<triangle<<") _e3 test failed"<<std::endl;
-            ++result;
-        }
+    ArrayList                           _attributeArrays;
+    unsigned int                        _numAttributes;
 
-        return result;
-    }
+    // per point data
+    VertexList                          _vertices;
+    FloatList                           _attributes;
+    std::vector<unsigned char>          _locked;
+    std::vector<unsigned char>          _removed;
+    IndexList                           _versions;
+    IndexList                           _firstCorner;
+    std::vector<Quadric>                _quadrics;
+    IndexList                           _marks;
 
-    unsigned int testAllTriangles()
-    {
-        unsigned int numErrors = 0;
-        for(TriangleSet::iterator itr=_triangleSet.begin();
-            itr!=_triangleSet.end();
-            ++itr)
-        {
-            numErrors += testTriangle(const_cast<Triangle*>(itr->get()));
-        }
-        return numErrors;
-    }
+    // per triangle and per corner data
+    IndexList                           _triangles;
+    std::vector<unsigned char>          _triangleRemoved;
+    IndexList                           _nextCorner;
+    unsigned int                        _numTriangles;
 
-    Edge* addEdge(Triangle* triangle, Point* p1, Point* p2)
-    {
-        // OSG_NOTICE<<"        addEdge("<<p1<<","<<p2<<")"<<std::endl;
-        osg::ref_ptr<Edge> edge = new Edge;
-        if (dereference_check_less(p1, p2))
-        {
-            edge->_p1 = p1;
-            edge->_p2 = p2;
-        }
-        else
-        {
-            edge->_p1 = p2;
-            edge->_p2 = p1;
-        }
+    std::vector<Collapse>               _collapses;
+    std::vector<Division>               _divisions;
 
-        edge->setErrorMetric( computeErrorMetric( edge.get(), edge->_proposedPoint.get()));
-
-        EdgeSet::iterator itr = _edgeSet.find(edge);
-        if (itr==_edgeSet.end())
-        {
-            // OSG_NOTICE<<"          addEdge("<<edge.get()<<") edge->_p1="<<edge->_p1.get()<<" _p2="<<edge->_p2.get()<<std::endl;
-            _edgeSet.insert(edge);
-        }
-        else
-        {
-            // OSG_NOTICE<<"          reuseEdge("<<edge.get()<<") edge->_p1="<<edge->_p1.get()<<" _p2="<<edge->_p2.get()<<std::endl;
-            edge = *itr;
-        }
-
-        edge->addTriangle(triangle);
-
-        return edge.get();
-    }
-
-    void removeEdge(Triangle* triangle, Edge* edge)
-    {
-        EdgeSet::iterator itr = _edgeSet.find(edge);
-        if (itr!=_edgeSet.end())
-        {
-            edge->_triangles.erase(triangle);
-            if (edge->_triangles.empty())
-            {
-                edge->_p1 = 0;
-                edge->_p2 = 0;
-
-                // edge no longer in use, so need to delete.
-                _edgeSet.erase(itr);
-            }
-        }
-    }
-
-    Edge* replaceEdgePoint(Edge* edge, Point* pOriginal, Point* pNew)
-    {
-        if (edge->_p1==pOriginal || edge->_p2==pOriginal)
-        {
-            EdgeSet::iterator itr = _edgeSet.find(edge);
-            if (itr!=_edgeSet.end())
-            {
-                // remove the edge from the list, as its positoin in the list
-                // may need to change once its values have been amended
-                _edgeSet.erase(itr);
-            }
-
-            // modify its values
-            if (edge->_p1==pOriginal) edge->_p1=pNew;
-            if (edge->_p2==pOriginal) edge->_p2=pNew;
-
-            if (dereference_check_less(edge->_p2,edge->_p1))
-            {
-                edge->_p1.swap(edge->_p2);
-            }
-
-            itr = _edgeSet.find(edge);
-            if (itr!=_edgeSet.end())
-            {
-                // reuse existing edge.
-                edge = const_cast<Edge*>(itr->get());
-            }
-            else
-            {
-                // put it back in.
-                _edgeSet.insert(edge);
-            }
-            return edge;
-        }
-        else
-        {
-            return edge;
-        }
-
-    }
+    unsigned int                        _markValue;
+    IndexList                           _neighbours;
+    IndexList                           _localTriangles;
+};
 
+////////////////////////////////////////////////////////////////////////////////
+//
+// Copying between the Geometry arrays and the EdgeCollapse's vertices and attributes
 
-    bool collapseEdge(Edge* edge, Point* pNew)
-    {
-        //if (edge->_triangles.size()<2) return false;
-        //if (edge->_triangles.size()>2) return false;
+class CopyVertexArrayToVerticesVisitor : public osg::ArrayVisitor
+{
+    public:
+        CopyVertexArrayToVerticesVisitor(EdgeCollapse::VertexList& vertices):
+            _vertices(vertices),
+            _copied(false) {}
 
-#ifdef ORIGIANAL_CODE
-        if (edge->getMaxNormalDeviationOnEdgeCollapse()>1.0)
-        {
-            OSG_NOTICE<<"collapseEdge("<<edge<<") refused due to edge->getMaxNormalDeviationOnEdgeCollapse() = "<<edge->getMaxNormalDeviationOnEdgeCollapse()<<std::endl;
-           return false;
-        }
-        else
+        virtual void apply(osg::Vec2Array& array)
         {
-            //OSG_NOTICE<<"collapseEdge("<<edge<<") edge->getMaxNormalDeviationOnEdgeCollapse() = "<<edge->getMaxNormalDeviationOnEdgeCollapse()<<std::endl;
+            _vertices.resize(array.size());
+            for(unsigned int i=0;i<array.size();++i) _vertices[i].set(array[i].x(),array[i].y(),0.0f);
+            _copied = true;
         }
-#endif
-
-        typedef std::set< osg::ref_ptr<Edge> > LocalEdgeList;
-
-        osg::ref_ptr<Edge> keep_edge_locally_referenced_to_prevent_premature_deletion = edge;
-        osg::ref_ptr<Point> keep_point_locally_referenced_to_prevent_premature_deletion = pNew;
-        osg::ref_ptr<Point> edge_p1 = edge->_p1;
-        osg::ref_ptr<Point> edge_p2 = edge->_p2;
-
-        TriangleList triangles_p1;
-        TriangleList triangles_p2;
-        LocalEdgeList oldEdges;
 
-
-        if (edge_p1 != pNew)
+        virtual void apply(osg::Vec3Array& array)
         {
-            for(TriangleSet::iterator itr=edge_p1->_triangles.begin();
-                itr!=edge_p1->_triangles.end();
-                ++itr)
-            {
-                if (edge->_triangles.count(*itr)==0)
-                {
-                    Triangle* triangle = const_cast<Triangle*>(itr->get());
-                    triangles_p1.push_back(triangle);
-                    oldEdges.insert(triangle->_e1);
-                    oldEdges.insert(triangle->_e2);
-                    oldEdges.insert(triangle->_e3);
-                }
-            }
-
-            //triangles_p1 = edge_p1->_triangles;
+            _vertices.assign(array.begin(), array.end());
+            _copied = true;
         }
 
-        if (edge_p2 != pNew)
+        virtual void apply(osg::Vec4Array& array)
         {
-            for(TriangleSet::iterator itr=edge_p2->_triangles.begin();
-                itr!=edge_p2->_triangles.end();
-                ++itr)
+            _vertices.resize(array.size());
+            for(unsigned int i=0;i<array.size();++i)
             {
-                if (edge->_triangles.count(*itr)==0)
-                {
-                    Triangle* triangle = const_cast<Triangle*>(itr->get());
-                    triangles_p2.push_back(triangle);
-                    oldEdges.insert(triangle->_e1);
-                    oldEdges.insert(triangle->_e2);
-                    oldEdges.insert(triangle->_e3);
-                }
+                const osg::Vec4& value = array[i];
+                _vertices[i].set(value.x()/value.w(),value.y()/value.w(),value.z()/value.w());
             }
-            //triangles_p2 = edge_p2->_triangles;
+            _copied = true;
         }
 
-        for(LocalEdgeList::iterator oeitr=oldEdges.begin();
-            oeitr!=oldEdges.end();
-            ++oeitr)
-        {
-            _edgeSet.erase(*oeitr);
-
-            const_cast<Edge*>(oeitr->get())->setErrorMetric(0.0f);
-
-            _edgeSet.insert(*oeitr);
-        }
+        EdgeCollapse::VertexList&   _vertices;
+        bool                        _copied;
 
-        TriangleList::iterator titr_p1, titr_p2;
-
-        for(titr_p1 = triangles_p1.begin();
-            titr_p1 != triangles_p1.end();
-            ++titr_p1)
-        {
-            removeTriangle(const_cast<Triangle*>(titr_p1->get()));
-        }
-
-        for(titr_p2 = triangles_p2.begin();
-            titr_p2 != triangles_p2.end();
-            ++titr_p2)
-        {
-            removeTriangle(const_cast<Triangle*>(titr_p2->get()));
-        }
-
-        //OSG_NOTICE<<"  pNew="<<pNew<<"\tedge_p1"<<edge_p1.get()<<"\tedge_p2"<<edge_p2.get()<<std::endl;
-
-        // we copy the edge's _triangles and interate the copy of the triangle set to avoid invalidating iterators.
-        TriangleSet trianglesToRemove = edge->_triangles;
-        for(TriangleSet::iterator teitr=trianglesToRemove.begin();
-            teitr!=trianglesToRemove.end();
-            ++teitr)
-        {
-            Triangle* triangle = const_cast<Triangle*>(teitr->get());
-            removeTriangle(triangle);
-        }
+    protected:
 
-        LocalEdgeList newEdges;
+        CopyVertexArrayToVerticesVisitor& operator = (const CopyVertexArrayToVerticesVisitor&) { return *this; }
+};
 
+class CopyVerticesToVertexArrayVisitor : public osg::ArrayVisitor
+{
+    public:
+        CopyVerticesToVertexArrayVisitor(const EdgeCollapse::VertexList& vertices, const EdgeCollapse::IndexList& order):
+            _vertices(vertices),
+            _order(order) {}
 
-        for(titr_p1 = triangles_p1.begin();
-            titr_p1 != triangles_p1.end();
-            ++titr_p1)
+        virtual void apply(osg::Vec2Array& array)
         {
-            Triangle* triangle = const_cast<Triangle*>(titr_p1->get());
-
-            Point* p1 = (triangle->_p1==edge_p1 || triangle->_p1==edge_p2)? pNew : triangle->_p1.get();
-            Point* p2 = (triangle->_p2==edge_p1 || triangle->_p2==edge_p2)? pNew : triangle->_p2.get();
-            Point* p3 = (triangle->_p3==edge_p1 || triangle->_p3==edge_p2)? pNew : triangle->_p3.get();
-
-            Triangle* newTri = addTriangle(p1,p2,p3);
-
-            if (newTri)
+            array.resize(_order.size());
+            for(unsigned int i=0;i<_order.size();++i)
             {
-                newEdges.insert(newTri->_e1);
-                newEdges.insert(newTri->_e2);
-                newEdges.insert(newTri->_e3);
+                const osg::Vec3& vertex = _vertices[_order[i]];
+                array[i].set(vertex.x(),vertex.y());
             }
         }
 
-
-        for(titr_p2 = triangles_p2.begin();
-            titr_p2 != triangles_p2.end();
-            ++titr_p2)
+        virtual void apply(osg::Vec3Array& array)
         {
-            Triangle* triangle = const_cast<Triangle*>(titr_p2->get());
-
-            Point* p1 = (triangle->_p1==edge_p1 || triangle->_p1==edge_p2)? pNew : triangle->_p1.get();
-            Point* p2 = (triangle->_p2==edge_p1 || triangle->_p2==edge_p2)? pNew : triangle->_p2.get();
-            Point* p3 = (triangle->_p3==edge_p1 || triangle->_p3==edge_p2)? pNew : triangle->_p3.get();
-
-            Triangle* newTri = addTriangle(p1,p2,p3);
-
-            if (newTri)
-            {
-                newEdges.insert(newTri->_e1);
-                newEdges.insert(newTri->_e2);
-                newEdges.insert(newTri->_e3);
-            }
+            array.resize(_order.size());
+            for(unsigned int i=0;i<_order.size();++i) array[i] = _vertices[_order[i]];
         }
 
-        LocalEdgeList edges2UpdateErrorMetric;
-
-        LocalEdgeList::const_iterator newEdgeIt(newEdges.begin());
-        while (newEdgeIt != newEdges.end())
+        virtual void apply(osg::Vec4Array& array)
         {
-            const Point* p = 0;
-            if (newEdgeIt->get()->_p1.get() != pNew)
-                p = newEdgeIt->get()->_p1.get();
-            else
-                p = newEdgeIt->get()->_p2.get();
-
-            TriangleSet::const_iterator triangleIt(p->_triangles.begin());
-            while (triangleIt != p->_triangles.end())
+            array.resize(_order.size());
+            for(unsigned int i=0;i<_order.size();++i)
             {
-                const Triangle* triangle = triangleIt->get();
-                if (triangle->_e1->_p1 == p || triangle->_e1->_p2 == p)
-                    edges2UpdateErrorMetric.insert(triangle->_e1);
-                if (triangle->_e2->_p1 == p || triangle->_e2->_p2 == p)
-                    edges2UpdateErrorMetric.insert(triangle->_e2);
-                if (triangle->_e3->_p1 == p || triangle->_e3->_p2 == p)
-                    edges2UpdateErrorMetric.insert(triangle->_e3);
-
-                ++triangleIt;
+                const osg::Vec3& vertex = _vertices[_order[i]];
+                array[i].set(vertex.x(),vertex.y(),vertex.z(),1.0f);
             }
-
-            ++newEdgeIt;
-        }
-
-        edges2UpdateErrorMetric.insert(newEdges.begin(), newEdges.end());
-
-        // OSG_NOTICE<<"Edges to recalibarate "<<edges2UpdateErrorMetric.size()<<std::endl;
-
-        for(LocalEdgeList::iterator itr=edges2UpdateErrorMetric.begin();
-            itr!=edges2UpdateErrorMetric.end();
-            ++itr)
-        {
-            //OSG_NOTICE<<"updateErrorMetricForEdge("<<itr->get()<<")"<<std::endl;
-            updateErrorMetricForEdge(const_cast<Edge*>(itr->get()));
         }
 
-        return true;
-    }
-
-
-    bool divideEdge(Edge* edge, Point* pNew)
-    {
-         // OSG_NOTICE<<"divideEdge("<<edge<<") before _edgeSet.size()="<<_edgeSet.size()<<" _triangleSet.size()="<<_triangleSet.size()<<std::endl;
-
-        // first collect the triangles associaged with edges that need deleting
-        osg::ref_ptr<Edge> keep_edge_locally_referenced_to_prevent_premature_deletion = edge;
-        TriangleSet triangles = edge->_triangles;
-
-        // OSG_NOTICE<<"   numTriangles on edges "<<triangles.size()<<std::endl;
-
-        // unsigned int numTriangles1 = _triangleSet.size();
-        // unsigned int numBoundaryEdges1 = computeNumBoundaryEdges();
-        // unsigned int numEdges1 = _edgeSet.size();
-
-        typedef std::set< osg::ref_ptr<Edge> > LocalEdgeList;
-        LocalEdgeList edges2UpdateErrorMetric;
-        TriangleSet::iterator titr;
-
-
-        // for each deleted triangle insert two new triangles
-        for(titr = triangles.begin();
-            titr != triangles.end();
-            ++titr)
-        {
-            Triangle* tri = const_cast<Triangle*>(titr->get());
-            int edgeToReplace = 0;
-            if (edge->_p1 == tri->_p1)
-            {
-                if (edge->_p2 == tri->_p2.get()) edgeToReplace = 1; // edge p1,p2
-                else if (edge->_p2 == tri->_p3.get()) edgeToReplace = 3; // edge p3, p1
-            }
-            else if (edge->_p1 == tri->_p2.get())
-            {
-                if (edge->_p2 == tri->_p3.get()) edgeToReplace = 2; // edge p2,p3
-                else if (edge->_p2 == tri->_p1.get()) edgeToReplace = 1; // edge p1, p2
-            }
-            else if (edge->_p1 == tri->_p3.get())
-            {
-                if (edge->_p2 == tri->_p1.get()) edgeToReplace = 3; // edge p3,p1
-                else if (edge->_p2 == tri->_p2.get()) edgeToReplace = 2; // edge p2, p3
-            }
-
-            Triangle* newTri1 = 0;
-            Triangle* newTri2 = 0;
-            switch(edgeToReplace)
-            {
-                case(0): // error, shouldn't get here.
-                    OSG_NOTICE<<"Error EdgeCollapse::divideEdge(Edge*,Point*) passed invalid edge."<<std::endl;
-                    return false;
-                case(1): // p1, p2
-                    // OSG_NOTICE<<"   // p1, p2 "<<std::endl;
-                    // OSG_NOTICE<<"   newTri1 = addTriangle(tri->_p1.get(), pNew, tri->_p3.get());"<<std::endl;
-                    newTri1 = addTriangle(tri->_p1.get(), pNew, tri->_p3.get());
-                    // OSG_NOTICE<<"   newTri2 = addTriangle(pNew, tri->_p2.get(), tri->_p3.get());"<<std::endl;
-                    newTri2 = addTriangle(pNew, tri->_p2.get(), tri->_p3.get());
-                    break;
-                case(2): // p2, p3
-                    // OSG_NOTICE<<"   // p2, p3"<<std::endl;
-                    // OSG_NOTICE<<"   newTri1 = addTriangle(tri->_p1.get(), tri->_p2.get(), pNew);"<<std::endl;
-                    newTri1 = addTriangle(tri->_p1.get(), tri->_p2.get(), pNew);
-                    //OSG_NOTICE<<"   newTri2 = addTriangle(tri->_p1.get(), pNew, tri->_p3.get());"<<std::endl;
-                    newTri2 = addTriangle(tri->_p1.get(), pNew, tri->_p3.get());
-                    break;
-                case(3): // p3, p1
-                    // OSG_NOTICE<<"   // p3, p1"<<std::endl;
-                    // OSG_NOTICE<<"   newTri1 = addTriangle(tri->_p1.get(), tri->_p2.get(), pNew);"<<std::endl;
-                    newTri1 = addTriangle(tri->_p1.get(), tri->_p2.get(), pNew);
-                    // OSG_NOTICE<<"   newTri2 = addTriangle(pNew, tri->_p2.get(), tri->_p3.get());"<<std::endl;
-                    newTri2 = addTriangle(pNew, tri->_p2.get(), tri->_p3.get());
-                    break;
-            }
+        const EdgeCollapse::VertexList& _vertices;
+        const EdgeCollapse::IndexList&  _order;
 
-            if (newTri1)
-            {
-                edges2UpdateErrorMetric.insert(newTri1->_e1.get());
-                edges2UpdateErrorMetric.insert(newTri1->_e2.get());
-                edges2UpdateErrorMetric.insert(newTri1->_e3.get());
-            }
-            if (newTri2)
-            {
-                edges2UpdateErrorMetric.insert(newTri2->_e1.get());
-                edges2UpdateErrorMetric.insert(newTri2->_e2.get());
-                edges2UpdateErrorMetric.insert(newTri2->_e3.get());
-            }
-        }
+    protected:
 
-        // unsigned int numTriangles2 = _triangleSet.size();
-        // unsigned int numEdges2 = _edgeSet.size();
-        // unsigned int numBoundaryEdges2 = computeNumBoundaryEdges();
+        CopyVerticesToVertexArrayVisitor& operator = (const CopyVerticesToVertexArrayVisitor&) { return *this; }
+};
 
-        // remove all the triangles associated with edge
-        for(titr = triangles.begin();
-            titr != triangles.end();
-            ++titr)
-        {
-            removeTriangle(const_cast<Triangle*>(titr->get()));
-        }
+// Interleaves each per vertex array into the attribute list, _offset is advanced past the components copied.
+class CopyArrayToAttributesVisitor : public osg::ArrayVisitor
+{
+    public:
+        CopyArrayToAttributesVisitor(EdgeCollapse::FloatList& attributes, unsigned int stride):
+            _attributes(attributes),
+            _stride(stride),
+            _offset(0) {}
 
-        for(LocalEdgeList::iterator itr=edges2UpdateErrorMetric.begin();
-            itr!=edges2UpdateErrorMetric.end();
-            ++itr)
+        template<class A>
+        void copyScalars(const A& array)
         {
-            //OSG_NOTICE<<"updateErrorMetricForEdge("<<itr->get()<<")"<<std::endl;
-            if (itr->valid()) updateErrorMetricForEdge(const_cast<Edge*>(itr->get()));
+            for(unsigned int i=0;i<array.size();++i) _attributes[i*_stride+_offset] = (float)array[i];
+            _offset += 1;
         }
 
-        // unsigned int numBoundaryEdges3 = computeNumBoundaryEdges();
-        // unsigned int numEdges3 = _edgeSet.size();
-        // unsigned int numTriangles3 = _triangleSet.size();
-
-        // OSG_NOTICE<<"   numTriangles1="<<numTriangles1<<"   numTriangles2="<<numTriangles2<<"   numTriangles3="<<numTriangles3<<std::endl;
-        // OSG_NOTICE<<"   numEdges1="<<numEdges1<<"   numEdges2="<<numEdges2<<"   numEdges3="<<numEdges3<<std::endl;
-        // OSG_NOTICE<<"   numBoundaryEdges1="<<numBoundaryEdges1<<"   numBoundaryEdges2="<<numBoundaryEdges2<<"   numBoundaryEdges3="<<numBoundaryEdges3<<std::endl;
-        // OSG_NOTICE<<"divideEdge("<<edge<<") after _edgeSet.size()="<<_edgeSet.size()<<" _triangleSet.size()="<<_triangleSet.size()<<std::endl;
-
-        return true;
-    }
-
-    unsigned int testEdge(Edge* edge)
-    {
-        unsigned int numErrors = 0;
-        for(TriangleSet::iterator teitr=edge->_triangles.begin();
-            teitr!=edge->_triangles.end();
-            ++teitr)
+        template<class A>
+        void copyVectors(const A& array)
         {
-            Triangle* triangle = const_cast<Triangle*>(teitr->get());
-            if (!(triangle->_e1 == edge || triangle->_e2 == edge || triangle->_e3 == edge))
+            const unsigned int numComponents = A::ElementDataType::num_components;
+            for(unsigned int i=0;i<array.size();++i)
             {
-                OSG_NOTICE<<"testEdge("<<edge<<"). triangle != point back to this edge"<<std::endl;
-                OSG_NOTICE<<"                     triangle->_e1=="<<triangle->_e1.get()<<std::endl;
-                OSG_NOTICE<<"                     triangle->_e2=="<<triangle->_e2.get()<<std::endl;
-                OSG_NOTICE<<"                     triangle->_e3=="<<triangle->_e3.get()<<std::endl;
-                ++numErrors;
+                float* attributes = &_attributes[i*_stride+_offset];
+                for(unsigned int c=0;c<numComponents;++c) attributes[c] = (float)array[i][c];
             }
+            _offset += numComponents;
         }
 
-        if (edge->_triangles.empty())
-        {
-            OSG_NOTICE<<"testEdge("<<edge<<")._triangles is empty"<<std::endl;
-            ++numErrors;
-        }
-        return numErrors;
-    }
-
-    unsigned int testAllEdges()
-    {
-        unsigned int numErrors = 0;
-        for(EdgeSet::iterator itr = _edgeSet.begin();
-            itr!=_edgeSet.end();
-            ++itr)
-        {
-            numErrors += testEdge(const_cast<Edge*>(itr->get()));
-        }
-        return numErrors;
-    }
-
-    unsigned int computeNumBoundaryEdges()
-    {
-        unsigned int numBoundaryEdges = 0;
-        for(EdgeSet::iterator itr = _edgeSet.begin();
-            itr!=_edgeSet.end();
-            ++itr)
-        {
-            if ((*itr)->isBoundaryEdge()) ++numBoundaryEdges;
-        }
-        return numBoundaryEdges;
-    }
-
-
-    Point* addPoint(Triangle* triangle, unsigned int p1)
-    {
-        return addPoint(triangle,_originalPointList[p1].get());
-    }
-
-    Point* addPoint(Triangle* triangle, Point* point)
-    {
+        virtual void apply(osg::Array&) {}
+        virtual void apply(osg::ByteArray& array) { copyScalars(array); }
+        virtual void apply(osg::ShortArray& array) { copyScalars(array); }
+        virtual void apply(osg::IntArray& array) { copyScalars(array); }
+        virtual void apply(osg::UByteArray& array) { copyScalars(array); }
+        virtual void apply(osg::UShortArray& array) { copyScalars(array); }
+        virtual void apply(osg::UIntArray& array) { copyScalars(array); }
+        virtual void apply(osg::FloatArray& array) { copyScalars(array); }
+        virtual void apply(osg::Vec4ubArray& array) { copyVectors(array); }
+        virtual void apply(osg::Vec2Array& array) { copyVectors(array); }
+        virtual void apply(osg::Vec3Array& array) { copyVectors(array); }
+        virtual void apply(osg::Vec4Array& array) { copyVectors(array); }
+
+        EdgeCollapse::FloatList&    _attributes;
+        unsigned int                _stride;
+        unsigned int                _offset;
 
-        PointSet::iterator itr = _pointSet.find(point);
-        if (itr==_pointSet.end())
-        {
-            //OSG_NOTICE<<"  addPoint("<<point.get()<<")"<<std::endl;
-            _pointSet.insert(point);
-        }
-        else
-        {
-            point = const_cast<Point*>(itr->get());
-            //OSG_NOTICE<<"  reusePoint("<<point.get()<<")"<<std::endl;
-        }
+    protected:
 
-        point->_triangles.insert(triangle);
+        CopyArrayToAttributesVisitor& operator = (const CopyArrayToAttributesVisitor&) { return *this; }
+};
 
-        return point;
-    }
+class CopyAttributesToArrayVisitor : public osg::ArrayVisitor
+{
+    public:
+        CopyAttributesToArrayVisitor(const EdgeCollapse::FloatList& attributes, unsigned int stride, const EdgeCollapse::IndexList& order):
+            _attributes(attributes),
+            _stride(stride),
+            _order(order),
+            _offset(0) {}
 
-    void removePoint(Triangle* triangle, Point* point)
-    {
-        PointSet::iterator itr = _pointSet.find(point);
-        if (itr!=_pointSet.end())
+        template<class A, typename R>
+        void copyScalars(A& array, R /*dummy*/)
         {
-            point->_triangles.erase(triangle);
-
-            if (point->_triangles.empty())
-            {
-                // point no longer in use, so need to delete.
-                _pointSet.erase(itr);
-            }
+            array.resize(_order.size());
+            for(unsigned int i=0;i<_order.size();++i) array[i] = R(_attributes[_order[i]*_stride+_offset]);
+            _offset += 1;
         }
 
-    }
-
-    unsigned int testPoint(Point* point)
-    {
-        unsigned int numErrors = 0;
-
-        for(TriangleSet::iterator itr=point->_triangles.begin();
-            itr!=point->_triangles.end();
-            ++itr)
+        template<class A>
+        void copyVectors(A& array)
         {
-            Triangle* triangle = const_cast<Triangle*>(itr->get());
-            if (!(triangle->_p1 == point || triangle->_p2 == point || triangle->_p3 == point))
+            typedef typename A::ElementDataType::value_type value_type;
+            const unsigned int numComponents = A::ElementDataType::num_components;
+            array.resize(_order.size());
+            for(unsigned int i=0;i<_order.size();++i)
             {
-                OSG_NOTICE<<"testPoint("<<point<<") error, triangle "<<triangle<<" does not point back to this point"<<std::endl;
-                OSG_NOTICE<<"             triangle->_p1 "<<triangle->_p1.get()<<std::endl;
-                OSG_NOTICE<<"             triangle->_p2 "<<triangle->_p2.get()<<std::endl;
-                OSG_NOTICE<<"             triangle->_p3 "<<triangle->_p3.get()<<std::endl;
-                ++numErrors;
+                const float* attributes = &_attributes[_order[i]*_stride+_offset];
+                for(unsigned int c=0;c<numComponents;++c) array[i][c] = value_type(attributes[c]);
             }
+            _offset += numComponents;
         }
 
-        return numErrors;
-    }
-
-    unsigned int testAllPoints()
-    {
-        unsigned int numErrors = 0;
-        for(PointSet::iterator itr = _pointSet.begin();
-            itr!=_pointSet.end();
-            ++itr)
-        {
-            numErrors += testPoint(const_cast<Point*>(itr->get()));
-        }
-        return numErrors;
-    }
-
-//protected:
-
-    typedef std::vector< osg::ref_ptr<osg::Array> > ArrayList;
-
-    osg::Geometry*                  _geometry;
-
-    bool                            _computeErrorMetricUsingLength;
-    EdgeSet                         _edgeSet;
-    TriangleSet                     _triangleSet;
-    PointSet                        _pointSet;
-    PointList                       _originalPointList;
-
-};
-
-struct CollectTriangleOperator
-{
-
-    CollectTriangleOperator():_ec(0) {}
-
-    void setEdgeCollapse(EdgeCollapse* ec) { _ec = ec; }
+        // use local typedefs if usinged char,short and int to get round gcc 3.3.1 problem with defining unsigned short()
+        typedef unsigned char dummy_uchar;
+        typedef unsigned short dummy_ushort;
+        typedef unsigned int dummy_uint;
 
-    EdgeCollapse* _ec;
+        virtual void apply(osg::Array&) {}
+        virtual void apply(osg::ByteArray& array) { copyScalars(array, char()); }
+        virtual void apply(osg::ShortArray& array) { copyScalars(array, short()); }
+        virtual void apply(osg::IntArray& array) { copyScalars(array, int()); }
+        virtual void apply(osg::UByteArray& array) { copyScalars(array, dummy_uchar()); }
+        virtual void apply(osg::UShortArray& array) { copyScalars(array, dummy_ushort()); }
+        virtual void apply(osg::UIntArray& array) { copyScalars(array, dummy_uint()); }
+        virtual void apply(osg::FloatArray& array) { copyScalars(array, float()); }
+        virtual void apply(osg::Vec4ubArray& array) { copyVectors(array); }
+        virtual void apply(osg::Vec2Array& array) { copyVectors(array); }
+        virtual void apply(osg::Vec3Array& array) { copyVectors(array); }
+        virtual void apply(osg::Vec4Array& array) { copyVectors(array); }
+
+        const EdgeCollapse::FloatList&  _attributes;
+        unsigned int                    _stride;
+        const EdgeCollapse::IndexList&  _order;
+        unsigned int                    _offset;
 
-    // for use  in the triangle functor.
-    inline void operator()(unsigned int p1, unsigned int p2, unsigned int p3)
-    {
-        _ec->addTriangle(p1,p2,p3);
-    }
+    protected:
 
+        CopyAttributesToArrayVisitor& operator = (const CopyAttributesToArrayVisitor&) { return *this; }
 };
 
-EdgeCollapse::~EdgeCollapse()
-{
-    std::for_each(_edgeSet.begin(),_edgeSet.end(),dereference_clear());
-
-    std::for_each(_triangleSet.begin(),_triangleSet.end(),dereference_clear());
-    std::for_each(_pointSet.begin(),_pointSet.end(),dereference_clear());
-    std::for_each(_originalPointList.begin(),_originalPointList.end(),dereference_clear());
-}
-
-
-typedef osg::TriangleIndexFunctor<CollectTriangleOperator> CollectTriangleIndexFunctor;
-
-class CopyArrayToPointsVisitor : public osg::ArrayVisitor
+class NormalizeArrayVisitor : public osg::ArrayVisitor
 {
     public:
-        CopyArrayToPointsVisitor(EdgeCollapse::PointList& pointList):
-            _pointList(pointList) {}
-
-        template<class T>
-        void copy(T& array)
-        {
-            if (_pointList.size()!=array.size()) return;
-
-            for(unsigned int i=0;i<_pointList.size();++i)
-                _pointList[i]->_attributes.push_back((float)array[i]);
-        }
-
-        virtual void apply(osg::Array&) {}
-        virtual void apply(osg::ByteArray& array) { copy(array); }
-        virtual void apply(osg::ShortArray& array) { copy(array); }
-        virtual void apply(osg::IntArray& array) { copy(array); }
-        virtual void apply(osg::UByteArray& array) { copy(array); }
-        virtual void apply(osg::UShortArray& array) { copy(array); }
-        virtual void apply(osg::UIntArray& array) { copy(array); }
-        virtual void apply(osg::FloatArray& array) { copy(array); }
-
-        virtual void apply(osg::Vec4ubArray& array)
-        {
-            if (_pointList.size()!=array.size()) return;
-
-            for(unsigned int i=0;i<_pointList.size();++i)
-            {
-                osg::Vec4ub& value = array[i];
-                EdgeCollapse::FloatList& attributes = _pointList[i]->_attributes;
-                attributes.push_back((float)value.r());
-                attributes.push_back((float)value.g());
-                attributes.push_back((float)value.b());
-                attributes.push_back((float)value.a());
-            }
-        }
-
-        virtual void apply(osg::Vec2Array& array)
-        {
-            if (_pointList.size()!=array.size()) return;
-
-            for(unsigned int i=0;i<_pointList.size();++i)
-            {
-                osg::Vec2& value = array[i];
-                EdgeCollapse::FloatList& attributes = _pointList[i]->_attributes;
-                attributes.push_back(value.x());
-                attributes.push_back(value.y());
-            }
-        }
-
-        virtual void apply(osg::Vec3Array& array)
-        {
-            if (_pointList.size()!=array.size()) return;
-
-            for(unsigned int i=0;i<_pointList.size();++i)
-            {
-                osg::Vec3& value = array[i];
-                EdgeCollapse::FloatList& attributes = _pointList[i]->_attributes;
-                attributes.push_back(value.x());
-                attributes.push_back(value.y());
-                attributes.push_back(value.z());
-            }
-        }
+        NormalizeArrayVisitor() {}
 
-        virtual void apply(osg::Vec4Array& array)
+        template<typename Itr>
+        void normalize(Itr begin, Itr end)
         {
-            if (_pointList.size()!=array.size()) return;
-
-            for(unsigned int i=0;i<_pointList.size();++i)
+            for(Itr itr = begin;
+                itr != end;
+                ++itr)
             {
-                osg::Vec4& value = array[i];
-                EdgeCollapse::FloatList& attributes = _pointList[i]->_attributes;
-                attributes.push_back(value.x());
-                attributes.push_back(value.y());
-                attributes.push_back(value.z());
-                attributes.push_back(value.w());
+                itr->normalize();
             }
         }
 
-        EdgeCollapse::PointList& _pointList;
-
-
-    protected:
+        virtual void apply(osg::Vec2Array& array) { normalize(array.begin(),array.end()); }
+        virtual void apply(osg::Vec3Array& array) { normalize(array.begin(),array.end()); }
+        virtual void apply(osg::Vec4Array& array) { normalize(array.begin(),array.end()); }
 
-        CopyArrayToPointsVisitor& operator = (const CopyArrayToPointsVisitor&) { return *this; }
 };
 
-class CopyVertexArrayToPointsVisitor : public osg::ArrayVisitor
+static unsigned int getNumAttributeComponents(const osg::Array* array)
 {
-    public:
-        CopyVertexArrayToPointsVisitor(EdgeCollapse::PointList& pointList):
-            _pointList(pointList) {}
-
-        virtual void apply(osg::Vec2Array& array)
-        {
-            if (_pointList.size()!=array.size()) return;
+    switch(array->getType())
+    {
+        case(osg::Array::ByteArrayType):
+        case(osg::Array::ShortArrayType):
+        case(osg::Array::IntArrayType):
+        case(osg::Array::UByteArrayType):
+        case(osg::Array::UShortArrayType):
+        case(osg::Array::UIntArrayType):
+        case(osg::Array::FloatArrayType):
+            return 1;
+        case(osg::Array::Vec2ArrayType):
+            return 2;
+        case(osg::Array::Vec3ArrayType):
+            return 3;
+        case(osg::Array::Vec4ArrayType):
+        case(osg::Array::Vec4ubArrayType):
+            return 4;
+        default:
+            return 0;
+    }
+}
 
-            for(unsigned int i=0;i<_pointList.size();++i)
-            {
-                _pointList[i] = new EdgeCollapse::Point;
-                _pointList[i]->_index = i;
+struct WeldLess
+{
+    WeldLess(const EdgeCollapse::VertexList& vertices, const EdgeCollapse::FloatList& attributes, unsigned int numAttributes):
+        _vertices(vertices),
+        _attributes(attributes),
+        _numAttributes(numAttributes) {}
 
-                osg::Vec2& value = array[i];
-                osg::Vec3& vertex = _pointList[i]->_vertex;
-                vertex.set(value.x(),value.y(),0.0f);
-            }
-        }
+    inline bool operator() (unsigned int lhs, unsigned int rhs) const
+    {
+        if (_vertices[lhs] < _vertices[rhs]) return true;
+        if (_vertices[rhs] < _vertices[lhs]) return false;
 
-        virtual void apply(osg::Vec3Array& array)
+        const float* lhs_attributes = _numAttributes ? &_attributes[lhs*_numAttributes] : 0;
+        const float* rhs_attributes = _numAttributes ? &_attributes[rhs*_numAttributes] : 0;
+        for(unsigned int i=0;i<_numAttributes;++i)
         {
-            if (_pointList.size()!=array.size()) return;
-
-            for(unsigned int i=0;i<_pointList.size();++i)
-            {
-                _pointList[i] = new EdgeCollapse::Point;
-                _pointList[i]->_index = i;
-
-                _pointList[i]->_vertex = array[i];
-            }
+            if (lhs_attributes[i] < rhs_attributes[i]) return true;
+            if (rhs_attributes[i] < lhs_attributes[i]) return false;
         }
+        return false;
+    }
 
-        virtual void apply(osg::Vec4Array& array)
-        {
-            if (_pointList.size()!=array.size()) return;
-
-            for(unsigned int i=0;i<_pointList.size();++i)
-            {
-                _pointList[i] = new EdgeCollapse::Point;
-                _pointList[i]->_index = i;
+    const EdgeCollapse::VertexList& _vertices;
+    const EdgeCollapse::FloatList&  _attributes;
+    unsigned int                    _numAttributes;
+};
 
-                osg::Vec4& value = array[i];
-                osg::Vec3& vertex = _pointList[i]->_vertex;
-                vertex.set(value.x()/value.w(),value.y()/value.w(),value.z()/value.w());
-            }
-        }
+struct CollectTriangleOperator
+{
+    CollectTriangleOperator():_weldedIndices(0),_triangles(0) {}
 
-        EdgeCollapse::PointList& _pointList;
+    const EdgeCollapse::IndexList*  _weldedIndices;
+    EdgeCollapse::IndexList*        _triangles;
 
-    protected:
+    // for use  in the triangle functor.
+    inline void operator()(unsigned int p1, unsigned int p2, unsigned int p3)
+    {
+        unsigned int w1 = (*_weldedIndices)[p1];
+        unsigned int w2 = (*_weldedIndices)[p2];
+        unsigned int w3 = (*_weldedIndices)[p3];
 
-        CopyVertexArrayToPointsVisitor& operator = (const CopyVertexArrayToPointsVisitor&) { return *this; }
+        // discard triangles made degenerate by welding
+        if (w1==w2 || w2==w3 || w3==w1) return;
 
+        _triangles->push_back(w1);
+        _triangles->push_back(w2);
+        _triangles->push_back(w3);
+    }
 };
 
-void EdgeCollapse::setGeometry(osg::Geometry* geometry, const Simplifier::IndexList& protectedPoints)
+typedef osg::TriangleIndexFunctor<CollectTriangleOperator> CollectTriangleIndexFunctor;
+
+////////////////////////////////////////////////////////////////////////////////
+//
+// EdgeCollapse implementation
+
+bool EdgeCollapse::setGeometry(osg::Geometry* geometry, const Simplifier::IndexList& protectedPoints)
 {
     _geometry = geometry;
 
+    if (!_geometry->getVertexArray() || _geometry->getVertexArray()->getNumElements()==0) return false;
+
     // check to see if vertex attributes indices exists, if so expand them to remove them
     if (_geometry->containsSharedArrays())
     {
@@ -1426,296 +519,640 @@ void EdgeCollapse::setGeometry(osg::Geometry* geometry, const Simplifier::IndexL
         _geometry->duplicateSharedArrays();
     }
 
-    unsigned int numVertices = geometry->getVertexArray()->getNumElements();
-
-    _originalPointList.resize(numVertices);
+    unsigned int numVertices = _geometry->getVertexArray()->getNumElements();
 
-    // copy vertices across to local point list
-    CopyVertexArrayToPointsVisitor copyVertexArrayToPoints(_originalPointList);
-    _geometry->getVertexArray()->accept(copyVertexArrayToPoints);
-
-    // copy other per vertex attributes across to local point list.
-    CopyArrayToPointsVisitor        copyArrayToPoints(_originalPointList);
+    // copy vertices across to local vertex list
+    VertexList vertices;
+    CopyVertexArrayToVerticesVisitor copyVertexArrayToVertices(vertices);
+    _geometry->getVertexArray()->accept(copyVertexArrayToVertices);
+    if (!copyVertexArrayToVertices._copied) return false;
 
+    // find the per vertex attributes that are to be interpolated
+    ArrayList arrays;
     for(unsigned int ti=0;ti<_geometry->getNumTexCoordArrays();++ti)
     {
         if (_geometry->getTexCoordArray(ti))
-            geometry->getTexCoordArray(ti)->accept(copyArrayToPoints);
+            arrays.push_back(_geometry->getTexCoordArray(ti));
     }
 
     if (_geometry->getNormalArray() && _geometry->getNormalArray()->getBinding()==osg::Array::BIND_PER_VERTEX)
-        geometry->getNormalArray()->accept(copyArrayToPoints);
+        arrays.push_back(_geometry->getNormalArray());
 
     if (_geometry->getColorArray() && _geometry->getColorArray()->getBinding()==osg::Array::BIND_PER_VERTEX)
-        geometry->getColorArray()->accept(copyArrayToPoints);
+        arrays.push_back(_geometry->getColorArray());
 
     if (_geometry->getSecondaryColorArray() && _geometry->getSecondaryColorArray()->getBinding()==osg::Array::BIND_PER_VERTEX)
-        geometry->getSecondaryColorArray()->accept(copyArrayToPoints);
+        arrays.push_back(_geometry->getSecondaryColorArray());
 
     if (_geometry->getFogCoordArray() && _geometry->getFogCoordArray()->getBinding()==osg::Array::BIND_PER_VERTEX)
-        geometry->getFogCoordArray()->accept(copyArrayToPoints);
+        arrays.push_back(_geometry->getFogCoordArray());
 
     for(unsigned int vi=0;vi<_geometry->getNumVertexAttribArrays();++vi)
     {
         if (_geometry->getVertexAttribArray(vi) &&  _geometry->getVertexAttribArray(vi)->getBinding()==osg::Array::BIND_PER_VERTEX)
-            geometry->getVertexAttribArray(vi)->accept(copyArrayToPoints);
+            arrays.push_back(_geometry->getVertexAttribArray(vi));
+    }
+
+    _attributeArrays.clear();
+    _numAttributes = 0;
+    for(ArrayList::iterator itr = arrays.begin();
+        itr != arrays.end();
+        ++itr)
+    {
+        unsigned int numComponents = getNumAttributeComponents(*itr);
+        if (numComponents>0 && (*itr)->getNumElements()==numVertices)
+        {
+            _attributeArrays.push_back(*itr);
+            _numAttributes += numComponents;
+        }
+    }
+
+    FloatList attributes(numVertices*_numAttributes);
+    CopyArrayToAttributesVisitor copyArrayToAttributes(attributes, _numAttributes);
+    for(ArrayList::iterator itr = _attributeArrays.begin();
+        itr != _attributeArrays.end();
+        ++itr)
+    {
+        (*itr)->accept(copyArrayToAttributes);
+    }
+
+    // weld together the vertices that match in position and all attributes.
+    IndexList sortedIndices(numVertices);
+    for(unsigned int i=0;i<numVertices;++i) sortedIndices[i] = i;
+
+    WeldLess weldLess(vertices, attributes, _numAttributes);
+    std::sort(sortedIndices.begin(), sortedIndices.end(), weldLess);
+
+    IndexList weldedIndices(numVertices);
+    _vertices.clear();
+    _vertices.reserve(numVertices);
+    _attributes.clear();
+    _attributes.reserve(numVertices*_numAttributes);
+    for(unsigned int i=0;i<numVertices;++i)
+    {
+        unsigned int vi = sortedIndices[i];
+        if (i==0 || weldLess(sortedIndices[i-1], vi))
+        {
+            _vertices.push_back(vertices[vi]);
+            if (_numAttributes) _attributes.insert(_attributes.end(), attributes.begin()+vi*_numAttributes, attributes.begin()+(vi+1)*_numAttributes);
+        }
+        weldedIndices[vi] = _vertices.size()-1;
     }
 
+    unsigned int numPoints = _vertices.size();
+    _locked.assign(numPoints, 0);
+    _removed.assign(numPoints, 0);
+    _versions.assign(numPoints, 0);
+    _firstCorner.assign(numPoints, INVALID_INDEX);
+    _marks.assign(numPoints, 0);
+
     // now set the protected points up.
     for(Simplifier::IndexList::const_iterator pitr=protectedPoints.begin();
         pitr!=protectedPoints.end();
         ++pitr)
     {
-        _originalPointList[*pitr]->_protected = true;
+        if (*pitr<numVertices) _locked[weldedIndices[*pitr]] = 1;
     }
 
-
+    _triangles.clear();
     CollectTriangleIndexFunctor collectTriangles;
-    collectTriangles.setEdgeCollapse(this);
-
+    collectTriangles._weldedIndices = &weldedIndices;
+    collectTriangles._triangles = &_triangles;
     _geometry->accept(collectTriangles);
 
-}
-
+    _numTriangles = _triangles.size()/3;
+    _triangleRemoved.assign(_numTriangles, 0);
+    _nextCorner.resize(_triangles.size());
+    for(unsigned int corner=0; corner<_triangles.size(); ++corner)
+    {
+        addCorner(corner);
+    }
 
+    return true;
+}
 
-class CopyPointsToArrayVisitor : public osg::ArrayVisitor
+unsigned int EdgeCollapse::newMark()
 {
-    public:
-        CopyPointsToArrayVisitor(EdgeCollapse::PointList& pointList):
-            _pointList(pointList),
-            _index(0) {}
+    if (++_markValue==0)
+    {
+        std::fill(_marks.begin(), _marks.end(), 0);
+        _markValue = 1;
+    }
+    return _markValue;
+}
 
+void EdgeCollapse::addCorner(unsigned int corner)
+{
+    unsigned int point = _triangles[corner];
+    _nextCorner[corner] = _firstCorner[point];
+    _firstCorner[point] = corner;
+}
 
-        template<typename T,typename R>
-        void copy(T& array, R /*dummy*/)
-        {
-            array.resize(_pointList.size());
+void EdgeCollapse::removeCorner(unsigned int corner)
+{
+    unsigned int* link = &_firstCorner[_triangles[corner]];
+    while(*link!=INVALID_INDEX && *link!=corner) link = &_nextCorner[*link];
+    if (*link==corner) *link = _nextCorner[corner];
+}
 
-            for(unsigned int i=0;i<_pointList.size();++i)
-            {
-                if (_index<_pointList[i]->_attributes.size())
-                {
-                    float val = (_pointList[i]->_attributes[_index]);
-                    array[i] = R (val);
-                }
-            }
+unsigned int EdgeCollapse::addPoint(const osg::Vec3& vertex)
+{
+    unsigned int point = _vertices.size();
+    _vertices.push_back(vertex);
+    _attributes.resize(_attributes.size()+_numAttributes);
+    _locked.push_back(0);
+    _removed.push_back(0);
+    _versions.push_back(0);
+    _firstCorner.push_back(INVALID_INDEX);
+    _marks.push_back(0);
+    return point;
+}
 
-            ++_index;
-        }
+void EdgeCollapse::collectNeighbours(unsigned int point, IndexList& neighbours)
+{
+    neighbours.clear();
 
-        // use local typedefs if usinged char,short and int to get round gcc 3.3.1 problem with defining unsigned short()
-        typedef unsigned char dummy_uchar;
-        typedef unsigned short dummy_ushort;
-        typedef unsigned int dummy_uint;
+    unsigned int mark = newMark();
+    for(unsigned int corner=_firstCorner[point]; corner!=INVALID_INDEX; corner=_nextCorner[corner])
+    {
+        if (!isLiveCorner(corner, point)) continue;
 
-        virtual void apply(osg::Array&) {}
-        virtual void apply(osg::ByteArray& array) { copy(array, char());}
-        virtual void apply(osg::ShortArray& array) { copy(array, short()); }
-        virtual void apply(osg::IntArray& array) { copy(array, int()); }
-        virtual void apply(osg::UByteArray& array) { copy(array, dummy_uchar()); }
-        virtual void apply(osg::UShortArray& array) { copy(array,dummy_ushort()); }
-        virtual void apply(osg::UIntArray& array) { copy(array, dummy_uint()); }
-        virtual void apply(osg::FloatArray& array) { copy(array, float()); }
-
-        virtual void apply(osg::Vec4ubArray& array)
+        const unsigned int* t = &_triangles[(corner/3)*3];
+        for(unsigned int i=0;i<3;++i)
         {
-            array.resize(_pointList.size());
-
-            for(unsigned int i=0;i<_pointList.size();++i)
+            if (t[i]!=point && _marks[t[i]]!=mark)
             {
-                EdgeCollapse::FloatList& attributes = _pointList[i]->_attributes;
-                array[i].set((unsigned char)attributes[_index],
-                             (unsigned char)attributes[_index+1],
-                             (unsigned char)attributes[_index+2],
-                             (unsigned char)attributes[_index+3]);
+                _marks[t[i]] = mark;
+                neighbours.push_back(t[i]);
             }
-            _index += 4;
         }
+    }
+}
 
-        virtual void apply(osg::Vec2Array& array)
-        {
-            array.resize(_pointList.size());
+void EdgeCollapse::collectEdges(EdgeKeyList& edges) const
+{
+    edges.clear();
+    edges.reserve(_triangles.size());
+    for(unsigned int ti=0; ti<_triangleRemoved.size(); ++ti)
+    {
+        if (_triangleRemoved[ti]) continue;
 
-            for(unsigned int i=0;i<_pointList.size();++i)
-            {
-                EdgeCollapse::FloatList& attributes = _pointList[i]->_attributes;
-                if (_index+1<attributes.size()) array[i].set(attributes[_index],attributes[_index+1]);
-            }
-            _index += 2;
+        const unsigned int* t = &_triangles[ti*3];
+        for(unsigned int i=0;i<3;++i)
+        {
+            unsigned int pa = t[i], pb = t[(i+1)%3];
+            edges.push_back(pa<pb ? EdgeKey(pa,pb) : EdgeKey(pb,pa));
         }
+    }
+    std::sort(edges.begin(), edges.end());
+}
 
-        virtual void apply(osg::Vec3Array& array)
-        {
-            array.resize(_pointList.size());
+float EdgeCollapse::computeCollapse(unsigned int p0, unsigned int p1, osg::Vec3& position, float& ratio) const
+{
+    Quadric quadric = _quadrics[p0];
+    quadric += _quadrics[p1];
 
-            for(unsigned int i=0;i<_pointList.size();++i)
+    osg::Vec3d v0(_vertices[p0]);
+    osg::Vec3d v1(_vertices[p1]);
+    osg::Vec3d edge = v1-v0;
+    double edgeLength2 = edge.length2();
+
+    osg::Vec3d optimal = v0;
+    if (!_locked[p0])
+    {
+        // solve for the position that minimizes the quadric, accepting it only when well conditioned and near the edge.
+        bool solved = false;
+        double det = quadric.a00*(quadric.a11*quadric.a22 - quadric.a12*quadric.a12) -
+                     quadric.a01*(quadric.a01*quadric.a22 - quadric.a12*quadric.a02) +
+                     quadric.a02*(quadric.a01*quadric.a12 - quadric.a11*quadric.a02);
+        double scale = osg::maximum(quadric.a00, osg::maximum(quadric.a11, quadric.a22));
+        if (fabs(det) > 1e-6*scale*scale*scale)
+        {
+            double b0 = -quadric.b0, b1 = -quadric.b1, b2 = -quadric.b2;
+            osg::Vec3d solution(
+                (b0*(quadric.a11*quadric.a22 - quadric.a12*quadric.a12) - quadric.a01*(b1*quadric.a22 - quadric.a12*b2) + quadric.a02*(b1*quadric.a12 - quadric.a11*b2))/det,
+                (quadric.a00*(b1*quadric.a22 - quadric.a12*b2) - b0*(quadric.a01*quadric.a22 - quadric.a12*quadric.a02) + quadric.a02*(quadric.a01*b2 - b1*quadric.a02))/det,
+                (quadric.a00*(quadric.a11*b2 - b1*quadric.a12) - quadric.a01*(quadric.a01*b2 - b1*quadric.a02) + b0*(quadric.a01*quadric.a12 - quadric.a11*quadric.a02))/det);
+
+            if ((solution-(v0+v1)*0.5).length2() <= edgeLength2)
             {
-                EdgeCollapse::FloatList& attributes = _pointList[i]->_attributes;
-                if (_index+2<attributes.size()) array[i].set(attributes[_index],attributes[_index+1],attributes[_index+2]);
+                optimal = solution;
+                solved = true;
             }
-            _index += 3;
         }
 
-        virtual void apply(osg::Vec4Array& array)
+        if (!solved)
         {
-            array.resize(_pointList.size());
-
-            for(unsigned int i=0;i<_pointList.size();++i)
+            // fall back to the minimum along the edge.
+            double denominator = edge*quadric.multiply(edge);
+            double t = 0.5;
+            if (denominator>1e-12*edgeLength2*scale)
             {
-                EdgeCollapse::FloatList& attributes = _pointList[i]->_attributes;
-                if (_index+3<attributes.size()) array[i].set(attributes[_index],attributes[_index+1],attributes[_index+2],attributes[_index+3]);
+                t = -(edge*(quadric.multiply(v0) + osg::Vec3d(quadric.b0, quadric.b1, quadric.b2)))/denominator;
+                t = osg::clampBetween(t, 0.0, 1.0);
             }
-            _index += 4;
+            optimal = v0 + edge*t;
         }
+    }
 
-        EdgeCollapse::PointList& _pointList;
-        unsigned int _index;
+    position = optimal;
+    ratio = (edgeLength2>0.0 && !_locked[p0]) ? float(osg::clampBetween(((optimal-v0)*edge)/edgeLength2, 0.0, 1.0)) : 0.0f;
 
-    protected:
+    // report the error as the area weighted root mean square distance to the original planes.
+    double error = quadric.w>0.0 ? sqrt(osg::maximum(quadric.evaluate(optimal), 0.0)/quadric.w) : 0.0;
+    return float(error);
+}
 
-        CopyPointsToArrayVisitor& operator = (CopyPointsToArrayVisitor&) { return *this; }
-};
+bool EdgeCollapse::computeCollapse(unsigned int pa, unsigned int pb, Collapse& collapse) const
+{
+    // locked points can't move, so collapse the other point into them, and leave edges between two locked points alone.
+    if (_locked[pa] && _locked[pb]) return false;
+    if (_locked[pb]) std::swap(pa, pb);
+
+    osg::Vec3 position;
+    float ratio;
+    collapse.error = computeCollapse(pa, pb, position, ratio);
+    collapse.p0 = pa;
+    collapse.p1 = pb;
+    collapse.version0 = _versions[pa];
+    collapse.version1 = _versions[pb];
+    return true;
+}
 
-class NormalizeArrayVisitor : public osg::ArrayVisitor
+bool EdgeCollapse::satisfiesLinkCondition(unsigned int p0, unsigned int p1)
 {
-    public:
-        NormalizeArrayVisitor() {}
+    // the points must only share the neighbours opposite the edge, otherwise the collapse would pinch the surface.
+    unsigned int mark = newMark();
+    for(unsigned int corner=_firstCorner[p0]; corner!=INVALID_INDEX; corner=_nextCorner[corner])
+    {
+        if (!isLiveCorner(corner, p0)) continue;
 
-        template<typename Itr>
-        void normalize(Itr begin, Itr end)
+        const unsigned int* t = &_triangles[(corner/3)*3];
+        for(unsigned int i=0;i<3;++i) _marks[t[i]] = mark;
+    }
+
+    unsigned int numSharedNeighbours = 0;
+    unsigned int numSharedTriangles = 0;
+    for(unsigned int corner=_firstCorner[p1]; corner!=INVALID_INDEX; corner=_nextCorner[corner])
+    {
+        if (!isLiveCorner(corner, p1)) continue;
+
+        unsigned int triangle = corner/3;
+        if (triangleContains(triangle, p0)) ++numSharedTriangles;
+
+        const unsigned int* t = &_triangles[triangle*3];
+        for(unsigned int i=0;i<3;++i)
         {
-            for(Itr itr = begin;
-                itr != end;
-                ++itr)
+            if (t[i]!=p0 && t[i]!=p1 && _marks[t[i]]==mark)
             {
-                itr->normalize();
+                // clear the mark so each neighbour is only counted once
+                _marks[t[i]] = 0;
+                ++numSharedNeighbours;
             }
         }
+    }
 
-        virtual void apply(osg::Vec2Array& array) { normalize(array.begin(),array.end()); }
-        virtual void apply(osg::Vec3Array& array) { normalize(array.begin(),array.end()); }
-        virtual void apply(osg::Vec4Array& array) { normalize(array.begin(),array.end()); }
+    return numSharedTriangles>0 && numSharedNeighbours==numSharedTriangles;
+}
 
-};
+bool EdgeCollapse::flipsTriangles(unsigned int point, unsigned int other, const osg::Vec3& position) const
+{
+    for(unsigned int corner=_firstCorner[point]; corner!=INVALID_INDEX; corner=_nextCorner[corner])
+    {
+        if (!isLiveCorner(corner, point)) continue;
+
+        unsigned int triangle = corner/3;
 
-class CopyPointsToVertexArrayVisitor : public osg::ArrayVisitor
+        // triangles on the collapsed edge are removed so needn't be checked
+        if (triangleContains(triangle, other)) continue;
+
+        const unsigned int* t = &_triangles[triangle*3];
+        osg::Vec3 v[3] = { _vertices[t[0]], _vertices[t[1]], _vertices[t[2]] };
+        osg::Vec3 originalNormal = (v[1]-v[0])^(v[2]-v[0]);
+
+        v[corner%3] = position;
+        osg::Vec3 newNormal = (v[1]-v[0])^(v[2]-v[0]);
+
+        // reject normals that would deviate by 90 degrees or more, or become degenerate.
+        if (originalNormal.length2()>0.0f && originalNormal*newNormal<=0.0f) return true;
+    }
+    return false;
+}
+
+void EdgeCollapse::initCollapses()
 {
-    public:
-        CopyPointsToVertexArrayVisitor(EdgeCollapse::PointList& pointList):
-            _pointList(pointList) {}
+    _quadrics.assign(_vertices.size(), Quadric());
 
-        virtual void apply(osg::Vec2Array& array)
-        {
-            array.resize(_pointList.size());
+    for(unsigned int ti=0; ti<_triangleRemoved.size(); ++ti)
+    {
+        const unsigned int* t = &_triangles[ti*3];
+        osg::Vec3d v0(_vertices[t[0]]), v1(_vertices[t[1]]), v2(_vertices[t[2]]);
+        osg::Vec3d normal = (v1-v0)^(v2-v0);
+        double length = normal.length();
+        if (length==0.0) continue;
+
+        normal /= length;
+        Quadric quadric;
+        quadric.addPlane(normal, -(normal*v0), length*0.5);
+
+        _quadrics[t[0]] += quadric;
+        _quadrics[t[1]] += quadric;
+        _quadrics[t[2]] += quadric;
+    }
 
-            for(unsigned int i=0;i<_pointList.size();++i)
-            {
-                _pointList[i]->_index = i;
-                osg::Vec3& vertex = _pointList[i]->_vertex;
-                array[i].set(vertex.x(),vertex.y());
-            }
+    EdgeKeyList edges;
+    collectEdges(edges);
+
+    // points on boundaries, including attribute seams, and non manifold edges are locked in place.
+    for(EdgeKeyList::iterator itr = edges.begin(); itr != edges.end(); )
+    {
+        EdgeKeyList::iterator end = itr+1;
+        while(end!=edges.end() && *end==*itr) ++end;
+
+        if (end-itr != 2)
+        {
+            _locked[itr->first] = 1;
+            _locked[itr->second] = 1;
         }
+        itr = end;
+    }
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
 
-        virtual void apply(osg::Vec3Array& array)
+    _collapses.clear();
+    _collapses.reserve(edges.size());
+    for(EdgeKeyList::iterator itr = edges.begin(); itr != edges.end(); ++itr)
+    {
+        Collapse collapse;
+        if (computeCollapse(itr->first, itr->second, collapse)) _collapses.push_back(collapse);
+    }
+    std::make_heap(_collapses.begin(), _collapses.end(), CollapseGreater());
+}
+
+bool EdgeCollapse::getNextCollapseError(float& error)
+{
+    while(!_collapses.empty())
+    {
+        const Collapse& collapse = _collapses.front();
+        if (!_removed[collapse.p0] && !_removed[collapse.p1] &&
+            _versions[collapse.p0]==collapse.version0 && _versions[collapse.p1]==collapse.version1)
         {
-            array.resize(_pointList.size());
+            error = collapse.error;
+            return true;
+        }
+
+        std::pop_heap(_collapses.begin(), _collapses.end(), CollapseGreater());
+        _collapses.pop_back();
+    }
+    return false;
+}
+
+bool EdgeCollapse::collapseNextEdge()
+{
+    float error;
+    if (!getNextCollapseError(error)) return false;
+
+    Collapse collapse = _collapses.front();
+    std::pop_heap(_collapses.begin(), _collapses.end(), CollapseGreater());
+    _collapses.pop_back();
+
+    unsigned int p0 = collapse.p0;
+    unsigned int p1 = collapse.p1;
+
+    osg::Vec3 position;
+    float ratio;
+    computeCollapse(p0, p1, position, ratio);
+
+    if (!satisfiesLinkCondition(p0, p1) ||
+        flipsTriangles(p1, p0, position) ||
+        (!_locked[p0] && flipsTriangles(p0, p1, position)))
+    {
+        return false;
+    }
 
-            for(unsigned int i=0;i<_pointList.size();++i)
+    _vertices[p0] = position;
+    if (!_locked[p0])
+    {
+        float* attributes0 = _numAttributes ? &_attributes[p0*_numAttributes] : 0;
+        const float* attributes1 = _numAttributes ? &_attributes[p1*_numAttributes] : 0;
+        for(unsigned int i=0;i<_numAttributes;++i)
+        {
+            attributes0[i] = attributes0[i]*(1.0f-ratio) + attributes1[i]*ratio;
+        }
+    }
+    _quadrics[p0] += _quadrics[p1];
+    _removed[p1] = 1;
+    ++_versions[p0];
+
+    // move p1's triangles across to p0, removing those on the collapsed edge, and relink only p1's live
+    // corners onto p0's list so that dead corners don't accumulate as points are collapsed.
+    unsigned int corner = _firstCorner[p1];
+    _firstCorner[p1] = INVALID_INDEX;
+    while(corner!=INVALID_INDEX)
+    {
+        unsigned int nextCorner = _nextCorner[corner];
+        if (isLiveCorner(corner, p1))
+        {
+            unsigned int triangle = corner/3;
+            if (triangleContains(triangle, p0))
+            {
+                _triangleRemoved[triangle] = 1;
+                --_numTriangles;
+            }
+            else
             {
-                _pointList[i]->_index = i;
-                array[i] = _pointList[i]->_vertex;
+                _triangles[corner] = p0;
+                _nextCorner[corner] = _firstCorner[p0];
+                _firstCorner[p0] = corner;
             }
         }
+        corner = nextCorner;
+    }
 
-        virtual void apply(osg::Vec4Array& array)
-        {
-            array.resize(_pointList.size());
+    // the collapsed triangles also leave dead corners on p0's list.
+    unsigned int* link = &_firstCorner[p0];
+    while(*link!=INVALID_INDEX)
+    {
+        if (isLiveCorner(*link, p0)) link = &_nextCorner[*link];
+        else *link = _nextCorner[*link];
+    }
 
-            for(unsigned int i=0;i<_pointList.size();++i)
-            {
-                _pointList[i]->_index = i;
-                osg::Vec3& vertex = _pointList[i]->_vertex;
-                array[i].set(vertex.x(),vertex.y(),vertex.z(),1.0f);
-            }
+    // queue up new collapses for all the edges whose cost has changed.
+    collectNeighbours(p0, _neighbours);
+    for(IndexList::iterator itr = _neighbours.begin(); itr != _neighbours.end(); ++itr)
+    {
+        Collapse newCollapse;
+        if (computeCollapse(p0, *itr, newCollapse))
+        {
+            _collapses.push_back(newCollapse);
+            std::push_heap(_collapses.begin(), _collapses.end(), CollapseGreater());
         }
+    }
 
-        EdgeCollapse::PointList& _pointList;
+    return true;
+}
 
-    protected:
+void EdgeCollapse::pushDivision(unsigned int pa, unsigned int pb)
+{
+    Division division;
+    division.length = (_vertices[pa]-_vertices[pb]).length();
+    division.p0 = pa;
+    division.p1 = pb;
+    _divisions.push_back(division);
+    std::push_heap(_divisions.begin(), _divisions.end(), DivisionLess());
+}
 
-        CopyPointsToVertexArrayVisitor& operator = (const CopyPointsToVertexArrayVisitor&) { return *this; }
-};
+void EdgeCollapse::initDivisions()
+{
+    EdgeKeyList edges;
+    collectEdges(edges);
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
 
+    _divisions.clear();
+    _divisions.reserve(edges.size()*2);
+    for(EdgeKeyList::iterator itr = edges.begin(); itr != edges.end(); ++itr)
+    {
+        Division division;
+        division.length = (_vertices[itr->first]-_vertices[itr->second]).length();
+        division.p0 = itr->first;
+        division.p1 = itr->second;
+        _divisions.push_back(division);
+    }
+    std::make_heap(_divisions.begin(), _divisions.end(), DivisionLess());
+}
 
-void EdgeCollapse::copyBackToGeometry()
+bool EdgeCollapse::getNextDivisionLength(float& length)
 {
+    while(!_divisions.empty())
+    {
+        // points never move when up sampling, so an entry is valid for as long as its edge exists.
+        const Division& division = _divisions.front();
+        for(unsigned int corner=_firstCorner[division.p0]; corner!=INVALID_INDEX; corner=_nextCorner[corner])
+        {
+            if (isLiveCorner(corner, division.p0) && triangleContains(corner/3, division.p1))
+            {
+                length = division.length;
+                return true;
+            }
+        }
+
+        std::pop_heap(_divisions.begin(), _divisions.end(), DivisionLess());
+        _divisions.pop_back();
+    }
+    return false;
+}
 
-    // rebuild the _pointList from the _pointSet
-    _originalPointList.clear();
-    std::copy(_pointSet.begin(),_pointSet.end(),std::back_inserter(_originalPointList));
+bool EdgeCollapse::divideNextEdge()
+{
+    float length;
+    if (!getNextDivisionLength(length)) return false;
 
-    // copy vertices across to local point list
-    CopyPointsToVertexArrayVisitor copyVertexArrayToPoints(_originalPointList);
-    _geometry->getVertexArray()->accept(copyVertexArrayToPoints);
+    Division division = _divisions.front();
+    std::pop_heap(_divisions.begin(), _divisions.end(), DivisionLess());
+    _divisions.pop_back();
 
-    // copy other per vertex attributes across to local point list.
-    CopyPointsToArrayVisitor  copyArrayToPoints(_originalPointList);
+    unsigned int pa = division.p0;
+    unsigned int pb = division.p1;
 
-    for(unsigned int ti=0;ti<_geometry->getNumTexCoordArrays();++ti)
+    _localTriangles.clear();
+    for(unsigned int corner=_firstCorner[pa]; corner!=INVALID_INDEX; corner=_nextCorner[corner])
     {
-        if (_geometry->getTexCoordArray(ti))
-            _geometry->getTexCoordArray(ti)->accept(copyArrayToPoints);
+        if (isLiveCorner(corner, pa) && triangleContains(corner/3, pb)) _localTriangles.push_back(corner/3);
     }
 
-    if (_geometry->getNormalArray() && _geometry->getNormalArray()->getBinding()==osg::Array::BIND_PER_VERTEX)
+    unsigned int pm = addPoint((_vertices[pa]+_vertices[pb])*0.5f);
+    for(unsigned int i=0;i<_numAttributes;++i)
     {
-        _geometry->getNormalArray()->accept(copyArrayToPoints);
-
-        // now normalize the normals.
-        NormalizeArrayVisitor nav;
-        _geometry->getNormalArray()->accept(nav);
+        _attributes[pm*_numAttributes+i] = (_attributes[pa*_numAttributes+i]+_attributes[pb*_numAttributes+i])*0.5f;
     }
 
-    if (_geometry->getColorArray() && _geometry->getColorArray()->getBinding()==osg::Array::BIND_PER_VERTEX)
-        _geometry->getColorArray()->accept(copyArrayToPoints);
+    pushDivision(pa, pm);
+    pushDivision(pm, pb);
 
-    if (_geometry->getSecondaryColorArray() && _geometry->getSecondaryColorArray()->getBinding()==osg::Array::BIND_PER_VERTEX)
-        _geometry->getSecondaryColorArray()->accept(copyArrayToPoints);
+    // split each triangle on the edge in two, replacing pb in the original and pa in the copy by the new mid point so both keep their winding.
+    for(IndexList::iterator itr = _localTriangles.begin(); itr != _localTriangles.end(); ++itr)
+    {
+        unsigned int triangle = *itr;
+        unsigned int newTriangle = _triangleRemoved.size();
+        _triangleRemoved.push_back(0);
+        _nextCorner.resize(_nextCorner.size()+3);
+        ++_numTriangles;
 
-    if (_geometry->getFogCoordArray() && _geometry->getFogCoordArray()->getBinding()==osg::Array::BIND_PER_VERTEX)
-        _geometry->getFogCoordArray()->accept(copyArrayToPoints);
+        for(unsigned int i=0;i<3;++i)
+        {
+            unsigned int corner = triangle*3+i;
+            unsigned int point = _triangles[corner];
+            if (point==pb)
+            {
+                // unlink the corner from pb's list before relinking it into pm's, so the rest of pb's list is kept.
+                removeCorner(corner);
+                _triangles[corner] = pm;
+                addCorner(corner);
+            }
+            else if (point!=pa)
+            {
+                pushDivision(pm, point);
+            }
 
-    for(unsigned int vi=0;vi<_geometry->getNumVertexAttribArrays();++vi)
+            _triangles.push_back(point==pa ? pm : point);
+            addCorner(newTriangle*3+i);
+        }
+    }
+
+    return true;
+}
+
+void EdgeCollapse::copyBackToGeometry()
+{
+    // output the points still in use, keeping their original relative order.
+    IndexList newIndices(_vertices.size(), INVALID_INDEX);
+    for(unsigned int ti=0; ti<_triangleRemoved.size(); ++ti)
     {
-        if (_geometry->getVertexAttribArray(vi) &&  _geometry->getVertexAttribArray(vi)->getBinding()==osg::Array::BIND_PER_VERTEX)
-            _geometry->getVertexAttribArray(vi)->accept(copyArrayToPoints);
+        if (_triangleRemoved[ti]) continue;
+        for(unsigned int i=0;i<3;++i) newIndices[_triangles[ti*3+i]] = 0;
+    }
+
+    IndexList order;
+    order.reserve(_vertices.size());
+    for(unsigned int point=0; point<newIndices.size(); ++point)
+    {
+        if (newIndices[point]==INVALID_INDEX) continue;
+        newIndices[point] = order.size();
+        order.push_back(point);
     }
 
-    typedef std::set< osg::ref_ptr<Triangle>, dereference_less >    TrianglesSorted;
-    TrianglesSorted trianglesSorted;
-    for(TriangleSet::iterator itr = _triangleSet.begin();
-        itr != _triangleSet.end();
+    CopyVerticesToVertexArrayVisitor copyVerticesToVertexArray(_vertices, order);
+    _geometry->getVertexArray()->accept(copyVerticesToVertexArray);
+    _geometry->getVertexArray()->dirty();
+
+    CopyAttributesToArrayVisitor copyAttributesToArray(_attributes, _numAttributes, order);
+    for(ArrayList::iterator itr = _attributeArrays.begin();
+        itr != _attributeArrays.end();
         ++itr)
     {
-        trianglesSorted.insert(*itr);
+        (*itr)->accept(copyAttributesToArray);
+        (*itr)->dirty();
+
+        if (*itr==_geometry->getNormalArray())
+        {
+            // now normalize the normals.
+            NormalizeArrayVisitor nav;
+            (*itr)->accept(nav);
+        }
     }
 
-    osg::DrawElementsUInt* primitives = new osg::DrawElementsUInt(GL_TRIANGLES,trianglesSorted.size()*3);
+    osg::DrawElementsUInt* primitives = new osg::DrawElementsUInt(GL_TRIANGLES,_numTriangles*3);
     unsigned int pos = 0;
-    for(TrianglesSorted::iterator titr=trianglesSorted.begin();
-        titr!=trianglesSorted.end();
-        ++titr)
+    for(unsigned int ti=0; ti<_triangleRemoved.size(); ++ti)
     {
-        const Triangle* triangle = (*titr).get();
-        (*primitives)[pos++] = triangle->_p1->_index;
-        (*primitives)[pos++] = triangle->_p2->_index;
-        (*primitives)[pos++] = triangle->_p3->_index;
+        if (_triangleRemoved[ti]) continue;
+        (*primitives)[pos++] = newIndices[_triangles[ti*3]];
+        (*primitives)[pos++] = newIndices[_triangles[ti*3+1]];
+        (*primitives)[pos++] = newIndices[_triangles[ti*3+2]];
     }
 
     _geometry->getPrimitiveSetList().clear();
     _geometry->addPrimitiveSet(primitives);
-
+    _geometry->dirtyBound();
 }
 
 
@@ -1743,56 +1180,44 @@ void Simplifier::simplify(osg::Geometry& geometry, const IndexList& protectedPoi
 {
     OSG_INFO<<"++++++++++++++simplifier************"<<std::endl;
 
-    bool downSample = requiresDownSampling();
-
     EdgeCollapse ec;
-    ec.setComputeErrorMetricUsingLength(!downSample);
-    ec.setGeometry(&geometry, protectedPoints);
-    ec.updateErrorMetricForAllEdges();
-
-    unsigned int numOriginalPrimitives = ec._triangleSet.size();
+    if (!ec.setGeometry(&geometry, protectedPoints))
+    {
+        OSG_INFO<<"Simplifier::simplify(..) requires a Vec2Array, Vec3Array or Vec4Array vertex array, Geometry left unchanged."<<std::endl;
+        return;
+    }
 
+    unsigned int numOriginalPrimitives = ec.getNumTriangles();
+    float error = 0.0f;
 
-    if (downSample)
+    if (requiresDownSampling())
     {
-        while (!ec._edgeSet.empty() &&
-               continueSimplification((*ec._edgeSet.begin())->getErrorMetric() , numOriginalPrimitives, ec._triangleSet.size()) &&
-               ec.collapseMinimumErrorEdge())
+        ec.initCollapses();
+
+        while (ec.getNextCollapseError(error) &&
+               continueSimplification(error, numOriginalPrimitives, ec.getNumTriangles()))
         {
-           //OSG_INFO<<"   Collapsed edge ec._triangleSet.size()="<<ec._triangleSet.size()<<" error="<<(*ec._edgeSet.begin())->getErrorMetric()<<" vs "<<getMaximumError()<<std::endl;
+            ec.collapseNextEdge();
         }
 
-        OSG_INFO<<"******* AFTER EDGE COLLAPSE *********"<<ec._triangleSet.size()<<std::endl;
+        OSG_INFO<<"******* AFTER EDGE COLLAPSE *********"<<ec.getNumTriangles()<<std::endl;
     }
     else
     {
-
         // up sampling...
-        while (!ec._edgeSet.empty() &&
-               continueSimplification((*ec._edgeSet.rbegin())->getErrorMetric() , numOriginalPrimitives, ec._triangleSet.size()) &&
-//               ec._triangleSet.size() < targetNumTriangles  &&
-               ec.divideLongestEdge())
+        ec.initDivisions();
+
+        while (ec.getNextDivisionLength(error) &&
+               continueSimplification(error, numOriginalPrimitives, ec.getNumTriangles()))
         {
-           //OSG_INFO<<"   Edge divided ec._triangleSet.size()="<<ec._triangleSet.size()<<" error="<<(*ec._edgeSet.rbegin())->getErrorMetric()<<" vs "<<getMaximumError()<<std::endl;
+            ec.divideNextEdge();
         }
-        OSG_INFO<<"******* AFTER EDGE DIVIDE *********"<<ec._triangleSet.size()<<std::endl;
-    }
-
-    OSG_INFO<<"Number of triangle errors after edge collapse= "<<ec.testAllTriangles()<<std::endl;
-    OSG_INFO<<"Number of edge errors before edge collapse= "<<ec.testAllEdges()<<std::endl;
-    OSG_INFO<<"Number of point errors after edge collapse= "<<ec.testAllPoints()<<std::endl;
-    OSG_INFO<<"Number of triangles= "<<ec._triangleSet.size()<<std::endl;
-    OSG_INFO<<"Number of points= "<<ec._pointSet.size()<<std::endl;
-    OSG_INFO<<"Number of edges= "<<ec._edgeSet.size()<<std::endl;
-    OSG_INFO<<"Number of boundary edges= "<<ec.computeNumBoundaryEdges()<<std::endl;
 
-    if (!ec._edgeSet.empty())
-    {
-        OSG_INFO<<std::endl<<"Simplifier, in = "<<numOriginalPrimitives<<"\tout = "<<ec._triangleSet.size()<<"\terror="<<(*ec._edgeSet.begin())->getErrorMetric()<<"\tvs "<<getMaximumError()<<std::endl<<std::endl;
-        OSG_INFO<<           "        !ec._edgeSet.empty()  = "<<!ec._edgeSet.empty()<<std::endl;
-        OSG_INFO<<           "        continueSimplification(,,)  = "<<continueSimplification((*ec._edgeSet.begin())->getErrorMetric() , numOriginalPrimitives, ec._triangleSet.size())<<std::endl;
+        OSG_INFO<<"******* AFTER EDGE DIVIDE *********"<<ec.getNumTriangles()<<std::endl;
     }
 
+    OSG_INFO<<std::endl<<"Simplifier, in = "<<numOriginalPrimitives<<"\tout = "<<ec.getNumTriangles()<<"\terror="<<error<<"\tvs "<<getMaximumError()<<std::endl<<std::endl;
+
     ec.copyBackToGeometry();
 
     if (_smoothing)
@@ -47,19 +47,43 @@ void StateGraph::clean()
 }
 
 /** recursively prune the StateGraph of empty children.*/
-void StateGraph::prune()
+void StateGraph::prune(unsigned int numFramesToRetainEmpty)
 {
     // call prune on all children.
     ChildList::iterator citr=_children.begin();
     while(citr!=_children.end())
     {
-        citr->second->prune();
+        StateGraph* child = citr->second.get();
+        child->prune(numFramesToRetainEmpty);
 
-        if (citr->second->empty())
+        if (!child->_leaves.empty())
         {
+            child->_numFramesEmpty = 0;
+            ++citr;
+        }
+        else if (numFramesToRetainEmpty==0)
+        {
+            child->_numFramesEmpty = 0;
+            if (child->_children.empty())
+            {
+                ChildList::iterator ditr= citr++;
+                _children.erase(ditr);
+            }
+            else ++citr;
+        }
+        else if ((child->_children.empty() && child->_numFramesEmpty>=numFramesToRetainEmpty) ||
+                 (child->_numFramesEmpty>0 && child->_retainedStateSet.get()!=child->getStateSet()))
+        {
+            // either retained for long enough, or its StateSet has been deleted while retained.
             ChildList::iterator ditr= citr++;
             _children.erase(ditr);
         }
-        else ++citr;
+        else
+        {
+            // observe the StateSet of a retained StateGraph, as it may be deleted and a new StateSet
+            // allocated at the same address before the StateGraph is next used.
+            if (child->_numFramesEmpty++==0) child->_retainedStateSet = child->getStateSet();
+            ++citr;
+        }
     }
 }
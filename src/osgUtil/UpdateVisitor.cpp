@@ -12,6 +12,8 @@
 */
 #include <osgUtil/UpdateVisitor>
 
+#include <typeinfo>
+
 using namespace osg;
 using namespace osgUtil;
 
@@ -29,3 +31,11 @@ UpdateVisitor::~UpdateVisitor()
 void UpdateVisitor::reset()
 {
 }
+
+osg::NodeVisitor* UpdateVisitor::cloneForParallelTraversal() const
+{
+    // cloning a subclass as a plain UpdateVisitor would slice away its behaviour.
+    if (typeid(*this)!=typeid(UpdateVisitor)) return 0;
+
+    return new UpdateVisitor;
+}
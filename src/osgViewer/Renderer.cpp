@@ -632,6 +632,14 @@ static void collectSceneViewStats(unsigned int frameNumber, osgUtil::SceneView*
     stats->setAttribute(frameNumber, "Visible number of impostors", static_cast<double>(sceneStats.nimpostor));
     stats->setAttribute(frameNumber, "Number of ordered leaves", static_cast<double>(sceneStats.numOrderedLeaves));
 
+    osgUtil::CullVisitor* cullVisitor = sceneView->getCullVisitor();
+    if (cullVisitor)
+    {
+        stats->setAttribute(frameNumber, "Cull RenderLeaf allocations", static_cast<double>(cullVisitor->getNumRenderLeavesAllocated()));
+        stats->setAttribute(frameNumber, "Cull RenderLeaf pool size", static_cast<double>(cullVisitor->getNumRenderLeavesPooled()));
+        stats->setAttribute(frameNumber, "Cull StateGraph allocations", static_cast<double>(cullVisitor->getNumStateGraphsAllocated()));
+    }
+
     unsigned int totalNumPrimitiveSets = 0;
     const osgUtil::Statistics::PrimitiveValueMap& pvm = sceneStats.getPrimitiveValueMap();
     for(osgUtil::Statistics::PrimitiveValueMap::const_iterator pvm_itr = pvm.begin();
@@ -655,6 +663,32 @@ static void collectSceneViewStats(unsigned int frameNumber, osgUtil::SceneView*
     stats->setAttribute(frameNumber, "Visible number of GL_POLYGON", static_cast<double>(pcm[GL_POLYGON]));
 }
 
+static void collectParallelCameraCullStats(unsigned int frameNumber, osgUtil::SceneView* sceneView, osg::Stats* stats)
+{
+    osgUtil::CullVisitor* cullVisitor = sceneView->getCullVisitor();
+    if (!cullVisitor || cullVisitor->getParallelCameraCullTimes().empty()) return;
+
+    const osgUtil::CullVisitor::CameraCullTimeList& cameraCullTimes = cullVisitor->getParallelCameraCullTimes();
+
+    double totalTime = 0.0;
+    for(osgUtil::CullVisitor::CameraCullTimeList::const_iterator itr = cameraCullTimes.begin();
+        itr != cameraCullTimes.end();
+        ++itr)
+    {
+        totalTime += itr->second;
+
+        // nested Cameras only report their own cull time if they have been given Stats to collect into.
+        osg::Stats* cameraStats = itr->first->getStats();
+        if (cameraStats && cameraStats->collectStats("rendering"))
+        {
+            cameraStats->setAttribute(frameNumber, "Cull traversal time taken", itr->second);
+        }
+    }
+
+    stats->setAttribute(frameNumber, "Parallel camera culls", static_cast<double>(cameraCullTimes.size()));
+    stats->setAttribute(frameNumber, "Parallel camera cull time taken", totalTime);
+}
+
 void Renderer::cull()
 {
     DEBUG_MESSAGE<<"cull()"<<std::endl;
@@ -699,6 +733,8 @@ void Renderer::cull()
             stats->setAttribute(frameNumber, "Cull traversal begin time", osg::Timer::instance()->delta_s(_startTick, beforeCullTick));
             stats->setAttribute(frameNumber, "Cull traversal end time", osg::Timer::instance()->delta_s(_startTick, afterCullTick));
             stats->setAttribute(frameNumber, "Cull traversal time taken", osg::Timer::instance()->delta_s(beforeCullTick, afterCullTick));
+
+            collectParallelCameraCullStats(frameNumber, sceneView, stats);
         }
 
         if (stats && stats->collectStats("scene"))
@@ -923,6 +959,8 @@ void Renderer::cull_draw()
         stats->setAttribute(frameNumber, "Cull traversal end time", osg::Timer::instance()->delta_s(_startTick, afterCullTick));
         stats->setAttribute(frameNumber, "Cull traversal time taken", osg::Timer::instance()->delta_s(beforeCullTick, afterCullTick));
 
+        collectParallelCameraCullStats(frameNumber, sceneView, stats);
+
         stats->setAttribute(frameNumber, "Draw traversal begin time", osg::Timer::instance()->delta_s(_startTick, beforeDrawTick));
         stats->setAttribute(frameNumber, "Draw traversal end time", osg::Timer::instance()->delta_s(_startTick, afterDrawTick));
         stats->setAttribute(frameNumber, "Draw traversal time taken", osg::Timer::instance()->delta_s(beforeDrawTick, afterDrawTick));
@@ -24,6 +24,7 @@
 
 #include <osg/PolygonMode>
 #include <osg/Geometry>
+#include <osgDB/Registry>
 
 namespace osgViewer
 {
@@ -619,6 +620,10 @@ struct CameraSceneStatsTextDrawCallback : public virtual osg::Drawable::DrawCall
                 STATS_ATTRIBUTE("Visible number of GL_QUAD_STRIP")
                 STATS_ATTRIBUTE("Visible number of GL_POLYGON")
 
+                STATS_ATTRIBUTE("Cull RenderLeaf allocations")
+                STATS_ATTRIBUTE("Cull RenderLeaf pool size")
+                STATS_ATTRIBUTE("Cull StateGraph allocations")
+
                 text->setText(viewStr.str());
             }
         }
@@ -1057,6 +1062,8 @@ struct PagerCallback : public virtual osg::NodeCallback
                     osgText::Text* averageValue,
                     osgText::Text* filerequestlist,
                     osgText::Text* compilelist,
+                    osgText::Text* threadstats,
+                    osgText::Text* objectcachestats,
                     double multiplier):
         _dp(dp),
         _minValue(minValue),
@@ -1064,6 +1071,8 @@ struct PagerCallback : public virtual osg::NodeCallback
         _averageValue(averageValue),
         _filerequestlist(filerequestlist),
         _compilelist(compilelist),
+        _threadstats(threadstats),
+        _objectcachestats(objectcachestats),
         _multiplier(multiplier)
     {
     }
@@ -1112,6 +1121,23 @@ struct PagerCallback : public virtual osg::NodeCallback
 
             sprintf(tmpText,"%4d", _dp->getDataToCompileListSize());
             _compilelist->setText(tmpText);
+
+            std::string threadStats;
+            for(unsigned int i=0; i<_dp->getNumDatabaseThreads(); ++i)
+            {
+                const osgDB::DatabasePager::DatabaseThread* dt = _dp->getDatabaseThread(i);
+                sprintf(tmpText,"%u/%u  ", dt->getNumRequestsRead(), dt->getNumRequestsStolen());
+                threadStats += tmpText;
+            }
+            _threadstats->setText(threadStats);
+
+            const osgDB::ObjectCache* objectCache = osgDB::Registry::instance()->getObjectCache();
+            if (objectCache)
+            {
+                sprintf(tmpText,"%u  %.1fMB  %u/%u/%u", objectCache->getNumEntries(), double(objectCache->getSizeInBytes())/(1024.0*1024.0),
+                        objectCache->getNumHits(), objectCache->getNumMisses(), objectCache->getNumEvictions());
+                _objectcachestats->setText(tmpText);
+            }
         }
 
         traverse(node,nv);
@@ -1124,6 +1150,8 @@ struct PagerCallback : public virtual osg::NodeCallback
     osg::ref_ptr<osgText::Text> _averageValue;
     osg::ref_ptr<osgText::Text> _filerequestlist;
     osg::ref_ptr<osgText::Text> _compilelist;
+    osg::ref_ptr<osgText::Text> _threadstats;
+    osg::ref_ptr<osgText::Text> _objectcachestats;
     double                      _multiplier;
 };
 
@@ -1576,9 +1604,65 @@ void StatsHandler::setUpScene(osgViewer::ViewerBase* viewer)
                 compileList->setDataVariance(osg::Object::DYNAMIC);
 
 
-                pos.x() = maxLabel->getBoundingBox().xMax();
+                pos.x() = _leftPos;
+                pos.y() -= (_characterSize + backgroundSpacing);
+
+                _statsGeode->addDrawable(createBackgroundRectangle(    pos + osg::Vec3(-backgroundMargin, _characterSize + backgroundMargin, 0),
+                                                                       _statsWidth - 2 * backgroundMargin,
+                                                                       _characterSize + 2 * backgroundMargin,
+                                                                       backgroundColor));
+
+                osg::ref_ptr<osgText::Text> threadsLabel = new osgText::Text;
+                _statsGeode->addDrawable( threadsLabel.get() );
+
+                threadsLabel->setColor(colorDP);
+                threadsLabel->setFont(_font);
+                threadsLabel->setCharacterSize(_characterSize);
+                threadsLabel->setPosition(pos);
+                threadsLabel->setText("DatabasePager threads - read/stolen: ");
+
+                pos.x() = threadsLabel->getBoundingBox().xMax();
+
+                osg::ref_ptr<osgText::Text> threadStats = new osgText::Text;
+                _statsGeode->addDrawable( threadStats.get() );
+
+                threadStats->setColor(colorDP);
+                threadStats->setFont(_font);
+                threadStats->setCharacterSize(_characterSize);
+                threadStats->setPosition(pos);
+                threadStats->setText("0/0");
+                threadStats->setDataVariance(osg::Object::DYNAMIC);
+
+                pos.x() = _leftPos;
+                pos.y() -= (_characterSize + backgroundSpacing);
+
+                _statsGeode->addDrawable(createBackgroundRectangle(    pos + osg::Vec3(-backgroundMargin, _characterSize + backgroundMargin, 0),
+                                                                       _statsWidth - 2 * backgroundMargin,
+                                                                       _characterSize + 2 * backgroundMargin,
+                                                                       backgroundColor));
+
+                osg::ref_ptr<osgText::Text> objectCacheLabel = new osgText::Text;
+                _statsGeode->addDrawable( objectCacheLabel.get() );
+
+                objectCacheLabel->setColor(colorDP);
+                objectCacheLabel->setFont(_font);
+                objectCacheLabel->setCharacterSize(_characterSize);
+                objectCacheLabel->setPosition(pos);
+                objectCacheLabel->setText("ObjectCache - entries, size, hits/misses/evictions: ");
+
+                pos.x() = objectCacheLabel->getBoundingBox().xMax();
+
+                osg::ref_ptr<osgText::Text> objectCacheStats = new osgText::Text;
+                _statsGeode->addDrawable( objectCacheStats.get() );
+
+                objectCacheStats->setColor(colorDP);
+                objectCacheStats->setFont(_font);
+                objectCacheStats->setCharacterSize(_characterSize);
+                objectCacheStats->setPosition(pos);
+                objectCacheStats->setText("0");
+                objectCacheStats->setDataVariance(osg::Object::DYNAMIC);
 
-                _statsGeode->setCullCallback(new PagerCallback(dp, minValue.get(), maxValue.get(), averageValue.get(), requestList.get(), compileList.get(), 1000.0));
+                _statsGeode->setCullCallback(new PagerCallback(dp, minValue.get(), maxValue.get(), averageValue.get(), requestList.get(), compileList.get(), threadStats.get(), objectCacheStats.get(), 1000.0));
             }
 
             pos.x() = _leftPos;
@@ -1598,7 +1682,7 @@ void StatsHandler::setUpScene(osgViewer::ViewerBase* viewer)
         group->addChild(geode);
         geode->addDrawable(createBackgroundRectangle(pos + osg::Vec3(-backgroundMargin, _characterSize + backgroundMargin, 0),
                                                         10 * _characterSize + 2 * backgroundMargin,
-                                                        22 * _characterSize + 2 * backgroundMargin,
+                                                        25 * _characterSize + 2 * backgroundMargin,
                                                         backgroundColor));
 
         // Camera scene & primitive stats static text
@@ -1635,6 +1719,9 @@ void StatsHandler::setUpScene(osgViewer::ViewerBase* viewer)
         viewStr << "Quads" << std::endl;
         viewStr << "Quad strips" << std::endl;
         viewStr << "Polygons" << std::endl;
+        viewStr << "Leaf allocs" << std::endl;
+        viewStr << "Leaf pool" << std::endl;
+        viewStr << "Graph allocs" << std::endl;
         viewStr.setf(std::ios::right,std::ios::adjustfield);
         camStaticText->setText(viewStr.str());
 
@@ -1647,7 +1734,7 @@ void StatsHandler::setUpScene(osgViewer::ViewerBase* viewer)
         {
             geode->addDrawable(createBackgroundRectangle(pos + osg::Vec3(-backgroundMargin, _characterSize + backgroundMargin, 0),
                                                             5 * _characterSize + 2 * backgroundMargin,
-                                                            22 * _characterSize + 2 * backgroundMargin,
+                                                            25 * _characterSize + 2 * backgroundMargin,
                                                             backgroundColor));
 
             // Camera scene stats
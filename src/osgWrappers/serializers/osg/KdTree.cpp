@@ -0,0 +1,141 @@
+#include <osg/KdTree>
+#include <osgDB/ObjectWrapper>
+#include <osgDB/InputStream>
+#include <osgDB/OutputStream>
+
+static void readIndices( osgDB::InputStream& is, osg::KdTree::Indices& indices )
+{
+    unsigned int size = 0; is >> size >> is.BEGIN_BRACKET;
+    indices.resize( size );
+    if ( size>0 )
+    {
+        if ( is.isBinary() )
+        {
+            is.readComponentArray( (char*)&indices.front(), size, 1, sizeof(unsigned int) );
+        }
+        else
+        {
+            for ( unsigned int i=0; i<size; ++i ) is >> indices[i];
+        }
+    }
+    is >> is.END_BRACKET;
+}
+
+static void writeIndices( osgDB::OutputStream& os, const osg::KdTree::Indices& indices )
+{
+    os << (unsigned int)indices.size() << os.BEGIN_BRACKET;
+    if ( os.isBinary() )
+    {
+        if ( !indices.empty() ) os.writeCharArray( (const char*)&indices.front(), indices.size()*sizeof(unsigned int) );
+    }
+    else
+    {
+        for ( unsigned int i=0; i<indices.size(); ++i )
+        {
+            if ( !(i%8) ) os << std::endl;
+            os << indices[i];
+        }
+        os << std::endl;
+    }
+    os << os.END_BRACKET << std::endl;
+}
+
+// _primitiveIndices
+static bool checkPrimitiveIndices( const osg::KdTree& kdTree )
+{
+    return !kdTree.getPrimitiveIndices().empty();
+}
+
+static bool readPrimitiveIndices( osgDB::InputStream& is, osg::KdTree& kdTree )
+{
+    readIndices( is, kdTree.getPrimitiveIndices() );
+    return true;
+}
+
+static bool writePrimitiveIndices( osgDB::OutputStream& os, const osg::KdTree& kdTree )
+{
+    writeIndices( os, kdTree.getPrimitiveIndices() );
+    return true;
+}
+
+// _vertexIndices
+static bool checkVertexIndices( const osg::KdTree& kdTree )
+{
+    return !kdTree.getVertexIndices().empty();
+}
+
+static bool readVertexIndices( osgDB::InputStream& is, osg::KdTree& kdTree )
+{
+    readIndices( is, kdTree.getVertexIndices() );
+    return true;
+}
+
+static bool writeVertexIndices( osgDB::OutputStream& os, const osg::KdTree& kdTree )
+{
+    writeIndices( os, kdTree.getVertexIndices() );
+    return true;
+}
+
+// _kdNodes
+static bool checkNodes( const osg::KdTree& kdTree )
+{
+    return !kdTree.getNodes().empty();
+}
+
+static bool readNodes( osgDB::InputStream& is, osg::KdTree& kdTree )
+{
+    osg::KdTree::KdNodeList& nodes = kdTree.getNodes();
+    unsigned int size = 0; is >> size >> is.BEGIN_BRACKET;
+    nodes.resize( size );
+    for ( unsigned int i=0; i<size; ++i )
+    {
+        osg::KdTree::KdNode& node = nodes[i];
+        osg::Vec3f bbMin, bbMax;
+        is >> bbMin >> bbMax >> node.first >> node.second;
+        node.bb.set( bbMin, bbMax );
+    }
+    is >> is.END_BRACKET;
+    return true;
+}
+
+static bool writeNodes( osgDB::OutputStream& os, const osg::KdTree& kdTree )
+{
+    const osg::KdTree::KdNodeList& nodes = kdTree.getNodes();
+    os << (unsigned int)nodes.size() << os.BEGIN_BRACKET << std::endl;
+    for ( osg::KdTree::KdNodeList::const_iterator itr=nodes.begin(); itr!=nodes.end(); ++itr )
+    {
+        os << osg::Vec3f(itr->bb._min) << osg::Vec3f(itr->bb._max) << itr->first << itr->second << std::endl;
+    }
+    os << os.END_BRACKET << std::endl;
+    return true;
+}
+
+// A KdTree that doesn't hold together is discarded so that the intersectors fall back to the Geometry,
+// and the KdTreeBuilder replaces it when building KdTrees on load.
+struct KdTreeFinishedObjectReadCallback : public osgDB::FinishedObjectReadCallback
+{
+    virtual void objectRead(osgDB::InputStream&, osg::Object& obj)
+    {
+        osg::KdTree& kdTree = static_cast<osg::KdTree&>(obj);
+        if ( !kdTree.getNodes().empty() && !kdTree.validate() )
+        {
+            OSG_WARN << "KdTree read from file is invalid, discarding it." << std::endl;
+            kdTree.getNodes().clear();
+            kdTree.getPrimitiveIndices().clear();
+            kdTree.getVertexIndices().clear();
+        }
+    }
+};
+
+REGISTER_OBJECT_WRAPPER( KdTree,
+                         new osg::KdTree,
+                         osg::KdTree,
+                         "osg::Object osg::Shape osg::KdTree" )
+{
+    ADD_OBJECT_SERIALIZER( Vertices, osg::Vec3Array, NULL );  // _vertices
+    ADD_USER_SERIALIZER( PrimitiveIndices );  // _primitiveIndices
+    ADD_USER_SERIALIZER( VertexIndices );  // _vertexIndices
+    ADD_USER_SERIALIZER( Nodes );  // _kdNodes
+
+    wrapper->addFinishedObjectReadCallback( new KdTreeFinishedObjectReadCallback() );
+}